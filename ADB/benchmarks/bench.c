@@ -0,0 +1,176 @@
+// adb-bench: performance benchmarks.
+//
+//   adb-bench <benchmark> [arguments]
+//
+// Run without arguments to list the benchmarks.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "bench.h"
+
+
+static bench_command Commands[] =
+{
+    {"png",      "<directory> [--iterations N]", RunPNGBenchmark},
+    {"stream",   "[--textures N] [--size N] [--budget MiB] [--frames N] [--frame-ms N]", RunStreamBenchmark},
+    {"parallel", "[--count N] [--threads N] [--iterations N]", RunParallelBenchmark},
+    {"sample",   "[--size N] [--pixels N] [--iterations N]", RunSampleBenchmark},
+    {"frame",    "[--obj <file>]... [--meshes N] [--triangles N] [--materials N] [--entities N] [--frames N] [--warmup N] [--json <file>]", RunFrameBenchmark},
+    {"micro",    "[--filter <text>] [--runs N] [--warmup N] [--min-ms N] [--cpu N] [--save <file>] [--baseline <file>] [--threshold %]", RunMicroBenchmark},
+};
+
+// ==============================================
+// <Helpers> : PUBLIC
+// ==============================================
+
+
+double
+GetElapsedMs(uint64_t Start, uint64_t End)
+{
+    double Result = (double)(End - Start) * 1000.0 / (double)OSGetTimerFrequency();
+    return Result;
+}
+
+
+static bool
+EndsWithNoCase(byte_string String, byte_string Suffix)
+{
+    bool Result = String.Size >= Suffix.Size;
+
+    for (uint64_t Idx = 0; Result && Idx < Suffix.Size; ++Idx)
+    {
+        uint8_t A = String.Data[String.Size - Suffix.Size + Idx];
+        uint8_t B = Suffix.Data[Idx];
+
+        if (A >= 'A' && A <= 'Z') A += 'a' - 'A';
+        if (B >= 'A' && B <= 'Z') B += 'a' - 'A';
+
+        Result = A == B;
+    }
+
+    return Result;
+}
+
+
+static void
+AppendFilesWithExtension(byte_string Directory, byte_string Extension, memory_arena *Arena, os_file_list *Files)
+{
+    os_file_list List = OSListDirectory(Directory, Arena);
+
+    for (os_file_node *File = List.First; File != 0;)
+    {
+        os_file_node *Next = File->Next;
+
+        if (File->IsDirectory)
+        {
+            AppendFilesWithExtension(File->Path, Extension, Arena, Files);
+        }
+        else if (EndsWithNoCase(File->Path, Extension))
+        {
+            File->Next = 0;
+
+            if (!Files->First)
+            {
+                Files->First = File;
+                Files->Last  = File;
+            }
+            else
+            {
+                Files->Last->Next = File;
+                Files->Last       = File;
+            }
+
+            ++Files->Count;
+        }
+
+        File = Next;
+    }
+}
+
+
+os_file_list
+FindFilesWithExtension(byte_string Directory, byte_string Extension, memory_arena *Arena)
+{
+    os_file_list Result = {0};
+    AppendFilesWithExtension(Directory, Extension, Arena, &Result);
+
+    return Result;
+}
+
+bench_text
+CreateBenchText(uint64_t Capacity, memory_arena *Arena)
+{
+    bench_text Result = {PushArray(Arena, uint8_t, Capacity), 0, Capacity};
+
+    Result.Capacity = Result.Data ? Capacity : 0;
+    return Result;
+}
+
+
+void
+AppendBenchText(bench_text *Text, const char *Format, ...)
+{
+    va_list Args;
+    va_start(Args, Format);
+
+    uint64_t Left    = Text->Capacity - Text->Size;
+    int      Written = Left ? vsnprintf((char *)Text->Data + Text->Size, Left, Format, Args) : 0;
+
+    Text->Size += Written > 0 ? Minimum((uint64_t)Written, Left - 1) : 0;
+
+    va_end(Args);
+}
+
+
+bool
+WriteBenchText(const char *Path, bench_text *Text)
+{
+    buffer File = {Text->Data, Text->Size, 0};
+
+    // A text that filled its buffer up to the terminator lost whatever came after.
+
+    bool Result = Text->Size + 1 < Text->Capacity && WriteBufferToFile(ByteString((uint8_t *)Path, strlen(Path)), &File);
+    return Result;
+}
+
+// ==============================================
+// <Entry Point>
+// ==============================================
+
+
+int
+main(int ArgCount, char **Args)
+{
+    bench_command *Command = 0;
+
+    for (uint32_t CommandIdx = 0; ArgCount > 1 && CommandIdx < ArrayCount(Commands); ++CommandIdx)
+    {
+        if (strcmp(Args[1], Commands[CommandIdx].Name) == 0)
+        {
+            Command = Commands + CommandIdx;
+        }
+    }
+
+    if (!Command)
+    {
+        fprintf(stderr, "usage: adb-bench <benchmark> [arguments]\n\n");
+        for (uint32_t CommandIdx = 0; CommandIdx < ArrayCount(Commands); ++CommandIdx)
+        {
+            fprintf(stderr, "  %-14s %s\n", Commands[CommandIdx].Name, Commands[CommandIdx].Usage);
+        }
+
+        return 2;
+    }
+
+    // Benchmarks that want workers start their own, the shared memory only gets one.
+    engine_memory EngineMemory = OSCreateEngineMemory(1);
+
+    int Result = Command->Function(ArgCount - 2, Args + 2, &EngineMemory);
+    return Result;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+
+// ==============================================
+// <Benchmarks>
+// ==============================================
+
+// adb-bench runs one named benchmark per invocation: adb-bench <name> [arguments]. Each one lives
+// in its own bench_<name>.c and is listed in the table in bench.c.
+
+typedef int bench_function(int ArgCount, char **Args, engine_memory *EngineMemory);
+
+typedef struct
+{
+    const char     *Name;
+    const char     *Usage;
+    bench_function *Function;
+} bench_command;
+
+
+// Text built up with printf formats into a buffer of a fixed capacity, for the files benchmarks
+// write. Whatever does not fit is dropped and the write then fails, size the buffer up front.
+
+typedef struct
+{
+    uint8_t *Data;
+    uint64_t Size;
+    uint64_t Capacity;
+} bench_text;
+
+
+// Synthetic OBJ/MTL scenes (bench_obj.c): MeshCount objects of PolygonCount faces each. Triangles
+// and quads share the vertices of a grid, faces with more sides each get a ring of their own, the
+// parser fans them into triangles. Every mesh uses one of MaterialCount materials, none of them
+// has textures. Positions are written in the given float format, faces reference the attributes
+// the face format names.
+
+#define MAX_GENERATED_OBJ_VERTEX_COUNT 1000000 // What parsers/parser_obj.c takes per file, three per triangle.
+#define MAX_GENERATED_OBJ_SIDE_COUNT   32
+
+typedef enum
+{
+    ObjFace_Position        = 0, // f 1 2 3
+    ObjFace_PositionTexture = 1, // f 1/1 2/2 3/3
+    ObjFace_PositionNormal  = 2, // f 1//1 2//1 3//1
+    ObjFace_Full            = 3, // f 1/1/1 2/2/1 3/3/1
+    ObjFace_Count           = 4,
+} ObjFace_Type;
+
+
+typedef enum
+{
+    ObjFloat_Short    = 0, // -1.2500
+    ObjFloat_Long     = 1, // -1.250000000
+    ObjFloat_Exponent = 2, // -1.250000e+00
+    ObjFloat_Count    = 3,
+} ObjFloat_Type;
+
+
+typedef struct
+{
+    uint32_t      MeshCount;
+    uint32_t      PolygonCount;   // Per mesh.
+    uint32_t      SideCount;      // 3 to MAX_GENERATED_OBJ_SIDE_COUNT.
+    uint32_t      MaterialCount;
+    ObjFace_Type  Faces;
+    ObjFloat_Type Floats;
+} obj_scene_params;
+
+
+double       GetElapsedMs           (uint64_t Start, uint64_t End);
+os_file_list FindFilesWithExtension (byte_string Directory, byte_string Extension, memory_arena *Arena);
+
+bench_text   CreateBenchText        (uint64_t Capacity, memory_arena *Arena);
+void         AppendBenchText        (bench_text *Text, const char *Format, ...);
+bool         WriteBenchText         (const char *Path, bench_text *Text);
+
+// Writes <Directory>/<Name>.obj and .mtl, false when the scene is more than the parser takes or a
+// file could not be written. Size is what the OBJ came to.
+
+bool         GenerateObjScene       (obj_scene_params Params, const char *Directory, const char *Name, uint64_t *Size, memory_arena *Arena);
+
+int          RunPNGBenchmark        (int ArgCount, char **Args, engine_memory *EngineMemory);
+int          RunStreamBenchmark     (int ArgCount, char **Args, engine_memory *EngineMemory);
+int          RunParallelBenchmark   (int ArgCount, char **Args, engine_memory *EngineMemory);
+int          RunSampleBenchmark     (int ArgCount, char **Args, engine_memory *EngineMemory);
+int          RunFrameBenchmark      (int ArgCount, char **Args, engine_memory *EngineMemory);
+int          RunMicroBenchmark      (int ArgCount, char **Args, engine_memory *EngineMemory);
\ No newline at end of file
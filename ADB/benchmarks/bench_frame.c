@@ -0,0 +1,285 @@
+// adb-bench frame [--obj <file>]... [--meshes M] [--triangles N] [--materials N] [--entities N] [--frames N] [--warmup N] [--json <file>]
+//
+// Runs the engine the way the window does, UpdateEngine once per frame, on the null renderer
+// (engine/rendering/null/null_renderer.h) instead of a GPU. The scene is every --obj file, or one
+// generated into bench_frame/ with --meshes objects of --triangles triangles each, spread over
+// --materials materials without textures. Every mesh gets --entities entities, MAX_ENTITY_COUNT at
+// most in all. Entities have no transform yet, they all sit in the same place: what is measured is
+// the CPU side of a frame.
+//
+// Reports how long the import took (parsing, textures, resources), then frame times over --frames
+// frames after --warmup ones: mean, median, 90th and 99th percentile, worst. Also what the frame
+// arena held at the end of a frame and what the null renderer counted in the last one. --json writes
+// the same as one JSON object, for scripts that compare runs.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "engine/engine.h"
+#include "engine/rendering/renderer.h"
+#include "engine/rendering/scene.h"
+#include "engine/rendering/null/null_renderer.h"
+#include "bench.h"
+
+#define FRAME_VIEW_WIDTH         1920
+#define FRAME_VIEW_HEIGHT        1080
+#define FRAME_SCENE_DIRECTORY    "bench_frame"
+#define MAX_FRAME_OBJ_COUNT      64
+#define MAX_FRAME_MATERIAL_COUNT 64
+
+// ==============================================
+// <Frame Benchmark> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    double Mean;
+    double Median;
+    double P90;
+    double P99;
+    double Max;
+} frame_timing;
+
+
+static int
+CompareFrameMs(const void *A, const void *B)
+{
+    double X = *(const double *)A;
+    double Y = *(const double *)B;
+
+    int Result = (X > Y) - (X < Y);
+    return Result;
+}
+
+
+// Nearest rank, Samples ends up sorted.
+
+static frame_timing
+SummarizeFrameTimes(double *Samples, uint32_t Count)
+{
+    frame_timing Result = {0};
+    double       Total  = 0.0;
+
+    qsort(Samples, Count, sizeof(double), CompareFrameMs);
+
+    for (uint32_t Idx = 0; Idx < Count; ++Idx)
+    {
+        Total += Samples[Idx];
+    }
+
+    Result.Mean   = Total / (double)Count;
+    Result.Median = Samples[(Count - 1) / 2];
+    Result.P90    = Samples[(uint32_t)((uint64_t)(Count - 1) * 90 / 100)];
+    Result.P99    = Samples[(uint32_t)((uint64_t)(Count - 1) * 99 / 100)];
+    Result.Max    = Samples[Count - 1];
+
+    return Result;
+}
+
+
+static void
+AppendJSONString(bench_text *Text, const char *String)
+{
+    AppendBenchText(Text, "\"");
+
+    for (const char *At = String; *At; ++At)
+    {
+        if (*At == '"' || *At == '\\')
+        {
+            AppendBenchText(Text, "\\%c", *At);
+        }
+        else if ((uint8_t)*At >= 0x20)
+        {
+            AppendBenchText(Text, "%c", *At);
+        }
+    }
+
+    AppendBenchText(Text, "\"");
+}
+
+// ==============================================
+// <Frame Benchmark> : PUBLIC
+// ==============================================
+
+
+int
+RunFrameBenchmark(int ArgCount, char **Args, engine_memory *EngineMemory)
+{
+    char    *ObjPaths[MAX_FRAME_OBJ_COUNT];
+    uint32_t ObjCount      = 0;
+    char    *JSONPath      = 0;
+    uint32_t MeshCount     = 16;
+    uint32_t TriangleCount = 2000;
+    uint32_t MaterialCount = 4;
+    uint32_t EntityCount   = 16;
+    uint32_t FrameCount    = 500;
+    uint32_t WarmupCount   = 20;
+
+    for (int ArgIdx = 0; ArgIdx + 1 < ArgCount; ArgIdx += 2)
+    {
+        char     *Value  = Args[ArgIdx + 1];
+        uint32_t  Number = (uint32_t)atoi(Value);
+
+        if      (strcmp(Args[ArgIdx], "--obj")       == 0) ObjPaths[ObjCount++ % MAX_FRAME_OBJ_COUNT] = Value;
+        else if (strcmp(Args[ArgIdx], "--json")      == 0) JSONPath      = Value;
+        else if (strcmp(Args[ArgIdx], "--meshes")    == 0) MeshCount     = Number;
+        else if (strcmp(Args[ArgIdx], "--triangles") == 0) TriangleCount = Number;
+        else if (strcmp(Args[ArgIdx], "--materials") == 0) MaterialCount = Number;
+        else if (strcmp(Args[ArgIdx], "--entities")  == 0) EntityCount   = Number;
+        else if (strcmp(Args[ArgIdx], "--frames")    == 0) FrameCount    = Number;
+        else if (strcmp(Args[ArgIdx], "--warmup")    == 0) WarmupCount   = Number;
+        else FrameCount = 0;
+    }
+
+    // A generated scene must fit the scene, files are checked by what ends up drawn.
+
+    bool IsGenerated = ObjCount == 0;
+    bool IsValid     = !(ArgCount & 1) && FrameCount && EntityCount && ObjCount <= MAX_FRAME_OBJ_COUNT;
+
+    IsValid = IsValid && (!IsGenerated || (MeshCount && MeshCount * EntityCount <= MAX_ENTITY_COUNT && TriangleCount &&
+                                           MaterialCount && MaterialCount <= MAX_FRAME_MATERIAL_COUNT));
+
+    if (!IsValid)
+    {
+        fprintf(stderr, "usage: adb-bench frame [--obj <file>]... [--meshes N] [--triangles N] [--materials 1..%d] "
+                        "[--entities N] [--frames N] [--warmup N] [--json <file>]\n"
+                        "at most %d entities in all, meshes times entities\n", MAX_FRAME_MATERIAL_COUNT, MAX_ENTITY_COUNT);
+        return 2;
+    }
+
+    (void)EngineMemory;
+
+    engine_memory Memory = OSCreateEngineMemory(0);
+
+    if (IsGenerated)
+    {
+        memory_region Region = EnterMemoryRegion(Memory.FrameMemory);
+
+        obj_scene_params Scene = {MeshCount, TriangleCount, 3, MaterialCount, ObjFace_Full, ObjFloat_Short};
+
+        if (!GenerateObjScene(Scene, FRAME_SCENE_DIRECTORY, "scene", 0, Memory.FrameMemory))
+        {
+            fprintf(stderr, "adb-bench: could not write the scene to %s/\n", FRAME_SCENE_DIRECTORY);
+            return 1;
+        }
+
+        LeaveMemoryRegion(Region);
+
+        ObjPaths[ObjCount++] = FRAME_SCENE_DIRECTORY "/scene.obj";
+    }
+
+    renderer *Renderer = PushStruct(Memory.StateMemory, renderer);
+    memset(Renderer, 0, sizeof(renderer));
+
+    Renderer->Backend        = NullInitialize(Memory.StateMemory);
+    Renderer->Resources      = CreateResourceManager(Memory.StateMemory);
+    Renderer->ReferenceTable = CreateResourceReferenceTable(Memory.StateMemory);
+
+    byte_string *Paths = PushArray(Memory.StateMemory, byte_string, ObjCount);
+    double      *Times = PushArray(Memory.StateMemory, double, FrameCount);
+
+    for (uint32_t ObjIdx = 0; ObjIdx < ObjCount; ++ObjIdx)
+    {
+        Paths[ObjIdx] = ByteString((uint8_t *)ObjPaths[ObjIdx], strlen(ObjPaths[ObjIdx]));
+    }
+
+    // The import, as the first frame would do it.
+
+    uint64_t StateBefore  = GetArenaPosition(Memory.StateMemory);
+    uint64_t ImportStart  = OSReadTimer();
+
+    engine_scene_params Params = {Paths, ObjCount, EntityCount};
+    LoadEngineScene(Params, Renderer, &Memory);
+
+    double   ImportMs     = GetElapsedMs(ImportStart, OSReadTimer());
+    uint64_t ImportState  = GetArenaPosition(Memory.StateMemory) - StateBefore;
+    uint64_t ImportFrame  = GetArenaPosition(Memory.FrameMemory);
+
+    PopArenaTo(Memory.FrameMemory, 0);
+
+    uint64_t FrameBase     = GetArenaPosition(Memory.FrameMemory);
+    uint64_t FrameBytesMin = UINT64_MAX;
+    uint64_t FrameBytesMax = 0;
+    double   FirstFrameMs  = 0.0;
+
+    for (uint32_t Frame = 0; Frame < WarmupCount + FrameCount; ++Frame)
+    {
+        uint64_t FrameStart = OSReadTimer();
+
+        UpdateEngine(FRAME_VIEW_WIDTH, FRAME_VIEW_HEIGHT, Renderer, &Memory);
+
+        double   FrameMs    = GetElapsedMs(FrameStart, OSReadTimer());
+        uint64_t FrameBytes = GetArenaPosition(Memory.FrameMemory) - FrameBase;
+
+        PopArenaTo(Memory.FrameMemory, 0);
+
+        FirstFrameMs = Frame == 0 ? FrameMs : FirstFrameMs;
+
+        if (Frame >= WarmupCount)
+        {
+            Times[Frame - WarmupCount] = FrameMs;
+            FrameBytesMin = Minimum(FrameBytesMin, FrameBytes);
+            FrameBytesMax = Maximum(FrameBytesMax, FrameBytes);
+        }
+    }
+
+    frame_timing     Timing = SummarizeFrameTimes(Times, FrameCount);
+    null_frame_stats Stats  = GetNullFrameStats((null_renderer *)Renderer->Backend);
+
+    printf("%u obj files, %u entities per mesh, %u frames after %u warmup\n\n", ObjCount, EntityCount, FrameCount, WarmupCount);
+    printf("import       %10.3f ms, %.1f KiB state, %.1f KiB frame arena\n", ImportMs, (double)ImportState / 1024.0, (double)ImportFrame / 1024.0);
+    printf("first frame  %10.3f ms\n", FirstFrameMs);
+    printf("frame ms     %10s %10s %10s %10s %10s\n", "mean", "median", "p90", "p99", "max");
+    printf("             %10.4f %10.4f %10.4f %10.4f %10.4f\n", Timing.Mean, Timing.Median, Timing.P90, Timing.P99, Timing.Max);
+    printf("frame arena  %10llu to %llu bytes\n", (unsigned long long)FrameBytesMin, (unsigned long long)FrameBytesMax);
+    printf("last frame   %u draws, %llu vertices, %u batches, %u groups, %u binds, %u state changes, %llu bytes uploaded\n",
+           Stats.DrawCount, (unsigned long long)Stats.VertexCount, Stats.BatchCount, Stats.GroupCount, Stats.BindCount,
+           Stats.StateChangeCount, (unsigned long long)Stats.UploadedBytes);
+
+    int Result = Stats.DrawCount ? 0 : 1;
+
+    if (!Stats.DrawCount)
+    {
+        fprintf(stderr, "adb-bench: nothing was drawn, the scene did not load\n");
+    }
+
+    if (JSONPath)
+    {
+        bench_text JSON = CreateBenchText(KiB(4) + (uint64_t)ObjCount * 1024, Memory.StateMemory);
+
+        AppendBenchText(&JSON, "{\n  \"benchmark\": \"frame\",\n  \"obj\": [");
+        for (uint32_t ObjIdx = 0; ObjIdx < ObjCount; ++ObjIdx)
+        {
+            AppendBenchText(&JSON, ObjIdx ? ", " : "");
+            AppendJSONString(&JSON, ObjPaths[ObjIdx]);
+        }
+        AppendBenchText(&JSON, "],\n");
+
+        AppendBenchText(&JSON, "  \"entities_per_mesh\": %u,\n  \"frames\": %u,\n  \"warmup\": %u,\n", EntityCount, FrameCount, WarmupCount);
+        AppendBenchText(&JSON, "  \"import_ms\": %.4f,\n  \"import_state_bytes\": %llu,\n  \"import_frame_bytes\": %llu,\n",
+                        ImportMs, (unsigned long long)ImportState, (unsigned long long)ImportFrame);
+        AppendBenchText(&JSON, "  \"first_frame_ms\": %.4f,\n", FirstFrameMs);
+        AppendBenchText(&JSON, "  \"frame_ms\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+                        Timing.Mean, Timing.Median, Timing.P90, Timing.P99, Timing.Max);
+        AppendBenchText(&JSON, "  \"frame_arena_bytes\": {\"min\": %llu, \"max\": %llu},\n",
+                        (unsigned long long)FrameBytesMin, (unsigned long long)FrameBytesMax);
+        AppendBenchText(&JSON, "  \"draws\": %u,\n  \"vertices\": %llu,\n  \"batches\": %u,\n  \"groups\": %u,\n  \"passes\": %u,\n",
+                        Stats.DrawCount, (unsigned long long)Stats.VertexCount, Stats.BatchCount, Stats.GroupCount, Stats.PassCount);
+        AppendBenchText(&JSON, "  \"binds\": %u,\n  \"state_changes\": %u,\n  \"uploaded_bytes\": %llu\n}\n",
+                        Stats.BindCount, Stats.StateChangeCount, (unsigned long long)Stats.UploadedBytes);
+
+        if (!JSON.Data || !WriteBenchText(JSONPath, &JSON))
+        {
+            fprintf(stderr, "adb-bench: could not write %s\n", JSONPath);
+            Result = 1;
+        }
+    }
+
+    return Result;
+}
\ No newline at end of file
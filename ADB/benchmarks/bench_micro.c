@@ -0,0 +1,698 @@
+// adb-bench micro [--filter <text>] [--runs N] [--warmup N] [--min-ms N] [--cpu N] [--save <file>] [--baseline <file>] [--threshold %]
+//
+// Times the primitives every load goes through, one case at a time on this thread: arena pushes,
+// hashing, string compares and joins from utilities.c, the buffer parsing the OBJ parser is built
+// from, and ParseObjFromFile itself over generated files (bench_obj.c) that vary the polygon size,
+// the face format and how floats are written. The files go to bench_micro/, parsing them includes
+// reading them back, from the page cache after the first time.
+//
+// An operation is what a case repeats: a push, a string, a value, a face of a file.
+//
+// Every case first doubles how often it runs per sample until a sample takes --min-ms, which also
+// warms it up, then runs --warmup more samples that are thrown away and --runs that are kept.
+// Reported are the median and the best time per operation, the spread as the median absolute
+// deviation relative to the median, and the throughput where a case goes through bytes. The thread
+// is pinned to processor --cpu first (0 by default, -1 leaves it alone), so that runs do not
+// migrate between cores halfway.
+//
+// --filter keeps the cases whose name contains the text, in any case, and fails when there are none.
+// --save writes the medians as CSV. --baseline reads such a file back and compares: a case whose
+// median got slower by more than --threshold percent (5 by default) and by more than three times
+// the spread of both runs counts as a regression, and the exit code is 1 when there is one.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "parsers/parser_obj.h"
+#include "bench.h"
+
+#define MICRO_OBJ_DIRECTORY     "bench_micro"
+#define MICRO_VALUE_COUNT       4096
+#define MAX_MICRO_RUN_COUNT     1024
+#define MAX_MICRO_BASELINE_COUNT 256
+
+// ==============================================
+// <Micro Benchmark> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    engine_memory *EngineMemory;
+    memory_arena  *Arena;         // Scratch for the cases that allocate, popped after every call.
+
+    byte_string   *Strings;
+    byte_string   *Others;
+    uint32_t       StringCount;
+    buffer         Text;
+    char           ObjPath[256];
+
+    uint64_t       OpCount;       // Per call.
+    uint64_t       ByteCount;     // Per call, 0 when the case is not about bytes.
+} micro_input;
+
+
+typedef bool     micro_setup(micro_input *Input, uint32_t Variant);
+typedef uint64_t micro_function(micro_input *Input);
+
+
+typedef struct
+{
+    const char     *Name;
+    micro_setup    *Setup;
+    micro_function *Function;
+    uint32_t        Variant;
+} micro_case;
+
+
+typedef struct
+{
+    double Median;    // Nanoseconds per operation.
+    double Min;
+    double Spread;    // Median absolute deviation.
+} micro_result;
+
+
+typedef struct
+{
+    char   Name[64];
+    double Median;
+    double Spread;
+} micro_baseline;
+
+
+// Whatever the cases compute goes here, so that the compiler cannot drop the work.
+static volatile uint64_t MicroSink;
+
+
+static uint32_t
+NextMicroRandom(uint32_t *State)
+{
+    *State = *State * 1664525u + 1013904223u;
+
+    uint32_t Result = *State >> 8;
+    return Result;
+}
+
+
+static byte_string
+PushMicroString(uint32_t Size, uint32_t *Random, memory_arena *Arena)
+{
+    byte_string Result = ByteString(PushArray(Arena, uint8_t, Size + 1), Size);
+
+    for (uint32_t Idx = 0; Result.Data && Idx < Size; ++Idx)
+    {
+        Result.Data[Idx] = (uint8_t)('a' + NextMicroRandom(Random) % 26);
+    }
+
+    return Result;
+}
+
+
+// Text made of MICRO_VALUE_COUNT values and the whitespace between them, null-terminated.
+
+static buffer
+PushMicroText(micro_input *Input, const char *Format, uint32_t Variant)
+{
+    uint64_t  Capacity = MICRO_VALUE_COUNT * 32 + 1;
+    char     *Data     = PushArray(Input->EngineMemory->StateMemory, char, Capacity);
+    uint64_t  Size     = 0;
+    uint32_t  Random   = 0x4D494352u + Variant;
+
+    for (uint32_t Idx = 0; Data && Idx < MICRO_VALUE_COUNT; ++Idx)
+    {
+        float    Value = ((float)NextMicroRandom(&Random) / (float)(1 << 24) - 0.5f) * 200.f;
+        uint32_t Index = NextMicroRandom(&Random) % 1000000 + 1;
+
+        Size += Format ? snprintf(Data + Size, Capacity - Size, Format, Value)
+                       : snprintf(Data + Size, Capacity - Size, "%u", Index);
+        Size += snprintf(Data + Size, Capacity - Size, Idx % 3 == 2 ? "\n" : " ");
+    }
+
+    buffer Result = {(uint8_t *)Data, Data ? Size : 0, 0};
+    return Result;
+}
+
+
+static bool
+SetupArenaCase(micro_input *Input, uint32_t Variant)
+{
+    Input->OpCount   = 1024;
+    Input->ByteCount = 0;
+
+    (void)Variant;
+    return true;
+}
+
+
+static uint64_t
+PushArenaCase(micro_input *Input)
+{
+    memory_region Region = EnterMemoryRegion(Input->Arena);
+    uint64_t      Result = 0;
+
+    for (uint32_t Idx = 0; Idx < Input->OpCount; ++Idx)
+    {
+        Result += (uint64_t)(uintptr_t)PushArena(Input->Arena, 64, 8);
+    }
+
+    LeaveMemoryRegion(Region);
+    return Result;
+}
+
+
+// Variant is the string length. Others differ from Strings in the last byte only, the worst case
+// for a compare that has to get there.
+
+static bool
+SetupStringCase(micro_input *Input, uint32_t Variant)
+{
+    memory_arena *Arena  = Input->EngineMemory->StateMemory;
+    uint32_t      Random = 0x53545247u + Variant;
+
+    Input->StringCount = 256;
+    Input->Strings     = PushArray(Arena, byte_string, Input->StringCount);
+    Input->Others      = PushArray(Arena, byte_string, Input->StringCount);
+
+    for (uint32_t Idx = 0; Input->Strings && Input->Others && Idx < Input->StringCount; ++Idx)
+    {
+        Input->Strings[Idx] = PushMicroString(Variant, &Random, Arena);
+        Input->Others[Idx]  = ByteStringCopy(Input->Strings[Idx], Arena);
+
+        if (Input->Others[Idx].Data)
+        {
+            Input->Others[Idx].Data[Variant - 1] ^= 1;
+        }
+    }
+
+    Input->OpCount   = Input->StringCount;
+    Input->ByteCount = (uint64_t)Input->StringCount * Variant;
+
+    bool Result = Input->Strings && Input->Others;
+    return Result;
+}
+
+
+static uint64_t
+HashStringsCase(micro_input *Input)
+{
+    uint64_t Result = 0;
+
+    for (uint32_t Idx = 0; Idx < Input->StringCount; ++Idx)
+    {
+        Result ^= HashByteString(Input->Strings[Idx]);
+    }
+
+    return Result;
+}
+
+
+static uint64_t
+CompareStringsCase(micro_input *Input)
+{
+    uint64_t Result = 0;
+
+    for (uint32_t Idx = 0; Idx < Input->StringCount; ++Idx)
+    {
+        Result += ByteStringCompare(Input->Strings[Idx], Input->Others[Idx]) ? 1 : 0;
+    }
+
+    return Result;
+}
+
+
+static bool
+SetupConcatenateCase(micro_input *Input, uint32_t Variant)
+{
+    bool Result = SetupStringCase(Input, Variant);
+
+    Input->OpCount   = Input->StringCount - 2;
+    Input->ByteCount = Input->OpCount * 3 * Variant;
+
+    return Result;
+}
+
+
+// The way resource names are put together: a path, a mesh name and a part, joined by "::".
+
+static uint64_t
+ConcatenateStringsCase(micro_input *Input)
+{
+    memory_region Region = EnterMemoryRegion(Input->Arena);
+    uint64_t      Result = 0;
+
+    for (uint32_t Idx = 0; Idx < Input->OpCount; ++Idx)
+    {
+        byte_string Joined = ConcatenateStrings(Input->Strings + Idx, 3, ByteStringLiteral("::"), Input->Arena);
+        Result += Joined.Size;
+    }
+
+    LeaveMemoryRegion(Region);
+    return Result;
+}
+
+
+static const char *MicroFloatFormats[ObjFloat_Count] = {"%.4f", "%.9f", "%.6e"};
+
+
+static bool
+SetupFloatCase(micro_input *Input, uint32_t Variant)
+{
+    Input->Text      = PushMicroText(Input, MicroFloatFormats[Variant], Variant);
+    Input->OpCount   = MICRO_VALUE_COUNT;
+    Input->ByteCount = Input->Text.Size;
+
+    bool Result = Input->Text.Size != 0;
+    return Result;
+}
+
+
+static bool
+SetupNumberCase(micro_input *Input, uint32_t Variant)
+{
+    Input->Text      = PushMicroText(Input, 0, Variant);
+    Input->OpCount   = MICRO_VALUE_COUNT;
+    Input->ByteCount = Input->Text.Size;
+
+    bool Result = Input->Text.Size != 0;
+    return Result;
+}
+
+
+static uint64_t
+ParseFloatsCase(micro_input *Input)
+{
+    buffer Text   = Input->Text;
+    float  Result = 0.f;
+
+    for (uint32_t Idx = 0; Idx < MICRO_VALUE_COUNT; ++Idx)
+    {
+        SkipWhitespaces(&Text);
+        Result += ParseToFloat(&Text);
+    }
+
+    return (uint64_t)Result;
+}
+
+
+static uint64_t
+ParseNumbersCase(micro_input *Input)
+{
+    buffer Text   = Input->Text;
+    float  Result = 0.f;
+
+    for (uint32_t Idx = 0; Idx < MICRO_VALUE_COUNT; ++Idx)
+    {
+        SkipWhitespaces(&Text);
+        Result += ParseToNumber(&Text);
+    }
+
+    return (uint64_t)Result;
+}
+
+
+// Runs of 1 to Variant blanks, tabs and spaces mixed, each followed by one other character.
+
+static bool
+SetupWhitespaceCase(micro_input *Input, uint32_t Variant)
+{
+    uint64_t  Capacity = (uint64_t)MICRO_VALUE_COUNT * (Variant + 1) + 1;
+    uint8_t  *Data     = PushArray(Input->EngineMemory->StateMemory, uint8_t, Capacity);
+    uint64_t  Size     = 0;
+    uint32_t  Random   = 0x57485445u;
+
+    for (uint32_t Idx = 0; Data && Idx < MICRO_VALUE_COUNT; ++Idx)
+    {
+        uint32_t RunLength = NextMicroRandom(&Random) % Variant + 1;
+
+        for (uint32_t Blank = 0; Blank < RunLength; ++Blank)
+        {
+            Data[Size++] = NextMicroRandom(&Random) & 1 ? ' ' : '\t';
+        }
+
+        Data[Size++] = 'x';
+    }
+
+    Input->Text      = (buffer){Data, Data ? Size : 0, 0};
+    Input->OpCount   = MICRO_VALUE_COUNT;
+    Input->ByteCount = Size;
+
+    bool Result = Data != 0;
+    return Result;
+}
+
+
+static uint64_t
+SkipWhitespacesCase(micro_input *Input)
+{
+    buffer Text = Input->Text;
+
+    for (uint32_t Idx = 0; Idx < MICRO_VALUE_COUNT; ++Idx)
+    {
+        SkipWhitespaces(&Text);
+        ++Text.At;
+    }
+
+    return Text.At;
+}
+
+
+// The files parsed, by variant: polygon sides, face format and float format. 20 meshes of 2000
+// faces each, whatever their size.
+
+static const obj_scene_params MicroObjScenes[] =
+{
+    {20, 2000, 3, 4, ObjFace_Full,            ObjFloat_Short},
+    {20, 2000, 4, 4, ObjFace_Full,            ObjFloat_Short},
+    {20, 2000, 8, 4, ObjFace_Full,            ObjFloat_Short},
+    {20, 2000, 3, 4, ObjFace_Position,        ObjFloat_Short},
+    {20, 2000, 3, 4, ObjFace_PositionTexture, ObjFloat_Short},
+    {20, 2000, 3, 4, ObjFace_PositionNormal,  ObjFloat_Short},
+    {20, 2000, 3, 4, ObjFace_Full,            ObjFloat_Long},
+    {20, 2000, 3, 4, ObjFace_Full,            ObjFloat_Exponent},
+};
+
+
+static bool
+SetupObjCase(micro_input *Input, uint32_t Variant)
+{
+    char Name[32];
+    snprintf(Name, sizeof(Name), "scene_%u", Variant);
+    snprintf(Input->ObjPath, sizeof(Input->ObjPath), "%s/%s.obj", MICRO_OBJ_DIRECTORY, Name);
+
+    uint64_t Size   = 0;
+    bool     Result = GenerateObjScene(MicroObjScenes[Variant], MICRO_OBJ_DIRECTORY, Name, &Size, Input->EngineMemory->StateMemory);
+
+    Input->OpCount   = MicroObjScenes[Variant].MeshCount * MicroObjScenes[Variant].PolygonCount;
+    Input->ByteCount = Size;
+
+    return Result;
+}
+
+
+static uint64_t
+ParseObjCase(micro_input *Input)
+{
+    memory_region Region = EnterMemoryRegion(Input->EngineMemory->FrameMemory);
+
+    asset_file_data Data = ParseObjFromFile(ByteString((uint8_t *)Input->ObjPath, strlen(Input->ObjPath)), ObjParseFlag_SkipTextures, Input->EngineMemory);
+
+    LeaveMemoryRegion(Region);
+    return Data.VertexCount;
+}
+
+
+static const micro_case MicroCases[] =
+{
+    {"arena_push_64",         SetupArenaCase,       PushArenaCase,          0},
+    {"hash_16",               SetupStringCase,      HashStringsCase,        16},
+    {"hash_256",              SetupStringCase,      HashStringsCase,        256},
+    {"compare_16",            SetupStringCase,      CompareStringsCase,     16},
+    {"compare_256",           SetupStringCase,      CompareStringsCase,     256},
+    {"concatenate_3x32",      SetupConcatenateCase, ConcatenateStringsCase, 32},
+    {"parse_float_short",     SetupFloatCase,       ParseFloatsCase,        ObjFloat_Short},
+    {"parse_float_long",      SetupFloatCase,       ParseFloatsCase,        ObjFloat_Long},
+    {"parse_float_exponent",  SetupFloatCase,       ParseFloatsCase,        ObjFloat_Exponent},
+    {"parse_number",          SetupNumberCase,      ParseNumbersCase,       0},
+    {"skip_whitespace_1to4",  SetupWhitespaceCase,  SkipWhitespacesCase,    4},
+    {"skip_whitespace_1to32", SetupWhitespaceCase,  SkipWhitespacesCase,    32},
+    {"obj_triangles",         SetupObjCase,         ParseObjCase,           0},
+    {"obj_quads",             SetupObjCase,         ParseObjCase,           1},
+    {"obj_octagons",          SetupObjCase,         ParseObjCase,           2},
+    {"obj_faces_v",           SetupObjCase,         ParseObjCase,           3},
+    {"obj_faces_v_vt",        SetupObjCase,         ParseObjCase,           4},
+    {"obj_faces_v_vn",        SetupObjCase,         ParseObjCase,           5},
+    {"obj_floats_long",       SetupObjCase,         ParseObjCase,           6},
+    {"obj_floats_exponent",   SetupObjCase,         ParseObjCase,           7},
+};
+
+
+// Nanoseconds per operation for one sample of CallCount calls.
+
+static double
+SampleMicroCase(const micro_case *Case, micro_input *Input, uint64_t CallCount)
+{
+    uint64_t Sink  = 0;
+    uint64_t Start = OSReadTimer();
+
+    for (uint64_t Call = 0; Call < CallCount; ++Call)
+    {
+        Sink += Case->Function(Input);
+    }
+
+    double Ms = GetElapsedMs(Start, OSReadTimer());
+
+    MicroSink += Sink;
+
+    double Result = Ms * 1e6 / (double)(CallCount * Input->OpCount);
+    return Result;
+}
+
+
+static int
+CompareMicroSamples(const void *A, const void *B)
+{
+    double X = *(const double *)A;
+    double Y = *(const double *)B;
+
+    int Result = (X > Y) - (X < Y);
+    return Result;
+}
+
+
+static micro_result
+SummarizeMicroSamples(double *Samples, uint32_t Count)
+{
+    micro_result Result    = {0};
+    double       Deviation[MAX_MICRO_RUN_COUNT];
+
+    qsort(Samples, Count, sizeof(double), CompareMicroSamples);
+
+    Result.Median = Samples[Count / 2];
+    Result.Min    = Samples[0];
+
+    for (uint32_t Idx = 0; Idx < Count; ++Idx)
+    {
+        Deviation[Idx] = fabs(Samples[Idx] - Result.Median);
+    }
+
+    qsort(Deviation, Count, sizeof(double), CompareMicroSamples);
+    Result.Spread = Deviation[Count / 2];
+
+    return Result;
+}
+
+
+// Whether Filter appears anywhere in Name, ignoring case. No filter matches every case.
+
+static bool
+MatchesMicroFilter(const char *Name, const char *Filter)
+{
+    bool Result = !Filter || !*Filter;
+
+    for (const char *Start = Name; !Result && *Start; ++Start)
+    {
+        uint32_t Idx = 0;
+        while (Filter[Idx] && Start[Idx] && tolower((unsigned char)Start[Idx]) == tolower((unsigned char)Filter[Idx]))
+        {
+            ++Idx;
+        }
+
+        Result = Filter[Idx] == '\0';
+    }
+
+    return Result;
+}
+
+
+// name,median_ns,min_ns,spread_ns per line after a header, see WriteMicroResults.
+
+static uint32_t
+ReadMicroBaseline(const char *Path, micro_baseline *Baseline, memory_arena *Arena)
+{
+    memory_region Region = EnterMemoryRegion(Arena);
+    buffer        File   = ReadFileInBuffer(ByteString((uint8_t *)Path, strlen(Path)), Arena);
+    uint32_t      Count  = 0;
+
+    for (char *Line = IsBufferValid(&File) ? (char *)File.Data : 0; Line && *Line && Count < MAX_MICRO_BASELINE_COUNT;)
+    {
+        char   *End  = strchr(Line, '\n');
+        double  Min  = 0.0;
+
+        micro_baseline *Entry = Baseline + Count;
+
+        if (sscanf(Line, "%63[^,],%lf,%lf,%lf", Entry->Name, &Entry->Median, &Min, &Entry->Spread) == 4)
+        {
+            ++Count;
+        }
+
+        Line = End ? End + 1 : 0;
+    }
+
+    LeaveMemoryRegion(Region);
+    return Count;
+}
+
+// ==============================================
+// <Micro Benchmark> : PUBLIC
+// ==============================================
+
+
+int
+RunMicroBenchmark(int ArgCount, char **Args, engine_memory *EngineMemory)
+{
+    char    *Filter       = 0;
+    char    *SavePath     = 0;
+    char    *BaselinePath = 0;
+    uint32_t RunCount     = 15;
+    uint32_t WarmupCount  = 3;
+    uint32_t MinMs        = 5;
+    int      Processor    = 0;
+    double   Threshold    = 5.0;
+
+    for (int ArgIdx = 0; ArgIdx + 1 < ArgCount; ArgIdx += 2)
+    {
+        char *Value = Args[ArgIdx + 1];
+
+        if      (strcmp(Args[ArgIdx], "--filter")    == 0) Filter       = Value;
+        else if (strcmp(Args[ArgIdx], "--save")      == 0) SavePath     = Value;
+        else if (strcmp(Args[ArgIdx], "--baseline")  == 0) BaselinePath = Value;
+        else if (strcmp(Args[ArgIdx], "--runs")      == 0) RunCount     = (uint32_t)atoi(Value);
+        else if (strcmp(Args[ArgIdx], "--warmup")    == 0) WarmupCount  = (uint32_t)atoi(Value);
+        else if (strcmp(Args[ArgIdx], "--min-ms")    == 0) MinMs        = (uint32_t)atoi(Value);
+        else if (strcmp(Args[ArgIdx], "--cpu")       == 0) Processor    = atoi(Value);
+        else if (strcmp(Args[ArgIdx], "--threshold") == 0) Threshold    = atof(Value);
+        else RunCount = 0;
+    }
+
+    if ((ArgCount & 1) || RunCount == 0 || RunCount > MAX_MICRO_RUN_COUNT || MinMs == 0)
+    {
+        fprintf(stderr, "usage: adb-bench micro [--filter <text>] [--runs 1..%d] [--warmup N] [--min-ms N] [--cpu N] "
+                        "[--save <file>] [--baseline <file>] [--threshold %%]\n", MAX_MICRO_RUN_COUNT);
+        return 2;
+    }
+
+    uint32_t MatchCount = 0;
+
+    for (uint32_t CaseIdx = 0; CaseIdx < ArrayCount(MicroCases); ++CaseIdx)
+    {
+        MatchCount += MatchesMicroFilter(MicroCases[CaseIdx].Name, Filter) ? 1 : 0;
+    }
+
+    if (!MatchCount)
+    {
+        fprintf(stderr, "adb-bench: no case matches --filter %s\n", Filter);
+        return 2;
+    }
+
+    micro_baseline Baseline[MAX_MICRO_BASELINE_COUNT];
+    uint32_t       BaselineCount = 0;
+
+    if (BaselinePath)
+    {
+        BaselineCount = ReadMicroBaseline(BaselinePath, Baseline, EngineMemory->FrameMemory);
+        if (!BaselineCount)
+        {
+            fprintf(stderr, "adb-bench: no results in %s\n", BaselinePath);
+            return 1;
+        }
+    }
+
+    if (Processor >= 0 && !OSPinThread((uint32_t)Processor))
+    {
+        fprintf(stderr, "adb-bench: could not pin to processor %d, running unpinned\n", Processor);
+    }
+
+    memory_arena_params ArenaParams = {.ReserveSize = MiB(64), .CommitSize = KiB(64), .AllocatedFromFile = __FILE__, .AllocatedFromLine = __LINE__};
+
+    bench_text    Saved      = CreateBenchText(ArrayCount(MicroCases) * 128 + 64, EngineMemory->StateMemory);
+    double       *Samples    = PushArray(EngineMemory->StateMemory, double, RunCount);
+    memory_arena *Scratch    = AllocateArena(ArenaParams);
+    uint32_t      Regressed  = 0;
+
+    AppendBenchText(&Saved, "name,median_ns,min_ns,spread_ns\n");
+
+    printf("%u runs of at least %u ms after %u warmup, processor %d\n\n", RunCount, MinMs, WarmupCount, Processor);
+    printf("%-24s %12s %12s %8s %10s %10s\n", "case", "median ns", "min ns", "spread", "MB/s", "baseline");
+
+    for (uint32_t CaseIdx = 0; CaseIdx < ArrayCount(MicroCases); ++CaseIdx)
+    {
+        const micro_case *Case  = MicroCases + CaseIdx;
+        micro_input       Input = {.EngineMemory = EngineMemory, .Arena = Scratch};
+
+        if (!MatchesMicroFilter(Case->Name, Filter))
+        {
+            continue;
+        }
+
+        if (!Case->Setup(&Input, Case->Variant))
+        {
+            fprintf(stderr, "adb-bench: could not set up %s\n", Case->Name);
+            return 1;
+        }
+
+        // Grow the sample until it takes long enough for the timer, that is the warmup as well.
+
+        uint64_t CallCount = 1;
+        while (SampleMicroCase(Case, &Input, CallCount) * (double)(CallCount * Input.OpCount) < MinMs * 1e6 && CallCount < (1ull << 40))
+        {
+            CallCount *= 2;
+        }
+
+        for (uint32_t Run = 0; Run < WarmupCount; ++Run)
+        {
+            SampleMicroCase(Case, &Input, CallCount);
+        }
+
+        for (uint32_t Run = 0; Run < RunCount; ++Run)
+        {
+            Samples[Run] = SampleMicroCase(Case, &Input, CallCount);
+        }
+
+        micro_result Result     = SummarizeMicroSamples(Samples, RunCount);
+        double       MBPerSec   = Input.ByteCount ? (double)Input.ByteCount / (double)Input.OpCount / Result.Median * 1e9 / (1024.0 * 1024.0) : 0.0;
+        char         Compare[32] = "";
+
+        for (uint32_t Idx = 0; Idx < BaselineCount; ++Idx)
+        {
+            if (strcmp(Baseline[Idx].Name, Case->Name) == 0)
+            {
+                double Change = (Result.Median - Baseline[Idx].Median) / Baseline[Idx].Median * 100.0;
+                bool   Slower = Change > Threshold && Result.Median - Baseline[Idx].Median > 3.0 * (Result.Spread + Baseline[Idx].Spread);
+
+                snprintf(Compare, sizeof(Compare), "%+.1f%%%s", Change, Slower ? " SLOWER" : "");
+                Regressed += Slower ? 1 : 0;
+            }
+        }
+
+        printf("%-24s %12.3f %12.3f %7.1f%% %10.1f %10s\n", Case->Name, Result.Median, Result.Min, Result.Spread / Result.Median * 100.0,
+               MBPerSec, Compare);
+
+        AppendBenchText(&Saved, "%s,%.6f,%.6f,%.6f\n", Case->Name, Result.Median, Result.Min, Result.Spread);
+    }
+
+    ReleaseArena(Scratch);
+
+    int Result = 0;
+
+    if (BaselinePath)
+    {
+        printf("\n%u cases slower than %s\n", Regressed, BaselinePath);
+        Result = Regressed ? 1 : 0;
+    }
+
+    if (SavePath && !WriteBenchText(SavePath, &Saved))
+    {
+        fprintf(stderr, "adb-bench: could not write %s\n", SavePath);
+        Result = 1;
+    }
+
+    return Result;
+}
\ No newline at end of file
@@ -0,0 +1,242 @@
+// Synthetic OBJ/MTL scenes for the benchmarks that parse or load them, see obj_scene_params in
+// bench.h. The output only depends on the parameters.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "bench.h"
+
+// ==============================================
+// <OBJ Generator> : INTERNAL
+// ==============================================
+
+
+static const char *ObjFloatFormats[ObjFloat_Count] =
+{
+    [ObjFloat_Short]    = "%.4f",
+    [ObjFloat_Long]     = "%.9f",
+    [ObjFloat_Exponent] = "%.6e",
+};
+
+
+// Longest a line gets for one vertex, position and texture coordinate, and for one face corner.
+
+#define OBJ_VERTEX_LINE_SIZE 112
+#define OBJ_CORNER_SIZE      36
+
+
+static void
+AppendObjVertex(bench_text *Obj, ObjFloat_Type Floats, float X, float Y, float U, float V)
+{
+    float Values[5] = {X, Y, (U - V) * 0.5f, U, V};
+
+    AppendBenchText(Obj, "v");
+
+    for (uint32_t Idx = 0; Idx < ArrayCount(Values); ++Idx)
+    {
+        AppendBenchText(Obj, Idx == 3 ? "\nvt " : " ");
+        AppendBenchText(Obj, ObjFloatFormats[Floats], Values[Idx]);
+    }
+
+    AppendBenchText(Obj, "\n");
+}
+
+
+static void
+AppendObjCorner(bench_text *Obj, ObjFace_Type Faces, uint32_t Index)
+{
+    switch (Faces)
+    {
+
+    case ObjFace_Position:        AppendBenchText(Obj, " %u", Index);               break;
+    case ObjFace_PositionTexture: AppendBenchText(Obj, " %u/%u", Index, Index);     break;
+    case ObjFace_PositionNormal:  AppendBenchText(Obj, " %u//1", Index);            break;
+    default:                      AppendBenchText(Obj, " %u/%u/1", Index, Index);   break;
+
+    }
+}
+
+
+// Triangles and quads: a grid of cells, a quad per cell or two triangles. Base is the index of the
+// mesh's first vertex.
+
+static void
+AppendObjGrid(bench_text *Obj, obj_scene_params *Params, uint32_t MeshIdx, uint32_t Base)
+{
+    uint32_t CellCount   = Params->SideCount == 3 ? (Params->PolygonCount + 1) / 2 : Params->PolygonCount;
+    uint32_t ColumnCount = (uint32_t)ceil(sqrt((double)CellCount));
+    uint32_t RowCount    = (CellCount + ColumnCount - 1) / ColumnCount;
+
+    for (uint32_t Row = 0; Row <= RowCount; ++Row)
+    {
+        for (uint32_t Column = 0; Column <= ColumnCount; ++Column)
+        {
+            float U = (float)Column / (float)ColumnCount;
+            float V = (float)Row    / (float)RowCount;
+
+            AppendObjVertex(Obj, Params->Floats, U * 7.37f - 3.5f, V * 7.37f - 3.5f + (float)MeshIdx * 8.f, U, V);
+        }
+    }
+
+    AppendBenchText(Obj, "usemtl material_%u\n", MeshIdx % Params->MaterialCount);
+
+    for (uint32_t Polygon = 0; Polygon < Params->PolygonCount; ++Polygon)
+    {
+        uint32_t Cell   = Params->SideCount == 3 ? Polygon / 2 : Polygon;
+        uint32_t Corner = Base + (Cell / ColumnCount) * (ColumnCount + 1) + Cell % ColumnCount;
+        uint32_t Quad[4] = {Corner, Corner + 1, Corner + ColumnCount + 2, Corner + ColumnCount + 1};
+
+        AppendBenchText(Obj, "f");
+
+        if (Params->SideCount == 4)
+        {
+            for (uint32_t Idx = 0; Idx < 4; ++Idx)
+            {
+                AppendObjCorner(Obj, Params->Faces, Quad[Idx]);
+            }
+        }
+        else
+        {
+            uint32_t Half = Polygon & 1;
+
+            AppendObjCorner(Obj, Params->Faces, Quad[0]);
+            AppendObjCorner(Obj, Params->Faces, Quad[1 + Half]);
+            AppendObjCorner(Obj, Params->Faces, Quad[2 + Half]);
+        }
+
+        AppendBenchText(Obj, "\n");
+    }
+}
+
+
+// Every other polygon: a ring of SideCount vertices of its own, in cells of a grid.
+
+static void
+AppendObjRings(bench_text *Obj, obj_scene_params *Params, uint32_t MeshIdx, uint32_t Base)
+{
+    uint32_t ColumnCount = (uint32_t)ceil(sqrt((double)Params->PolygonCount));
+
+    for (uint32_t Polygon = 0; Polygon < Params->PolygonCount; ++Polygon)
+    {
+        float CenterX = (float)(Polygon % ColumnCount) * 1.13f;
+        float CenterY = (float)(Polygon / ColumnCount) * 1.13f + (float)MeshIdx * 1.13f * (float)ColumnCount;
+
+        for (uint32_t Side = 0; Side < Params->SideCount; ++Side)
+        {
+            float Angle = 6.2831853f * (float)Side / (float)Params->SideCount;
+            float U     = 0.5f + 0.5f * cosf(Angle);
+            float V     = 0.5f + 0.5f * sinf(Angle);
+
+            AppendObjVertex(Obj, Params->Floats, CenterX + U * 0.9f, CenterY + V * 0.9f, U, V);
+        }
+    }
+
+    AppendBenchText(Obj, "usemtl material_%u\n", MeshIdx % Params->MaterialCount);
+
+    for (uint32_t Polygon = 0; Polygon < Params->PolygonCount; ++Polygon)
+    {
+        AppendBenchText(Obj, "f");
+
+        for (uint32_t Side = 0; Side < Params->SideCount; ++Side)
+        {
+            AppendObjCorner(Obj, Params->Faces, Base + Polygon * Params->SideCount + Side);
+        }
+
+        AppendBenchText(Obj, "\n");
+    }
+}
+
+
+static uint32_t
+GetObjMeshVertexCount(obj_scene_params *Params)
+{
+    uint32_t Result = 0;
+
+    if (Params->SideCount <= 4)
+    {
+        uint32_t CellCount   = Params->SideCount == 3 ? (Params->PolygonCount + 1) / 2 : Params->PolygonCount;
+        uint32_t ColumnCount = (uint32_t)ceil(sqrt((double)CellCount));
+        uint32_t RowCount    = (CellCount + ColumnCount - 1) / ColumnCount;
+
+        Result = (ColumnCount + 1) * (RowCount + 1);
+    }
+    else
+    {
+        Result = Params->PolygonCount * Params->SideCount;
+    }
+
+    return Result;
+}
+
+// ==============================================
+// <OBJ Generator> : PUBLIC
+// ==============================================
+
+
+bool
+GenerateObjScene(obj_scene_params Params, const char *Directory, const char *Name, uint64_t *Size, memory_arena *Arena)
+{
+    bool     Result = false;
+    uint64_t Corner = (uint64_t)Params.MeshCount * Params.PolygonCount * (Params.SideCount - 2) * 3;
+
+    bool IsValid = Params.MeshCount && Params.PolygonCount && Params.MaterialCount                 &&
+                   Params.SideCount >= 3 && Params.SideCount <= MAX_GENERATED_OBJ_SIDE_COUNT      &&
+                   (uint32_t)Params.Faces < ObjFace_Count && (uint32_t)Params.Floats < ObjFloat_Count &&
+                   Corner <= MAX_GENERATED_OBJ_VERTEX_COUNT;
+
+    if (IsValid)
+    {
+        memory_region Region      = EnterMemoryRegion(Arena);
+        uint32_t      VertexCount = GetObjMeshVertexCount(&Params);
+        uint64_t      FaceSize    = (uint64_t)Params.PolygonCount * (Params.SideCount * OBJ_CORNER_SIZE + 4);
+        uint64_t      MeshSize    = (uint64_t)VertexCount * OBJ_VERTEX_LINE_SIZE + FaceSize + 128;
+        bench_text    Obj         = CreateBenchText(Params.MeshCount * MeshSize + 256, Arena);
+        bench_text    Mtl         = CreateBenchText((uint64_t)Params.MaterialCount * 128 + 64, Arena);
+
+        char ObjPath[512];
+        char MtlPath[512];
+        snprintf(ObjPath, sizeof(ObjPath), "%s/%s.obj", Directory, Name);
+        snprintf(MtlPath, sizeof(MtlPath), "%s/%s.mtl", Directory, Name);
+
+        for (uint32_t MaterialIdx = 0; MaterialIdx < Params.MaterialCount; ++MaterialIdx)
+        {
+            float Shade = (float)(MaterialIdx + 1) / (float)Params.MaterialCount;
+            AppendBenchText(&Mtl, "newmtl material_%u\nKd %.3f %.3f 0.500\nNs 32\nd 1\n\n", MaterialIdx, Shade, 1.f - Shade);
+        }
+
+        AppendBenchText(&Obj, "mtllib %s.mtl\nvn 0 0 -1\n", Name);
+
+        for (uint32_t MeshIdx = 0; MeshIdx < Params.MeshCount; ++MeshIdx)
+        {
+            uint32_t Base = MeshIdx * VertexCount + 1;
+
+            AppendBenchText(&Obj, "o mesh_%u\n", MeshIdx);
+
+            if (Params.SideCount <= 4)
+            {
+                AppendObjGrid(&Obj, &Params, MeshIdx, Base);
+            }
+            else
+            {
+                AppendObjRings(&Obj, &Params, MeshIdx, Base);
+            }
+        }
+
+        Result = OSCreateDirectory(ByteString((uint8_t *)Directory, strlen(Directory))) &&
+                 WriteBenchText(ObjPath, &Obj) && WriteBenchText(MtlPath, &Mtl);
+
+        if (Size)
+        {
+            *Size = Obj.Size;
+        }
+
+        LeaveMemoryRegion(Region);
+    }
+
+    return Result;
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+// adb-bench parallel [--count N] [--threads N] [--iterations N]
+//
+// Times ParallelFor and ParallelReduce (platform/parallel.h) on 1 thread, then 2, up to --threads
+// (one per logical processor by default). The threads are the caller plus that many workers minus
+// one: the queue is started once with every worker and each step lets the loops queue fewer jobs.
+//
+// The loop transforms --count points by a matrix, the way vertex assembly would, the reduction
+// computes their bounds. Both are checked against a plain loop over the same points. Each step
+// reports the best of --iterations runs and how much faster that is than one thread.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <float.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "platform/parallel.h"
+#include "bench.h"
+
+// ==============================================
+// <Parallel Benchmark> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    float  *Points;       // xyz, Count of them.
+    float  *Transformed;
+    float   Matrix[12];   // 3x4, rows.
+} parallel_points;
+
+
+typedef struct
+{
+    float Min[3];
+    float Max[3];
+} parallel_bounds;
+
+
+static void
+TransformPoints(uint64_t First, uint64_t End, void *Context)
+{
+    parallel_points *Points = (parallel_points *)Context;
+    float           *M      = Points->Matrix;
+
+    for (uint64_t Idx = First; Idx < End; ++Idx)
+    {
+        float *In  = Points->Points + Idx * 3;
+        float *Out = Points->Transformed + Idx * 3;
+
+        Out[0] = M[0] * In[0] + M[1] * In[1] + M[2]  * In[2] + M[3];
+        Out[1] = M[4] * In[0] + M[5] * In[1] + M[6]  * In[2] + M[7];
+        Out[2] = M[8] * In[0] + M[9] * In[1] + M[10] * In[2] + M[11];
+    }
+}
+
+
+static void
+BoundPoints(uint64_t First, uint64_t End, void *Context, void *Partial)
+{
+    parallel_points *Points = (parallel_points *)Context;
+    parallel_bounds *Bounds = (parallel_bounds *)Partial;
+
+    for (uint64_t Idx = First; Idx < End; ++Idx)
+    {
+        float *Point = Points->Points + Idx * 3;
+
+        for (uint32_t Axis = 0; Axis < 3; ++Axis)
+        {
+            Bounds->Min[Axis] = Minimum(Bounds->Min[Axis], Point[Axis]);
+            Bounds->Max[Axis] = Maximum(Bounds->Max[Axis], Point[Axis]);
+        }
+    }
+}
+
+
+static void
+CombineBounds(void *Result, void *Partial, void *Context)
+{
+    (void)Context;
+
+    parallel_bounds *Into = (parallel_bounds *)Result;
+    parallel_bounds *From = (parallel_bounds *)Partial;
+
+    for (uint32_t Axis = 0; Axis < 3; ++Axis)
+    {
+        Into->Min[Axis] = Minimum(Into->Min[Axis], From->Min[Axis]);
+        Into->Max[Axis] = Maximum(Into->Max[Axis], From->Max[Axis]);
+    }
+}
+
+
+static parallel_bounds
+GetEmptyBounds(void)
+{
+    parallel_bounds Result = {{FLT_MAX, FLT_MAX, FLT_MAX}, {-FLT_MAX, -FLT_MAX, -FLT_MAX}};
+    return Result;
+}
+
+// ==============================================
+// <Parallel Benchmark> : PUBLIC
+// ==============================================
+
+
+int
+RunParallelBenchmark(int ArgCount, char **Args, engine_memory *EngineMemory)
+{
+    uint32_t Count          = 1 << 22;
+    uint32_t MaxThreadCount = OSGetProcessorCount();
+    uint32_t IterationCount = 10;
+
+    for (int ArgIdx = 0; ArgIdx + 1 < ArgCount; ArgIdx += 2)
+    {
+        uint32_t Value = (uint32_t)atoi(Args[ArgIdx + 1]);
+
+        if      (strcmp(Args[ArgIdx], "--count")      == 0) Count          = Value;
+        else if (strcmp(Args[ArgIdx], "--threads")    == 0) MaxThreadCount = Value;
+        else if (strcmp(Args[ArgIdx], "--iterations") == 0) IterationCount = Value;
+        else Count = 0;
+    }
+
+    if ((ArgCount & 1) || !Count || !MaxThreadCount || !IterationCount)
+    {
+        fprintf(stderr, "usage: adb-bench parallel [--count N] [--threads N] [--iterations N]\n");
+        return 2;
+    }
+
+    (void)EngineMemory;
+
+    engine_memory    Memory   = OSCreateEngineMemory(Maximum(MaxThreadCount - 1, 1));
+    parallel_points *Points   = PushStruct(Memory.StateMemory, parallel_points);
+    float           *Expected = PushArray(Memory.StateMemory, float, (uint64_t)Count * 3);
+
+    Points->Points      = PushArray(Memory.StateMemory, float, (uint64_t)Count * 3);
+    Points->Transformed = PushArray(Memory.StateMemory, float, (uint64_t)Count * 3);
+
+    if (!Points->Points || !Points->Transformed || !Expected)
+    {
+        fprintf(stderr, "adb-bench: %u points do not fit in memory\n", Count);
+        return 1;
+    }
+
+    float Matrix[12] = {0.8f, -0.6f, 0.f, 1.f, 0.6f, 0.8f, 0.f, -2.f, 0.f, 0.f, 1.f, 0.5f};
+    memcpy(Points->Matrix, Matrix, sizeof(Matrix));
+
+    uint32_t Random = 0x2545F491u;
+    for (uint64_t Idx = 0; Idx < (uint64_t)Count * 3; ++Idx)
+    {
+        Random = Random * 1664525u + 1013904223u;
+        Points->Points[Idx] = (float)(Random >> 8) / (float)(1 << 24) * 200.f - 100.f;
+    }
+
+    // What the loops must come up with, from a plain loop on this thread.
+
+    parallel_bounds ExpectedBounds = GetEmptyBounds();
+    {
+        float *Transformed = Points->Transformed;
+
+        Points->Transformed = Expected;
+        TransformPoints(0, Count, Points);
+        BoundPoints(0, Count, Points, &ExpectedBounds);
+
+        Points->Transformed = Transformed;
+    }
+
+    printf("%u points, best of %u runs, up to %u threads\n\n", Count, IterationCount, MaxThreadCount);
+    printf("%8s %12s %10s %12s %10s\n", "threads", "for ms", "speedup", "reduce ms", "speedup");
+
+    double   ForBase      = 0.0;
+    double   ReduceBase   = 0.0;
+    uint32_t FailureCount = 0;
+
+    for (uint32_t ThreadCount = 1; ThreadCount <= MaxThreadCount; ++ThreadCount)
+    {
+        engine_memory Limited = Memory;
+        Limited.WorkerCount   = ThreadCount - 1;
+
+        double ForBest    = 0.0;
+        double ReduceBest = 0.0;
+
+        for (uint32_t Iteration = 0; Iteration < IterationCount; ++Iteration)
+        {
+            memset(Points->Transformed, 0, (uint64_t)Count * 3 * sizeof(float));
+
+            uint64_t ForStart = OSReadTimer();
+            ParallelFor(Count, 0, "transform points", TransformPoints, Points, JobPriority_Normal, &Limited);
+            double ForMs = GetElapsedMs(ForStart, OSReadTimer());
+
+            parallel_bounds Bounds      = GetEmptyBounds();
+            uint64_t        ReduceStart = OSReadTimer();
+            ParallelReduce(Count, 0, "bound points", BoundPoints, CombineBounds, &Bounds, sizeof(Bounds), Points, JobPriority_Normal, Memory.FrameMemory, &Limited);
+            double ReduceMs = GetElapsedMs(ReduceStart, OSReadTimer());
+
+            ForBest    = Iteration == 0 ? ForMs    : Minimum(ForBest, ForMs);
+            ReduceBest = Iteration == 0 ? ReduceMs : Minimum(ReduceBest, ReduceMs);
+
+            bool Matches = memcmp(Points->Transformed, Expected, (uint64_t)Count * 3 * sizeof(float)) == 0 &&
+                           memcmp(&Bounds, &ExpectedBounds, sizeof(Bounds)) == 0;
+
+            FailureCount += Matches ? 0 : 1;
+        }
+
+        ForBase    = ThreadCount == 1 ? ForBest    : ForBase;
+        ReduceBase = ThreadCount == 1 ? ReduceBest : ReduceBase;
+
+        printf("%8u %12.3f %9.2fx %12.3f %9.2fx\n", ThreadCount, ForBest, ForBase / ForBest, ReduceBest, ReduceBase / ReduceBest);
+    }
+
+    printf("\n%u runs came up with the wrong points or bounds\n", FailureCount);
+
+    int Result = FailureCount ? 1 : 0;
+    return Result;
+}
\ No newline at end of file
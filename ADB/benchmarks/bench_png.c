@@ -0,0 +1,212 @@
+// adb-bench png <directory> [--iterations N]
+//
+// Decodes every .png found under the directory with the engine decoder (parsers/parser_png.h) and
+// with stb_image, checks both give the same pixels and reports decode throughput in megabytes of
+// RGBA output per second. Single threaded, files are read once before timing starts. stb_image runs
+// the way the engine runs it, allocating from the image scratch arena and copying into Pixels.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "third_party/stb_image.h"
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "engine/rendering/assets.h"
+#include "parsers/parser_png.h"
+#include "bench.h"
+
+#define MAX_PNG_ITERATION_COUNT 1024
+
+// ==============================================
+// <PNG Benchmark> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    double Min;
+    double Median;
+} png_timing;
+
+
+static int
+CompareDouble(const void *A, const void *B)
+{
+    double X = *(const double *)A;
+    double Y = *(const double *)B;
+
+    int Result = (X > Y) - (X < Y);
+    return Result;
+}
+
+
+static png_timing
+SummarizeTimings(double *Samples, uint32_t Count)
+{
+    qsort(Samples, Count, sizeof(double), CompareDouble);
+
+    png_timing Result = {Samples[0], Samples[Count / 2]};
+    return Result;
+}
+
+
+static double
+GetMegabytesPerSecond(uint64_t Bytes, double Ms)
+{
+    double Result = Ms > 0.0 ? ((double)Bytes / (1024.0 * 1024.0)) / (Ms / 1000.0) : 0.0;
+    return Result;
+}
+
+// ==============================================
+// <PNG Benchmark> : PUBLIC
+// ==============================================
+
+
+int
+RunPNGBenchmark(int ArgCount, char **Args, engine_memory *EngineMemory)
+{
+    char    *Directory      = 0;
+    uint32_t IterationCount = 16;
+
+    for (int ArgIdx = 0; ArgIdx < ArgCount; ++ArgIdx)
+    {
+        if (strcmp(Args[ArgIdx], "--iterations") == 0 && ArgIdx + 1 < ArgCount)
+        {
+            IterationCount = (uint32_t)atoi(Args[++ArgIdx]);
+        }
+        else if (!Directory)
+        {
+            Directory = Args[ArgIdx];
+        }
+    }
+
+    if (!Directory || IterationCount == 0 || IterationCount > MAX_PNG_ITERATION_COUNT)
+    {
+        fprintf(stderr, "usage: adb-bench png <directory> [--iterations 1..%d]\n", MAX_PNG_ITERATION_COUNT);
+        return 2;
+    }
+
+    memory_arena *Arena = EngineMemory->StateMemory;
+    os_file_list  Files = FindFilesWithExtension(ByteString((uint8_t *)Directory, strlen(Directory)), ByteStringLiteral(".png"), Arena);
+
+    if (!Files.Count)
+    {
+        fprintf(stderr, "adb-bench: no .png files under %s\n", Directory);
+        return 1;
+    }
+
+    double   NativeSamples[MAX_PNG_ITERATION_COUNT];
+    double   StbSamples[MAX_PNG_ITERATION_COUNT];
+    double   NativeTotal   = 0.0;
+    double   StbTotal      = 0.0;
+    uint64_t NativeBytes   = 0;
+    uint64_t StbBytes      = 0;
+    uint32_t FallbackCount = 0;
+    uint32_t MismatchCount = 0;
+    uint32_t FailedCount   = 0;
+
+    printf("%-48s %11s %12s %12s %8s\n", "file", "size", "adb MB/s", "stb MB/s", "speedup");
+
+    for (os_file_node *File = Files.First; File != 0; File = File->Next)
+    {
+        memory_region Region = EnterMemoryRegion(EngineMemory->FrameMemory);
+
+        buffer   Content  = ReadFileInBuffer(File->Path, EngineMemory->FrameMemory);
+        uint64_t FileSize = IsBufferValid(&Content) ? Content.Size - 1 : 0;
+        png_info Info     = ReadPNGInfo(Content.Data, FileSize);
+
+        int      Width     = 0;
+        int      Height    = 0;
+        int      Channels  = 0;
+        bool     IsValid   = FileSize && stbi_info_from_memory(Content.Data, (int)FileSize, &Width, &Height, &Channels);
+        uint8_t *Reference = IsValid ? PushArray(EngineMemory->FrameMemory, uint8_t, (uint64_t)Width * Height * 4) : 0;
+
+        if (!Reference || !DecodeImageWithSTB(Content.Data, FileSize, Reference, (uint32_t)Width, (uint32_t)Height))
+        {
+            printf("%-48s %11s\n", (const char *)File->Path.Data, "unreadable");
+            ++FailedCount;
+
+            LeaveMemoryRegion(Region);
+            continue;
+        }
+
+        uint64_t PixelSize   = (uint64_t)Width * (uint64_t)Height * 4;
+        uint8_t *Pixels      = 0;
+        uint8_t *Scratch     = 0;
+        uint64_t ScratchSize = 0;
+        bool     IsNative    = Info.IsSupported;
+
+        if (IsNative)
+        {
+            ScratchSize = GetPNGScratchSize(Info, FileSize);
+            Pixels      = PushArray(EngineMemory->FrameMemory, uint8_t, PixelSize);
+            Scratch     = PushArray(EngineMemory->FrameMemory, uint8_t, ScratchSize);
+            IsNative    = DecodePNG(Content.Data, FileSize, Pixels, Scratch, ScratchSize, true);
+        }
+
+        if (IsNative && memcmp(Pixels, Reference, PixelSize) != 0)
+        {
+            printf("%-48s %11s\n", (const char *)File->Path.Data, "MISMATCH");
+            ++MismatchCount;
+            IsNative = false;
+        }
+
+        for (uint32_t Iteration = 0; Iteration < IterationCount; ++Iteration)
+        {
+            uint64_t Start = OSReadTimer();
+            DecodeImageWithSTB(Content.Data, FileSize, Reference, (uint32_t)Width, (uint32_t)Height);
+            uint64_t End   = OSReadTimer();
+
+            StbSamples[Iteration] = GetElapsedMs(Start, End);
+        }
+
+        for (uint32_t Iteration = 0; IsNative && Iteration < IterationCount; ++Iteration)
+        {
+            uint64_t Start = OSReadTimer();
+            DecodePNG(Content.Data, FileSize, Pixels, Scratch, ScratchSize, true);
+            uint64_t End   = OSReadTimer();
+
+            NativeSamples[Iteration] = GetElapsedMs(Start, End);
+        }
+
+        png_timing Stb = SummarizeTimings(StbSamples, IterationCount);
+
+        StbTotal += Stb.Median;
+        StbBytes += PixelSize;
+
+        if (IsNative)
+        {
+            png_timing Native = SummarizeTimings(NativeSamples, IterationCount);
+
+            NativeTotal += Native.Median;
+            NativeBytes += PixelSize;
+
+            printf("%-48s %11llu %12.1f %12.1f %7.2fx\n", (const char *)File->Path.Data, (unsigned long long)FileSize,
+                   GetMegabytesPerSecond(PixelSize, Native.Median), GetMegabytesPerSecond(PixelSize, Stb.Median),
+                   Native.Median > 0.0 ? Stb.Median / Native.Median : 0.0);
+        }
+        else
+        {
+            printf("%-48s %11llu %12s %12.1f\n", (const char *)File->Path.Data, (unsigned long long)FileSize,
+                   "stb only", GetMegabytesPerSecond(PixelSize, Stb.Median));
+            ++FallbackCount;
+        }
+
+        LeaveMemoryRegion(Region);
+    }
+
+    // Totals are the sum of per-file medians. The stb total covers every file, the adb total only
+    // the ones it decoded, so compare rates rather than times when there are fallbacks.
+
+    printf("\n%u files, %u fell back to stb, %u mismatched, %u unreadable, %u iterations each\n",
+           Files.Count, FallbackCount, MismatchCount, FailedCount, IterationCount);
+    printf("adb: %10.2f ms %10.1f MB/s\n", NativeTotal, GetMegabytesPerSecond(NativeBytes, NativeTotal));
+    printf("stb: %10.2f ms %10.1f MB/s\n", StbTotal, GetMegabytesPerSecond(StbBytes, StbTotal));
+
+    int Result = (MismatchCount || FailedCount) ? 1 : 0;
+    return Result;
+}
\ No newline at end of file
@@ -0,0 +1,357 @@
+// adb-bench sample [--size N] [--pixels N] [--iterations N]
+//
+// Times the software backend's texture sampling (engine/rendering/software/software_texture.h), a
+// lane of pixels at a time from tiled texels, against a naive sampler: one pixel at a time, float
+// weights, texels row by row the way they are loaded. Both filter the same way, so what differs is
+// the layout and the lanes. The texture is --size noise with its mips, sampled over a view of
+// --pixels pixels in three mappings, all rotated by 30 degrees: magnified twice, one texel per
+// pixel, minified four times. Bilinear samples the first level whatever the mapping, trilinear the
+// level the mapping calls for.
+//
+// Each reports the best of --iterations runs in millions of pixels per second, and the largest
+// difference of a channel between the two samplers, which the 8-bit weights account for.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "engine/rendering/assets.h"
+#include "engine/rendering/textures/texture_mips.h"
+#include "engine/rendering/software/software_lanes.h"
+#include "engine/rendering/software/software_texture.h"
+#include "bench.h"
+
+#define MAX_SAMPLE_SIZE 8192
+
+// ==============================================
+// <Sample Benchmark> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    const char *Name;
+    float       Scale;    // Texels per pixel.
+} sample_mapping;
+
+
+static const sample_mapping SampleMappings[] =
+{
+    {"magnified x2", 0.5f},
+    {"1:1",          1.f},
+    {"minified x4",  4.f},
+};
+
+
+typedef struct
+{
+    texture_mip Mips[MAX_TEXTURE_MIP_COUNT];
+    uint32_t    MipCount;
+} naive_texture;
+
+
+// Channels of a bilinear sample, 0 to 255, not rounded yet.
+
+static void
+SampleNaiveLevel(naive_texture *Texture, float U, float V, uint32_t Level, float *Out)
+{
+    texture_mip *Mip = Texture->Mips + Level;
+
+    float X = fminf(fmaxf(U * (float)Mip->Width  - 0.5f, -1.f), (float)Mip->Width);
+    float Y = fminf(fmaxf(V * (float)Mip->Height - 0.5f, -1.f), (float)Mip->Height);
+
+    float FloorX = floorf(X);
+    float FloorY = floorf(Y);
+    float FX     = X - FloorX;
+    float FY     = Y - FloorY;
+
+    uint32_t X0 = (uint32_t)fmaxf(FloorX, 0.f);
+    uint32_t Y0 = (uint32_t)fmaxf(FloorY, 0.f);
+    uint32_t X1 = Minimum((uint32_t)(FloorX + 1.f), Mip->Width - 1);
+    uint32_t Y1 = Minimum((uint32_t)(FloorY + 1.f), Mip->Height - 1);
+
+    uint8_t *Row0 = Mip->Data + (uint64_t)Y0 * Mip->Pitch;
+    uint8_t *Row1 = Mip->Data + (uint64_t)Y1 * Mip->Pitch;
+
+    for (uint32_t Channel = 0; Channel < 4; ++Channel)
+    {
+        float Top    = Row0[X0 * 4 + Channel] * (1.f - FX) + Row0[X1 * 4 + Channel] * FX;
+        float Bottom = Row1[X0 * 4 + Channel] * (1.f - FX) + Row1[X1 * 4 + Channel] * FX;
+
+        Out[Channel] = Top * (1.f - FY) + Bottom * FY;
+    }
+}
+
+
+static uint32_t
+PackNaiveSample(float *Channels)
+{
+    uint32_t Result = 0;
+
+    for (uint32_t Channel = 0; Channel < 4; ++Channel)
+    {
+        Result |= (uint32_t)(Channels[Channel] + 0.5f) << (Channel * 8);
+    }
+
+    return Result;
+}
+
+
+static void
+SampleNaiveBilinear(naive_texture *Texture, float *Us, float *Vs, uint32_t Count, float Lod, uint32_t *Out)
+{
+    (void)Lod;
+
+    for (uint32_t Idx = 0; Idx < Count; ++Idx)
+    {
+        float Channels[4];
+        SampleNaiveLevel(Texture, Us[Idx], Vs[Idx], 0, Channels);
+
+        Out[Idx] = PackNaiveSample(Channels);
+    }
+}
+
+
+static void
+SampleNaiveTrilinear(naive_texture *Texture, float *Us, float *Vs, uint32_t Count, float Lod, uint32_t *Out)
+{
+    float    Clamped  = fminf(fmaxf(Lod, 0.f), (float)(Texture->MipCount - 1));
+    uint32_t Fine     = (uint32_t)Clamped;
+    uint32_t Coarse   = Minimum(Fine + 1, Texture->MipCount - 1);
+    float    Fraction = Clamped - (float)Fine;
+
+    for (uint32_t Idx = 0; Idx < Count; ++Idx)
+    {
+        float FineChannels[4];
+        float CoarseChannels[4];
+        SampleNaiveLevel(Texture, Us[Idx], Vs[Idx], Fine, FineChannels);
+
+        if (Fraction > 0.f)
+        {
+            SampleNaiveLevel(Texture, Us[Idx], Vs[Idx], Coarse, CoarseChannels);
+
+            for (uint32_t Channel = 0; Channel < 4; ++Channel)
+            {
+                FineChannels[Channel] += (CoarseChannels[Channel] - FineChannels[Channel]) * Fraction;
+            }
+        }
+
+        Out[Idx] = PackNaiveSample(FineChannels);
+    }
+}
+
+
+// The derivatives are the same for every pixel of a mapping, the level of detail comes from them
+// like it does in the rasterizer.
+
+typedef struct
+{
+    float DUDX, DVDX, DUDY, DVDY;
+} sample_derivatives;
+
+
+static void
+SampleLanesBilinear(software_texture *Texture, float *Us, float *Vs, uint32_t Count, sample_derivatives *Derivatives, uint32_t *Out)
+{
+    (void)Derivatives;
+
+    for (uint32_t Idx = 0; Idx < Count; Idx += SOFTWARE_LANE_COUNT)
+    {
+        LaneStoreU32(Out + Idx, SampleBilinear(Texture, LaneLoadF32(Us + Idx), LaneLoadF32(Vs + Idx), 0));
+    }
+}
+
+
+static void
+SampleLanesTrilinear(software_texture *Texture, float *Us, float *Vs, uint32_t Count, sample_derivatives *Derivatives, uint32_t *Out)
+{
+    for (uint32_t Idx = 0; Idx < Count; Idx += SOFTWARE_LANE_COUNT)
+    {
+        lane_f32 Lod = GetSoftwareTextureLod(Texture, LaneF32(Derivatives->DUDX), LaneF32(Derivatives->DVDX),
+                                             LaneF32(Derivatives->DUDY), LaneF32(Derivatives->DVDY));
+
+        LaneStoreU32(Out + Idx, SampleTrilinear(Texture, LaneLoadF32(Us + Idx), LaneLoadF32(Vs + Idx), Lod));
+    }
+}
+
+
+static uint32_t
+GetLargestChannelDifference(uint32_t *A, uint32_t *B, uint32_t Count)
+{
+    uint32_t Result = 0;
+
+    for (uint32_t Idx = 0; Idx < Count; ++Idx)
+    {
+        for (uint32_t Channel = 0; Channel < 4; ++Channel)
+        {
+            int32_t Difference = (int32_t)((A[Idx] >> (Channel * 8)) & 0xFF) - (int32_t)((B[Idx] >> (Channel * 8)) & 0xFF);
+            Result = Maximum(Result, (uint32_t)(Difference < 0 ? -Difference : Difference));
+        }
+    }
+
+    return Result;
+}
+
+// ==============================================
+// <Sample Benchmark> : PUBLIC
+// ==============================================
+
+
+int
+RunSampleBenchmark(int ArgCount, char **Args, engine_memory *EngineMemory)
+{
+    uint32_t Size           = 1024;
+    uint32_t PixelCount     = 1 << 18;
+    uint32_t IterationCount = 10;
+
+    for (int ArgIdx = 0; ArgIdx + 1 < ArgCount; ArgIdx += 2)
+    {
+        uint32_t Value = (uint32_t)atoi(Args[ArgIdx + 1]);
+
+        if      (strcmp(Args[ArgIdx], "--size")       == 0) Size           = Value;
+        else if (strcmp(Args[ArgIdx], "--pixels")     == 0) PixelCount     = Value;
+        else if (strcmp(Args[ArgIdx], "--iterations") == 0) IterationCount = Value;
+        else Size = 0;
+    }
+
+    if ((ArgCount & 1) || !Size || Size > MAX_SAMPLE_SIZE || !PixelCount || !IterationCount)
+    {
+        fprintf(stderr, "usage: adb-bench sample [--size 1..%d] [--pixels N] [--iterations N]\n", MAX_SAMPLE_SIZE);
+        return 2;
+    }
+
+    memory_arena *Arena = EngineMemory->StateMemory;
+
+    // A square view, rows of whole lanes.
+
+    uint32_t ViewSide = AlignPow2((uint32_t)sqrt((double)PixelCount), 8);
+
+    PixelCount = ViewSide * ViewSide;
+
+    loaded_texture Texture =
+    {
+        .Width         = Size,
+        .Height        = Size,
+        .BytesPerPixel = 4,
+        .MipCount      = GetMipCount(Size, Size),
+        .Format        = TextureFormat_RGBA8,
+        .Data          = PushArray(Arena, uint8_t, GetMipChainSize(Size, Size, 4)),
+    };
+
+    float    *Us       = PushArrayAligned(Arena, float, PixelCount, 64);
+    float    *Vs       = PushArrayAligned(Arena, float, PixelCount, 64);
+    uint32_t *Naive    = PushArrayAligned(Arena, uint32_t, PixelCount, 64);
+    uint32_t *Lanes    = PushArrayAligned(Arena, uint32_t, PixelCount, 64);
+
+    if (!Texture.Data || !Us || !Vs || !Naive || !Lanes)
+    {
+        fprintf(stderr, "adb-bench: a %u texture and %u pixels do not fit in memory\n", Size, PixelCount);
+        return 1;
+    }
+
+    uint32_t Random = 0x53414D50u;
+    for (uint64_t Idx = 0; Idx < (uint64_t)Size * Size * 4; ++Idx)
+    {
+        Random = Random * 1664525u + 1013904223u;
+        Texture.Data[Idx] = (uint8_t)(Random >> 24);
+    }
+
+    GenerateMipChain(&Texture, MipFilter_Box, EngineMemory->FrameMemory);
+
+    naive_texture Reference = {.MipCount = Texture.MipCount};
+    for (uint32_t Level = 0; Level < Texture.MipCount; ++Level)
+    {
+        Reference.Mips[Level] = GetTextureMip(&Texture, Level);
+    }
+
+    uint64_t          TileStart = OSReadTimer();
+    software_texture *Tiled     = CreateSoftwareTexture(Texture);
+    double            TileMs    = GetElapsedMs(TileStart, OSReadTimer());
+
+    if (!Tiled)
+    {
+        fprintf(stderr, "adb-bench: could not create the software texture\n");
+        return 1;
+    }
+
+    printf("%u x %u texture, %u levels, tiled in %.2f ms | %u x %u pixels, %u lanes, best of %u runs\n\n",
+           Size, Size, Texture.MipCount, TileMs, ViewSide, ViewSide, SOFTWARE_LANE_COUNT, IterationCount);
+    printf("%-14s %-10s %14s %14s %9s %6s\n", "mapping", "filter", "naive Mpx/s", "lanes Mpx/s", "speedup", "diff");
+
+    float Cos = 0.8660254f;
+    float Sin = 0.5f;
+
+    for (uint32_t MappingIdx = 0; MappingIdx < ArrayCount(SampleMappings); ++MappingIdx)
+    {
+        const sample_mapping *Mapping = SampleMappings + MappingIdx;
+        float                 Step    = Mapping->Scale / (float)Size;
+
+        // Wrapped into the texture, the few seams this makes do not matter here.
+
+        for (uint32_t Y = 0; Y < ViewSide; ++Y)
+        {
+            for (uint32_t X = 0; X < ViewSide; ++X)
+            {
+                float U = ((float)X * Cos - (float)Y * Sin) * Step + 0.25f;
+                float V = ((float)X * Sin + (float)Y * Cos) * Step + 0.25f;
+
+                Us[Y * ViewSide + X] = U - floorf(U);
+                Vs[Y * ViewSide + X] = V - floorf(V);
+            }
+        }
+
+        sample_derivatives Derivatives = {Cos * Step, Sin * Step, -Sin * Step, Cos * Step};
+        float              Lod         = log2f(Mapping->Scale);
+
+        for (uint32_t Filter = 0; Filter < 2; ++Filter)
+        {
+            double NaiveBest = 0.0;
+            double LanesBest = 0.0;
+
+            for (uint32_t Iteration = 0; Iteration < IterationCount; ++Iteration)
+            {
+                uint64_t NaiveStart = OSReadTimer();
+
+                if (Filter == 0)
+                {
+                    SampleNaiveBilinear(&Reference, Us, Vs, PixelCount, Lod, Naive);
+                }
+                else
+                {
+                    SampleNaiveTrilinear(&Reference, Us, Vs, PixelCount, Lod, Naive);
+                }
+
+                double   NaiveMs    = GetElapsedMs(NaiveStart, OSReadTimer());
+                uint64_t LanesStart = OSReadTimer();
+
+                if (Filter == 0)
+                {
+                    SampleLanesBilinear(Tiled, Us, Vs, PixelCount, &Derivatives, Lanes);
+                }
+                else
+                {
+                    SampleLanesTrilinear(Tiled, Us, Vs, PixelCount, &Derivatives, Lanes);
+                }
+
+                double LanesMs = GetElapsedMs(LanesStart, OSReadTimer());
+
+                NaiveBest = Iteration == 0 ? NaiveMs : Minimum(NaiveBest, NaiveMs);
+                LanesBest = Iteration == 0 ? LanesMs : Minimum(LanesBest, LanesMs);
+            }
+
+            double NaiveRate = (double)PixelCount / (NaiveBest * 1000.0);
+            double LanesRate = (double)PixelCount / (LanesBest * 1000.0);
+
+            printf("%-14s %-10s %14.1f %14.1f %8.2fx %6u\n", Mapping->Name, Filter == 0 ? "bilinear" : "trilinear",
+                   NaiveRate, LanesRate, LanesRate / NaiveRate, GetLargestChannelDifference(Naive, Lanes, PixelCount));
+        }
+    }
+
+    DestroySoftwareTexture(Tiled);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,302 @@
+// adb-bench stream [--textures N] [--size N] [--budget MiB] [--frames N] [--frame-ms N]
+//
+// Flies a camera past a row of objects, each with its own texture, and runs the texture streamer
+// (engine/rendering/textures/texture_streaming.h) the way a frame would: requests from the objects
+// in front of the camera, one update, then the changed textures are picked up. Reports the time the
+// update takes on the main thread, what it reads from the texture cache and how the resident
+// memory compares to the budget. Each frame is held to --frame-ms so the reads get the time they
+// would have between frames.
+//
+// The textures are generated and written to the texture cache before timing starts, with texels
+// derived from their index and level so the levels that end up resident can be checked. The cache is
+// pointed at its own directory for the run, which is deleted once the benchmark is done.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "engine/rendering/assets.h"
+#include "engine/rendering/textures/texture_cache.h"
+#include "engine/rendering/textures/texture_mips.h"
+#include "engine/rendering/textures/texture_streaming.h"
+#include "bench.h"
+
+#define STREAM_OBJECT_SPACING  4.f
+#define STREAM_OBJECT_RADIUS   1.f
+#define STREAM_VIEW_HEIGHT     1080
+#define STREAM_REPORT_COUNT    10
+#define STREAM_CACHE_DIRECTORY "adb_bench_stream"
+
+// ==============================================
+// <Stream Benchmark> : INTERNAL
+// ==============================================
+
+
+static uint8_t
+GetStreamTexel(uint32_t TextureIdx, uint32_t Level, uint64_t Offset)
+{
+    uint8_t Result = (uint8_t)(TextureIdx * 31 + Level * 17 + Offset * 7);
+    return Result;
+}
+
+
+static void
+FillStreamTexture(loaded_texture *Texture, uint32_t TextureIdx)
+{
+    for (uint32_t Level = 0; Level < Texture->MipCount; ++Level)
+    {
+        texture_mip Mip  = GetTextureMip(Texture, Level);
+        uint64_t    Size = (uint64_t)Mip.Pitch * Mip.Height;
+
+        for (uint64_t Offset = 0; Offset < Size; ++Offset)
+        {
+            Mip.Data[Offset] = GetStreamTexel(TextureIdx, Level, Offset);
+        }
+    }
+}
+
+
+static uint64_t
+GetStreamCacheKey(uint32_t TextureSize, uint32_t TextureIdx)
+{
+    uint64_t Result = MakeTextureCacheKey(CombineHash(CombineHash(0x53545245414D4245ull, TextureSize), TextureIdx));
+    return Result;
+}
+
+
+// Textures that were never stored have nothing to delete, failing on them is fine.
+
+static void
+RemoveStreamTextures(uint32_t TextureSize, uint32_t TextureCount)
+{
+    for (uint32_t TextureIdx = 0; TextureIdx < TextureCount; ++TextureIdx)
+    {
+        RemoveCachedTexture(GetStreamCacheKey(TextureSize, TextureIdx));
+    }
+
+    OSDeleteDirectory(ByteStringLiteral(STREAM_CACHE_DIRECTORY));
+}
+
+
+// Levels are named from the top of the full chain, Texture starts at FirstLevel.
+
+static bool
+CheckStreamTexture(loaded_texture *Texture, uint32_t TextureIdx, uint32_t FirstLevel)
+{
+    bool Result = Texture->Data != 0;
+
+    for (uint32_t Level = 0; Result && Level < Texture->MipCount; ++Level)
+    {
+        texture_mip Mip  = GetTextureMip(Texture, Level);
+        uint64_t    Size = (uint64_t)Mip.Pitch * Mip.Height;
+
+        for (uint64_t Offset = 0; Result && Offset < Size; ++Offset)
+        {
+            Result = Mip.Data[Offset] == GetStreamTexel(TextureIdx, FirstLevel + Level, Offset);
+        }
+    }
+
+    return Result;
+}
+
+
+// Objects sit on both sides of the path, the camera looks down it. Same sizing as the scene does.
+
+static float
+GetStreamScreenSize(uint32_t ObjectIdx, float CameraZ)
+{
+    float X        = (ObjectIdx & 1) ? 2.f : -2.f;
+    float Z        = (float)ObjectIdx * STREAM_OBJECT_SPACING - CameraZ;
+    float Distance = sqrtf(X * X + Z * Z);
+    float Result   = 0.f;
+
+    if (Distance <= STREAM_OBJECT_RADIUS)
+    {
+        Result = 1.f;
+    }
+    else if (Z > -STREAM_OBJECT_RADIUS)
+    {
+        Result = STREAM_OBJECT_RADIUS / (Distance * tanf(3.14159f / 8.f));
+    }
+
+    return Result;
+}
+
+
+static double
+GetMiB(uint64_t Bytes)
+{
+    double Result = (double)Bytes / (1024.0 * 1024.0);
+    return Result;
+}
+
+// ==============================================
+// <Stream Benchmark> : PUBLIC
+// ==============================================
+
+
+int
+RunStreamBenchmark(int ArgCount, char **Args, engine_memory *EngineMemory)
+{
+    uint32_t TextureCount = 128;
+    uint32_t TextureSize  = 512;
+    uint32_t BudgetMiB    = 16;
+    uint32_t FrameCount   = 300;
+    uint32_t FrameMs      = 16;
+
+    for (int ArgIdx = 0; ArgIdx + 1 < ArgCount; ArgIdx += 2)
+    {
+        uint32_t Value = (uint32_t)atoi(Args[ArgIdx + 1]);
+
+        if      (strcmp(Args[ArgIdx], "--textures") == 0) TextureCount = Value;
+        else if (strcmp(Args[ArgIdx], "--size")     == 0) TextureSize  = Value;
+        else if (strcmp(Args[ArgIdx], "--budget")   == 0) BudgetMiB    = Value;
+        else if (strcmp(Args[ArgIdx], "--frames")   == 0) FrameCount   = Value;
+        else if (strcmp(Args[ArgIdx], "--frame-ms") == 0) FrameMs      = Value;
+        else TextureCount = 0;
+    }
+
+    bool IsPowerOfTwo = TextureSize && (TextureSize & (TextureSize - 1)) == 0;
+
+    if ((ArgCount & 1) || !TextureCount || !IsPowerOfTwo || TextureSize <= TEXTURE_STREAM_TAIL_SIZE || TextureSize > 8192 || !FrameCount)
+    {
+        fprintf(stderr, "usage: adb-bench stream [--textures N] [--size 128..8192, power of two] [--budget MiB] [--frames N] [--frame-ms N]\n");
+        return 2;
+    }
+
+    // The shared memory only has one worker, reads should not queue behind each other.
+
+    engine_memory     Memory   = OSCreateEngineMemory(0);
+    texture_streamer *Streamer = CreateTextureStreamer(MiB(BudgetMiB), TextureCount, Memory.StateMemory);
+    uint32_t         *Ids      = PushArray(Memory.StateMemory, uint32_t, TextureCount);
+    uint64_t          FullSize = 0;
+
+    (void)EngineMemory;
+
+    SetTextureCacheDirectory(ByteStringLiteral(STREAM_CACHE_DIRECTORY));
+
+    for (uint32_t TextureIdx = 0; Streamer && Ids && TextureIdx < TextureCount; ++TextureIdx)
+    {
+        memory_region Region = EnterMemoryRegion(Memory.FrameMemory);
+
+        loaded_texture Texture =
+        {
+            .Width         = TextureSize,
+            .Height        = TextureSize,
+            .BytesPerPixel = 4,
+            .MipCount      = GetMipCount(TextureSize, TextureSize),
+            .Format        = TextureFormat_RGBA8,
+        };
+
+        uint64_t Size = GetTextureDataSize(Texture.Width, Texture.Height, Texture.Format, Texture.MipCount);
+
+        Texture.Data     = PushArray(Memory.FrameMemory, uint8_t, Size);
+        Texture.CacheKey = GetStreamCacheKey(TextureSize, TextureIdx);
+
+        if (Texture.Data)
+        {
+            FillStreamTexture(&Texture, TextureIdx);
+
+            loaded_texture *ToStore = &Texture;
+            StoreCachedTextures(&ToStore, 1, &Memory);
+
+            Ids[TextureIdx] = AddStreamedTexture(Streamer, &Texture);
+            FullSize       += Size;
+        }
+
+        LeaveMemoryRegion(Region);
+
+        if (!Ids[TextureIdx])
+        {
+            fprintf(stderr, "adb-bench: could not stream texture %u, is %s writable?\n", TextureIdx, STREAM_CACHE_DIRECTORY);
+
+            RemoveStreamTextures(TextureSize, TextureIdx + 1);
+            return 1;
+        }
+    }
+
+    texture_stream_stats Start = GetTextureStreamStats(Streamer);
+
+    printf("%u textures of %ux%u RGBA8, %.1f MiB with every level, %.1f MiB of tails, budget %u MiB\n\n",
+           TextureCount, TextureSize, TextureSize, GetMiB(FullSize), GetMiB(Start.ResidentBytes), BudgetMiB);
+    printf("%8s %10s %12s %12s %6s %8s %10s\n", "frame", "update ms", "resident MiB", "wanted MiB", "bias", "pending", "read MiB");
+
+    double   UpdateTotal   = 0.0;
+    double   UpdateMax     = 0.0;
+    uint64_t PeakResident  = 0;
+    uint32_t ChangeCount   = 0;
+    uint64_t FrameTicks    = (uint64_t)FrameMs * OSGetTimerFrequency() / 1000;
+    float    PathLength    = (float)TextureCount * STREAM_OBJECT_SPACING + 20.f;
+
+    for (uint32_t Frame = 0; Frame < FrameCount; ++Frame)
+    {
+        uint64_t FrameStart = OSReadTimer();
+        float    CameraZ    = -10.f + PathLength * (float)Frame / (float)FrameCount;
+
+        for (uint32_t TextureIdx = 0; TextureIdx < TextureCount; ++TextureIdx)
+        {
+            RequestStreamedTexture(Streamer, Ids[TextureIdx], GetStreamScreenSize(TextureIdx, CameraZ));
+        }
+
+        uint64_t UpdateStart = OSReadTimer();
+
+        UpdateTextureStreaming(Streamer, STREAM_VIEW_HEIGHT, &Memory);
+
+        for (uint32_t TextureIdx = 0; TextureIdx < TextureCount; ++TextureIdx)
+        {
+            loaded_texture Texture;
+            ChangeCount += GetStreamedTexture(Streamer, Ids[TextureIdx], &Texture) ? 1 : 0;
+        }
+
+        double UpdateMs = GetElapsedMs(UpdateStart, OSReadTimer());
+
+        texture_stream_stats Stats = GetTextureStreamStats(Streamer);
+
+        UpdateTotal  += UpdateMs;
+        UpdateMax     = Maximum(UpdateMax, UpdateMs);
+        PeakResident  = Maximum(PeakResident, Stats.ResidentBytes);
+
+        if ((Frame + 1) % Maximum(FrameCount / STREAM_REPORT_COUNT, 1) == 0)
+        {
+            printf("%8u %10.3f %12.1f %12.1f %6u %8u %10.1f\n", Frame + 1, UpdateMs, GetMiB(Stats.ResidentBytes),
+                   GetMiB(Stats.WantedBytes), Stats.Bias, Stats.PendingReadCount, GetMiB(Stats.BytesRead));
+        }
+
+        while (OSReadTimer() - FrameStart < FrameTicks)
+        {
+        }
+    }
+
+    // Let the last reads land, then check every texture holds the levels it claims to.
+
+    Memory.CompleteWork(Memory.WorkQueue);
+    UpdateTextureStreaming(Streamer, STREAM_VIEW_HEIGHT, &Memory);
+
+    uint32_t MismatchCount = 0;
+
+    for (uint32_t TextureIdx = 0; TextureIdx < TextureCount; ++TextureIdx)
+    {
+        loaded_texture Texture;
+        GetStreamedTexture(Streamer, Ids[TextureIdx], &Texture);
+
+        uint32_t FirstLevel = GetMipCount(TextureSize, TextureSize) - Texture.MipCount;
+        MismatchCount += CheckStreamTexture(&Texture, TextureIdx, FirstLevel) ? 0 : 1;
+    }
+
+    texture_stream_stats End = GetTextureStreamStats(Streamer);
+
+    printf("\nupdate: %.3f ms average, %.3f ms worst over %u frames\n", UpdateTotal / FrameCount, UpdateMax, FrameCount);
+    printf("reads:  %u, %u failed, %.1f MiB, %u texture changes\n", End.ReadCount, End.FailedReadCount, GetMiB(End.BytesRead), ChangeCount);
+    printf("memory: %.1f MiB peak, %.1f MiB at the end, budget %u MiB\n", GetMiB(PeakResident), GetMiB(End.ResidentBytes), BudgetMiB);
+    printf("%u textures hold the wrong texels\n", MismatchCount);
+
+    RemoveStreamTextures(TextureSize, TextureCount);
+
+    int Result = (MismatchCount || End.FailedReadCount) ? 1 : 0;
+    return Result;
+}
\ No newline at end of file
@@ -4,48 +4,91 @@
 #include "engine.h"
 #include "rendering/renderer.h"
 #include "rendering/scene.h"
+#include "rendering/asset_archive.h"
 #include "platform/platform.h"
+#include "platform/profiler.h"
 
 typedef struct renderer renderer;
 
 typedef struct
 {
-	bool IsInitialized;
+	bool       IsInitialized;
+	game_scene Scene;
 } engine_state;
 
+static engine_state Engine;
+
 // Temp
 #include "parsers/parser_obj.h"
+#include "rendering/textures/texture_sources.h"
 
 void
-UpdateEngine(int WindowWidth, int WindowHeight, renderer *Renderer, engine_memory *EngineMemory)
+LoadEngineScene(engine_scene_params Params, renderer *Renderer, engine_memory *EngineMemory)
 {
-	static engine_state Engine;
-	static game_scene   Scene;
+	game_scene *Scene = &Engine.Scene;
 
-	if (!Engine.IsInitialized)
+	// Optional, reads fall back to loose files for anything the archive does not have.
+	MountAssetArchive(ByteStringLiteral("data.adbpak"), EngineMemory->StateMemory);
+
+	Scene->Camera      = CreateCamera(Vec3(0.f, 0.f, -20.f), 3.14159f / 4.f, 1901.f / 1041.f);
+	Scene->EntityCount = 0;
+
+	for (uint32_t ObjIdx = 0; ObjIdx < Params.ObjCount; ++ObjIdx)
 	{
-		asset_file_data AssetData = ParseObjFromFile(ByteStringLiteral("data/strawberry.obj"), EngineMemory);
+		asset_file_data AssetData = ParseObjFromFile(Params.ObjPaths[ObjIdx], ObjParseFlag_None, EngineMemory);
 
 		LoadAssetFileData(AssetData, EngineMemory->FrameMemory, Renderer);
 
-		Scene.Camera      = CreateCamera(Vec3(0.f, 0.f, -20.f), 3.14159f / 4.f, 1901.f / 1041.f);
-		Scene.EntityCount = 0;
-		CreateGameEntity(ByteStringLiteral("data/strawberry::strawberry"), &Scene, Renderer);
-		
+		// Named the way LoadAssetFileData names the meshes it creates.
+
+		for (uint32_t EntityIdx = 0; EntityIdx < Params.EntityCount; ++EntityIdx)
+		{
+			for (uint32_t MeshIdx = 0; MeshIdx < AssetData.MeshCount; ++MeshIdx)
+			{
+				byte_string MeshNameParts[2] = {StripExtensionName(AssetData.Meshes[MeshIdx].Path), AssetData.Meshes[MeshIdx].Name};
+				byte_string MeshResource     = ConcatenateStrings(MeshNameParts, 2, ByteStringLiteral("::"), EngineMemory->FrameMemory);
+
+				CreateGameEntity(MeshResource, Scene, Renderer);
+			}
+		}
+	}
+
+	// Everything is imported, the decoded sources are not needed anymore.
+	TrimTextureSources();
+
+	Engine.IsInitialized = true;
+}
+
+
+void
+UpdateEngine(int WindowWidth, int WindowHeight, renderer *Renderer, engine_memory *EngineMemory)
+{
+	TIMED_BLOCK_BEGIN(UpdateEngine);
+
+	if (!Engine.IsInitialized)
+	{
+		byte_string         ObjPath = ByteStringLiteral("data/strawberry.obj");
+		engine_scene_params Params  = {.ObjPaths = &ObjPath, .ObjCount = 1, .EntityCount = 1};
+
+		LoadEngineScene(Params, Renderer, EngineMemory);
 
 		// TODO: From the asset_file_data we want to initialize the rendering objects. The idea is to construct a static mesh from the mesh_data. Just do a naive implementation.
 		// TODO: Render the tree! (Material, Winding Order?, Camera Stuff)
-
-		Engine.IsInitialized = true;
 	}
 
 	clear_color Color = (clear_color){.R = 0.f, .G = 0.f, .B = 0.f, .A = 1.f};
 	RendererStartFrame(Color, Renderer);
 
-	UpdateScene(&Scene, EngineMemory, Renderer);
+	Renderer->Commands = CreateRenderCommandList(EngineMemory->FrameMemory);
 
+	UpdateScene(&Engine.Scene, EngineMemory, Renderer);
+	UpdateRendererStreaming((uint32_t)WindowHeight, EngineMemory, Renderer);
+
+	SortRenderCommands(&Renderer->Commands, EngineMemory->FrameMemory);
 	RendererDrawFrame(WindowWidth, WindowHeight, EngineMemory, Renderer);
 
 
 	RendererFlushFrame(Renderer);
+
+	TIMED_BLOCK_END(UpdateEngine);
 } 
\ No newline at end of file
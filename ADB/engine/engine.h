@@ -1,5 +1,21 @@
 #pragma once
 
+#include <stdint.h>
+
+#include "utilities.h"
+
 typedef struct renderer renderer;
 typedef struct engine_memory engine_memory;
+
+// Imports every OBJ and creates EntityCount entities of each mesh in them. UpdateEngine loads the
+// default scene on its first call unless a scene was loaded before.
+
+typedef struct
+{
+	byte_string *ObjPaths;
+	uint32_t     ObjCount;
+	uint32_t     EntityCount;
+} engine_scene_params;
+
+void LoadEngineScene(engine_scene_params Params, renderer *Renderer, engine_memory *EngineMemory);
 void UpdateEngine(int WindowWidth, int WindowHeight, renderer *Renderer, engine_memory *EngineMemory);
\ No newline at end of file
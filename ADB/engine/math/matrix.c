@@ -0,0 +1,28 @@
+#include "matrix.h"
+
+// Column vectors, as the shaders multiply them: A * B applies B first.
+
+mat4x4 Mat4x4Multiply(mat4x4 A, mat4x4 B)
+{
+	float *Left   = &A.c0r0;
+	float *Right  = &B.c0r0;
+	mat4x4 Result = {0};
+	float *Out    = &Result.c0r0;
+
+	for (int Column = 0; Column < 4; ++Column)
+	{
+		for (int Row = 0; Row < 4; ++Row)
+		{
+			float Sum = 0.f;
+
+			for (int Idx = 0; Idx < 4; ++Idx)
+			{
+				Sum += Left[Idx * 4 + Row] * Right[Column * 4 + Idx];
+			}
+
+			Out[Column * 4 + Row] = Sum;
+		}
+	}
+
+	return Result;
+}
\ No newline at end of file
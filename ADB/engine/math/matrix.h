@@ -6,4 +6,6 @@ typedef struct
 	float c1r0, c1r1, c1r2, c1r3;
 	float c2r0, c2r1, c2r2, c2r3;
 	float c3r0, c3r1, c3r2, c3r3;
-} mat4x4;
\ No newline at end of file
+} mat4x4;
+
+mat4x4 Mat4x4Multiply  (mat4x4 A, mat4x4 B);
\ No newline at end of file
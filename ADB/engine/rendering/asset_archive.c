@@ -0,0 +1,470 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "asset_archive.h"
+
+// ==============================================
+// <Compression> : INTERNAL
+// ==============================================
+
+// A match may not start in the last 12 bytes and the last 5 bytes are always literals, decoders
+// rely on both to copy without checking every byte.
+
+#define LZ_MIN_MATCH     4
+#define LZ_LAST_LITERALS 5
+#define LZ_MATCH_LIMIT   12
+#define LZ_MAX_OFFSET    65535
+#define LZ_HASH_BITS     12
+
+
+static uint32_t
+ReadU32(uint8_t *At)
+{
+	uint32_t Result;
+	memcpy(&Result, At, sizeof(Result));
+	return Result;
+}
+
+
+static uint8_t *
+WriteLZLength(uint8_t *Out, uint64_t Length)
+{
+	while (Length >= 255)
+	{
+		*Out++  = 255;
+		Length -= 255;
+	}
+
+	*Out++ = (uint8_t)Length;
+	return Out;
+}
+
+
+static bool
+ReadLZLength(uint8_t **In, uint8_t *InEnd, uint64_t *Length)
+{
+	bool    Result = true;
+	uint8_t Byte   = 255;
+
+	while (Byte == 255)
+	{
+		if (*In >= InEnd)
+		{
+			Result = false;
+			break;
+		}
+
+		Byte     = *(*In)++;
+		*Length += Byte;
+	}
+
+	return Result;
+}
+
+
+static uint8_t *
+WriteLZSequence(uint8_t *Out, uint8_t *Literals, uint64_t LiteralCount, uint32_t Offset, uint64_t MatchLength)
+{
+	uint8_t *Token = Out++;
+	*Token = (uint8_t)((LiteralCount < 15 ? LiteralCount : 15) << 4);
+
+	if (LiteralCount >= 15)
+	{
+		Out = WriteLZLength(Out, LiteralCount - 15);
+	}
+
+	memcpy(Out, Literals, LiteralCount);
+	Out += LiteralCount;
+
+	// A sequence without a match only ever ends the block.
+
+	if (MatchLength)
+	{
+		*Out++ = (uint8_t)(Offset & 0xFF);
+		*Out++ = (uint8_t)(Offset >> 8);
+
+		uint64_t Extra = MatchLength - LZ_MIN_MATCH;
+		*Token |= (uint8_t)(Extra < 15 ? Extra : 15);
+
+		if (Extra >= 15)
+		{
+			Out = WriteLZLength(Out, Extra - 15);
+		}
+	}
+
+	return Out;
+}
+
+// With AllowPartial the output may be smaller than the block, decoding stops once it is full.
+// Returns the number of bytes written, or 0 on malformed input.
+
+static uint64_t
+DecodeLZ(uint8_t *Input, uint64_t InputSize, uint8_t *Output, uint64_t OutputSize, bool AllowPartial)
+{
+	bool     Result = Input && Output && InputSize;
+	uint8_t *In     = Input;
+	uint8_t *InEnd  = Input + InputSize;
+	uint8_t *Out    = Output;
+	uint8_t *OutEnd = Output + OutputSize;
+
+	while (Result && In < InEnd)
+	{
+		uint8_t  Token        = *In++;
+		uint64_t LiteralCount = Token >> 4;
+
+		if (LiteralCount == 15)
+		{
+			Result = ReadLZLength(&In, InEnd, &LiteralCount);
+		}
+
+		if (AllowPartial && Result && LiteralCount > (uint64_t)(OutEnd - Out))
+		{
+			LiteralCount = (uint64_t)(OutEnd - Out);
+			InEnd        = In + LiteralCount;
+		}
+
+		if (!Result || LiteralCount > (uint64_t)(InEnd - In) || LiteralCount > (uint64_t)(OutEnd - Out))
+		{
+			Result = false;
+			break;
+		}
+
+		memcpy(Out, In, LiteralCount);
+		In  += LiteralCount;
+		Out += LiteralCount;
+
+		if (In == InEnd || (AllowPartial && Out == OutEnd))
+		{
+			break;
+		}
+
+		if (InEnd - In < 2)
+		{
+			Result = false;
+			break;
+		}
+
+		uint64_t Offset      = (uint64_t)In[0] | ((uint64_t)In[1] << 8);
+		uint64_t MatchLength = (Token & 15);
+		In += 2;
+
+		if (MatchLength == 15)
+		{
+			Result = ReadLZLength(&In, InEnd, &MatchLength);
+		}
+
+		MatchLength += LZ_MIN_MATCH;
+
+		if (AllowPartial && MatchLength > (uint64_t)(OutEnd - Out))
+		{
+			MatchLength = (uint64_t)(OutEnd - Out);
+			InEnd       = In;
+		}
+
+		if (!Result || Offset == 0 || Offset > (uint64_t)(Out - Output) || MatchLength > (uint64_t)(OutEnd - Out))
+		{
+			Result = false;
+			break;
+		}
+
+		// Overlapping matches repeat the last Offset bytes, they have to be copied forward one at a time.
+
+		uint8_t *Match = Out - Offset;
+		if (Offset >= MatchLength)
+		{
+			memcpy(Out, Match, MatchLength);
+			Out += MatchLength;
+		}
+		else
+		{
+			for (uint64_t Idx = 0; Idx < MatchLength; ++Idx)
+			{
+				*Out++ = *Match++;
+			}
+		}
+	}
+
+	uint64_t Written = (Result && (AllowPartial || Out == OutEnd)) ? (uint64_t)(Out - Output) : 0;
+	return Written;
+}
+
+// ==============================================
+// <Compression> : PUBLIC
+// ==============================================
+
+
+uint64_t
+GetCompressBound(uint64_t Size)
+{
+	uint64_t Result = Size + Size / 255 + 16;
+	return Result;
+}
+
+
+// Greedy single-probe compressor. It trades ratio for speed, this runs at pack time on every asset
+// and the decoder does not care how the matches were found.
+
+uint64_t
+CompressLZ(uint8_t *Input, uint64_t InputSize, uint8_t *Output, uint64_t OutputSize)
+{
+	uint64_t Result = 0;
+
+	if (Input && Output && OutputSize >= GetCompressBound(InputSize) && InputSize < UINT32_MAX)
+	{
+		uint32_t Table[1 << LZ_HASH_BITS] = {0};
+		uint8_t *Out                      = Output;
+		uint64_t Anchor                   = 0;
+		uint64_t At                       = 0;
+
+		if (InputSize > LZ_MATCH_LIMIT)
+		{
+			uint64_t MatchStartLimit = InputSize - LZ_MATCH_LIMIT;
+			uint64_t MatchEndLimit   = InputSize - LZ_LAST_LITERALS;
+
+			while (At < MatchStartLimit)
+			{
+				uint32_t Sequence  = ReadU32(Input + At);
+				uint32_t Hash      = (Sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+				uint64_t Candidate = Table[Hash];
+
+				Table[Hash] = (uint32_t)At;
+
+				if (Candidate < At && At - Candidate <= LZ_MAX_OFFSET && ReadU32(Input + Candidate) == Sequence)
+				{
+					uint64_t MatchLength = LZ_MIN_MATCH;
+					while (At + MatchLength < MatchEndLimit && Input[Candidate + MatchLength] == Input[At + MatchLength])
+					{
+						++MatchLength;
+					}
+
+					Out    = WriteLZSequence(Out, Input + Anchor, At - Anchor, (uint32_t)(At - Candidate), MatchLength);
+					At    += MatchLength;
+					Anchor = At;
+				}
+				else
+				{
+					++At;
+				}
+			}
+		}
+
+		Out    = WriteLZSequence(Out, Input + Anchor, InputSize - Anchor, 0, 0);
+		Result = (uint64_t)(Out - Output);
+	}
+
+	return Result;
+}
+
+
+bool
+DecompressLZ(uint8_t *Input, uint64_t InputSize, uint8_t *Output, uint64_t OutputSize)
+{
+	bool Result = DecodeLZ(Input, InputSize, Output, OutputSize, false) == OutputSize;
+	return Result;
+}
+
+// ==============================================
+// <Asset Archive> : INTERNAL
+// ==============================================
+
+
+static asset_archive *MountedArchives;
+
+
+static bool
+IsArchiveEntryValid(asset_archive *Archive, asset_archive_entry *Entry)
+{
+	uint64_t End    = Entry->Offset + Entry->PackedSize + 1;
+	bool     Result = Entry->Offset >= sizeof(asset_archive_header) && End > Entry->Offset && End <= Archive->Header->SlotOffset;
+
+	if (Entry->Compression == ArchiveCompression_None)
+	{
+		Result = Result && Entry->PackedSize == Entry->Size;
+	}
+	else
+	{
+		Result = Result && Entry->Compression == ArchiveCompression_LZ;
+	}
+
+	return Result;
+}
+
+// ==============================================
+// <Asset Archive> : PUBLIC
+// ==============================================
+
+
+asset_archive *
+MountAssetArchive(byte_string Path, memory_arena *Arena)
+{
+	asset_archive *Result = 0;
+	buffer         File   = OSMapFile(Path);
+
+	if (IsBufferValid(&File) && File.Size >= sizeof(asset_archive_header))
+	{
+		asset_archive_header *Header = (asset_archive_header *)File.Data;
+
+		bool IsPowerOfTwo = Header->SlotCount && (Header->SlotCount & (Header->SlotCount - 1)) == 0;
+		bool IsValid      = Header->Magic == ASSET_ARCHIVE_MAGIC && Header->Version == ASSET_ARCHIVE_VERSION && IsPowerOfTwo &&
+		                    Header->EntryCount <= Header->SlotCount && Header->SlotOffset >= sizeof(asset_archive_header) &&
+		                    Header->SlotOffset + (uint64_t)Header->SlotCount * sizeof(asset_archive_entry) <= File.Size;
+
+		Result = IsValid ? PushStruct(Arena, asset_archive) : 0;
+		if (Result)
+		{
+			Result->File   = File;
+			Result->Header = Header;
+			Result->Slots  = (asset_archive_entry *)(File.Data + Header->SlotOffset);
+			Result->Next   = MountedArchives;
+
+			MountedArchives = Result;
+		}
+	}
+
+	if (!Result)
+	{
+		OSUnmapFile(&File);
+	}
+
+	return Result;
+}
+
+
+void
+UnmountAssetArchives(void)
+{
+	for (asset_archive *Archive = MountedArchives; Archive != 0; Archive = Archive->Next)
+	{
+		OSUnmapFile(&Archive->File);
+	}
+
+	MountedArchives = 0;
+}
+
+
+asset_archive_entry *
+FindArchiveEntry(asset_archive *Archive, resource_uuid UUID)
+{
+	asset_archive_entry *Result = 0;
+
+	if (Archive && UUID.Value)
+	{
+		uint32_t Mask = Archive->Header->SlotCount - 1;
+		uint32_t Slot = (uint32_t)UUID.Value & Mask;
+
+		for (uint32_t Probe = 0; Probe < Archive->Header->SlotCount; ++Probe)
+		{
+			asset_archive_entry *Entry = Archive->Slots + Slot;
+
+			if (Entry->UUID == 0)
+			{
+				break;
+			}
+
+			if (Entry->UUID == UUID.Value)
+			{
+				Result = IsArchiveEntryValid(Archive, Entry) ? Entry : 0;
+				break;
+			}
+
+			Slot = (Slot + 1) & Mask;
+		}
+	}
+
+	return Result;
+}
+
+
+asset_read
+BeginAssetRead(byte_string Path, memory_arena *Arena)
+{
+	asset_read           Result  = {0};
+	resource_uuid        UUID    = MakeResourceUUID(Path);
+	asset_archive       *Archive = MountedArchives;
+	asset_archive_entry *Entry   = 0;
+
+	for (; Archive != 0; Archive = Archive->Next)
+	{
+		Entry = FindArchiveEntry(Archive, UUID);
+		if (Entry)
+		{
+			break;
+		}
+	}
+
+	if (!Entry)
+	{
+		Result.Output = ReadFileInBuffer(Path, Arena);
+	}
+	else if (Entry->Compression == ArchiveCompression_None)
+	{
+		// Stored entries are served straight from the mapping, the writer put the null byte after them.
+
+		Result.Output.Data = Archive->File.Data + Entry->Offset;
+		Result.Output.Size = (size_t)Entry->Size + 1;
+	}
+	else
+	{
+		Result.Output.Data = PushArray(Arena, uint8_t, (uint64_t)Entry->Size + 1);
+		if (Result.Output.Data)
+		{
+			Result.Output.Data[Entry->Size] = '\0';
+			Result.Output.Size              = (size_t)Entry->Size + 1;
+			Result.Packed                   = Entry;
+			Result.PackedData               = Archive->File.Data + Entry->Offset;
+		}
+	}
+
+	return Result;
+}
+
+
+void
+FinishAssetRead(asset_read *Read)
+{
+	if (Read && Read->Packed)
+	{
+		asset_archive_entry *Entry = Read->Packed;
+
+		if (!DecompressLZ(Read->PackedData, Entry->PackedSize, Read->Output.Data, Entry->Size))
+		{
+			Read->Output = (buffer){0};
+		}
+
+		Read->Packed     = 0;
+		Read->PackedData = 0;
+	}
+}
+
+
+byte_string
+PeekAssetRead(asset_read *Read, uint64_t Size)
+{
+	byte_string Result = {0};
+
+	if (Read && Read->Packed && IsBufferValid(&Read->Output))
+	{
+		Result.Data = Read->Output.Data;
+		Result.Size = DecodeLZ(Read->PackedData, Read->Packed->PackedSize, Read->Output.Data, Minimum(Size, Read->Packed->Size), true);
+	}
+	else if (Read && IsBufferValid(&Read->Output))
+	{
+		Result.Data = Read->Output.Data;
+		Result.Size = Minimum(Size, Read->Output.Size - 1);
+	}
+
+	return Result;
+}
+
+
+buffer
+ReadAssetInBuffer(byte_string Path, memory_arena *Arena)
+{
+	asset_read Read = BeginAssetRead(Path, Arena);
+	FinishAssetRead(&Read);
+
+	return Read.Output;
+}
\ No newline at end of file
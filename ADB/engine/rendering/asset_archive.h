@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "assets.h"
+
+// ==============================================
+// <Asset Archive>
+// ==============================================
+
+// A single file holding many assets, written by adb-pack. Layout:
+//
+//   asset_archive_header | entry data ... | slot table
+//
+// The slot table is an open-addressed hash table of SlotCount entries keyed by the resource uuid of
+// the path the asset was packed from (a zero uuid marks an empty slot). Every entry's data is
+// followed by a null byte so uncompressed entries can be handed out in place, with the same
+// trailing byte ReadFileInBuffer adds. Little-endian only.
+
+#define ASSET_ARCHIVE_MAGIC   0x4B504441 // 'ADPK'
+#define ASSET_ARCHIVE_VERSION 1
+
+
+typedef enum
+{
+	ArchiveCompression_None = 0,
+	ArchiveCompression_LZ   = 1,
+} ArchiveCompression_Type;
+
+
+typedef struct
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t EntryCount;
+	uint32_t SlotCount;
+	uint64_t SlotOffset;
+} asset_archive_header;
+
+
+typedef struct asset_archive_entry
+{
+	uint64_t UUID;
+	uint64_t Offset;
+	uint32_t PackedSize;
+	uint32_t Size;
+	uint32_t Compression;
+	uint32_t Reserved;
+} asset_archive_entry;
+
+
+typedef struct asset_archive asset_archive;
+struct asset_archive
+{
+	asset_archive        *Next;
+	buffer                File;
+	asset_archive_header *Header;
+	asset_archive_entry  *Slots;
+};
+
+// Mounting is not thread-safe, do it before any job reads assets. Archives mounted later are
+// searched first so they can override earlier ones.
+
+asset_archive       * MountAssetArchive     (byte_string Path, memory_arena *Arena);
+void                  UnmountAssetArchives  (void);
+asset_archive_entry * FindArchiveEntry      (asset_archive *Archive, resource_uuid UUID);
+
+// Looks through the mounted archives first and falls back to the file system. Either way the result
+// looks like what ReadFileInBuffer returns.
+
+asset_read            BeginAssetRead        (byte_string Path, memory_arena *Arena);
+void                  FinishAssetRead       (asset_read *Read);
+
+// The first Size bytes of an unfinished read (fewer if the asset is smaller), meant for headers.
+// Compressed entries are decoded only that far, into Output, which FinishAssetRead overwrites.
+byte_string           PeekAssetRead         (asset_read *Read, uint64_t Size);
+buffer                ReadAssetInBuffer     (byte_string Path, memory_arena *Arena);
+
+// ==============================================
+// <Compression>
+// ==============================================
+
+// LZ4 block format. Decompression checks every bound and returns false on malformed input.
+
+uint64_t              GetCompressBound      (uint64_t Size);
+uint64_t              CompressLZ            (uint8_t *Input, uint64_t InputSize, uint8_t *Output, uint64_t OutputSize);
+bool                  DecompressLZ          (uint8_t *Input, uint64_t InputSize, uint8_t *Output, uint64_t OutputSize);
\ No newline at end of file
@@ -1,32 +1,344 @@
 #include <assert.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+
+// stb_image allocates from the image scratch arena of the decoding thread. Nothing is freed on its
+// own, DecodeImageWithSTB pops the whole decode once the pixels are copied out.
+
+static void * AllocateImageMemory   (size_t Size);
+static void * ReallocateImageMemory (void *Memory, size_t OldSize, size_t NewSize);
+
+#define STBI_MALLOC(Size)                            AllocateImageMemory(Size)
+#define STBI_REALLOC_SIZED(Memory, OldSize, NewSize) ReallocateImageMemory(Memory, OldSize, NewSize)
+#define STBI_FREE(Memory)                            ((void)(Memory))
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_FLIP_VERTICALLY_ON_LOAD 1
 #include "third_party/stb_image.h"
 
 #include "assets.h"
+#include "asset_archive.h"
+#include "parsers/parser_png.h"
+#include "textures/texture_mips.h"
 
-void 
-LoadTextureFromDisk(platform_work_queue *Queue, texture_to_load *ToLoad)
+// Enough for the headers stbi_info needs, JPEGs with a large EXIF block are the worst case.
+#define TEXTURE_HEADER_PEEK_SIZE KiB(64)
+
+// ==============================================
+// <Image Memory> : INTERNAL
+// ==============================================
+
+
+static ThreadLocal memory_arena *ImageScratch;
+
+
+static memory_arena *
+GetImageScratch(void)
+{
+	if (!ImageScratch)
+	{
+		memory_arena_params Params =
+		{
+			.AllocatedFromFile = __FILE__,
+			.AllocatedFromLine = __LINE__,
+			.ReserveSize       = MiB(64),
+			.CommitSize        = KiB(64),
+		};
+
+		ImageScratch = AllocateArena(Params);
+	}
+
+	return ImageScratch;
+}
+
+
+static void *
+AllocateImageMemory(size_t Size)
+{
+	void *Result = PushArena(GetImageScratch(), Size, 16);
+	return Result;
+}
+
+
+static void *
+ReallocateImageMemory(void *Memory, size_t OldSize, size_t NewSize)
+{
+	memory_arena *Arena  = GetImageScratch();
+	void         *Result = Memory;
+
+	if (!Memory)
+	{
+		Result = AllocateImageMemory(NewSize);
+	}
+	else if (NewSize > OldSize)
+	{
+		// stb grows its zlib output by doubling. When that block is the last push it simply extends.
+
+		uint8_t *End    = (uint8_t *)Memory + OldSize;
+		bool     IsLast = End == (uint8_t *)Arena->Current + Arena->Current->Position;
+
+		if (!IsLast || PushArena(Arena, NewSize - OldSize, 1) != End)
+		{
+			Result = AllocateImageMemory(NewSize);
+			if (Result)
+			{
+				memcpy(Result, Memory, OldSize);
+			}
+		}
+	}
+
+	return Result;
+}
+
+// ==============================================
+// <Decoding> : INTERNAL
+// ==============================================
+
+
+static bool
+HasTransparentPixels(uint8_t *Pixels, uint64_t PixelCount)
+{
+	bool Result = false;
+
+	for (uint64_t Idx = 0; Idx < PixelCount && !Result; ++Idx)
+	{
+		Result = Pixels[Idx * 4 + 3] != 0xFF;
+	}
+
+	return Result;
+}
+
+// ==============================================
+// <IO> : PUBLIC
+// ==============================================
+
+
+resource_uuid
+MakeResourceUUID(byte_string PathToResource)
+{
+	resource_uuid Result = {0};
+
+	// Resolve the path into a local copy before hashing. Where each segment starts is kept so ".."
+	// can pop the previous one. Paths that do not fit are hashed as they are.
+
+	uint8_t  Normalized[1024];
+	uint32_t SegmentStarts[128];
+	bool     SegmentIsParent[128];
+	uint32_t SegmentCount = 0;
+	uint64_t Size         = 0;
+	bool     Fits         = PathToResource.Size <= sizeof(Normalized);
+
+	if (Fits && PathToResource.Size && (PathToResource.Data[0] == '/' || PathToResource.Data[0] == '\\'))
+	{
+		Normalized[Size++] = '/';
+	}
+
+	uint64_t Start = 0;
+	for (uint64_t At = 0; Fits && At <= PathToResource.Size; ++At)
+	{
+		if (At < PathToResource.Size && PathToResource.Data[At] != '/' && PathToResource.Data[At] != '\\')
+		{
+			continue;
+		}
+
+		uint8_t *Segment     = PathToResource.Data + Start;
+		uint64_t SegmentSize = At - Start;
+		Start                = At + 1;
+
+		bool IsEmpty  = SegmentSize == 0 || (SegmentSize == 1 && Segment[0] == '.');
+		bool IsParent = SegmentSize == 2 && Segment[0] == '.' && Segment[1] == '.';
+
+		if (IsEmpty)
+		{
+			continue;
+		}
+
+		if (IsParent && SegmentCount && !SegmentIsParent[SegmentCount - 1])
+		{
+			Size = SegmentStarts[--SegmentCount];
+			continue;
+		}
+
+		if (SegmentCount == ArrayCount(SegmentStarts))
+		{
+			Fits = false;
+			break;
+		}
+
+		SegmentStarts[SegmentCount]   = (uint32_t)Size;
+		SegmentIsParent[SegmentCount] = IsParent;
+		++SegmentCount;
+
+		if (Size && Normalized[Size - 1] != '/')
+		{
+			Normalized[Size++] = '/';
+		}
+
+		memcpy(Normalized + Size, Segment, SegmentSize);
+		Size += SegmentSize;
+	}
+
+	if (Fits)
+	{
+		Result.Value = HashByteString(ByteString(Normalized, Size));
+	}
+	else
+	{
+		Result.Value = HashByteString(PathToResource);
+	}
+
+	return Result;
+}
+
+
+
+void
+PrepareTextureLoad(texture_to_load *ToLoad, memory_arena *Arena)
 {
-	assert(Queue);
 	assert(ToLoad);
 
-	// In which cases is this needed? All?
-	stbi_set_flip_vertically_on_load(1);
+	byte_string Header = PeekAssetRead(&ToLoad->FileContent, TEXTURE_HEADER_PEEK_SIZE);
+	png_info    Info   = ReadPNGInfo(Header.Data, Header.Size);
+
+	ToLoad->Pixels      = 0;
+	ToLoad->Width       = 0;
+	ToLoad->Height      = 0;
+	ToLoad->Scratch     = 0;
+	ToLoad->ScratchSize = 0;
+
+	if (Info.IsSupported)
+	{
+		uint64_t FileSize = ToLoad->FileContent.Output.Size - 1;
+
+		ToLoad->Width       = Info.Width;
+		ToLoad->Height      = Info.Height;
+		ToLoad->ScratchSize = GetPNGScratchSize(Info, FileSize);
+		ToLoad->Scratch     = PushArray(Arena, uint8_t, ToLoad->ScratchSize);
+	}
+	else if (Header.Size)
+	{
+		int Width    = 0;
+		int Height   = 0;
+		int Channels = 0;
+
+		if (stbi_info_from_memory(Header.Data, (int)Header.Size, &Width, &Height, &Channels))
+		{
+			ToLoad->Width  = (uint32_t)Width;
+			ToLoad->Height = (uint32_t)Height;
+		}
+	}
+
+	if (ToLoad->Width && ToLoad->Height)
+	{
+		ToLoad->Pixels = PushArray(Arena, uint8_t, GetMipChainSize(ToLoad->Width, ToLoad->Height, 4));
+	}
+}
+
+
+void
+ReadTextureSource(platform_work_queue *Queue, texture_to_load *ToLoad)
+{
+	(void)Queue;
+	assert(ToLoad);
 
 	// TODO:
 	// 1) Instead of handling the file read on the "main" thread we could ask it to query the OS for the
 	//    file size and then allocate memory from which we can read the file into.
-	// 2) Write our own texture loader? How hard is it to handle the basic formats? (JPEG, PNG)
 
-	if (ToLoad->Output && IsBufferValid(&ToLoad->FileContent))
+	// Archived textures are decompressed here rather than on the thread that queued us.
+
+	FinishAssetRead(&ToLoad->FileContent);
+
+	buffer *FileContent = &ToLoad->FileContent.Output;
+
+	ToLoad->SourceHash = 0;
+	if (ToLoad->UseCache && IsBufferValid(FileContent))
 	{
-		loaded_texture *Texture = ToLoad->Output;
+		ToLoad->SourceHash = HashByteString(ByteString(FileContent->Data, FileContent->Size - 1));
+	}
+}
 
-		// Currently we force to RGBA. Unsure if it's the correct choice, but we do this for simplicity.
 
-		Texture->Data          = stbi_load_from_memory(ToLoad->FileContent.Data, ToLoad->FileContent.Size, &Texture->Width, &Texture->Height, &Texture->BytesPerPixel, 4);
-		Texture->BytesPerPixel = 4;
+bool
+DecodeTexture(texture_to_load *ToLoad)
+{
+	assert(ToLoad);
+
+	buffer *FileContent = &ToLoad->FileContent.Output;
+	bool    Result      = false;
+
+	if (ToLoad->Output && ToLoad->Pixels && IsBufferValid(FileContent))
+	{
+		loaded_texture *Texture  = ToLoad->Output;
+		uint64_t        FileSize = FileContent->Size - 1;
+
+		// Decoded to RGBA8, the import converts to smaller formats later (textures/texture_compress.h).
+		// stb_image still gets a go at the PNGs we reject, it is more lenient about broken files.
+
+		if (ToLoad->Scratch)
+		{
+			Result = DecodePNG(FileContent->Data, FileSize, ToLoad->Pixels, ToLoad->Scratch, ToLoad->ScratchSize, true);
+		}
+
+		if (!Result)
+		{
+			Result = DecodeImageWithSTB(FileContent->Data, FileSize, ToLoad->Pixels, ToLoad->Width, ToLoad->Height);
+		}
+
+		if (Result)
+		{
+			Texture->Data          = ToLoad->Pixels;
+			Texture->Width         = ToLoad->Width;
+			Texture->Height        = ToLoad->Height;
+			Texture->BytesPerPixel = 4;
+			Texture->MipCount      = 1;
+			Texture->Format        = TextureFormat_RGBA8;
+			Texture->HasAlpha      = HasTransparentPixels(ToLoad->Pixels, (uint64_t)ToLoad->Width * ToLoad->Height);
+			Texture->CacheKey      = 0;
+			Texture->StreamKey     = 0;
+		}
+	}
+
+	return Result;
+}
+
+
+void
+LoadTextureFromDisk(platform_work_queue *Queue, texture_to_load *ToLoad)
+{
+	assert(Queue);
+	assert(ToLoad);
+
+	ReadTextureSource(Queue, ToLoad);
+	DecodeTexture(ToLoad);
+}
+
+
+bool
+DecodeImageWithSTB(uint8_t *Data, uint64_t Size, uint8_t *Pixels, uint32_t Width, uint32_t Height)
+{
+	memory_region Region = EnterMemoryRegion(GetImageScratch());
+
+	stbi_set_flip_vertically_on_load_thread(1);
+
+	int      DecodedWidth  = 0;
+	int      DecodedHeight = 0;
+	int      Channels      = 0;
+	uint8_t *Decoded       = 0;
+
+	if (Data && Pixels && Size <= INT32_MAX)
+	{
+		Decoded = stbi_load_from_memory(Data, (int)Size, &DecodedWidth, &DecodedHeight, &Channels, 4);
 	}
+
+	bool Result = Decoded && (uint32_t)DecodedWidth == Width && (uint32_t)DecodedHeight == Height;
+	if (Result)
+	{
+		memcpy(Pixels, Decoded, (uint64_t)Width * Height * 4);
+	}
+
+	LeaveMemoryRegion(Region);
+	return Result;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "utilities.h"
 #include "engine/math/vector.h"
@@ -12,23 +13,126 @@
 
 typedef struct
 {
-	uint32_t    Width;
-	uint32_t    Height;
-	uint32_t    BytesPerPixel;
-	uint8_t    *Data;
-	byte_string Path;
+	uint64_t Value;
+} resource_uuid;
+
+
+// Paths are hashed as if "./", "../" and backslashes were resolved, "a/b/../c.png" and "a/c.png"
+// give the same uuid.
+
+resource_uuid MakeResourceUUID(byte_string PathToResource);
+
+
+// A read that may still have work left to do. When the asset comes from a compressed archive entry,
+// Output is allocated but only filled by FinishAssetRead, which is safe to call from a job.
+
+typedef struct asset_archive_entry asset_archive_entry;
+typedef struct
+{
+	buffer               Output;
+	asset_archive_entry *Packed;
+	uint8_t             *PackedData;
+} asset_read;
+
+
+typedef enum
+{
+	MaterialMap_Color     = 0,
+	MaterialMap_Normal    = 1,
+	MaterialMap_Roughness = 2,
+	MaterialMap_Metalness = 3,
+	MaterialMap_Occlusion = 4,
+
+	MaterialMap_Count     = 5,
+} MaterialMap_Type;
+
+
+// What the maps are packed into at import, see textures/texture_pack.h.
+
+typedef enum
+{
+	MaterialTexture_Albedo  = 0,
+	MaterialTexture_Surface = 1,
+
+	MaterialTexture_Count   = 2,
+} MaterialTexture_Type;
+
+
+// The block formats store 4x4 texels per block, see textures/texture_compress.h.
+
+typedef enum
+{
+	TextureFormat_RGBA8 = 0,
+	TextureFormat_BC1   = 1,
+	TextureFormat_BC3   = 2,
+	TextureFormat_BC4   = 3,
+	TextureFormat_BC5   = 4,
+	TextureFormat_BC7   = 5,
+
+	TextureFormat_Count = 6,
+} TextureFormat_Type;
+
+
+typedef struct
+{
+	uint32_t           Width;
+	uint32_t           Height;
+	uint32_t           BytesPerPixel; // RGBA8 only, 0 for the block formats.
+	uint32_t           MipCount;      // Levels stored in Data, see textures/texture_mips.h. 0 means 1.
+	TextureFormat_Type Format;
+	uint8_t           *Data;
+	byte_string        Path;
+	bool               IsSRGB;        // Color data, mips are filtered in linear space.
+	bool               HasAlpha;      // Some texel is not fully opaque.
+
+	// Set on import when the texture cache missed, StoreCachedTextures writes the processed texture
+	// under this key and clears it.
+	uint64_t           CacheKey;
+
+	// Where the texture cache holds this texture once it is stored or was loaded from it, 0 when it
+	// is not there. Lets textures/texture_streaming.h read levels back later.
+	uint64_t           StreamKey;
 } loaded_texture;
 
 
 typedef struct
 {
-	buffer          FileContent;
-	loaded_texture *Output;
-	uint32_t        Id;
+	asset_read       FileContent;
+	loaded_texture  *Output;
+	uint32_t         Id;
+	MaterialMap_Type Map;
+	bool             UseCache;      // Hash the file for the texture cache.
+
+	// Set by ReadTextureSource when UseCache is, 0 otherwise.
+	uint64_t         SourceHash;
+
+	// Set by PrepareTextureLoad. The decoded pixels land in Pixels, which has room for the whole mip
+	// chain. Scratch is only reserved for the formats we decode ourselves, the others go through
+	// stb_image.
+	uint8_t         *Pixels;
+	uint32_t         Width;
+	uint32_t         Height;
+	uint8_t         *Scratch;
+	uint64_t         ScratchSize;
 } texture_to_load;
 
 typedef struct platform_work_queue platform_work_queue;
-void LoadTextureFromDisk(platform_work_queue *Queue, texture_to_load *ToLoad);
+
+// Reads the image header and reserves the decoded pixels and decoder scratch from Arena, which then
+// owns the texture data. Must run on the thread that owns Arena, before the load is queued.
+void PrepareTextureLoad  (texture_to_load *ToLoad, memory_arena *Arena);
+
+// The load is split so the importer can look the texture cache up before paying for the decode:
+// ReadTextureSource finishes the read and hashes the file, DecodeTexture fills Output. Both may run
+// from a job. LoadTextureFromDisk does the two back to back.
+void ReadTextureSource   (platform_work_queue *Queue, texture_to_load *ToLoad);
+bool DecodeTexture       (texture_to_load *ToLoad);
+void LoadTextureFromDisk (platform_work_queue *Queue, texture_to_load *ToLoad);
+
+// Decodes to RGBA8 with stb_image into Pixels, which holds Width * Height * 4 bytes as reported by
+// stbi_info. stb_image allocates from a scratch arena owned by the calling thread, released before
+// returning.
+bool DecodeImageWithSTB  (uint8_t *Data, uint64_t Size, uint8_t *Pixels, uint32_t Width, uint32_t Height);
 
 // ==============================================
 // <Data>
@@ -43,23 +147,14 @@ typedef struct
 } mesh_vertex_data;
 
 
-typedef enum
-{
-	MaterialMap_Color     = 0,
-	MaterialMap_Normal    = 1,
-	MaterialMap_Roughness = 2,
-
-	MaterialMap_Count     = 3,
-} MaterialMap_Type;
-
-
 typedef struct
 {
 	float          Shininess;
 	float          Opacity;
 
 	byte_string    Path;
-	loaded_texture Textures[MaterialMap_Count];
+	byte_string    MapPaths[MaterialMap_Count];     // The sources, empty when the slot is unused.
+	loaded_texture Textures[MaterialTexture_Count];
 } material_data;
 
 
@@ -0,0 +1,100 @@
+#include <stdint.h>
+#include <assert.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "baked_assets.h" // Implementation File
+#include "textures/texture_mips.h"
+#include "textures/texture_pack.h"
+
+// ==============================================
+// <Writing> : INTERNAL
+// ==============================================
+
+
+static bool
+IsBakeableTextureFormat(uint32_t Format, uint32_t BytesPerPixel)
+{
+	bool Result = Format < TextureFormat_Count && (Format == TextureFormat_RGBA8 ? BytesPerPixel == 4 : BytesPerPixel == 0);
+	return Result;
+}
+
+// ==============================================
+// <Writing> : PUBLIC
+// ==============================================
+
+
+buffer
+BakeTexture(loaded_texture *Texture, memory_arena *Arena)
+{
+	buffer Result = {0};
+
+	if (Texture && Texture->Data && Texture->Width && Texture->Height && IsBakeableTextureFormat(Texture->Format, Texture->BytesPerPixel))
+	{
+		uint32_t MipCount = Maximum(Texture->MipCount, 1);
+		uint64_t DataSize = GetTextureDataSize(Texture->Width, Texture->Height, Texture->Format, MipCount);
+		uint64_t Size     = sizeof(baked_texture_header) + DataSize;
+		uint8_t *Data     = PushArray(Arena, uint8_t, Size);
+
+		if (Data)
+		{
+			baked_texture_header *Header = (baked_texture_header *)Data;
+			Header->Magic         = BAKED_TEXTURE_MAGIC;
+			Header->Version       = BAKED_ASSET_VERSION;
+			Header->Width         = Texture->Width;
+			Header->Height        = Texture->Height;
+			Header->BytesPerPixel = Texture->BytesPerPixel;
+			Header->MipCount      = MipCount;
+			Header->Format        = Texture->Format;
+			Header->Flags         = (Texture->IsSRGB ? BakedTextureFlag_SRGB : 0) | (Texture->HasAlpha ? BakedTextureFlag_HasAlpha : 0);
+			Header->DataSize      = DataSize;
+
+			memcpy(Header + 1, Texture->Data, DataSize);
+
+			Result.Data = Data;
+			Result.Size = Size;
+			Result.At   = 0;
+		}
+	}
+
+	return Result;
+}
+
+// ==============================================
+// <Reading> : PUBLIC
+// ==============================================
+
+
+loaded_texture
+ReadBakedTexture(buffer *Buffer)
+{
+	loaded_texture Result = {0};
+
+	if (IsBufferValid(Buffer) && Buffer->Size >= sizeof(baked_texture_header))
+	{
+		baked_texture_header *Header = (baked_texture_header *)Buffer->Data;
+
+		bool IsValid = Header->Magic   == BAKED_TEXTURE_MAGIC &&
+		               Header->Version == BAKED_ASSET_VERSION &&
+		               Header->Width  && Header->Width  <= (1u << (MAX_TEXTURE_MIP_COUNT - 1)) &&
+		               Header->Height && Header->Height <= (1u << (MAX_TEXTURE_MIP_COUNT - 1)) &&
+		               Header->MipCount >= 1 && Header->MipCount <= GetMipCount(Header->Width, Header->Height) &&
+		               IsBakeableTextureFormat(Header->Format, Header->BytesPerPixel) &&
+		               Header->DataSize == GetTextureDataSize(Header->Width, Header->Height, Header->Format, Header->MipCount) &&
+		               sizeof(baked_texture_header) + Header->DataSize <= Buffer->Size;
+
+		if (IsValid)
+		{
+			Result.Width         = Header->Width;
+			Result.Height        = Header->Height;
+			Result.BytesPerPixel = Header->BytesPerPixel;
+			Result.MipCount      = Header->MipCount;
+			Result.Format        = (TextureFormat_Type)Header->Format;
+			Result.IsSRGB        = (Header->Flags & BakedTextureFlag_SRGB) != 0;
+			Result.HasAlpha      = (Header->Flags & BakedTextureFlag_HasAlpha) != 0;
+			Result.Data          = (uint8_t *)(Header + 1);
+		}
+	}
+
+	return Result;
+}
\ No newline at end of file
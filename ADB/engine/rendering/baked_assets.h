@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "utilities.h"
+#include "assets.h"
+
+// ==============================================
+// <Baked Assets>
+// ==============================================
+
+// Binary textures as the importer finishes them, written by the texture cache (textures/texture_cache.h),
+// which adb-bake fills ahead of time, so a load is a read instead of an image decode.
+// Meshes are not baked, the OBJ parser is what loads them. Little-endian only.
+
+#define BAKED_TEXTURE_MAGIC 0x58544441 // 'ADTX'
+#define BAKED_ASSET_VERSION 4
+
+
+typedef enum
+{
+	BakedTextureFlag_SRGB     = 1 << 0,
+	BakedTextureFlag_HasAlpha = 1 << 1,
+} BakedTextureFlag_Type;
+
+
+typedef struct
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t BytesPerPixel;
+	uint32_t MipCount;
+	uint32_t Format;        // TextureFormat_Type
+	uint32_t Flags;         // BakedTextureFlag_Type
+	uint64_t DataSize;
+} baked_texture_header;
+
+
+buffer          BakeTexture          (loaded_texture *Texture, memory_arena *Arena);
+
+// The result points into the buffer, it must outlive it.
+
+loaded_texture  ReadBakedTexture     (buffer *Buffer);
\ No newline at end of file
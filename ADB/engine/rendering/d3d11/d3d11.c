@@ -14,8 +14,10 @@
 
 #include "utilities.h"
 #include "platform/platform.h"
+#include "platform/profiler.h"
 #include "engine/rendering/renderer.h"
 #include "engine/rendering/assets.h"
+#include "engine/rendering/textures/texture_mips.h"
 
 #include "mesh_vertex_shader.h"
 #include "mesh_pixel_shader.h"
@@ -200,6 +202,26 @@ RendererCreateVertexBuffer(void *Data, uint64_t Size, renderer *Renderer)
     return Result;
 }
 
+static DXGI_FORMAT
+GetDXGIFormat(TextureFormat_Type Format)
+{
+    // Color stays UNORM, the shaders expect the sRGB values as they are stored.
+
+    static const DXGI_FORMAT Formats[TextureFormat_Count] =
+    {
+        [TextureFormat_RGBA8] = DXGI_FORMAT_R8G8B8A8_UNORM,
+        [TextureFormat_BC1]   = DXGI_FORMAT_BC1_UNORM,
+        [TextureFormat_BC3]   = DXGI_FORMAT_BC3_UNORM,
+        [TextureFormat_BC4]   = DXGI_FORMAT_BC4_UNORM,
+        [TextureFormat_BC5]   = DXGI_FORMAT_BC5_UNORM,
+        [TextureFormat_BC7]   = DXGI_FORMAT_BC7_UNORM,
+    };
+
+    DXGI_FORMAT Result = (uint32_t)Format < TextureFormat_Count ? Formats[Format] : DXGI_FORMAT_UNKNOWN;
+    return Result;
+}
+
+
 void *
 RendererCreateTexture(loaded_texture LoadedTexture, renderer *Renderer)
 {
@@ -207,18 +229,21 @@ RendererCreateTexture(loaded_texture LoadedTexture, renderer *Renderer)
 
     // The BytesPerPixel check is artificial and should be removed.
 
-    if (LoadedTexture.Data && LoadedTexture.Width && LoadedTexture.Height && LoadedTexture.BytesPerPixel == 4)
+    bool IsSupported = LoadedTexture.Format == TextureFormat_RGBA8 ? LoadedTexture.BytesPerPixel == 4 : GetDXGIFormat(LoadedTexture.Format) != DXGI_FORMAT_UNKNOWN;
+
+    if (LoadedTexture.Data && LoadedTexture.Width && LoadedTexture.Height && IsSupported)
     {
-        d3d11_renderer *D3D11 = (d3d11_renderer *)Renderer->Backend;
-        ID3D11Device   *Device = D3D11->Device;
+        d3d11_renderer *D3D11    = (d3d11_renderer *)Renderer->Backend;
+        ID3D11Device   *Device   = D3D11->Device;
+        uint32_t        MipCount = Minimum(Maximum(LoadedTexture.MipCount, 1), MAX_TEXTURE_MIP_COUNT);
 
         D3D11_TEXTURE2D_DESC TextureDesc =
         {
             .Width              = LoadedTexture.Width,
             .Height             = LoadedTexture.Height,
-            .MipLevels          = 1,
+            .MipLevels          = MipCount,
             .ArraySize          = 1,
-            .Format             = DXGI_FORMAT_R8G8B8A8_UNORM,
+            .Format             = GetDXGIFormat(LoadedTexture.Format),
             .SampleDesc.Count   = 1,
             .SampleDesc.Quality = 0,
             .Usage              = D3D11_USAGE_IMMUTABLE,
@@ -227,14 +252,18 @@ RendererCreateTexture(loaded_texture LoadedTexture, renderer *Renderer)
             .MiscFlags          = 0,
         };
         
-        D3D11_SUBRESOURCE_DATA InitialData =
+        D3D11_SUBRESOURCE_DATA InitialData[MAX_TEXTURE_MIP_COUNT] = {0};
+
+        for (uint32_t Level = 0; Level < MipCount; ++Level)
         {
-            .pSysMem     = LoadedTexture.Data,
-            .SysMemPitch = LoadedTexture.Width * LoadedTexture.BytesPerPixel,
-        };
+            texture_mip Mip = GetTextureMip(&LoadedTexture, Level);
+
+            InitialData[Level].pSysMem     = Mip.Data;
+            InitialData[Level].SysMemPitch = Mip.Pitch;
+        }
         
         ID3D11Texture2D *Texture = 0;
-        Device->lpVtbl->CreateTexture2D(Device, &TextureDesc, &InitialData, &Texture);
+        Device->lpVtbl->CreateTexture2D(Device, &TextureDesc, InitialData, &Texture);
         if (Texture)
         {
             D3D11_SHADER_RESOURCE_VIEW_DESC TextureViewDesc =
@@ -242,7 +271,7 @@ RendererCreateTexture(loaded_texture LoadedTexture, renderer *Renderer)
                 .Format                    = TextureDesc.Format,
                 .ViewDimension             = D3D11_SRV_DIMENSION_TEXTURE2D,
                 .Texture2D.MostDetailedMip = 0,
-                .Texture2D.MipLevels       = 1,
+                .Texture2D.MipLevels       = MipCount,
             };
         
             Device->lpVtbl->CreateShaderResourceView(Device, (ID3D11Resource *)Texture, &TextureViewDesc, &Result);
@@ -255,6 +284,21 @@ RendererCreateTexture(loaded_texture LoadedTexture, renderer *Renderer)
 }
 
 
+void
+RendererDestroyTexture(void *Texture, renderer *Renderer)
+{
+    (void)Renderer;
+
+    // The view holds the last reference to the texture, see RendererCreateTexture.
+
+    ID3D11ShaderResourceView *View = (ID3D11ShaderResourceView *)Texture;
+    if (View)
+    {
+        View->lpVtbl->Release(View);
+    }
+}
+
+
 // ==============================================
 // <Drawing>
 // ==============================================
@@ -272,117 +316,120 @@ RendererStartFrame(clear_color Color, renderer *Renderer)
 
 // Obviously this is a super hardcoded implementation and we would rely on some sort of batcher. I just want to get something on screen.
 // Then we will clean up all of this code and augment it.
+//
+// The commands come sorted (see SortRenderCommands), state is only bound when the key of a command
+// differs from the previous one in that part.
 
 void
 RendererDrawFrame(int Width, int Height, engine_memory *EngineMemory, renderer *Renderer)
 {
-    d3d11_renderer      *D3D11   = (d3d11_renderer *)Renderer->Backend;
-    ID3D11DeviceContext *Context = D3D11->DeviceContext;
+    TIMED_BLOCK_BEGIN(RendererDrawFrame);
 
-    for (render_pass_node *PassNode = Renderer->PassList.First; PassNode != 0; PassNode = PassNode->Next)
+    d3d11_renderer      *D3D11    = (d3d11_renderer *)Renderer->Backend;
+    ID3D11DeviceContext *Context  = D3D11->DeviceContext;
+    render_command_list *Commands = &Renderer->Commands;
+
+    for (uint32_t EntryIdx = 0; EntryIdx < Commands->Count; ++EntryIdx)
     {
-        render_pass *Pass = &PassNode->Value;
+        uint64_t        Key         = Commands->Entries[EntryIdx].Key;
+        uint64_t        PreviousKey = EntryIdx ? Commands->Entries[EntryIdx - 1].Key : 0;
+        render_command *Command     = Commands->Commands + Commands->Entries[EntryIdx].CommandIdx;
 
-        switch (Pass->Type)
-        {
+        bool IsNewPass     = !EntryIdx || GetRenderKeyPass(Key)     != GetRenderKeyPass(PreviousKey);
+        bool IsNewGroup    = IsNewPass || GetRenderKeyGroup(Key)    != GetRenderKeyGroup(PreviousKey);
+        bool IsNewMaterial = IsNewPass || GetRenderKeyMaterial(Key) != GetRenderKeyMaterial(PreviousKey);
+        bool IsNewMesh     = IsNewPass || GetRenderKeyMesh(Key)     != GetRenderKeyMesh(PreviousKey);
 
-        case RenderPass_Mesh:
+        if (IsNewPass)
         {
-            D3D11_VIEWPORT Viewport = { 0.f, 0.f, Width, Height, 0.f, 1.f };
-            Context->lpVtbl->RSSetState(Context, D3D11->MeshRasterizerState);
-            Context->lpVtbl->RSSetViewports(Context, 1, &Viewport);
-            Context->lpVtbl->IASetPrimitiveTopology(Context, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-            Context->lpVtbl->IASetInputLayout(Context, D3D11->MeshInputLayout);
-            Context->lpVtbl->VSSetShader(Context, D3D11->MeshVertexShader, 0, 0);
-            Context->lpVtbl->PSSetShader(Context, D3D11->MeshPixelShader, 0, 0);
-            Context->lpVtbl->OMSetRenderTargets(Context, 1, &D3D11->RenderView, 0);
-            Context->lpVtbl->PSSetSamplers(Context, 0, 1, &D3D11->MeshSamplerState);
-
-            render_pass_params_mesh *PassParams = &Pass->Params.Mesh;
-
-            for (mesh_group_node *GroupNode = PassParams->First; GroupNode != 0; GroupNode = GroupNode->Next)
+            switch (GetRenderKeyPass(Key))
             {
-                mesh_group_params *GroupParams = &GroupNode->Params;
 
-                {
-                    D3D11_MAPPED_SUBRESOURCE Mapped;
-                    Context->lpVtbl->Map(Context, (ID3D11Resource *)D3D11->MeshTransformUniformBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &Mapped);
-                    if (Mapped.pData)
-                    {
-                        memcpy(Mapped.pData, GroupParams, sizeof(mesh_group_params));
-                        Context->lpVtbl->Unmap(Context, (ID3D11Resource *)D3D11->MeshTransformUniformBuffer, 0);
-                    }
-                }
+            case RenderPass_Mesh:
+            {
+                D3D11_VIEWPORT Viewport = { 0.f, 0.f, Width, Height, 0.f, 1.f };
+                Context->lpVtbl->RSSetState(Context, D3D11->MeshRasterizerState);
+                Context->lpVtbl->RSSetViewports(Context, 1, &Viewport);
+                Context->lpVtbl->IASetPrimitiveTopology(Context, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+                Context->lpVtbl->IASetInputLayout(Context, D3D11->MeshInputLayout);
+                Context->lpVtbl->VSSetShader(Context, D3D11->MeshVertexShader, 0, 0);
+                Context->lpVtbl->PSSetShader(Context, D3D11->MeshPixelShader, 0, 0);
+                Context->lpVtbl->OMSetRenderTargets(Context, 1, &D3D11->RenderView, 0);
+                Context->lpVtbl->PSSetSamplers(Context, 0, 1, &D3D11->MeshSamplerState);
+            } break;
+
+            default:
+            {
+                assert(!"INVALID ENGINE STATE");
+            } break;
 
-                Context->lpVtbl->VSSetConstantBuffers(Context, 0, 1, &D3D11->MeshTransformUniformBuffer);
+            }
+        }
+
+        if (IsNewGroup)
+        {
+            mesh_group_params *GroupParams = Commands->Groups + GetRenderKeyGroup(Key);
 
-                // Iterate batches (tier 2: material params)
-                for (render_command_batch_node *BatchNode = GroupNode->BatchList.First; BatchNode != 0; BatchNode = BatchNode->Next)
+            {
+                D3D11_MAPPED_SUBRESOURCE Mapped;
+                Context->lpVtbl->Map(Context, (ID3D11Resource *)D3D11->MeshTransformUniformBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &Mapped);
+                if (Mapped.pData)
                 {
-                    render_command_batch *Batch       = &BatchNode->Value;
-                    mesh_batch_params    *BatchParams = &BatchNode->MeshParams;
-
-                    {
-                        renderer_material *Material = AccessUnderlyingResource(BatchParams->Material, Renderer->Resources);
-                        assert(Material);
-
-                        renderer_backend_resource *ColorBD   = AccessUnderlyingResource(Material->Maps[MaterialMap_Color], Renderer->Resources);
-                        ID3D11ShaderResourceView  *ColorView = ColorBD ? (ID3D11ShaderResourceView *)ColorBD->Data : 0;
-
-                        Context->lpVtbl->PSSetShaderResources(Context, 0, 1, &ColorView);
-                    }
-
-                    // Execute all commands in this batch
-                    for (uint32_t CmdIdx = 0; CmdIdx < Batch->Count; ++CmdIdx)
-                    {
-                        render_command *Command = &Batch->Commands[CmdIdx];
-
-                        switch (Command->Type)
-                        {
-
-                        case RenderCommand_StaticGeometry:
-                        {
-                            renderer_static_mesh *StaticMesh = AccessUnderlyingResource(Command->StaticGeometry.MeshHandle, Renderer->Resources);
-                            assert(StaticMesh);
-
-                            // Bind vertex buffer
-                            {
-                                renderer_backend_resource *VertexBufferBD = AccessUnderlyingResource(StaticMesh->VertexBuffer, Renderer->Resources);
-                                ID3D11Buffer              *VertexBuffer   = (ID3D11Buffer *)VertexBufferBD->Data;
-
-                                UINT32 Stride = sizeof(mesh_vertex_data);
-                                UINT32 Offset = 0;
-                                Context->lpVtbl->IASetVertexBuffers(Context, 0, 1, &VertexBuffer, &Stride, &Offset);
-                            }
-
-                            // Draw each submesh (they all share the material from the batch)
-                            for (uint32_t SubmeshIdx = 0; SubmeshIdx < StaticMesh->SubmeshCount; ++SubmeshIdx)
-                            {
-                                renderer_static_submesh *Submesh = &StaticMesh->Submeshes[SubmeshIdx];
-                                Context->lpVtbl->Draw(Context, Submesh->VertexCount, Submesh->VertexStart);
-                            }
-                        } break;
-
-                        default:
-                        {
-                            assert(!"INVALID ENGINE STATE");
-                        } break;
-
-                        }
-                    }
+                    memcpy(Mapped.pData, GroupParams, sizeof(mesh_group_params));
+                    Context->lpVtbl->Unmap(Context, (ID3D11Resource *)D3D11->MeshTransformUniformBuffer, 0);
                 }
             }
+
+            Context->lpVtbl->VSSetConstantBuffers(Context, 0, 1, &D3D11->MeshTransformUniformBuffer);
+        }
+
+        if (IsNewMaterial)
+        {
+            mesh_batch_params         *BatchParams = Commands->Materials + GetRenderKeyMaterial(Key);
+            renderer_backend_resource *ColorBD     = AccessUnderlyingResource(BatchParams->Textures[MaterialTexture_Albedo], Renderer->Resources);
+            ID3D11ShaderResourceView  *ColorView   = ColorBD ? (ID3D11ShaderResourceView *)ColorBD->Data : 0;
+
+            Context->lpVtbl->PSSetShaderResources(Context, 0, 1, &ColorView);
+        }
+
+        switch (Command->Type)
+        {
+
+        case RenderCommand_StaticGeometry:
+        {
+            renderer_static_mesh *StaticMesh = AccessUnderlyingResource(Command->StaticGeometry.MeshHandle, Renderer->Resources);
+            assert(StaticMesh);
+
+            // The key's mesh is the handle, one vertex buffer per mesh.
+            if (IsNewMesh)
+            {
+                renderer_backend_resource *VertexBufferBD = AccessUnderlyingResource(StaticMesh->VertexBuffer, Renderer->Resources);
+                ID3D11Buffer              *VertexBuffer   = (ID3D11Buffer *)VertexBufferBD->Data;
+
+                UINT32 Stride = sizeof(mesh_vertex_data);
+                UINT32 Offset = 0;
+                Context->lpVtbl->IASetVertexBuffers(Context, 0, 1, &VertexBuffer, &Stride, &Offset);
+            }
+
+            // Only the submesh this command was pushed for, the others may use other materials.
+            if (Command->StaticGeometry.SubmeshIndex < StaticMesh->SubmeshCount)
+            {
+                renderer_static_submesh *Submesh = &StaticMesh->Submeshes[Command->StaticGeometry.SubmeshIndex];
+                Context->lpVtbl->Draw(Context, Submesh->VertexCount, Submesh->VertexStart);
+            }
         } break;
 
         default:
         {
             assert(!"INVALID ENGINE STATE");
         } break;
+
         }
     }
 
-    Renderer->PassList.First = 0;
-    Renderer->PassList.Last  = 0;
+    Renderer->Commands = (render_command_list){0};
+
+    TIMED_BLOCK_END(RendererDrawFrame);
 }
 
 void
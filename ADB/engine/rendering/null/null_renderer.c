@@ -0,0 +1,336 @@
+#include <assert.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "platform/profiler.h"
+#include "engine/rendering/renderer.h"
+#include "engine/rendering/assets.h"
+#include "engine/rendering/textures/texture_mips.h"
+
+#include "null_renderer.h"
+
+
+typedef struct null_resource null_resource;
+struct null_resource
+{
+    null_resource *NextFree;
+    uint64_t       Size;
+};
+
+
+typedef struct
+{
+    RenderPassType     Pass;
+    int                Viewport[2];   // Width, height.
+    mesh_group_params  Transforms;
+    bool               HasTransforms;
+    void              *Albedo;
+    void              *VertexBuffer;
+} null_bound_state;
+
+
+typedef struct null_renderer
+{
+    memory_arena     *Arena;
+    null_resource    *FirstFree;      // Destroyed textures, vertex buffers are never destroyed.
+    null_bound_state  Bound;
+    null_frame_stats  Frame;          // Counted since the last flush.
+    null_frame_stats  Last;
+} null_renderer;
+
+
+null_renderer *
+NullInitialize(memory_arena *Arena)
+{
+    null_renderer *Result = PushStruct(Arena, null_renderer);
+
+    if (Result)
+    {
+        memset(Result, 0, sizeof(null_renderer));
+        Result->Arena = Arena;
+    }
+
+    return Result;
+}
+
+
+null_frame_stats
+GetNullFrameStats(null_renderer *Null)
+{
+    null_frame_stats Result = Null->Last;
+    return Result;
+}
+
+
+// Counts a bind and whether it changed the state, Bound is then set to Value.
+
+static void
+BindNullState(void *Bound, void *Value, size_t Size, null_renderer *Null)
+{
+    ++Null->Frame.BindCount;
+
+    if (memcmp(Bound, Value, Size) != 0)
+    {
+        ++Null->Frame.StateChangeCount;
+        memcpy(Bound, Value, Size);
+    }
+}
+
+// ==============================================
+// <Resources>
+// ==============================================
+
+
+static null_resource *
+CreateNullResource(uint64_t Size, null_renderer *Null)
+{
+    null_resource *Result = Null->FirstFree;
+
+    if (Result)
+    {
+        Null->FirstFree = Result->NextFree;
+    }
+    else
+    {
+        Result = PushStruct(Null->Arena, null_resource);
+    }
+
+    if (Result)
+    {
+        Result->NextFree = 0;
+        Result->Size     = Size;
+
+        Null->Frame.UploadedBytes += Size;
+    }
+
+    return Result;
+}
+
+
+void *
+RendererCreateVertexBuffer(void *Data, uint64_t Size, renderer *Renderer)
+{
+    null_resource *Result = 0;
+
+    if (Data && Size && Renderer)
+    {
+        null_renderer *Null = (null_renderer *)Renderer->Backend;
+
+        Result = CreateNullResource(Size, Null);
+        if (Result)
+        {
+            ++Null->Frame.VertexBufferCount;
+            Null->Frame.VertexBufferBytes += Size;
+        }
+    }
+
+    return Result;
+}
+
+
+void *
+RendererCreateTexture(loaded_texture LoadedTexture, renderer *Renderer)
+{
+    null_resource *Result = 0;
+
+    // Same checks as the D3D11 backend, a texture it would refuse is refused here as well.
+
+    bool IsSupported = LoadedTexture.Format == TextureFormat_RGBA8 ? LoadedTexture.BytesPerPixel == 4 : (uint32_t)LoadedTexture.Format < TextureFormat_Count;
+
+    if (LoadedTexture.Data && LoadedTexture.Width && LoadedTexture.Height && IsSupported)
+    {
+        null_renderer *Null     = (null_renderer *)Renderer->Backend;
+        uint32_t       MipCount = Minimum(Maximum(LoadedTexture.MipCount, 1), MAX_TEXTURE_MIP_COUNT);
+        uint64_t       Size     = GetTextureDataSize(LoadedTexture.Width, LoadedTexture.Height, LoadedTexture.Format, MipCount);
+
+        Result = CreateNullResource(Size, Null);
+        if (Result)
+        {
+            ++Null->Frame.TextureCount;
+            Null->Frame.TextureBytes += Size;
+        }
+    }
+
+    return Result;
+}
+
+
+void
+RendererDestroyTexture(void *Texture, renderer *Renderer)
+{
+    null_resource *Resource = (null_resource *)Texture;
+
+    if (Resource)
+    {
+        null_renderer *Null = (null_renderer *)Renderer->Backend;
+
+        --Null->Frame.TextureCount;
+        Null->Frame.TextureBytes -= Resource->Size;
+
+        Resource->NextFree = Null->FirstFree;
+        Null->FirstFree    = Resource;
+    }
+}
+
+// ==============================================
+// <Drawing>
+// ==============================================
+
+
+void
+RendererStartFrame(clear_color Color, renderer *Renderer)
+{
+    (void)Color;
+
+    null_renderer *Null = (null_renderer *)Renderer->Backend;
+    memset(&Null->Bound, 0, sizeof(Null->Bound));
+}
+
+
+void
+RendererDrawFrame(int Width, int Height, engine_memory *EngineMemory, renderer *Renderer)
+{
+    TIMED_BLOCK_BEGIN(RendererDrawFrame);
+
+    (void)EngineMemory;
+
+    null_renderer       *Null     = (null_renderer *)Renderer->Backend;
+    null_bound_state    *Bound    = &Null->Bound;
+    render_command_list *Commands = &Renderer->Commands;
+
+    for (uint32_t EntryIdx = 0; EntryIdx < Commands->Count; ++EntryIdx)
+    {
+        uint64_t        Key         = Commands->Entries[EntryIdx].Key;
+        uint64_t        PreviousKey = EntryIdx ? Commands->Entries[EntryIdx - 1].Key : 0;
+        render_command *Command     = Commands->Commands + Commands->Entries[EntryIdx].CommandIdx;
+
+        bool IsNewPass     = !EntryIdx || GetRenderKeyPass(Key)     != GetRenderKeyPass(PreviousKey);
+        bool IsNewGroup    = IsNewPass || GetRenderKeyGroup(Key)    != GetRenderKeyGroup(PreviousKey);
+        bool IsNewMaterial = IsNewPass || GetRenderKeyMaterial(Key) != GetRenderKeyMaterial(PreviousKey);
+        bool IsNewMesh     = IsNewPass || GetRenderKeyMesh(Key)     != GetRenderKeyMesh(PreviousKey);
+
+        if (IsNewPass)
+        {
+            RenderPassType Pass = GetRenderKeyPass(Key);
+
+            ++Null->Frame.PassCount;
+
+            switch (Pass)
+            {
+
+            case RenderPass_Mesh:
+            {
+                // The shaders, input layout, rasterizer state and sampler only go together, one bind.
+
+                int Viewport[2] = {Width, Height};
+
+                BindNullState(&Bound->Pass, &Pass, sizeof(Bound->Pass), Null);
+                BindNullState(Bound->Viewport, Viewport, sizeof(Viewport), Null);
+            } break;
+
+            default:
+            {
+                assert(!"INVALID ENGINE STATE");
+            } break;
+
+            }
+        }
+
+        if (IsNewGroup)
+        {
+            mesh_group_params *GroupParams = Commands->Groups + GetRenderKeyGroup(Key);
+
+            ++Null->Frame.GroupCount;
+
+            // The D3D11 backend rewrites the transforms whenever the group changes, whether they changed or not.
+
+            Null->Frame.UploadedBytes += sizeof(mesh_group_params);
+
+            if (!Bound->HasTransforms)
+            {
+                ++Null->Frame.BindCount;
+                ++Null->Frame.StateChangeCount;
+
+                Bound->Transforms    = *GroupParams;
+                Bound->HasTransforms = true;
+            }
+            else
+            {
+                BindNullState(&Bound->Transforms, GroupParams, sizeof(mesh_group_params), Null);
+            }
+        }
+
+        if (IsNewGroup || IsNewMaterial)
+        {
+            ++Null->Frame.BatchCount;
+        }
+
+        if (IsNewMaterial)
+        {
+            mesh_batch_params         *BatchParams = Commands->Materials + GetRenderKeyMaterial(Key);
+            renderer_backend_resource *ColorBD     = AccessUnderlyingResource(BatchParams->Textures[MaterialTexture_Albedo], Renderer->Resources);
+            void                      *Albedo      = ColorBD ? ColorBD->Data : 0;
+
+            BindNullState(&Bound->Albedo, &Albedo, sizeof(Albedo), Null);
+        }
+
+        switch (Command->Type)
+        {
+
+        case RenderCommand_StaticGeometry:
+        {
+            renderer_static_mesh *StaticMesh = AccessUnderlyingResource(Command->StaticGeometry.MeshHandle, Renderer->Resources);
+            assert(StaticMesh);
+
+            if (IsNewMesh)
+            {
+                renderer_backend_resource *VertexBufferBD = AccessUnderlyingResource(StaticMesh->VertexBuffer, Renderer->Resources);
+                void                      *VertexBuffer   = VertexBufferBD ? VertexBufferBD->Data : 0;
+
+                BindNullState(&Bound->VertexBuffer, &VertexBuffer, sizeof(VertexBuffer), Null);
+            }
+
+            if (Command->StaticGeometry.SubmeshIndex < StaticMesh->SubmeshCount)
+            {
+                renderer_static_submesh *Submesh = &StaticMesh->Submeshes[Command->StaticGeometry.SubmeshIndex];
+
+                ++Null->Frame.DrawCount;
+                Null->Frame.VertexCount += Submesh->VertexCount;
+            }
+        } break;
+
+        default:
+        {
+            assert(!"INVALID ENGINE STATE");
+        } break;
+
+        }
+    }
+
+    Renderer->Commands = (render_command_list){0};
+
+    TIMED_BLOCK_END(RendererDrawFrame);
+}
+
+
+void
+RendererFlushFrame(renderer *Renderer)
+{
+    null_renderer *Null = (null_renderer *)Renderer->Backend;
+
+    Null->Last = Null->Frame;
+
+    // What is alive carries over, the rest starts again from zero.
+
+    null_frame_stats Next =
+    {
+        .Index             = Null->Frame.Index + 1,
+        .TextureCount      = Null->Frame.TextureCount,
+        .TextureBytes      = Null->Frame.TextureBytes,
+        .VertexBufferCount = Null->Frame.VertexBufferCount,
+        .VertexBufferBytes = Null->Frame.VertexBufferBytes,
+    };
+
+    Null->Frame = Next;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "utilities.h"
+
+// ==============================================
+// <Null Backend>
+// ==============================================
+
+// A backend without a GPU, linked in place of d3d11/d3d11.c. It walks the sorted commands
+// RendererDrawFrame is given the way the D3D11 backend does and counts instead of drawing. Resources only remember their
+// size, nothing is copied. What the engine does on the CPU around it (resource manager, streaming,
+// scene, command building) runs as it would on Windows.
+//
+// Binds are what the D3D11 backend issues for the same frame, state changes the binds that changed
+// what was bound: the pipeline and viewport when the pass of the key changes, the transforms when the
+// group does, the albedo for the material and the vertex buffer for the mesh. Passes, groups and
+// batches count the runs of commands that share them, a batch being a group and a material. Nothing is
+// bound when a frame starts. Uploads are created vertex buffers and textures, all their levels, and
+// the transforms of every group run.
+//
+// A frame is counted from one RendererFlushFrame to the next, resources created in between count
+// towards it. Like the D3D11 backend it must only be used from one thread.
+
+typedef struct null_renderer null_renderer;
+
+
+typedef struct
+{
+    uint64_t Index;                 // Frames flushed before this one.
+    uint32_t PassCount;
+    uint32_t GroupCount;
+    uint32_t BatchCount;
+    uint32_t DrawCount;
+    uint64_t VertexCount;
+    uint32_t BindCount;
+    uint32_t StateChangeCount;
+    uint64_t UploadedBytes;
+
+    // Alive when the frame was flushed.
+
+    uint32_t TextureCount;
+    uint64_t TextureBytes;
+    uint32_t VertexBufferCount;
+    uint64_t VertexBufferBytes;
+} null_frame_stats;
+
+
+null_renderer *  NullInitialize     (memory_arena *Arena);
+
+// The last frame flushed, all zero before the first.
+null_frame_stats GetNullFrameStats  (null_renderer *Null);
\ No newline at end of file
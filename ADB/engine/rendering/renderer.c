@@ -3,151 +3,98 @@
 #include <math.h>
 #include <string.h>
 
-#include "third_party/stb_image.h"
-
 #include "utilities.h"         // Arenas
 #include "platform/platform.h" // Engine Memory
+#include "platform/profiler.h" // Timed blocks
 #include "renderer.h"          // Implementation File
 
+#include "textures/texture_streaming.h"
 
-static render_pass *
-GetRenderPass(memory_arena *Arena, RenderPassType Type, render_command_pass_list *PassList)
-{
-    render_pass_node *Result = PassList->Last;
 
-    if (!Result || Result->Value.Type != Type)
-    {
-        Result = PushStruct(Arena, render_pass_node);
-        if (!Result)
-        {
-            return NULL;
-        }
+// ==============================================
+// <Render Commands>
+// ==============================================
 
-        Result->Value.Type = Type;
-        Result->Next       = NULL;
-        memset(&Result->Value.Params, 0, sizeof(Result->Value.Params));
 
-        if (!PassList->First)
-        {
-            PassList->First = Result;
-        }
+#define RENDER_MATERIAL_SLOT_COUNT (MAX_RENDER_MATERIAL_COUNT * 2)
+#define RENDER_SORT_DIGIT_COUNT    8
 
-        if (PassList->Last)
-        {
-            PassList->Last->Next = Result;
-        }
-
-        PassList->Last = Result;
-    }
 
-    assert(Result);
+render_command_list
+CreateRenderCommandList(memory_arena *Arena)
+{
+    render_command_list Result = {0};
 
-    return &Result->Value;
-}
+    Result.Commands      = PushArray(Arena, render_command, MAX_RENDER_COMMAND_COUNT);
+    Result.Entries       = PushArray(Arena, render_sort_entry, MAX_RENDER_COMMAND_COUNT);
+    Result.Groups        = PushArray(Arena, mesh_group_params, MAX_RENDER_GROUP_COUNT);
+    Result.Materials     = PushArray(Arena, mesh_batch_params, MAX_RENDER_MATERIAL_COUNT);
+    Result.MaterialSlots = PushArray(Arena, uint16_t, RENDER_MATERIAL_SLOT_COUNT);
 
+    if (Result.Commands && Result.Entries && Result.Groups && Result.Materials && Result.MaterialSlots)
+    {
+        Result.Capacity = MAX_RENDER_COMMAND_COUNT;
+        memset(Result.MaterialSlots, 0, RENDER_MATERIAL_SLOT_COUNT * sizeof(uint16_t));
+    }
 
-static bool
-MeshGroupParamsAreMergeable(mesh_group_params *A, mesh_group_params *B)
-{
-    bool Result = memcmp(A, B, sizeof(mesh_group_params)) == 0;
     return Result;
 }
 
 
-static bool
-MeshBatchParamsAreMergeable(mesh_batch_params *A, mesh_batch_params *B)
-{
-    bool Result = memcmp(A, B, sizeof(mesh_batch_params)) == 0;
-    return Result;
-}
-
+// There are a handful of views in a frame, looking through them is cheaper than hashing the matrices.
 
-render_command_batch_list *
-PushMeshGroupParams(mesh_group_params *Params, memory_arena *Arena, render_command_pass_list *PassList)
+uint32_t
+PushMeshGroupParams(mesh_group_params *Params, render_command_list *List)
 {
-    render_command_batch_list *Result = 0;
+    uint32_t Result = INVALID_RENDER_INDEX;
 
-    render_pass *Pass = GetRenderPass(Arena, RenderPass_Mesh, PassList);
-    if(Pass)
+    for (uint32_t GroupIdx = List->GroupCount; GroupIdx > 0 && Result == INVALID_RENDER_INDEX; --GroupIdx)
     {
-        render_pass_params_mesh *PassParams = &Pass->Params.Mesh;
-
-        mesh_group_node *Group = PassParams->Last;
-        if (!Group || !MeshGroupParamsAreMergeable(Params, &Group->Params))
+        if (memcmp(Params, List->Groups + GroupIdx - 1, sizeof(mesh_group_params)) == 0)
         {
-            Group = PushStruct(Arena, mesh_group_node);
-            if (Group)
-            {
-                Group->Next   = 0;
-                Group->Params = *Params;
-                Group->BatchList.BatchCount = 0;
-                Group->BatchList.First      = 0;
-                Group->BatchList.Last       = 0;
-            }
-
-            if (!PassParams->First)
-            {
-                PassParams->First = Group;
-                PassParams->Last  = Group;
-            }
-            else if (PassParams->Last)
-            {
-                PassParams->Last->Next = Group;
-                PassParams->Last       = Group;
-            }
-            else
-            {
-                assert(!"INVALID ENGINE STATE");
-            }
+            Result = GroupIdx - 1;
         }
     }
 
-    if (Pass)
+    if (Result == INVALID_RENDER_INDEX && List->Capacity && List->GroupCount < MAX_RENDER_GROUP_COUNT)
     {
-        Result = &Pass->Params.Mesh.Last->BatchList;
+        Result = List->GroupCount++;
+        List->Groups[Result] = *Params;
     }
 
     return Result;
 }
 
 
-render_command_batch *
-PushMeshBatchParams(mesh_batch_params *Params, memory_arena *Arena, render_command_batch_list *BatchList)
+uint32_t
+PushMeshBatchParams(mesh_batch_params *Params, render_command_list *List)
 {
-    render_command_batch *Result = 0;
+    uint32_t Result = INVALID_RENDER_INDEX;
 
-    render_command_batch_node *BatchNode = BatchList->Last;
-    if (!BatchNode || !MeshBatchParamsAreMergeable(Params, &BatchNode->MeshParams))
+    if (List->Capacity)
     {
-        BatchNode = PushStruct(Arena, render_command_batch_node);
-        if (BatchNode)
-        {
-            BatchNode->Next       = 0;
-            BatchNode->MeshParams = *Params;
-            BatchNode->Value.Commands = PushArray(Arena, render_command, 50);
-            BatchNode->Value.Count    = 0;
-            BatchNode->Value.Capacity = 50;
-        }
+        uint64_t Hash = HashByteString(ByteString((uint8_t *)Params, sizeof(mesh_batch_params)));
+        uint32_t Slot = (uint32_t)Hash & (RENDER_MATERIAL_SLOT_COUNT - 1);
 
-        if (!BatchList->First)
-        {
-            BatchList->First = BatchNode;
-            BatchList->Last  = BatchNode;
-        }
-        else if (BatchList->Last)
+        while (List->MaterialSlots[Slot] && Result == INVALID_RENDER_INDEX)
         {
-            BatchList->Last->Next = BatchNode;
-            BatchList->Last       = BatchNode;
+            uint32_t MaterialIdx = List->MaterialSlots[Slot] - 1u;
+
+            if (memcmp(Params, List->Materials + MaterialIdx, sizeof(mesh_batch_params)) == 0)
+            {
+                Result = MaterialIdx;
+            }
+
+            Slot = (Slot + 1) & (RENDER_MATERIAL_SLOT_COUNT - 1);
         }
-        else
+
+        if (Result == INVALID_RENDER_INDEX && List->MaterialCount < MAX_RENDER_MATERIAL_COUNT)
         {
-            assert(!"INVALID ENGINE STATE");
-        }
-    }
+            Result = List->MaterialCount++;
 
-    if (BatchNode)
-    {
-        Result = &BatchNode->Value;
+            List->Materials[Result]   = *Params;
+            List->MaterialSlots[Slot] = (uint16_t)(Result + 1);
+        }
     }
 
     return Result;
@@ -155,25 +102,115 @@ PushMeshBatchParams(mesh_batch_params *Params, memory_arena *Arena, render_comma
 
 
 render_command *
-PushRenderCommand(render_command_batch *Batch)
+PushRenderCommand(render_command_key Key, render_command_list *List)
 {
     render_command *Result = 0;
 
-    if (Batch->Count < Batch->Capacity)
+    bool IsValid = Key.Group < List->GroupCount && Key.Material < List->MaterialCount && Key.Mesh <= 0xFFF;
+
+    if (IsValid && List->Count < List->Capacity)
     {
-        Result = Batch->Commands + Batch->Count++;
+        float    Depth     = fminf(fmaxf(Key.Depth, 0.f), 1.f);
+        uint64_t DepthBits = (uint64_t)(Depth * (float)((1u << RENDER_KEY_DEPTH_BITS) - 1));
+
+        render_sort_entry *Entry = List->Entries + List->Count;
+        Entry->Key        = ((uint64_t)Key.Pass     << RENDER_KEY_PASS_SHIFT)     |
+                            ((uint64_t)Key.Group    << RENDER_KEY_GROUP_SHIFT)    |
+                            ((uint64_t)Key.Material << RENDER_KEY_MATERIAL_SHIFT) |
+                            ((uint64_t)Key.Mesh     << RENDER_KEY_MESH_SHIFT)     |
+                            DepthBits;
+        Entry->CommandIdx = List->Count;
+
+        Result = List->Commands + List->Count++;
     }
 
     return Result;
 }
 
 
+// All the histograms in one read of the keys, then one scatter per digit that is not the same for
+// every key: the pass and group digits rarely differ, most frames sort in 4 or 5 scatters. A scatter
+// is stable, which is what makes sorting the lowest digit first come out right.
+
+void
+SortRenderCommands(render_command_list *List, memory_arena *Arena)
+{
+    TIMED_BLOCK_BEGIN(SortRenderCommands);
+
+    uint32_t Count = List->Count;
+
+    if (Count > 1)
+    {
+        memory_region      Region     = EnterMemoryRegion(Arena);
+        uint32_t          *Histograms = PushArray(Arena, uint32_t, RENDER_SORT_DIGIT_COUNT * 256);
+        render_sort_entry *Scratch    = PushArray(Arena, render_sort_entry, Count);
+
+        if (Histograms && Scratch)
+        {
+            memset(Histograms, 0, RENDER_SORT_DIGIT_COUNT * 256 * sizeof(uint32_t));
+
+            for (uint32_t EntryIdx = 0; EntryIdx < Count; ++EntryIdx)
+            {
+                uint64_t Key = List->Entries[EntryIdx].Key;
+
+                for (uint32_t Digit = 0; Digit < RENDER_SORT_DIGIT_COUNT; ++Digit)
+                {
+                    ++Histograms[Digit * 256 + ((Key >> (Digit * 8)) & 0xFF)];
+                }
+            }
+
+            render_sort_entry *Source = List->Entries;
+            render_sort_entry *Target = Scratch;
+
+            for (uint32_t Digit = 0; Digit < RENDER_SORT_DIGIT_COUNT; ++Digit)
+            {
+                uint32_t *Offset = Histograms + Digit * 256;
+                uint32_t  Shift  = Digit * 8;
+
+                if (Offset[(Source[0].Key >> Shift) & 0xFF] != Count)
+                {
+                    uint32_t Total = 0;
+
+                    for (uint32_t Bucket = 0; Bucket < 256; ++Bucket)
+                    {
+                        uint32_t BucketCount = Offset[Bucket];
+                        Offset[Bucket] = Total;
+                        Total         += BucketCount;
+                    }
+
+                    for (uint32_t EntryIdx = 0; EntryIdx < Count; ++EntryIdx)
+                    {
+                        render_sort_entry Entry = Source[EntryIdx];
+                        Target[Offset[(Entry.Key >> Shift) & 0xFF]++] = Entry;
+                    }
+
+                    render_sort_entry *Swap = Source;
+                    Source = Target;
+                    Target = Swap;
+                }
+            }
+
+            // An odd number of scatters leaves the keys in the scratch space, which goes away with the region.
+
+            if (Source != List->Entries)
+            {
+                memcpy(List->Entries, Source, Count * sizeof(render_sort_entry));
+            }
+        }
+
+        LeaveMemoryRegion(Region);
+    }
+
+    TIMED_BLOCK_END(SortRenderCommands);
+}
+
+
 // ==============================================
 // <Resources> 
 // ==============================================
 
 
-#define MAX_RENDERER_RESOURCE 128
+#define MAX_RENDERER_RESOURCE 1024
 
 
 #define INVALID_LINK_SENTINEL   0xFFFFFFFF
@@ -230,14 +267,6 @@ typedef struct renderer_resource_manager
 
 
 
-resource_uuid
-MakeResourceUUID(byte_string PathToResource)
-{
-    resource_uuid Result = {.Value = HashByteString(PathToResource)};
-    return Result;
-}
-
-
 static resource_reference_entry *
 GetEntry(uint32_t Index, resource_reference_table *Table)
 {
@@ -561,9 +590,32 @@ CreateResourceManager(memory_arena *Arena)
 }
 
 
+// The sphere around the box of the vertices, not the tightest one but close enough to size textures.
+
+static void
+SetSubmeshBounds(renderer_static_submesh *Submesh, mesh_vertex_data *Vertices, uint32_t VertexCount)
+{
+    vec3 Min = VertexCount ? Vertices[0].Position : Vec3(0.f, 0.f, 0.f);
+    vec3 Max = Min;
+
+    for (uint32_t VertexIdx = 1; VertexIdx < VertexCount; ++VertexIdx)
+    {
+        vec3 Position = Vertices[VertexIdx].Position;
+
+        Min = Vec3(fminf(Min.X, Position.X), fminf(Min.Y, Position.Y), fminf(Min.Z, Position.Z));
+        Max = Vec3(fmaxf(Max.X, Position.X), fmaxf(Max.Y, Position.Y), fmaxf(Max.Z, Position.Z));
+    }
+
+    Submesh->Center = Vec3Scale(Vec3Add(Min, Max), 0.5f);
+    Submesh->Radius = Vec3Length(Vec3Subtract(Max, Min)) * 0.5f;
+}
+
+
 void
 LoadAssetFileData(asset_file_data AssetFile, memory_arena *Arena, renderer *Renderer)
 {
+    TIMED_BLOCK_BEGIN(LoadAssetFileData);
+
     for (uint32_t MaterialIdx = 0; MaterialIdx < AssetFile.MaterialCount; ++MaterialIdx)
     {
         resource_uuid   MaterialUUID   = MakeResourceUUID(AssetFile.Materials[MaterialIdx].Path);
@@ -574,9 +626,9 @@ LoadAssetFileData(asset_file_data AssetFile, memory_arena *Arena, renderer *Rend
             renderer_material *Material = AccessUnderlyingResource(MaterialHandle, Renderer->Resources);
             assert(Material);
 
-            for (MaterialMap_Type MapType = MaterialMap_Color; MapType < MaterialMap_Count; ++MapType)
+            for (MaterialTexture_Type TextureType = MaterialTexture_Albedo; TextureType < MaterialTexture_Count; ++TextureType)
             {
-                resource_uuid   TextureUUID   = MakeResourceUUID(AssetFile.Materials[MaterialIdx].Textures[MapType].Path);
+                resource_uuid   TextureUUID   = MakeResourceUUID(AssetFile.Materials[MaterialIdx].Textures[TextureType].Path);
                 resource_handle TextureHandle = FindOrCreateResource(TextureUUID, RendererResource_TextureView, Renderer->Resources, Renderer->ReferenceTable);
 
                 if (IsValidResourceHandle(TextureHandle))
@@ -584,16 +636,26 @@ LoadAssetFileData(asset_file_data AssetFile, memory_arena *Arena, renderer *Rend
                     renderer_backend_resource *BackendResource = AccessUnderlyingResource(TextureHandle, Renderer->Resources);
                     assert(BackendResource);
 
-                    BackendResource->Data = RendererCreateTexture(AssetFile.Materials[MaterialIdx].Textures[MapType], Renderer);
+                    // Atlas pages are shared by several materials, only the first one creates it.
+
+                    if (!BackendResource->Data)
+                    {
+                        loaded_texture Texture = AssetFile.Materials[MaterialIdx].Textures[TextureType];
+
+                        if (Renderer->Streamer)
+                        {
+                            BackendResource->StreamId = AddStreamedTexture(Renderer->Streamer, &Texture);
+                        }
 
-                    Material->Maps[MapType] = BindResourceHandle(TextureHandle, Renderer->Resources);
+                        BackendResource->Data = RendererCreateTexture(Texture, Renderer);
+                    }
+
+                    Material->Textures[TextureType] = BindResourceHandle(TextureHandle, Renderer->Resources);
                 }
                 else
                 {
                     assert(!"How do we handle such a case?");
                 }
-
-                stbi_image_free(AssetFile.Materials[MaterialIdx].Textures[MapType].Data);
             }
         }
         else
@@ -653,6 +715,8 @@ LoadAssetFileData(asset_file_data AssetFile, memory_arena *Arena, renderer *Rend
                 StaticMesh->Submeshes[SubmeshIdx].Material    = BindResourceHandle(MaterialState.Handle, Renderer->Resources);
                 StaticMesh->Submeshes[SubmeshIdx].VertexCount = SubmeshData->VertexCount;
                 StaticMesh->Submeshes[SubmeshIdx].VertexStart = SubmeshData->VertexOffset;
+
+                SetSubmeshBounds(&StaticMesh->Submeshes[SubmeshIdx], AssetFile.Vertices + SubmeshData->VertexOffset, SubmeshData->VertexCount);
             }
         }
         else
@@ -660,6 +724,58 @@ LoadAssetFileData(asset_file_data AssetFile, memory_arena *Arena, renderer *Rend
             assert(!"How do we handle such a case?");
         }
     }
+
+    TIMED_BLOCK_END(LoadAssetFileData);
+}
+
+
+void
+RequestMaterialDetail(resource_handle MaterialHandle, float ScreenSize, renderer *Renderer)
+{
+    renderer_material *Material = Renderer->Streamer ? AccessUnderlyingResource(MaterialHandle, Renderer->Resources) : 0;
+
+    for (uint32_t TextureIdx = 0; Material && TextureIdx < MaterialTexture_Count; ++TextureIdx)
+    {
+        renderer_backend_resource *Texture = AccessUnderlyingResource(Material->Textures[TextureIdx], Renderer->Resources);
+
+        if (Texture && Texture->StreamId)
+        {
+            RequestStreamedTexture(Renderer->Streamer, Texture->StreamId, ScreenSize);
+        }
+    }
+}
+
+
+void
+UpdateRendererStreaming(uint32_t ViewHeight, engine_memory *EngineMemory, renderer *Renderer)
+{
+    if (Renderer->Streamer)
+    {
+        UpdateTextureStreaming(Renderer->Streamer, ViewHeight, EngineMemory);
+
+        renderer_resource_manager *Resources = Renderer->Resources;
+
+        uint32_t Index = Resources->FirstByType[RendererResource_TextureView];
+        while (Index != INVALID_LINK_SENTINEL)
+        {
+            renderer_resource *Resource = GetRendererResource(Index, Resources);
+            loaded_texture     Texture  = {0};
+
+            // A texture that cannot be recreated keeps the levels it had on the GPU.
+
+            if (Resource->Backend.StreamId && GetStreamedTexture(Renderer->Streamer, Resource->Backend.StreamId, &Texture))
+            {
+                void *Created = RendererCreateTexture(Texture, Renderer);
+                if (Created)
+                {
+                    RendererDestroyTexture(Resource->Backend.Data, Renderer);
+                    Resource->Backend.Data = Created;
+                }
+            }
+
+            Index = Resource->NextSameType;
+        }
+    }
 }
 
 
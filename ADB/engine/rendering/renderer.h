@@ -4,7 +4,8 @@
 #include "engine/math/matrix.h"
 #include <engine/math/vector.h>
 
-typedef struct renderer renderer;
+typedef struct renderer         renderer;
+typedef struct texture_streamer texture_streamer;
 
 
 
@@ -49,13 +50,14 @@ typedef struct
 
 typedef struct
 {
-    void *Data;
+    void     *Data;
+    uint32_t  StreamId; // Textures only, see textures/texture_streaming.h. 0 when all levels are resident.
 } renderer_backend_resource;
 
 
 typedef struct
 {
-    resource_handle Maps[MaterialMap_Count];
+    resource_handle Textures[MaterialTexture_Count];
 } renderer_material;
 
 
@@ -64,6 +66,10 @@ typedef struct
     uint64_t        VertexCount;
     uint64_t        VertexStart;
     resource_handle Material;
+
+    // Bounding sphere in model space, what decides how much of the screen its textures cover.
+    vec3            Center;
+    float           Radius;
 } renderer_static_submesh;
 
 
@@ -76,12 +82,6 @@ typedef struct
 } renderer_static_mesh;
 
 
-typedef struct
-{
-    uint64_t Value;
-} resource_uuid;
-
-
 typedef struct
 {
     uint32_t        Id;
@@ -91,7 +91,13 @@ typedef struct
 
 void                        LoadAssetFileData             (asset_file_data AssetFile, memory_arena *Arena, renderer *Renderer);
 
-resource_uuid               MakeResourceUUID              (byte_string PathToResource);
+// With a streamer, textures are created from their mip tail and get their larger levels once
+// something on screen asks for them. ScreenSize is the part of the view height the material covers.
+// The update recreates the textures whose levels changed, it must run before the frame is drawn.
+
+void                        RequestMaterialDetail         (resource_handle Material, float ScreenSize, renderer *Renderer);
+void                        UpdateRendererStreaming       (uint32_t ViewHeight, engine_memory *EngineMemory, renderer *Renderer);
+
 resource_reference_state    FindResourceByUUID            (resource_uuid UUID, resource_reference_table *Table);
 
 resource_handle             BindResourceHandle            (resource_handle Handle, renderer_resource_manager *ResourceManager);
@@ -110,6 +116,7 @@ void * AccessUnderlyingResource  (resource_handle Handle, renderer_resource_mana
 
 
 void * RendererCreateTexture       (loaded_texture Texture, renderer *Renderer);
+void   RendererDestroyTexture      (void *Texture, renderer *Renderer);
 void * RendererCreateVertexBuffer  (void *Data, uint64_t Size, renderer *Renderer);
 
 // ==============================================
@@ -142,7 +149,33 @@ mat4x4 GetCameraProjectionMatrix  (camera *Camera);
 // ==============================================
 
 
-#define MAX_RENDER_COMMAND_COUNT 64
+// The draws of a frame go in one array, in whatever order the scene pushes them, each with a 64-bit
+// key made of the state it needs, the most expensive to change first:
+//
+//   63   60 59        48 47        36 35        24 23                     0
+//   | pass |   group    |  material  |    mesh    |         depth          |
+//
+// Groups and materials are indices in tables of the frame, equal params get the same index. The mesh
+// is the handle's value. Depth is front to back, so that inside the same state the closest draws go
+// first. SortRenderCommands orders the keys once everything is pushed, draws that share state end up
+// next to each other whatever the submission order, and the backend binds what differs between one
+// key and the next.
+
+#define MAX_RENDER_COMMAND_COUNT  16384
+#define MAX_RENDER_GROUP_COUNT    256
+#define MAX_RENDER_MATERIAL_COUNT 1024
+#define INVALID_RENDER_INDEX      0xFFFFFFFF
+
+#define RENDER_KEY_PASS_SHIFT     60
+#define RENDER_KEY_GROUP_SHIFT    48
+#define RENDER_KEY_MATERIAL_SHIFT 36
+#define RENDER_KEY_MESH_SHIFT     24
+#define RENDER_KEY_DEPTH_BITS     24
+
+#define GetRenderKeyPass(Key)      ((RenderPassType)((Key) >> RENDER_KEY_PASS_SHIFT))
+#define GetRenderKeyGroup(Key)     ((uint32_t)((Key) >> RENDER_KEY_GROUP_SHIFT)    & 0xFFF)
+#define GetRenderKeyMaterial(Key)  ((uint32_t)((Key) >> RENDER_KEY_MATERIAL_SHIFT) & 0xFFF)
+#define GetRenderKeyMesh(Key)      ((uint32_t)((Key) >> RENDER_KEY_MESH_SHIFT)     & 0xFFF)
 
 typedef enum
 {
@@ -162,6 +195,7 @@ typedef enum
 typedef struct
 {
     resource_handle MeshHandle;
+    uint32_t        SubmeshIndex;
 } static_geometry_command;
 
 
@@ -176,41 +210,15 @@ typedef struct
 } render_command;
 
 
-typedef struct
-{
-    render_command *Commands;
-    uint32_t        Count;
-    uint32_t        Capacity;
-} render_command_batch;
-
+// What a batch binds, rather than the material it came from: materials whose albedo went into the
+// same atlas page end up with the same textures and share a batch.
 
 typedef struct
 {
-    resource_handle Material;
+    resource_handle Textures[MaterialTexture_Count];
 } mesh_batch_params;
 
 
-typedef struct render_command_batch_node render_command_batch_node;
-struct render_command_batch_node
-{
-    render_command_batch_node *Next;
-    render_command_batch       Value;
-
-    union
-    {
-        mesh_batch_params MeshParams;
-    };
-};
-
-
-typedef struct
-{
-    render_command_batch_node *First;
-    render_command_batch_node *Last;
-    uint64_t                   BatchCount;
-} render_command_batch_list;
-
-
 typedef struct
 {
     mat4x4 WorldMatrix;
@@ -219,54 +227,49 @@ typedef struct
 } mesh_group_params;
 
 
-typedef struct mesh_group_node mesh_group_node;
-struct mesh_group_node
-{
-    mesh_group_node          *Next;
-    render_command_batch_list BatchList;
-    mesh_group_params         Params;
-};
-
-
 typedef struct
 {
-    mesh_group_node *First;
-    mesh_group_node *Last;
-    uint32_t         Count;
-} render_pass_params_mesh;
+    RenderPassType Pass;
+    uint32_t       Group;     // From PushMeshGroupParams.
+    uint32_t       Material;  // From PushMeshBatchParams.
+    uint32_t       Mesh;
+    float          Depth;     // In [0, 1], clamped.
+} render_command_key;
 
 
 typedef struct
 {
-    RenderPassType Type;
-    union
-    {
-        render_pass_params_mesh Mesh;
-    } Params;
-} render_pass;
-
-
-typedef struct render_pass_node render_pass_node;
-struct render_pass_node
-{
-    render_pass_node *Next;
-    render_pass       Value;
-};
+    uint64_t Key;
+    uint32_t CommandIdx;
+} render_sort_entry;
 
 
 typedef struct
 {
-    render_pass_node *First;
-    render_pass_node *Last;
-} render_command_pass_list;
+    render_command    *Commands;       // In the order they were pushed.
+    render_sort_entry *Entries;        // One per command, in key order once sorted.
+    uint32_t           Count;
+    uint32_t           Capacity;
+
+    mesh_group_params *Groups;
+    uint32_t           GroupCount;
+    mesh_batch_params *Materials;
+    uint32_t           MaterialCount;
+    uint16_t          *MaterialSlots;  // Open addressing on the params' hash, index + 1, 0 when free.
+} render_command_list;
 
 
-// Experimental API
+// The list lives in Arena, for one frame. Pushes return an index or a command to fill,
+// INVALID_RENDER_INDEX or 0 once a table is full. A command whose key is not valid is not pushed.
 
-render_command            * PushRenderCommand    (render_command_batch *Batch);
+render_command_list   CreateRenderCommandList  (memory_arena *Arena);
+uint32_t              PushMeshGroupParams      (mesh_group_params *Params, render_command_list *List);
+uint32_t              PushMeshBatchParams      (mesh_batch_params *Params, render_command_list *List);
+render_command      * PushRenderCommand        (render_command_key Key, render_command_list *List);
 
-render_command_batch_list * PushMeshGroupParams  (mesh_group_params *Params, memory_arena *Arena, render_command_pass_list *PassList);
-render_command_batch      * PushMeshBatchParams  (mesh_batch_params *Params, memory_arena *Arena, render_command_batch_list *BatchList);
+// LSD radix sort of the keys, 8 bits at a time, skipping the digits every key shares. Scratch space
+// comes from Arena.
+void                  SortRenderCommands       (render_command_list *List, memory_arena *Arena);
 
 
 typedef struct
@@ -287,7 +290,8 @@ void RendererFlushFrame  (renderer *Renderer);
 typedef struct renderer
 {
     void                      *Backend;
-    render_command_pass_list   PassList;
+    render_command_list        Commands;
     renderer_resource_manager *Resources;
     resource_reference_table  *ReferenceTable;
+    texture_streamer          *Streamer;       // Optional.
 } renderer;
\ No newline at end of file
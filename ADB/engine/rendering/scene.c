@@ -1,7 +1,9 @@
 #include <stdbool.h>
 #include <assert.h>
+#include <math.h>
 
 #include "platform/platform.h"
+#include "platform/profiler.h"
 #include "renderer.h"
 
 #include "scene.h"
@@ -12,7 +14,7 @@ CreateGameEntity(byte_string MeshResource, game_scene *Scene, renderer *Renderer
 {
 	game_entity *Entity = 0;
 
-	if (IsValidByteString(MeshResource) && Scene)
+	if (IsValidByteString(MeshResource) && Scene && Scene->EntityCount < MAX_ENTITY_COUNT)
 	{
 		// TODO: Query Resource, Allocate Entity, Bind Resource, Set State
 
@@ -22,8 +24,7 @@ CreateGameEntity(byte_string MeshResource, game_scene *Scene, renderer *Renderer
 		resource_uuid            MeshUUID  = MakeResourceUUID(MeshResource);
 		resource_reference_state MeshState = FindResourceByUUID(MeshUUID, Renderer->ReferenceTable);
 
-		// Obviously this is stupid, but fine for prototyping.
-		Entity = &Scene->Entities[0];
+		Entity = &Scene->Entities[Scene->EntityCount];
 		Entity->MeshHandle = BindResourceHandle(MeshState.Handle, Renderer->Resources);
 		Entity->IsAlive    = true;
 
@@ -34,9 +35,36 @@ CreateGameEntity(byte_string MeshResource, game_scene *Scene, renderer *Renderer
 }
 
 
+// The part of the view height the sphere covers, 0 when it is behind the camera. Entities have no
+// transform yet, the bounds are already in world space.
+
+static float
+GetScreenSize(camera *Camera, vec3 Center, float Radius)
+{
+	vec3  ToCenter = Vec3Subtract(Center, Camera->Position);
+	float Distance = Vec3Length(ToCenter);
+	float Result   = 0.f;
+
+	if (Distance <= Radius)
+	{
+		Result = 1.f;
+	}
+	else if (Vec3Dot(ToCenter, Camera->Forward) > -Radius)
+	{
+		Result = Radius / (Distance * tanf(Camera->FovY * 0.5f));
+	}
+
+	return Result;
+}
+
+
 void
 UpdateScene(game_scene *Scene, engine_memory *EngineMemory, renderer *Renderer)
 {
+	TIMED_BLOCK_BEGIN(UpdateScene);
+
+	(void)EngineMemory;
+
 	mesh_group_params GroupParams =
 	{
 		.WorldMatrix      = GetCameraWorldMatrix(&Scene->Camera),
@@ -44,7 +72,9 @@ UpdateScene(game_scene *Scene, engine_memory *EngineMemory, renderer *Renderer)
 		.ProjectionMatrix = GetCameraProjectionMatrix(&Scene->Camera),
 	};
 
-	render_command_batch_list *BatchList = PushMeshGroupParams(&GroupParams, EngineMemory->FrameMemory, &Renderer->PassList);
+	camera  *Camera     = &Scene->Camera;
+	uint32_t GroupIdx   = PushMeshGroupParams(&GroupParams, &Renderer->Commands);
+	float    DepthScale = 1.f / (Camera->FarPlane - Camera->NearPlane);
 
 	for (uint32_t Idx = 0; Idx < Scene->EntityCount; ++Idx)
 	{
@@ -57,20 +87,39 @@ UpdateScene(game_scene *Scene, engine_memory *EngineMemory, renderer *Renderer)
 
 			for (uint32_t MeshIdx = 0; MeshIdx < Mesh->SubmeshCount; ++MeshIdx)
 			{
-				mesh_batch_params BatchParams =
+				renderer_material *Material    = AccessUnderlyingResource(Mesh->Submeshes[MeshIdx].Material, Renderer->Resources);
+				mesh_batch_params  BatchParams = {0};
+
+				for (uint32_t TextureIdx = 0; Material && TextureIdx < MaterialTexture_Count; ++TextureIdx)
+				{
+					BatchParams.Textures[TextureIdx] = Material->Textures[TextureIdx];
+				}
+
+				float ScreenSize = GetScreenSize(&Scene->Camera, Mesh->Submeshes[MeshIdx].Center, Mesh->Submeshes[MeshIdx].Radius);
+				RequestMaterialDetail(Mesh->Submeshes[MeshIdx].Material, ScreenSize, Renderer);
+
+				// Sorted on the distance to the center along the view, closest first.
+
+				render_command_key Key =
 				{
-					.Material = Mesh->Submeshes[MeshIdx].Material,
+					.Pass     = RenderPass_Mesh,
+					.Group    = GroupIdx,
+					.Material = PushMeshBatchParams(&BatchParams, &Renderer->Commands),
+					.Mesh     = Entity->MeshHandle.Value,
+					.Depth    = (Vec3Dot(Vec3Subtract(Mesh->Submeshes[MeshIdx].Center, Camera->Position), Camera->Forward) - Camera->NearPlane) * DepthScale,
 				};
 
-				render_command_batch *Batch   = PushMeshBatchParams(&BatchParams, EngineMemory->FrameMemory, BatchList);
-				render_command       *Command = PushRenderCommand(Batch);
+				render_command *Command = PushRenderCommand(Key, &Renderer->Commands);
 
 				if (Command)
 				{
 					Command->Type = RenderCommand_StaticGeometry;
-					Command->StaticGeometry.MeshHandle = Entity->MeshHandle;
+					Command->StaticGeometry.MeshHandle   = Entity->MeshHandle;
+					Command->StaticGeometry.SubmeshIndex = MeshIdx;
 				}
 			}
 		}
 	}
+
+	TIMED_BLOCK_END(UpdateScene);
 }
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
 
-#define MAX_ENTITY_COUNT 64
+#define MAX_ENTITY_COUNT 1024
 
 
 typedef struct
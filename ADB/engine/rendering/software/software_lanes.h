@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#define SOFTWARE_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_AVX2 0
+#include <emmintrin.h>
+#else
+#error "The software renderer needs SSE2"
+#endif
+
+// ==============================================
+// <Lanes>
+// ==============================================
+
+// SOFTWARE_LANE_COUNT floats or integers side by side, 8 where the compiler targets AVX2 and 4
+// otherwise. Masks are all ones in the lanes they hold for. The U16 operations work on the two
+// halves of every lane separately.
+
+#if SOFTWARE_AVX2
+
+#define SOFTWARE_LANE_COUNT 8
+
+typedef __m256  lane_f32;
+typedef __m256i lane_u32;
+
+#define LaneF32(Value)              _mm256_set1_ps(Value)
+#define LaneU32(Value)              _mm256_set1_epi32((int)(Value))
+#define LaneOffsets()               _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f)
+#define LaneLoadF32(At)             _mm256_load_ps(At)
+#define LaneStoreF32(At, Value)     _mm256_store_ps((At), (Value))
+#define LaneLoadU32(At)             _mm256_load_si256((__m256i *)(At))
+#define LaneStoreU32(At, Value)     _mm256_store_si256((__m256i *)(At), (Value))
+#define LaneAdd(A, B)               _mm256_add_ps((A), (B))
+#define LaneMul(A, B)               _mm256_mul_ps((A), (B))
+#define LaneDiv(A, B)               _mm256_div_ps((A), (B))
+#define LaneMin(A, B)               _mm256_min_ps((A), (B))
+#define LaneMax(A, B)               _mm256_max_ps((A), (B))
+#define LaneSub(A, B)               _mm256_sub_ps((A), (B))
+#define LaneToF32(A)                _mm256_cvtepi32_ps(A)
+#define LaneOr(A, B)                _mm256_or_si256((A), (B))
+#define LaneAddU32(A, B)            _mm256_add_epi32((A), (B))
+#define LaneSubU32(A, B)            _mm256_sub_epi32((A), (B))
+#define LaneCastU32(A)              _mm256_castps_si256(A)
+#define LaneCastF32(A)              _mm256_castsi256_ps(A)
+#define LaneShiftLeft(A, Count)     _mm256_slli_epi32((A), (Count))
+#define LaneShiftRight(A, Count)    _mm256_srli_epi32((A), (Count))
+#define LaneAddU16(A, B)            _mm256_add_epi16((A), (B))
+#define LaneMulU16(A, B)            _mm256_mullo_epi16((A), (B))
+#define LaneTruncate(A)             _mm256_cvttps_epi32(A)
+#define LaneGreaterEqual(A, B)      _mm256_castps_si256(_mm256_cmp_ps((A), (B), _CMP_GE_OQ))
+#define LaneLess(A, B)              _mm256_castps_si256(_mm256_cmp_ps((A), (B), _CMP_LT_OQ))
+#define LaneAnd(A, B)               _mm256_and_si256((A), (B))
+#define LaneMaskBits(Mask)          ((uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(Mask)))
+#define LaneSelectU32(Mask, A, B)   _mm256_blendv_epi8((B), (A), (Mask))
+#define LaneSelectF32(Mask, A, B)   _mm256_blendv_ps((B), (A), _mm256_castsi256_ps(Mask))
+
+#else
+
+#define SOFTWARE_LANE_COUNT 4
+
+typedef __m128  lane_f32;
+typedef __m128i lane_u32;
+
+#define LaneF32(Value)              _mm_set1_ps(Value)
+#define LaneU32(Value)              _mm_set1_epi32((int)(Value))
+#define LaneOffsets()               _mm_setr_ps(0.f, 1.f, 2.f, 3.f)
+#define LaneLoadF32(At)             _mm_load_ps(At)
+#define LaneStoreF32(At, Value)     _mm_store_ps((At), (Value))
+#define LaneLoadU32(At)             _mm_load_si128((__m128i *)(At))
+#define LaneStoreU32(At, Value)     _mm_store_si128((__m128i *)(At), (Value))
+#define LaneAdd(A, B)               _mm_add_ps((A), (B))
+#define LaneMul(A, B)               _mm_mul_ps((A), (B))
+#define LaneDiv(A, B)               _mm_div_ps((A), (B))
+#define LaneMin(A, B)               _mm_min_ps((A), (B))
+#define LaneMax(A, B)               _mm_max_ps((A), (B))
+#define LaneSub(A, B)               _mm_sub_ps((A), (B))
+#define LaneToF32(A)                _mm_cvtepi32_ps(A)
+#define LaneOr(A, B)                _mm_or_si128((A), (B))
+#define LaneAddU32(A, B)            _mm_add_epi32((A), (B))
+#define LaneSubU32(A, B)            _mm_sub_epi32((A), (B))
+#define LaneCastU32(A)              _mm_castps_si128(A)
+#define LaneCastF32(A)              _mm_castsi128_ps(A)
+#define LaneShiftLeft(A, Count)     _mm_slli_epi32((A), (Count))
+#define LaneShiftRight(A, Count)    _mm_srli_epi32((A), (Count))
+#define LaneAddU16(A, B)            _mm_add_epi16((A), (B))
+#define LaneMulU16(A, B)            _mm_mullo_epi16((A), (B))
+#define LaneTruncate(A)             _mm_cvttps_epi32(A)
+#define LaneGreaterEqual(A, B)      _mm_castps_si128(_mm_cmpge_ps((A), (B)))
+#define LaneLess(A, B)              _mm_castps_si128(_mm_cmplt_ps((A), (B)))
+#define LaneAnd(A, B)               _mm_and_si128((A), (B))
+#define LaneMaskBits(Mask)          ((uint32_t)_mm_movemask_ps(_mm_castsi128_ps(Mask)))
+#define LaneSelectU32(Mask, A, B)   _mm_or_si128(_mm_and_si128((Mask), (A)), _mm_andnot_si128((Mask), (B)))
+#define LaneSelectF32(Mask, A, B)   _mm_castsi128_ps(LaneSelectU32((Mask), _mm_castps_si128(A), _mm_castps_si128(B)))
+
+#endif
\ No newline at end of file
@@ -0,0 +1,985 @@
+#include <assert.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "platform/parallel.h"
+#include "platform/profiler.h"
+#include "engine/rendering/renderer.h"
+#include "engine/rendering/assets.h"
+#include "engine/rendering/textures/texture_mips.h"
+
+#include "software_lanes.h"
+#include "software_texture.h"
+#include "software_renderer.h"
+
+// Tiles are square and a whole number of lanes wide, the buffers are padded to whole tiles.
+#define SOFTWARE_TILE_SIZE       64
+
+// Vertices a job transforms at most, whole triangles and a whole number of lanes either way.
+#define SOFTWARE_SPAN_SIZE       (3 * 8 * 64)
+
+// The triangles are split in this many slices for binning, each one counts its tiles on its own.
+#define SOFTWARE_BIN_SLICE_COUNT 64
+
+#define SOFTWARE_SUBPIXEL_COUNT  16.f
+
+// ==============================================
+// <Lanes> : INTERNAL
+// ==============================================
+
+
+static uint32_t
+CountMaskBits(uint32_t Bits)
+{
+    uint32_t Result = 0;
+
+    for (; Bits; Bits &= Bits - 1)
+    {
+        ++Result;
+    }
+
+    return Result;
+}
+
+// ==============================================
+// <Software Backend> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    mesh_vertex_data *Vertices;
+    uint64_t          VertexCount;
+} software_vertex_buffer;
+
+
+typedef struct
+{
+    mesh_vertex_data *Vertices;     // The draw's first vertex.
+    uint32_t          VertexCount;  // Whole triangles.
+    uint32_t          GroupIdx;
+    software_texture *Texture;
+} software_draw;
+
+
+typedef struct
+{
+    uint32_t DrawIdx;
+    uint32_t First;             // Vertex of the draw.
+    uint32_t Count;
+    uint32_t VertexBase;        // Where its clip-space vertices go, a whole number of lanes in.
+    uint32_t TriangleBase;      // Its first triangle slot, there are two per triangle.
+    uint32_t RasterizedCount;
+} software_span;
+
+
+typedef enum
+{
+    SoftwarePlane_Z    = 0,
+    SoftwarePlane_InvW = 1,
+    SoftwarePlane_U    = 2, // U/W
+    SoftwarePlane_V    = 3, // V/W
+
+    SoftwarePlane_Count = 4,
+} SoftwarePlane_Type;
+
+
+// Edge I goes through (EdgeX, EdgeY) and is A * (X - EdgeX) + B * (Y - EdgeY), positive inside. Bias
+// is what the top-left rule takes off the edges that must not own the pixels right on them. Planes
+// are d/dX, d/dY and the value at the origin, the first vertex.
+
+typedef struct
+{
+    float             EdgeA[3];
+    float             EdgeB[3];
+    float             EdgeX[3];
+    float             EdgeY[3];
+    float             EdgeBias[3];
+
+    float             OriginX;
+    float             OriginY;
+    float             Planes[SoftwarePlane_Count][3];
+
+    int32_t           MinX;     // The pixels whose center it may cover, MinX > MaxX when none.
+    int32_t           MinY;
+    int32_t           MaxX;
+    int32_t           MaxY;
+
+    software_texture *Texture;
+} software_triangle;
+
+
+typedef struct
+{
+    uint32_t *Triangles;
+    uint32_t  Count;
+    uint64_t  PixelCount;
+} software_tile;
+
+
+typedef struct
+{
+    float X, Y, Z, W, U, V;
+} software_vertex;
+
+
+typedef struct software_renderer
+{
+    memory_arena         *Arena;
+    uint32_t              MaxWidth;
+    uint32_t              MaxHeight;
+    uint32_t              Pitch;        // Pixels, a whole number of tiles.
+    uint32_t             *Color;
+    float                *Depth;
+    uint32_t              ClearColor;
+
+    software_image        Image;
+    software_frame_stats  Frame;
+    software_frame_stats  Last;
+} software_renderer;
+
+
+// Everything one RendererDrawFrame works on, in frame memory.
+
+typedef struct
+{
+    software_renderer *Software;
+    int32_t            Width;
+    int32_t            Height;
+
+    mat4x4            *Transforms;  // Projection * View * World, per group.
+    software_draw     *Draws;
+    software_span     *Spans;
+    uint32_t           SpanCount;
+
+    float             *Clip[6];     // X, Y, Z, W, U, V, per span vertex.
+    software_triangle *Triangles;
+    uint32_t           SlotCount;
+
+    uint32_t           TileCountX;
+    uint32_t           TileCount;
+    software_tile     *Tiles;
+    uint32_t           SliceCount;
+    uint32_t          *SliceTiles;  // Per slice and tile: the count, then where the slice writes.
+    uint32_t          *Binned;
+} software_frame;
+
+
+software_renderer *
+SoftwareInitialize(uint32_t MaxWidth, uint32_t MaxHeight, memory_arena *Arena)
+{
+    software_renderer *Result = PushStruct(Arena, software_renderer);
+
+    if (Result && MaxWidth && MaxHeight)
+    {
+        memset(Result, 0, sizeof(software_renderer));
+
+        uint32_t RowCount = AlignPow2(MaxHeight, SOFTWARE_TILE_SIZE);
+
+        Result->Arena     = Arena;
+        Result->MaxWidth  = MaxWidth;
+        Result->MaxHeight = MaxHeight;
+        Result->Pitch     = AlignPow2(MaxWidth, SOFTWARE_TILE_SIZE);
+        Result->Color     = PushArrayAligned(Arena, uint32_t, (uint64_t)Result->Pitch * RowCount, 64);
+        Result->Depth     = PushArrayAligned(Arena, float, (uint64_t)Result->Pitch * RowCount, 64);
+    }
+
+    return Result;
+}
+
+
+software_image
+GetSoftwareImage(software_renderer *Software)
+{
+    software_image Result = Software->Image;
+    return Result;
+}
+
+
+software_frame_stats
+GetSoftwareFrameStats(software_renderer *Software)
+{
+    software_frame_stats Result = Software->Last;
+    return Result;
+}
+
+// ==============================================
+// <Resources>
+// ==============================================
+
+
+void *
+RendererCreateVertexBuffer(void *Data, uint64_t Size, renderer *Renderer)
+{
+    software_vertex_buffer *Result = 0;
+
+    if (Data && Size && Renderer)
+    {
+        software_renderer *Software = (software_renderer *)Renderer->Backend;
+
+        Result = PushStruct(Software->Arena, software_vertex_buffer);
+        if (Result)
+        {
+            Result->VertexCount = Size / sizeof(mesh_vertex_data);
+            Result->Vertices    = PushArray(Software->Arena, mesh_vertex_data, Result->VertexCount);
+
+            if (Result->Vertices)
+            {
+                memcpy(Result->Vertices, Data, Result->VertexCount * sizeof(mesh_vertex_data));
+            }
+        }
+    }
+
+    return Result;
+}
+
+
+void *
+RendererCreateTexture(loaded_texture LoadedTexture, renderer *Renderer)
+{
+    (void)Renderer;
+
+    software_texture *Result = 0;
+
+    // Same checks as the D3D11 backend, a texture it would refuse is refused here as well.
+
+    bool IsSupported = LoadedTexture.Format == TextureFormat_RGBA8 ? LoadedTexture.BytesPerPixel == 4 : (uint32_t)LoadedTexture.Format < TextureFormat_Count;
+
+    if (IsSupported)
+    {
+        Result = CreateSoftwareTexture(LoadedTexture);
+    }
+
+    return Result;
+}
+
+
+void
+RendererDestroyTexture(void *Texture, renderer *Renderer)
+{
+    (void)Renderer;
+
+    DestroySoftwareTexture((software_texture *)Texture);
+}
+
+// ==============================================
+// <Vertices> : INTERNAL
+// ==============================================
+
+
+// Lanes of the span's vertices from Index on. Lanes past the end repeat the last vertex, they are
+// transformed for nothing but never read outside the buffer.
+
+static void
+LoadVertexLanes(mesh_vertex_data *Vertices, uint32_t Index, uint32_t Count, lane_f32 *Out)
+{
+#if SOFTWARE_AVX2
+    __m256i Lanes   = _mm256_add_epi32(_mm256_set1_epi32((int)Index), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i Offsets = _mm256_mullo_epi32(_mm256_min_epi32(Lanes, _mm256_set1_epi32((int)Count - 1)), _mm256_set1_epi32(sizeof(mesh_vertex_data) / sizeof(float)));
+
+    Out[0] = _mm256_i32gather_ps(&Vertices->Position.X, Offsets, 4);
+    Out[1] = _mm256_i32gather_ps(&Vertices->Position.Y, Offsets, 4);
+    Out[2] = _mm256_i32gather_ps(&Vertices->Position.Z, Offsets, 4);
+    Out[3] = _mm256_i32gather_ps(&Vertices->Texture.X,  Offsets, 4);
+    Out[4] = _mm256_i32gather_ps(&Vertices->Texture.Y,  Offsets, 4);
+#else
+    mesh_vertex_data *Lane[4];
+
+    for (uint32_t Idx = 0; Idx < 4; ++Idx)
+    {
+        Lane[Idx] = Vertices + Minimum(Index + Idx, Count - 1);
+    }
+
+    Out[0] = _mm_setr_ps(Lane[0]->Position.X, Lane[1]->Position.X, Lane[2]->Position.X, Lane[3]->Position.X);
+    Out[1] = _mm_setr_ps(Lane[0]->Position.Y, Lane[1]->Position.Y, Lane[2]->Position.Y, Lane[3]->Position.Y);
+    Out[2] = _mm_setr_ps(Lane[0]->Position.Z, Lane[1]->Position.Z, Lane[2]->Position.Z, Lane[3]->Position.Z);
+    Out[3] = _mm_setr_ps(Lane[0]->Texture.X,  Lane[1]->Texture.X,  Lane[2]->Texture.X,  Lane[3]->Texture.X);
+    Out[4] = _mm_setr_ps(Lane[0]->Texture.Y,  Lane[1]->Texture.Y,  Lane[2]->Texture.Y,  Lane[3]->Texture.Y);
+#endif
+}
+
+
+// Row of a column-vector matrix times (X, Y, Z, 1).
+
+static lane_f32
+TransformLanes(float *Row, lane_f32 X, lane_f32 Y, lane_f32 Z)
+{
+    lane_f32 Result = LaneAdd(LaneAdd(LaneMul(LaneF32(Row[0]), X), LaneMul(LaneF32(Row[4]), Y)),
+                              LaneAdd(LaneMul(LaneF32(Row[8]), Z), LaneF32(Row[12])));
+    return Result;
+}
+
+
+static void
+TransformSpan(software_frame *Frame, software_span *Span)
+{
+    software_draw    *Draw     = Frame->Draws + Span->DrawIdx;
+    float            *Matrix   = &Frame->Transforms[Draw->GroupIdx].c0r0;
+    mesh_vertex_data *Vertices = Draw->Vertices + Span->First;
+
+    for (uint32_t Idx = 0; Idx < Span->Count; Idx += SOFTWARE_LANE_COUNT)
+    {
+        lane_f32 In[5];
+        LoadVertexLanes(Vertices, Idx, Span->Count, In);
+
+        uint32_t At = Span->VertexBase + Idx;
+
+        for (uint32_t Row = 0; Row < 4; ++Row)
+        {
+            LaneStoreF32(Frame->Clip[Row] + At, TransformLanes(Matrix + Row, In[0], In[1], In[2]));
+        }
+
+        LaneStoreF32(Frame->Clip[4] + At, In[3]);
+        LaneStoreF32(Frame->Clip[5] + At, In[4]);
+    }
+}
+
+
+// Keeps what lies in front of the near plane (Z >= -W), 3 or 4 vertices, 0 when nothing does.
+
+static uint32_t
+ClipAgainstNearPlane(software_vertex *In, software_vertex *Out)
+{
+    uint32_t Result = 0;
+
+    for (uint32_t Idx = 0; Idx < 3; ++Idx)
+    {
+        software_vertex *A = In + Idx;
+        software_vertex *B = In + (Idx + 1) % 3;
+
+        float DistanceA = A->Z + A->W;
+        float DistanceB = B->Z + B->W;
+
+        if (DistanceA >= 0.f)
+        {
+            Out[Result++] = *A;
+        }
+
+        if ((DistanceA >= 0.f) != (DistanceB >= 0.f))
+        {
+            float  T    = DistanceA / (DistanceA - DistanceB);
+            float *From = &A->X;
+            float *To   = &B->X;
+            float *At   = &Out[Result++].X;
+
+            for (uint32_t Component = 0; Component < 6; ++Component)
+            {
+                At[Component] = From[Component] + (To[Component] - From[Component]) * T;
+            }
+        }
+    }
+
+    return Result;
+}
+
+
+static bool
+SetupTriangle(software_frame *Frame, software_vertex *V0, software_vertex *V1, software_vertex *V2, software_texture *Texture, software_triangle *Out)
+{
+    software_vertex *Vertices[3] = {V0, V1, V2};
+
+    float X[3], Y[3], Planes[SoftwarePlane_Count][3];
+
+    for (uint32_t Idx = 0; Idx < 3; ++Idx)
+    {
+        software_vertex *Vertex = Vertices[Idx];
+        float            InvW   = 1.f / Vertex->W;
+
+        X[Idx] = floorf((Vertex->X * InvW * 0.5f + 0.5f) * (float)Frame->Width  * SOFTWARE_SUBPIXEL_COUNT + 0.5f) / SOFTWARE_SUBPIXEL_COUNT;
+        Y[Idx] = floorf((0.5f - Vertex->Y * InvW * 0.5f) * (float)Frame->Height * SOFTWARE_SUBPIXEL_COUNT + 0.5f) / SOFTWARE_SUBPIXEL_COUNT;
+
+        Planes[SoftwarePlane_Z][Idx]    = Vertex->Z * InvW;
+        Planes[SoftwarePlane_InvW][Idx] = InvW;
+        Planes[SoftwarePlane_U][Idx]    = Vertex->U * InvW;
+        Planes[SoftwarePlane_V][Idx]    = Vertex->V * InvW;
+    }
+
+    // Counter-clockwise on screen is a negative area with Y down: those are the front faces. They are
+    // turned around so that the edge functions are positive inside.
+
+    float Area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+
+    if (!(Area < 0.f))
+    {
+        return false;
+    }
+
+    float Swap;
+    Swap = X[1]; X[1] = X[2]; X[2] = Swap;
+    Swap = Y[1]; Y[1] = Y[2]; Y[2] = Swap;
+
+    for (uint32_t Plane = 0; Plane < SoftwarePlane_Count; ++Plane)
+    {
+        Swap = Planes[Plane][1]; Planes[Plane][1] = Planes[Plane][2]; Planes[Plane][2] = Swap;
+    }
+
+    Area = -Area;
+
+    // Pixel centers sit at .5, clamped before anything becomes an integer.
+
+    float MinX = fmaxf(ceilf(fminf(X[0], fminf(X[1], X[2])) - 0.5f), 0.f);
+    float MinY = fmaxf(ceilf(fminf(Y[0], fminf(Y[1], Y[2])) - 0.5f), 0.f);
+    float MaxX = fminf(floorf(fmaxf(X[0], fmaxf(X[1], X[2])) - 0.5f), (float)(Frame->Width - 1));
+    float MaxY = fminf(floorf(fmaxf(Y[0], fmaxf(Y[1], Y[2])) - 0.5f), (float)(Frame->Height - 1));
+
+    if (!(MinX <= MaxX && MinY <= MaxY))
+    {
+        return false;
+    }
+
+    Out->MinX = (int32_t)MinX;
+    Out->MinY = (int32_t)MinY;
+    Out->MaxX = (int32_t)MaxX;
+    Out->MaxY = (int32_t)MaxY;
+
+    // Edge I is opposite vertex I, its function is Area at that vertex: divided by Area they are the
+    // barycentric coordinates. Snapped positions put products on a 1/256 grid, an edge that must not
+    // own a pixel right on it gives up half a step.
+
+    for (uint32_t Edge = 0; Edge < 3; ++Edge)
+    {
+        uint32_t From = (Edge + 1) % 3;
+        uint32_t To   = (Edge + 2) % 3;
+        float    A    = Y[From] - Y[To];
+        float    B    = X[To] - X[From];
+
+        bool IsTopLeft = A > 0.f || (A == 0.f && B > 0.f);
+
+        Out->EdgeA[Edge]    = A;
+        Out->EdgeB[Edge]    = B;
+        Out->EdgeX[Edge]    = X[From];
+        Out->EdgeY[Edge]    = Y[From];
+        Out->EdgeBias[Edge] = IsTopLeft ? 0.f : -0.5f / (SOFTWARE_SUBPIXEL_COUNT * SOFTWARE_SUBPIXEL_COUNT);
+    }
+
+    Out->OriginX = X[0];
+    Out->OriginY = Y[0];
+
+    for (uint32_t Plane = 0; Plane < SoftwarePlane_Count; ++Plane)
+    {
+        float *Values = Planes[Plane];
+
+        Out->Planes[Plane][0] = (Values[0] * Out->EdgeA[0] + Values[1] * Out->EdgeA[1] + Values[2] * Out->EdgeA[2]) / Area;
+        Out->Planes[Plane][1] = (Values[0] * Out->EdgeB[0] + Values[1] * Out->EdgeB[1] + Values[2] * Out->EdgeB[2]) / Area;
+        Out->Planes[Plane][2] = Values[0];
+    }
+
+    Out->Texture = Texture;
+    return true;
+}
+
+
+static void
+SetupSpan(software_frame *Frame, software_span *Span)
+{
+    software_texture *Texture = Frame->Draws[Span->DrawIdx].Texture;
+
+    for (uint32_t Triangle = 0; Triangle < Span->Count / 3; ++Triangle)
+    {
+        software_triangle *Slots = Frame->Triangles + Span->TriangleBase + Triangle * 2;
+        software_vertex    In[3];
+        software_vertex    Clipped[4];
+
+        for (uint32_t Corner = 0; Corner < 3; ++Corner)
+        {
+            uint32_t At = Span->VertexBase + Triangle * 3 + Corner;
+
+            In[Corner] = (software_vertex){Frame->Clip[0][At], Frame->Clip[1][At], Frame->Clip[2][At], Frame->Clip[3][At], Frame->Clip[4][At], Frame->Clip[5][At]};
+        }
+
+        uint32_t ClippedCount = ClipAgainstNearPlane(In, Clipped);
+        bool     HasFirst     = ClippedCount >= 3 && SetupTriangle(Frame, Clipped, Clipped + 1, Clipped + 2, Texture, Slots);
+        bool     HasSecond    = ClippedCount == 4 && SetupTriangle(Frame, Clipped, Clipped + 2, Clipped + 3, Texture, Slots + 1);
+
+        Slots[0].MinX = HasFirst  ? Slots[0].MinX : 1;
+        Slots[0].MaxX = HasFirst  ? Slots[0].MaxX : 0;
+        Slots[1].MinX = HasSecond ? Slots[1].MinX : 1;
+        Slots[1].MaxX = HasSecond ? Slots[1].MaxX : 0;
+
+        Span->RasterizedCount += (HasFirst ? 1 : 0) + (HasSecond ? 1 : 0);
+    }
+}
+
+
+static void
+RunVertexSpans(uint64_t First, uint64_t End, void *Context)
+{
+    software_frame *Frame = (software_frame *)Context;
+
+    for (uint64_t SpanIdx = First; SpanIdx < End; ++SpanIdx)
+    {
+        TransformSpan(Frame, Frame->Spans + SpanIdx);
+        SetupSpan(Frame, Frame->Spans + SpanIdx);
+    }
+}
+
+// ==============================================
+// <Binning> : INTERNAL
+// ==============================================
+
+
+// Whether some pixel center of the rectangle may be inside every edge: each edge is tested at the
+// corner it is the most positive at.
+
+static bool
+OverlapsRectangle(software_triangle *Triangle, int32_t MinX, int32_t MinY, int32_t MaxX, int32_t MaxY)
+{
+    bool Result = true;
+
+    for (uint32_t Edge = 0; Edge < 3 && Result; ++Edge)
+    {
+        double X = (Triangle->EdgeA[Edge] > 0.f ? MaxX : MinX) + 0.5;
+        double Y = (Triangle->EdgeB[Edge] > 0.f ? MaxY : MinY) + 0.5;
+
+        double Value = (double)Triangle->EdgeA[Edge] * (X - Triangle->EdgeX[Edge]) + (double)Triangle->EdgeB[Edge] * (Y - Triangle->EdgeY[Edge]);
+
+        Result = Value + Triangle->EdgeBias[Edge] >= 0.0;
+    }
+
+    return Result;
+}
+
+
+// Counts the triangles of the slice per tile, or writes them where the counts said.
+
+static void
+BinSlice(software_frame *Frame, uint32_t Slice, bool Write)
+{
+    uint32_t *Tiles = Frame->SliceTiles + (uint64_t)Slice * Frame->TileCount;
+    uint32_t  First = (uint32_t)((uint64_t)Frame->SlotCount * Slice / Frame->SliceCount);
+    uint32_t  End   = (uint32_t)((uint64_t)Frame->SlotCount * (Slice + 1) / Frame->SliceCount);
+
+    if (!Write)
+    {
+        memset(Tiles, 0, Frame->TileCount * sizeof(uint32_t));
+    }
+
+    for (uint32_t TriangleIdx = First; TriangleIdx < End; ++TriangleIdx)
+    {
+        software_triangle *Triangle = Frame->Triangles + TriangleIdx;
+
+        if (Triangle->MinX > Triangle->MaxX)
+        {
+            continue;
+        }
+
+        for (int32_t TileY = Triangle->MinY / SOFTWARE_TILE_SIZE; TileY <= Triangle->MaxY / SOFTWARE_TILE_SIZE; ++TileY)
+        {
+            for (int32_t TileX = Triangle->MinX / SOFTWARE_TILE_SIZE; TileX <= Triangle->MaxX / SOFTWARE_TILE_SIZE; ++TileX)
+            {
+                int32_t  MinX = Maximum(TileX * SOFTWARE_TILE_SIZE, Triangle->MinX);
+                int32_t  MinY = Maximum(TileY * SOFTWARE_TILE_SIZE, Triangle->MinY);
+                int32_t  MaxX = Minimum(TileX * SOFTWARE_TILE_SIZE + SOFTWARE_TILE_SIZE - 1, Triangle->MaxX);
+                int32_t  MaxY = Minimum(TileY * SOFTWARE_TILE_SIZE + SOFTWARE_TILE_SIZE - 1, Triangle->MaxY);
+                uint32_t Tile = TileY * Frame->TileCountX + TileX;
+
+                if (OverlapsRectangle(Triangle, MinX, MinY, MaxX, MaxY))
+                {
+                    if (Write)
+                    {
+                        Frame->Binned[Tiles[Tile]++] = TriangleIdx;
+                    }
+                    else
+                    {
+                        ++Tiles[Tile];
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+static void
+CountSlices(uint64_t First, uint64_t End, void *Context)
+{
+    for (uint64_t Slice = First; Slice < End; ++Slice)
+    {
+        BinSlice((software_frame *)Context, (uint32_t)Slice, false);
+    }
+}
+
+
+static void
+WriteSlices(uint64_t First, uint64_t End, void *Context)
+{
+    for (uint64_t Slice = First; Slice < End; ++Slice)
+    {
+        BinSlice((software_frame *)Context, (uint32_t)Slice, true);
+    }
+}
+
+// ==============================================
+// <Tiles> : INTERNAL
+// ==============================================
+
+
+static void
+ClearTile(software_renderer *Software, int32_t TileX, int32_t TileY)
+{
+    lane_u32 Color = LaneU32(Software->ClearColor);
+    lane_f32 Depth = LaneF32(FLT_MAX);
+
+    for (int32_t Y = TileY; Y < TileY + SOFTWARE_TILE_SIZE; ++Y)
+    {
+        uint32_t *ColorRow = Software->Color + (uint64_t)Y * Software->Pitch;
+        float    *DepthRow = Software->Depth + (uint64_t)Y * Software->Pitch;
+
+        for (int32_t X = TileX; X < TileX + SOFTWARE_TILE_SIZE; X += SOFTWARE_LANE_COUNT)
+        {
+            LaneStoreU32(ColorRow + X, Color);
+            LaneStoreF32(DepthRow + X, Depth);
+        }
+    }
+}
+
+
+static uint64_t
+RasterizeTriangle(software_renderer *Software, software_triangle *Triangle, int32_t TileX, int32_t TileY)
+{
+    uint64_t Result = 0;
+
+    // Lanes start on a whole lane, the ones left of the triangle fail the edge test. Those right of
+    // MaxX may not, when the view cut the triangle: they are masked.
+
+    int32_t MinX = Maximum(Triangle->MinX, TileX) & ~(SOFTWARE_LANE_COUNT - 1);
+    int32_t MinY = Maximum(Triangle->MinY, TileY);
+    int32_t MaxX = Minimum(Triangle->MaxX, TileX + SOFTWARE_TILE_SIZE - 1);
+    int32_t MaxY = Minimum(Triangle->MaxY, TileY + SOFTWARE_TILE_SIZE - 1);
+
+    // Everything is evaluated from the center of the tile's first pixel, the offsets stay small.
+
+    double CenterX = TileX + 0.5;
+    double CenterY = TileY + 0.5;
+
+    lane_f32 EdgeA[3], EdgeB[3];
+    float    EdgeC[3];
+
+    for (uint32_t Edge = 0; Edge < 3; ++Edge)
+    {
+        EdgeA[Edge] = LaneF32(Triangle->EdgeA[Edge]);
+        EdgeB[Edge] = LaneF32(Triangle->EdgeB[Edge]);
+        EdgeC[Edge] = (float)((double)Triangle->EdgeA[Edge] * (CenterX - Triangle->EdgeX[Edge]) +
+                              (double)Triangle->EdgeB[Edge] * (CenterY - Triangle->EdgeY[Edge])) + Triangle->EdgeBias[Edge];
+    }
+
+    lane_f32 PlaneA[SoftwarePlane_Count], PlaneB[SoftwarePlane_Count];
+    float    PlaneC[SoftwarePlane_Count];
+
+    for (uint32_t Plane = 0; Plane < SoftwarePlane_Count; ++Plane)
+    {
+        float *Values = Triangle->Planes[Plane];
+
+        PlaneA[Plane] = LaneF32(Values[0]);
+        PlaneB[Plane] = LaneF32(Values[1]);
+        PlaneC[Plane] = (float)(Values[0] * (CenterX - Triangle->OriginX) + Values[1] * (CenterY - Triangle->OriginY) + Values[2]);
+    }
+
+    lane_f32 Zero    = LaneF32(0.f);
+    lane_f32 Offsets = LaneOffsets();
+    lane_f32 EndX    = LaneF32((float)(MaxX + 1 - TileX));
+
+    for (int32_t Y = MinY; Y <= MaxY; ++Y)
+    {
+        uint32_t *ColorRow = Software->Color + (uint64_t)Y * Software->Pitch;
+        float    *DepthRow = Software->Depth + (uint64_t)Y * Software->Pitch;
+        lane_f32  DeltaY   = LaneF32((float)(Y - TileY));
+
+        lane_f32 RowEdge[3], RowPlane[SoftwarePlane_Count];
+
+        for (uint32_t Edge = 0; Edge < 3; ++Edge)
+        {
+            RowEdge[Edge] = LaneAdd(LaneF32(EdgeC[Edge]), LaneMul(EdgeB[Edge], DeltaY));
+        }
+
+        for (uint32_t Plane = 0; Plane < SoftwarePlane_Count; ++Plane)
+        {
+            RowPlane[Plane] = LaneAdd(LaneF32(PlaneC[Plane]), LaneMul(PlaneB[Plane], DeltaY));
+        }
+
+        for (int32_t X = MinX; X <= MaxX; X += SOFTWARE_LANE_COUNT)
+        {
+            lane_f32 DeltaX = LaneAdd(LaneF32((float)(X - TileX)), Offsets);
+
+            lane_u32 Mask = LaneAnd(LaneAnd(LaneGreaterEqual(LaneAdd(RowEdge[0], LaneMul(EdgeA[0], DeltaX)), Zero),
+                                            LaneGreaterEqual(LaneAdd(RowEdge[1], LaneMul(EdgeA[1], DeltaX)), Zero)),
+                                    LaneAnd(LaneGreaterEqual(LaneAdd(RowEdge[2], LaneMul(EdgeA[2], DeltaX)), Zero), LaneLess(DeltaX, EndX)));
+
+            if (!LaneMaskBits(Mask))
+            {
+                continue;
+            }
+
+            lane_f32 Depth    = LaneLoadF32(DepthRow + X);
+            lane_f32 NewDepth = LaneAdd(RowPlane[SoftwarePlane_Z], LaneMul(PlaneA[SoftwarePlane_Z], DeltaX));
+
+            Mask = LaneAnd(Mask, LaneLess(NewDepth, Depth));
+
+            uint32_t Bits = LaneMaskBits(Mask);
+            if (!Bits)
+            {
+                continue;
+            }
+
+            lane_f32 InvW = LaneAdd(RowPlane[SoftwarePlane_InvW], LaneMul(PlaneA[SoftwarePlane_InvW], DeltaX));
+            lane_f32 W    = LaneDiv(LaneF32(1.f), InvW);
+            lane_f32 U    = LaneMul(LaneAdd(RowPlane[SoftwarePlane_U], LaneMul(PlaneA[SoftwarePlane_U], DeltaX)), W);
+            lane_f32 V    = LaneMul(LaneAdd(RowPlane[SoftwarePlane_V], LaneMul(PlaneA[SoftwarePlane_V], DeltaX)), W);
+
+            // d(U/W * W)/dX, what the quad of pixels around would see.
+
+            lane_f32 DUDX = LaneMul(LaneSub(PlaneA[SoftwarePlane_U], LaneMul(U, PlaneA[SoftwarePlane_InvW])), W);
+            lane_f32 DVDX = LaneMul(LaneSub(PlaneA[SoftwarePlane_V], LaneMul(V, PlaneA[SoftwarePlane_InvW])), W);
+            lane_f32 DUDY = LaneMul(LaneSub(PlaneB[SoftwarePlane_U], LaneMul(U, PlaneB[SoftwarePlane_InvW])), W);
+            lane_f32 DVDY = LaneMul(LaneSub(PlaneB[SoftwarePlane_V], LaneMul(V, PlaneB[SoftwarePlane_InvW])), W);
+
+            lane_f32 Lod   = GetSoftwareTextureLod(Triangle->Texture, DUDX, DVDX, DUDY, DVDY);
+            lane_u32 Color = SampleTrilinear(Triangle->Texture, U, V, Lod);
+
+            LaneStoreF32(DepthRow + X, LaneSelectF32(Mask, NewDepth, Depth));
+            LaneStoreU32(ColorRow + X, LaneSelectU32(Mask, Color, LaneLoadU32(ColorRow + X)));
+
+            Result += CountMaskBits(Bits);
+        }
+    }
+
+    return Result;
+}
+
+
+static void
+RasterizeTiles(uint64_t First, uint64_t End, void *Context)
+{
+    software_frame    *Frame    = (software_frame *)Context;
+    software_renderer *Software = Frame->Software;
+
+    for (uint64_t TileIdx = First; TileIdx < End; ++TileIdx)
+    {
+        software_tile *Tile  = Frame->Tiles + TileIdx;
+        int32_t        TileX = (int32_t)(TileIdx % Frame->TileCountX) * SOFTWARE_TILE_SIZE;
+        int32_t        TileY = (int32_t)(TileIdx / Frame->TileCountX) * SOFTWARE_TILE_SIZE;
+
+        ClearTile(Software, TileX, TileY);
+
+        for (uint32_t Idx = 0; Idx < Tile->Count; ++Idx)
+        {
+            Tile->PixelCount += RasterizeTriangle(Software, Frame->Triangles + Tile->Triangles[Idx], TileX, TileY);
+        }
+    }
+}
+
+// ==============================================
+// <Drawing>
+// ==============================================
+
+
+void
+RendererStartFrame(clear_color Color, renderer *Renderer)
+{
+    software_renderer *Software = (software_renderer *)Renderer->Backend;
+
+    float    Channels[4] = {Color.R, Color.G, Color.B, Color.A};
+    uint32_t Packed      = 0;
+
+    for (uint32_t Channel = 0; Channel < 4; ++Channel)
+    {
+        float Value = fminf(fmaxf(Channels[Channel], 0.f), 1.f);
+        Packed |= (uint32_t)(Value * 255.f + 0.5f) << (Channel * 8);
+    }
+
+    Software->ClearColor = Packed;
+}
+
+
+// The draws of the frame in the order of their keys, front to back inside the same state, and the
+// spans they are cut in.
+
+static void
+CollectDraws(software_frame *Frame, renderer *Renderer, memory_arena *Arena)
+{
+    render_command_list *Commands = &Renderer->Commands;
+
+    Frame->Transforms = PushArray(Arena, mat4x4, Maximum(Commands->GroupCount, 1));
+    Frame->Draws      = PushArray(Arena, software_draw, Maximum(Commands->Count, 1));
+
+    for (uint32_t GroupIdx = 0; GroupIdx < Commands->GroupCount; ++GroupIdx)
+    {
+        mesh_group_params *Params = Commands->Groups + GroupIdx;
+
+        Frame->Transforms[GroupIdx] = Mat4x4Multiply(Params->ProjectionMatrix, Mat4x4Multiply(Params->ViewMatrix, Params->WorldMatrix));
+    }
+
+    uint32_t DrawCount = 0;
+
+    for (uint32_t EntryIdx = 0; EntryIdx < Commands->Count; ++EntryIdx)
+    {
+        uint64_t        Key     = Commands->Entries[EntryIdx].Key;
+        render_command *Command = Commands->Commands + Commands->Entries[EntryIdx].CommandIdx;
+
+        assert(GetRenderKeyPass(Key) == RenderPass_Mesh);
+        assert(Command->Type == RenderCommand_StaticGeometry);
+
+        mesh_batch_params         *BatchParams    = Commands->Materials + GetRenderKeyMaterial(Key);
+        renderer_backend_resource *AlbedoBD       = AccessUnderlyingResource(BatchParams->Textures[MaterialTexture_Albedo], Renderer->Resources);
+        renderer_static_mesh      *StaticMesh     = AccessUnderlyingResource(Command->StaticGeometry.MeshHandle, Renderer->Resources);
+        renderer_backend_resource *VertexBufferBD = StaticMesh ? AccessUnderlyingResource(StaticMesh->VertexBuffer, Renderer->Resources) : 0;
+        software_vertex_buffer    *VertexBuffer   = VertexBufferBD ? (software_vertex_buffer *)VertexBufferBD->Data : 0;
+
+        if (VertexBuffer && Command->StaticGeometry.SubmeshIndex < StaticMesh->SubmeshCount)
+        {
+            renderer_static_submesh *Submesh = &StaticMesh->Submeshes[Command->StaticGeometry.SubmeshIndex];
+
+            uint64_t Start = Minimum(Submesh->VertexStart, VertexBuffer->VertexCount);
+            uint64_t Count = Minimum(Submesh->VertexCount, VertexBuffer->VertexCount - Start);
+
+            software_draw *Draw = Frame->Draws + DrawCount++;
+
+            Draw->Vertices    = VertexBuffer->Vertices + Start;
+            Draw->VertexCount = (uint32_t)(Count - Count % 3);
+            Draw->GroupIdx    = GetRenderKeyGroup(Key);
+            Draw->Texture     = AlbedoBD ? (software_texture *)AlbedoBD->Data : 0;
+        }
+    }
+
+    uint32_t SpanCount = 0;
+
+    for (uint32_t DrawIdx = 0; DrawIdx < DrawCount; ++DrawIdx)
+    {
+        SpanCount += (Frame->Draws[DrawIdx].VertexCount + SOFTWARE_SPAN_SIZE - 1) / SOFTWARE_SPAN_SIZE;
+    }
+
+    Frame->Spans     = PushArray(Arena, software_span, Maximum(SpanCount, 1));
+    Frame->SpanCount = 0;
+
+    uint32_t VertexBase   = 0;
+    uint32_t TriangleBase = 0;
+
+    for (uint32_t DrawIdx = 0; DrawIdx < DrawCount; ++DrawIdx)
+    {
+        for (uint32_t First = 0; First < Frame->Draws[DrawIdx].VertexCount; First += SOFTWARE_SPAN_SIZE)
+        {
+            software_span *Span = Frame->Spans + Frame->SpanCount++;
+
+            Span->DrawIdx         = DrawIdx;
+            Span->First           = First;
+            Span->Count           = Minimum(Frame->Draws[DrawIdx].VertexCount - First, SOFTWARE_SPAN_SIZE);
+            Span->VertexBase      = VertexBase;
+            Span->TriangleBase    = TriangleBase;
+            Span->RasterizedCount = 0;
+
+            VertexBase   += AlignPow2(Span->Count, SOFTWARE_LANE_COUNT);
+            TriangleBase += Span->Count / 3 * 2;
+        }
+    }
+
+    for (uint32_t Component = 0; Component < ArrayCount(Frame->Clip); ++Component)
+    {
+        Frame->Clip[Component] = PushArrayAligned(Arena, float, Maximum(VertexBase, SOFTWARE_LANE_COUNT), 64);
+    }
+
+    Frame->Triangles = PushArray(Arena, software_triangle, Maximum(TriangleBase, 1));
+    Frame->SlotCount = TriangleBase;
+
+    Frame->Software->Frame.DrawCount     += DrawCount;
+    Frame->Software->Frame.TriangleCount += TriangleBase / 2;
+}
+
+
+void
+RendererDrawFrame(int Width, int Height, engine_memory *EngineMemory, renderer *Renderer)
+{
+    TIMED_BLOCK_BEGIN(RendererDrawFrame);
+
+    software_renderer *Software = (software_renderer *)Renderer->Backend;
+    memory_arena      *Arena    = EngineMemory->FrameMemory;
+    memory_region      Region   = EnterMemoryRegion(Arena);
+
+    software_frame *Frame = PushStruct(Arena, software_frame);
+    memset(Frame, 0, sizeof(software_frame));
+
+    Frame->Software = Software;
+    Frame->Width    = Minimum(Maximum(Width, 1), (int)Software->MaxWidth);
+    Frame->Height   = Minimum(Maximum(Height, 1), (int)Software->MaxHeight);
+
+    CollectDraws(Frame, Renderer, Arena);
+
+    ParallelFor(Frame->SpanCount, 1, "software vertices", RunVertexSpans, Frame, JobPriority_Frame, EngineMemory);
+
+    // Slices write their triangles in the tiles after those of the slices before them: every tile
+    // keeps the order they were submitted in.
+
+    Frame->TileCountX = (Frame->Width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    Frame->TileCount  = Frame->TileCountX * ((Frame->Height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE);
+    Frame->SliceCount = Minimum(Maximum(Frame->SlotCount, 1), SOFTWARE_BIN_SLICE_COUNT);
+    Frame->SliceTiles = PushArray(Arena, uint32_t, (uint64_t)Frame->SliceCount * Frame->TileCount);
+    Frame->Tiles      = PushArray(Arena, software_tile, Frame->TileCount);
+
+    ParallelFor(Frame->SliceCount, 1, "software binning", CountSlices, Frame, JobPriority_Frame, EngineMemory);
+
+    uint32_t BinnedCount = 0;
+
+    for (uint32_t TileIdx = 0; TileIdx < Frame->TileCount; ++TileIdx)
+    {
+        Frame->Tiles[TileIdx].Count      = 0;
+        Frame->Tiles[TileIdx].PixelCount = 0;
+
+        for (uint32_t Slice = 0; Slice < Frame->SliceCount; ++Slice)
+        {
+            uint32_t *Count = Frame->SliceTiles + (uint64_t)Slice * Frame->TileCount + TileIdx;
+            uint32_t  Slot  = BinnedCount + Frame->Tiles[TileIdx].Count;
+
+            Frame->Tiles[TileIdx].Count += *Count;
+            *Count = Slot;
+        }
+
+        BinnedCount += Frame->Tiles[TileIdx].Count;
+    }
+
+    Frame->Binned = PushArray(Arena, uint32_t, Maximum(BinnedCount, 1));
+
+    for (uint32_t TileIdx = 0, Slot = 0; TileIdx < Frame->TileCount; Slot += Frame->Tiles[TileIdx++].Count)
+    {
+        Frame->Tiles[TileIdx].Triangles = Frame->Binned + Slot;
+    }
+
+    ParallelFor(Frame->SliceCount, 1, "software binning", WriteSlices, Frame, JobPriority_Frame, EngineMemory);
+    ParallelFor(Frame->TileCount, 1, "software tiles", RasterizeTiles, Frame, JobPriority_Frame, EngineMemory);
+
+    for (uint32_t SpanIdx = 0; SpanIdx < Frame->SpanCount; ++SpanIdx)
+    {
+        Software->Frame.RasterizedCount += Frame->Spans[SpanIdx].RasterizedCount;
+    }
+
+    for (uint32_t TileIdx = 0; TileIdx < Frame->TileCount; ++TileIdx)
+    {
+        Software->Frame.PixelCount += Frame->Tiles[TileIdx].PixelCount;
+    }
+
+    Software->Frame.BinnedCount += BinnedCount;
+
+    Software->Image.Pixels = (uint8_t *)Software->Color;
+    Software->Image.Width  = (uint32_t)Frame->Width;
+    Software->Image.Height = (uint32_t)Frame->Height;
+    Software->Image.Pitch  = Software->Pitch * sizeof(uint32_t);
+
+    LeaveMemoryRegion(Region);
+
+    Renderer->Commands = (render_command_list){0};
+
+    TIMED_BLOCK_END(RendererDrawFrame);
+}
+
+
+void
+RendererFlushFrame(renderer *Renderer)
+{
+    software_renderer *Software = (software_renderer *)Renderer->Backend;
+
+    Software->Last = Software->Frame;
+
+    software_frame_stats Next = {.Index = Software->Frame.Index + 1};
+    Software->Frame = Next;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "utilities.h"
+
+// ==============================================
+// <Software Backend>
+// ==============================================
+
+// A backend that draws on the CPU, linked in place of d3d11/d3d11.c where there is no GPU. It walks
+// the same passes and draws what the D3D11 pipeline would: triangle lists transformed by the group's
+// World, View and Projection, back faces culled (front faces are counter-clockwise on screen), the
+// batch's albedo texture. Unlike the D3D11 backend so far it has a depth buffer, less passes. Depth
+// is not clipped, triangles are only clipped against the near plane.
+//
+// A frame runs in three steps, each spread over the work queue with ParallelFor:
+//
+//   Vertices : every draw is cut in spans of whole triangles. A span is transformed lanes of vertices
+//              at a time, clipped and set up: snapped to 1/16 pixel, culled, edge functions and the
+//              planes of depth, 1/W, U/W and V/W.
+//   Binning  : triangles go into the screen tiles they overlap, in the order they were submitted.
+//              Slices of the triangles count their tiles first, then write into their part of each.
+//   Tiles    : a tile is cleared and its triangles are rasterized in order, lanes of pixels at a
+//              time: edge functions with the top-left rule, depth test, perspective-correct UVs.
+//
+// Lanes are 8 wide where the compiler targets AVX2, 4 wide (SSE2) otherwise. Edge functions are
+// floats evaluated from the corner of the tile, exact for edges shorter than about 1000 pixels.
+// Textures are decoded to RGBA8 and tiled when created, then sampled trilinear with the level of
+// detail of every pixel (software_texture.h). Like the D3D11 backend it must only be used from the
+// thread that owns the work queue.
+
+typedef struct software_renderer software_renderer;
+
+
+typedef struct
+{
+    uint8_t *Pixels;    // RGBA8, top row first.
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Pitch;     // Bytes from one row to the next.
+} software_image;
+
+
+typedef struct
+{
+    uint64_t Index;             // Frames drawn before this one.
+    uint32_t DrawCount;
+    uint32_t TriangleCount;     // Submitted.
+    uint32_t RasterizedCount;   // Left after clipping and culling, clipping may split a triangle in two.
+    uint32_t BinnedCount;       // Triangles times the tiles they went into.
+    uint64_t PixelCount;        // Passed the depth test.
+} software_frame_stats;
+
+
+// Frames are drawn at most MaxWidth by MaxHeight, larger views are cut down to that.
+software_renderer *  SoftwareInitialize     (uint32_t MaxWidth, uint32_t MaxHeight, memory_arena *Arena);
+
+// The last frame drawn, until the next one is. All zero before the first.
+software_image       GetSoftwareImage       (software_renderer *Software);
+software_frame_stats GetSoftwareFrameStats  (software_renderer *Software);
\ No newline at end of file
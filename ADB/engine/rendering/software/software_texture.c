@@ -0,0 +1,382 @@
+#include <string.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "engine/rendering/assets.h"
+#include "engine/rendering/textures/texture_mips.h"
+#include "engine/rendering/textures/texture_compress.h"
+
+#include "software_lanes.h"
+#include "software_texture.h"
+
+// ==============================================
+// <Lanes> : INTERNAL
+// ==============================================
+
+
+// Exact for the magnitudes sampling gets to, coordinates are clamped before.
+
+static lane_f32
+FloorLanes(lane_f32 Value)
+{
+#if SOFTWARE_AVX2
+    lane_f32 Result = _mm256_floor_ps(Value);
+#else
+    lane_f32 Truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(Value));
+    lane_f32 Result    = _mm_sub_ps(Truncated, _mm_and_ps(_mm_cmpgt_ps(Truncated, Value), _mm_set1_ps(1.f)));
+#endif
+
+    return Result;
+}
+
+
+static lane_u32
+GatherLanes(const void *Base, lane_u32 Index)
+{
+#if SOFTWARE_AVX2
+    lane_u32 Result = _mm256_i32gather_epi32((const int *)Base, Index, 4);
+#else
+    uint32_t Indices[4];
+    uint32_t Values[4];
+    _mm_storeu_si128((__m128i *)Indices, Index);
+
+    for (uint32_t Lane = 0; Lane < 4; ++Lane)
+    {
+        Values[Lane] = ((const uint32_t *)Base)[Indices[Lane]];
+    }
+
+    lane_u32 Result = _mm_loadu_si128((__m128i *)Values);
+#endif
+
+    return Result;
+}
+
+// ==============================================
+// <Sampling> : INTERNAL
+// ==============================================
+
+
+// What a lane needs of the level it samples, lanes may sample different ones.
+
+typedef struct
+{
+    lane_u32 Offset;
+    lane_f32 Width;
+    lane_f32 Height;
+    lane_f32 TileCount;
+} software_level_lanes;
+
+
+static software_level_lanes
+GatherLevelLanes(software_texture *Texture, lane_u32 Level)
+{
+    software_level_lanes Result;
+
+    Result.Offset    = GatherLanes(Texture->MipOffsets, Level);
+    Result.Width     = LaneCastF32(GatherLanes(Texture->MipWidths, Level));
+    Result.Height    = LaneCastF32(GatherLanes(Texture->MipHeights, Level));
+    Result.TileCount = LaneCastF32(GatherLanes(Texture->MipTileCounts, Level));
+
+    return Result;
+}
+
+
+// X and Y are whole texels inside the level.
+
+static lane_u32
+GetTexelIndex(software_level_lanes *Level, lane_f32 X, lane_f32 Y)
+{
+    lane_f32 Quarter = LaneF32(1.f / SOFTWARE_TEXTURE_TILE_SIZE);
+    lane_u32 Low     = LaneU32(SOFTWARE_TEXTURE_TILE_SIZE - 1);
+
+    lane_f32 Tile   = LaneAdd(LaneMul(FloorLanes(LaneMul(Y, Quarter)), Level->TileCount), FloorLanes(LaneMul(X, Quarter)));
+    lane_u32 InTile = LaneOr(LaneShiftLeft(LaneAnd(LaneTruncate(Y), Low), 2), LaneAnd(LaneTruncate(X), Low));
+
+    lane_u32 Result = LaneAddU32(Level->Offset, LaneAddU32(LaneShiftLeft(LaneTruncate(Tile), 4), InTile));
+    return Result;
+}
+
+
+// Sum of packed RGBA8 texels weighted by integers that add up to 256. Red and blue, then green and
+// alpha, are multiplied as the 16-bit halves of the lane: no product nor their sum reaches 65536.
+
+static lane_u32
+BlendTexels(lane_u32 *Texels, lane_u32 *Weights, uint32_t Count)
+{
+    lane_u32 Mask       = LaneU32(0x00FF00FF);
+    lane_u32 RedBlue    = LaneU32(0);
+    lane_u32 GreenAlpha = LaneU32(0);
+
+    for (uint32_t Idx = 0; Idx < Count; ++Idx)
+    {
+        lane_u32 Weight = LaneOr(Weights[Idx], LaneShiftLeft(Weights[Idx], 16));
+
+        RedBlue    = LaneAddU16(RedBlue,    LaneMulU16(LaneAnd(Texels[Idx], Mask), Weight));
+        GreenAlpha = LaneAddU16(GreenAlpha, LaneMulU16(LaneAnd(LaneShiftRight(Texels[Idx], 8), Mask), Weight));
+    }
+
+    lane_u32 Result = LaneOr(LaneAnd(LaneShiftRight(RedBlue, 8), Mask), LaneAnd(GreenAlpha, LaneU32(0xFF00FF00)));
+    return Result;
+}
+
+
+static lane_u32
+SampleLevelLanes(software_texture *Texture, software_level_lanes *Level, lane_f32 U, lane_f32 V)
+{
+    lane_f32 Zero = LaneF32(0.f);
+    lane_f32 One  = LaneF32(1.f);
+    lane_f32 Half = LaneF32(0.5f);
+
+    // Texel centers are at .5. Past the edges both texels clamp to the same one, which keeps NaNs
+    // and huge coordinates inside as well.
+
+    lane_f32 X = LaneMin(LaneMax(LaneSub(LaneMul(U, Level->Width),  Half), LaneF32(-1.f)), Level->Width);
+    lane_f32 Y = LaneMin(LaneMax(LaneSub(LaneMul(V, Level->Height), Half), LaneF32(-1.f)), Level->Height);
+
+    lane_f32 X0 = FloorLanes(X);
+    lane_f32 Y0 = FloorLanes(Y);
+    lane_f32 FX = LaneSub(X, X0);
+    lane_f32 FY = LaneSub(Y, Y0);
+    lane_f32 X1 = LaneMin(LaneAdd(X0, One), LaneSub(Level->Width, One));
+    lane_f32 Y1 = LaneMin(LaneAdd(Y0, One), LaneSub(Level->Height, One));
+
+    X0 = LaneMax(X0, Zero);
+    Y0 = LaneMax(Y0, Zero);
+
+    lane_u32 Texels[4] =
+    {
+        GatherLanes(Texture->Texels, GetTexelIndex(Level, X0, Y0)),
+        GatherLanes(Texture->Texels, GetTexelIndex(Level, X1, Y0)),
+        GatherLanes(Texture->Texels, GetTexelIndex(Level, X0, Y1)),
+        GatherLanes(Texture->Texels, GetTexelIndex(Level, X1, Y1)),
+    };
+
+    // Truncated, the last weight takes what is left: they add up to 256 and none is negative.
+
+    lane_f32 Scale  = LaneF32(256.f);
+    lane_f32 InvFX  = LaneSub(One, FX);
+    lane_f32 InvFY  = LaneSub(One, FY);
+
+    lane_u32 Weights[4];
+    Weights[0] = LaneTruncate(LaneMul(LaneMul(InvFX, InvFY), Scale));
+    Weights[1] = LaneTruncate(LaneMul(LaneMul(FX, InvFY), Scale));
+    Weights[2] = LaneTruncate(LaneMul(LaneMul(InvFX, FY), Scale));
+    Weights[3] = LaneSubU32(LaneSubU32(LaneSubU32(LaneU32(256), Weights[0]), Weights[1]), Weights[2]);
+
+    lane_u32 Result = BlendTexels(Texels, Weights, 4);
+    return Result;
+}
+
+// ==============================================
+// <Software Textures> : PUBLIC
+// ==============================================
+
+
+software_texture *
+CreateSoftwareTexture(loaded_texture LoadedTexture)
+{
+    software_texture *Result   = 0;
+    uint32_t          MipCount = Minimum(Maximum(LoadedTexture.MipCount, 1), MAX_TEXTURE_MIP_COUNT);
+    uint64_t          Tiled    = 0;
+
+    for (uint32_t Level = 0; Level < MipCount; ++Level)
+    {
+        uint64_t TileCountX = (Maximum(LoadedTexture.Width  >> Level, 1) + SOFTWARE_TEXTURE_TILE_SIZE - 1) / SOFTWARE_TEXTURE_TILE_SIZE;
+        uint64_t TileCountY = (Maximum(LoadedTexture.Height >> Level, 1) + SOFTWARE_TEXTURE_TILE_SIZE - 1) / SOFTWARE_TEXTURE_TILE_SIZE;
+
+        Tiled += TileCountX * TileCountY * SOFTWARE_TEXTURE_TILE_SIZE * SOFTWARE_TEXTURE_TILE_SIZE;
+    }
+
+    // Tile indices go through floats, exact below 2^24.
+
+    bool IsValid = LoadedTexture.Data && LoadedTexture.Width && LoadedTexture.Height && Tiled < (1u << 24) * 16;
+
+    if (IsValid)
+    {
+        bool     IsDecoded = LoadedTexture.Format == TextureFormat_RGBA8;
+        uint64_t Decoded   = IsDecoded ? 0 : GetTextureDataSize(LoadedTexture.Width, LoadedTexture.Height, TextureFormat_RGBA8, MipCount);
+
+        memory_arena_params Params =
+        {
+            .ReserveSize       = AlignPow2(Tiled * 4 + Decoded + KiB(64), KiB(64)),
+            .CommitSize        = KiB(64),
+            .AllocatedFromFile = __FILE__,
+            .AllocatedFromLine = __LINE__,
+        };
+
+        memory_arena *Arena  = AllocateArena(Params);
+        uint32_t     *Texels = PushArrayAligned(Arena, uint32_t, Tiled, 64);
+
+        Result = PushStruct(Arena, software_texture);
+
+        // Block formats are decoded in what follows, given back once tiled.
+
+        memory_region  Region = EnterMemoryRegion(Arena);
+        loaded_texture Source = LoadedTexture;
+
+        Source.MipCount = MipCount;
+
+        if (!IsDecoded)
+        {
+            DecompressTexture(&Source, Arena);
+        }
+
+        if (Result && Texels && Source.Data && Source.Format == TextureFormat_RGBA8 && Source.BytesPerPixel == 4)
+        {
+            memset(Result, 0, sizeof(software_texture));
+
+            Result->Arena    = Arena;
+            Result->Texels   = Texels;
+            Result->Width    = LoadedTexture.Width;
+            Result->Height   = LoadedTexture.Height;
+            Result->MipCount = MipCount;
+
+            uint32_t *Dest = Texels;
+
+            for (uint32_t Level = 0; Level < MipCount; ++Level)
+            {
+                texture_mip Mip        = GetTextureMip(&Source, Level);
+                uint32_t    TileCountX = (Mip.Width  + SOFTWARE_TEXTURE_TILE_SIZE - 1) / SOFTWARE_TEXTURE_TILE_SIZE;
+                uint32_t    TileCountY = (Mip.Height + SOFTWARE_TEXTURE_TILE_SIZE - 1) / SOFTWARE_TEXTURE_TILE_SIZE;
+
+                Result->MipOffsets[Level]    = (int32_t)(Dest - Texels);
+                Result->MipWidths[Level]     = (float)Mip.Width;
+                Result->MipHeights[Level]    = (float)Mip.Height;
+                Result->MipTileCounts[Level] = (float)TileCountX;
+
+                for (uint32_t TileY = 0; TileY < TileCountY; ++TileY)
+                {
+                    for (uint32_t TileX = 0; TileX < TileCountX; ++TileX)
+                    {
+                        for (uint32_t Y = 0; Y < SOFTWARE_TEXTURE_TILE_SIZE; ++Y)
+                        {
+                            uint32_t SourceY = Minimum(TileY * SOFTWARE_TEXTURE_TILE_SIZE + Y, Mip.Height - 1);
+                            uint8_t *Row     = Mip.Data + (uint64_t)SourceY * Mip.Pitch;
+
+                            for (uint32_t X = 0; X < SOFTWARE_TEXTURE_TILE_SIZE; ++X)
+                            {
+                                uint32_t SourceX = Minimum(TileX * SOFTWARE_TEXTURE_TILE_SIZE + X, Mip.Width - 1);
+                                memcpy(Dest++, Row + SourceX * 4, 4);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            Result = 0;
+        }
+
+        LeaveMemoryRegion(Region);
+
+        if (!Result)
+        {
+            ReleaseArena(Arena);
+        }
+    }
+
+    return Result;
+}
+
+
+void
+DestroySoftwareTexture(software_texture *Texture)
+{
+    if (Texture)
+    {
+        ReleaseArena(Texture->Arena);
+    }
+}
+
+
+lane_f32
+GetSoftwareTextureLod(software_texture *Texture, lane_f32 DUDX, lane_f32 DVDX, lane_f32 DUDY, lane_f32 DVDY)
+{
+    lane_f32 Zero = LaneF32(0.f);
+
+    if (!Texture)
+    {
+        return Zero;
+    }
+
+    lane_f32 Width  = LaneF32((float)Texture->Width);
+    lane_f32 Height = LaneF32((float)Texture->Height);
+    lane_f32 AX     = LaneMul(DUDX, Width);
+    lane_f32 BX     = LaneMul(DVDX, Height);
+    lane_f32 AY     = LaneMul(DUDY, Width);
+    lane_f32 BY     = LaneMul(DVDY, Height);
+
+    // The larger footprint, squared: its log2 is twice the level. The log2 is the exponent plus the
+    // mantissa taken as linear in between, 0.09 off at most.
+
+    lane_f32 Squared  = LaneMax(LaneAdd(LaneMul(AX, AX), LaneMul(BX, BX)), LaneAdd(LaneMul(AY, AY), LaneMul(BY, BY)));
+    lane_u32 Bits     = LaneCastU32(Squared);
+    lane_f32 Exponent = LaneSub(LaneToF32(LaneShiftRight(Bits, 23)), LaneF32(127.f));
+    lane_f32 Mantissa = LaneSub(LaneCastF32(LaneOr(LaneAnd(Bits, LaneU32(0x007FFFFF)), LaneU32(0x3F800000))), LaneF32(1.f));
+    lane_f32 Lod      = LaneMul(LaneAdd(Exponent, Mantissa), LaneF32(0.5f));
+
+    lane_f32 Result = LaneMax(LaneMin(Lod, LaneF32((float)(Texture->MipCount - 1))), Zero);
+    return Result;
+}
+
+
+lane_u32
+SampleBilinear(software_texture *Texture, lane_f32 U, lane_f32 V, uint32_t Level)
+{
+    if (!Texture)
+    {
+        return LaneU32(0xFF000000);
+    }
+
+    Level = Minimum(Level, Texture->MipCount - 1);
+
+    software_level_lanes Lanes =
+    {
+        .Offset    = LaneU32(Texture->MipOffsets[Level]),
+        .Width     = LaneF32(Texture->MipWidths[Level]),
+        .Height    = LaneF32(Texture->MipHeights[Level]),
+        .TileCount = LaneF32(Texture->MipTileCounts[Level]),
+    };
+
+    lane_u32 Result = SampleLevelLanes(Texture, &Lanes, U, V);
+    return Result;
+}
+
+
+lane_u32
+SampleTrilinear(software_texture *Texture, lane_f32 U, lane_f32 V, lane_f32 Lod)
+{
+    if (!Texture)
+    {
+        return LaneU32(0xFF000000);
+    }
+
+    lane_f32 Zero     = LaneF32(0.f);
+    lane_f32 MaxLevel = LaneF32((float)(Texture->MipCount - 1));
+
+    Lod = LaneMax(LaneMin(Lod, MaxLevel), Zero);
+
+    lane_f32 Fine     = FloorLanes(Lod);
+    lane_f32 Fraction = LaneSub(Lod, Fine);
+
+    software_level_lanes FineLanes = GatherLevelLanes(Texture, LaneTruncate(Fine));
+    lane_u32             Result    = SampleLevelLanes(Texture, &FineLanes, U, V);
+
+    // Lanes right on a level, magnified ones for a start, do not need the next.
+
+    if (LaneMaskBits(LaneLess(Zero, Fraction)))
+    {
+        software_level_lanes CoarseLanes = GatherLevelLanes(Texture, LaneTruncate(LaneMin(LaneAdd(Fine, LaneF32(1.f)), MaxLevel)));
+
+        lane_u32 Samples[2] = {Result, SampleLevelLanes(Texture, &CoarseLanes, U, V)};
+        lane_u32 Weights[2];
+
+        Weights[1] = LaneTruncate(LaneMul(Fraction, LaneF32(256.f)));
+        Weights[0] = LaneSubU32(LaneU32(256), Weights[1]);
+
+        Result = BlendTexels(Samples, Weights, 2);
+    }
+
+    return Result;
+}
\ No newline at end of file
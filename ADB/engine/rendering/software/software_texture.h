@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "utilities.h"
+#include "engine/rendering/assets.h"
+#include "engine/rendering/textures/texture_mips.h"
+#include "software_lanes.h"
+
+// ==============================================
+// <Software Textures>
+// ==============================================
+
+// Textures of the software backend, RGBA8 whatever they were loaded as. A level is stored in tiles
+// of 4x4 texels, 64 bytes, one cache line: the four texels a bilinear sample reads share a line 9
+// times out of 16, and the lines a row of pixels walks through stay close whatever the direction
+// it walks the texture in. Texels are row by row inside a tile, tiles row by row inside a level,
+// levels largest first. The padding of the last tiles of a row or column repeats the edge.
+//
+// Sampling is what the mesh shader's sampler does: clamped, bilinear inside a level, linear
+// between levels, a lane of pixels at a time. Weights are 8 bits like most hardware's.
+
+#define SOFTWARE_TEXTURE_TILE_SIZE 4
+
+
+typedef struct
+{
+    memory_arena *Arena;          // The texture lives in it, released by DestroySoftwareTexture.
+    uint32_t     *Texels;         // 64-byte aligned.
+    uint32_t      Width;
+    uint32_t      Height;
+    uint32_t      MipCount;
+
+    // Per level, floats and integers the lanes gather.
+    int32_t       MipOffsets[MAX_TEXTURE_MIP_COUNT];  // Texels before the level.
+    float         MipWidths[MAX_TEXTURE_MIP_COUNT];
+    float         MipHeights[MAX_TEXTURE_MIP_COUNT];
+    float         MipTileCounts[MAX_TEXTURE_MIP_COUNT]; // Tiles in a row.
+} software_texture;
+
+
+// Expects a texture the renderer takes, 0 when it could not be decoded. Block formats are decoded
+// first. Runs on the calling thread.
+software_texture * CreateSoftwareTexture   (loaded_texture LoadedTexture);
+void               DestroySoftwareTexture  (software_texture *Texture);
+
+// Level of detail from the UV derivatives along X and Y of the screen, in [0, MipCount - 1].
+lane_f32           GetSoftwareTextureLod   (software_texture *Texture, lane_f32 DUDX, lane_f32 DVDX, lane_f32 DUDY, lane_f32 DVDY);
+
+// RGBA8 samples at U, V. No texture reads as opaque black, like an unbound slot in the shader.
+lane_u32           SampleBilinear          (software_texture *Texture, lane_f32 U, lane_f32 V, uint32_t Level);
+lane_u32           SampleTrilinear         (software_texture *Texture, lane_f32 U, lane_f32 V, lane_f32 Lod);
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include <assert.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "texture_atlas.h"
+#include "texture_mips.h"
+
+// ==============================================
+// <Skyline> : INTERNAL
+// ==============================================
+
+// The top edge of what is placed so far, as runs sorted by X that cover the whole page width. Every
+// size is a multiple of 4, so a page never needs more than one run per 4 texels.
+
+
+typedef struct
+{
+	uint32_t X;
+	uint32_t Y;
+	uint32_t Width;
+} skyline_run;
+
+
+typedef struct
+{
+	skyline_run *Runs;
+	uint32_t     RunCount;
+	uint32_t     UsedWidth;
+	uint32_t     UsedHeight;
+} atlas_skyline;
+
+
+static uint32_t
+GetPaddedSize(uint32_t Size)
+{
+	uint32_t Result = (Size + 2 * TEXTURE_ATLAS_GUTTER + 3) & ~3u;
+	return Result;
+}
+
+
+static void
+InitSkyline(atlas_skyline *Skyline, memory_arena *Arena)
+{
+	Skyline->Runs       = PushArray(Arena, skyline_run, TEXTURE_ATLAS_PAGE_SIZE / 4 + 1);
+	Skyline->RunCount   = 1;
+	Skyline->UsedWidth  = 0;
+	Skyline->UsedHeight = 0;
+
+	Skyline->Runs[0] = (skyline_run){.X = 0, .Y = 0, .Width = TEXTURE_ATLAS_PAGE_SIZE};
+}
+
+
+// Bottom-left: the spot whose top ends lowest, the leftmost one on ties.
+
+static bool
+FindSkylineSpot(atlas_skyline *Skyline, uint32_t Width, uint32_t Height, uint32_t *RunIndex, uint32_t *SpotY)
+{
+	uint32_t BestTop = UINT32_MAX;
+
+	for (uint32_t Idx = 0; Idx < Skyline->RunCount; ++Idx)
+	{
+		uint32_t X = Skyline->Runs[Idx].X;
+		if (X + Width > TEXTURE_ATLAS_PAGE_SIZE)
+		{
+			break;
+		}
+
+		// Resting on the highest run under the whole width.
+
+		uint32_t Y       = 0;
+		uint32_t Covered = 0;
+
+		for (uint32_t Under = Idx; Covered < Width; ++Under)
+		{
+			Y        = Maximum(Y, Skyline->Runs[Under].Y);
+			Covered += Skyline->Runs[Under].Width;
+		}
+
+		if (Y + Height <= TEXTURE_ATLAS_PAGE_SIZE && Y + Height < BestTop)
+		{
+			BestTop   = Y + Height;
+			*RunIndex = Idx;
+			*SpotY    = Y;
+		}
+	}
+
+	bool Result = BestTop != UINT32_MAX;
+	return Result;
+}
+
+
+static void
+RaiseSkyline(atlas_skyline *Skyline, uint32_t RunIndex, uint32_t Y, uint32_t Width, uint32_t Height)
+{
+	skyline_run *Runs = Skyline->Runs;
+	skyline_run  New  = {.X = Runs[RunIndex].X, .Y = Y + Height, .Width = Width};
+
+	memmove(Runs + RunIndex + 1, Runs + RunIndex, (Skyline->RunCount - RunIndex) * sizeof(skyline_run));
+	Runs[RunIndex]     = New;
+	Skyline->RunCount += 1;
+
+	// Trim what the new run now covers.
+
+	uint32_t End = New.X + New.Width;
+	while (RunIndex + 1 < Skyline->RunCount && Runs[RunIndex + 1].X < End)
+	{
+		skyline_run *Next   = Runs + RunIndex + 1;
+		uint32_t     Shrink = End - Next->X;
+
+		if (Next->Width <= Shrink)
+		{
+			memmove(Next, Next + 1, (Skyline->RunCount - RunIndex - 2) * sizeof(skyline_run));
+			Skyline->RunCount -= 1;
+		}
+		else
+		{
+			Next->X     += Shrink;
+			Next->Width -= Shrink;
+			break;
+		}
+	}
+
+	for (uint32_t Idx = 0; Idx + 1 < Skyline->RunCount;)
+	{
+		if (Runs[Idx].Y == Runs[Idx + 1].Y)
+		{
+			Runs[Idx].Width += Runs[Idx + 1].Width;
+			memmove(Runs + Idx + 1, Runs + Idx + 2, (Skyline->RunCount - Idx - 2) * sizeof(skyline_run));
+			Skyline->RunCount -= 1;
+		}
+		else
+		{
+			++Idx;
+		}
+	}
+
+	Skyline->UsedWidth  = Maximum(Skyline->UsedWidth, End);
+	Skyline->UsedHeight = Maximum(Skyline->UsedHeight, Y + Height);
+}
+
+// ==============================================
+// <Pages> : INTERNAL
+// ==============================================
+
+
+// Copies the item into its padded rectangle, the gutter repeats the nearest edge texel.
+
+static void
+BlitAtlasItem(loaded_texture *Page, loaded_texture *Texture, uint32_t X, uint32_t Y)
+{
+	uint32_t PaddedWidth  = GetPaddedSize(Texture->Width);
+	uint32_t PaddedHeight = GetPaddedSize(Texture->Height);
+	uint32_t RightGutter  = PaddedWidth - Texture->Width - TEXTURE_ATLAS_GUTTER;
+
+	for (uint32_t Row = 0; Row < PaddedHeight; ++Row)
+	{
+		uint32_t SourceRow = Row < TEXTURE_ATLAS_GUTTER ? 0 : Minimum(Row - TEXTURE_ATLAS_GUTTER, Texture->Height - 1);
+		uint8_t *Source    = Texture->Data + (uint64_t)SourceRow * Texture->Width * 4;
+		uint8_t *Dest      = Page->Data + ((uint64_t)(Y + Row) * Page->Width + X) * 4;
+
+		for (uint32_t Col = 0; Col < TEXTURE_ATLAS_GUTTER; ++Col)
+		{
+			memcpy(Dest + Col * 4, Source, 4);
+		}
+
+		memcpy(Dest + TEXTURE_ATLAS_GUTTER * 4, Source, (uint64_t)Texture->Width * 4);
+
+		for (uint32_t Col = 0; Col < RightGutter; ++Col)
+		{
+			memcpy(Dest + (TEXTURE_ATLAS_GUTTER + Texture->Width + Col) * 4, Source + (Texture->Width - 1) * 4, 4);
+		}
+	}
+}
+
+// ==============================================
+// <Texture Atlas> : PUBLIC
+// ==============================================
+
+
+bool
+FitsTextureAtlas(uint32_t Width, uint32_t Height)
+{
+	bool Result = Width && Height && Width <= TEXTURE_ATLAS_MAX_ITEM_SIZE && Height <= TEXTURE_ATLAS_MAX_ITEM_SIZE;
+	return Result;
+}
+
+
+loaded_texture *
+BuildTextureAtlases(texture_atlas_item *Items, uint32_t Count, uint32_t *PageCount, memory_arena *Arena)
+{
+	assert(PageCount);
+
+	// There are never more pages than items, the placement scratch goes after the array.
+
+	loaded_texture *Pages = PushArray(Arena, loaded_texture, Count);
+	uint32_t       *X     = PushArray(Arena, uint32_t, Count);
+	uint32_t       *Y     = PushArray(Arena, uint32_t, Count);
+
+	*PageCount = 0;
+
+	memory_region Region = EnterMemoryRegion(Arena);
+
+	atlas_skyline *Skylines = PushArray(Arena, atlas_skyline, Count);
+	uint32_t      *Order    = PushArray(Arena, uint32_t, Count);
+
+	// Tallest first. Few enough items that an insertion sort does.
+
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		uint32_t At = Idx;
+		while (At && Items[Order[At - 1]].Texture->Height < Items[Idx].Texture->Height)
+		{
+			Order[At] = Order[At - 1];
+			--At;
+		}
+
+		Order[At] = Idx;
+	}
+
+	for (uint32_t OrderIdx = 0; OrderIdx < Count; ++OrderIdx)
+	{
+		texture_atlas_item *Item   = Items + Order[OrderIdx];
+		uint32_t            Width  = GetPaddedSize(Item->Texture->Width);
+		uint32_t            Height = GetPaddedSize(Item->Texture->Height);
+		uint32_t            Run    = 0;
+		uint32_t            SpotY  = 0;
+		uint32_t            Page   = 0;
+
+		assert(FitsTextureAtlas(Item->Texture->Width, Item->Texture->Height));
+
+		while (Page < *PageCount && !FindSkylineSpot(Skylines + Page, Width, Height, &Run, &SpotY))
+		{
+			++Page;
+		}
+
+		if (Page == *PageCount)
+		{
+			InitSkyline(Skylines + Page, Arena);
+			FindSkylineSpot(Skylines + Page, Width, Height, &Run, &SpotY);
+
+			*PageCount += 1;
+		}
+
+		Item->Page         = Page;
+		X[Order[OrderIdx]] = Skylines[Page].Runs[Run].X;
+		Y[Order[OrderIdx]] = SpotY;
+
+		RaiseSkyline(Skylines + Page, Run, SpotY, Width, Height);
+	}
+
+	// Pages are cropped to what they use, the mips do not need a power of two.
+
+	for (uint32_t Page = 0; Page < *PageCount; ++Page)
+	{
+		Pages[Page] = (loaded_texture)
+		{
+			.Width         = Skylines[Page].UsedWidth,
+			.Height        = Skylines[Page].UsedHeight,
+			.BytesPerPixel = 4,
+			.MipCount      = 1,
+			.Format        = TextureFormat_RGBA8,
+			.IsSRGB        = Items[0].Texture->IsSRGB,
+		};
+	}
+
+	LeaveMemoryRegion(Region);
+
+	for (uint32_t Page = 0; Page < *PageCount; ++Page)
+	{
+		uint64_t Size = GetMipChainSize(Pages[Page].Width, Pages[Page].Height, 4);
+
+		Pages[Page].Data = PushArray(Arena, uint8_t, Size);
+		if (Pages[Page].Data)
+		{
+			memset(Pages[Page].Data, 0, Size);
+		}
+	}
+
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		texture_atlas_item *Item = Items + Idx;
+		loaded_texture     *Page = Pages + Item->Page;
+
+		if (Page->Data)
+		{
+			BlitAtlasItem(Page, Item->Texture, X[Idx], Y[Idx]);
+			Page->HasAlpha = Page->HasAlpha || Item->Texture->HasAlpha;
+		}
+
+		Item->Scale  = Vec2((float)Item->Texture->Width / (float)Page->Width, (float)Item->Texture->Height / (float)Page->Height);
+		Item->Offset = Vec2((float)(X[Idx] + TEXTURE_ATLAS_GUTTER) / (float)Page->Width, (float)(Y[Idx] + TEXTURE_ATLAS_GUTTER) / (float)Page->Height);
+	}
+
+	return Pages;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "engine/rendering/assets.h"
+
+// ==============================================
+// <Texture Atlas>
+// ==============================================
+
+// Small textures are merged into shared pages at import, so the materials that use them bind the
+// same texture and their draws batch together. Items are placed by a skyline packer (bottom-left,
+// tallest first). Each one is surrounded by a gutter of its own edge texels and starts on a 4-texel
+// boundary, no block of the compressed page straddles two items and bilinear filtering does not
+// reach a neighbour until the mips are 4 levels down.
+//
+// Sampling outside [0, 1] would land in the neighbours, only textures whose UVs stay inside can go
+// in. A UV is moved into the page with uv * Scale + Offset.
+
+#define TEXTURE_ATLAS_PAGE_SIZE     2048
+#define TEXTURE_ATLAS_MAX_ITEM_SIZE 256
+#define TEXTURE_ATLAS_GUTTER        4
+
+
+typedef struct
+{
+	loaded_texture *Texture; // RGBA8, one level.
+
+	// Set by BuildTextureAtlases.
+	uint32_t        Page;
+	vec2            Scale;
+	vec2            Offset;
+} texture_atlas_item;
+
+
+bool             FitsTextureAtlas    (uint32_t Width, uint32_t Height);
+
+// Pages are RGBA8 with room for their mip chain, pushed on the arena along with the returned array.
+// They take IsSRGB from the first item and HasAlpha from any. Paths are left to the caller.
+loaded_texture * BuildTextureAtlases (texture_atlas_item *Items, uint32_t Count, uint32_t *PageCount, memory_arena *Arena);
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include <assert.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "texture_cache.h"
+#include "texture_mips.h"
+#include "engine/rendering/baked_assets.h"
+
+#define TEXTURE_CACHE_MAX_JOB_COUNT 16
+
+// ==============================================
+// <Paths> : INTERNAL
+// ==============================================
+
+// "<directory>/<16 hex digits>.adtx" plus the null byte, built on the stack so jobs can use it.
+
+typedef struct
+{
+	uint8_t Data[TEXTURE_CACHE_DIRECTORY_MAX + 1 + 16 + 5 + 1];
+} texture_cache_path;
+
+
+static uint8_t  CacheDirectory[TEXTURE_CACHE_DIRECTORY_MAX + 1] = TEXTURE_CACHE_DIRECTORY;
+static uint64_t CacheDirectorySize                              = sizeof(TEXTURE_CACHE_DIRECTORY) - 1;
+
+
+static byte_string
+MakeTextureCachePath(uint64_t Key, texture_cache_path *Path)
+{
+	static const char Digits[] = "0123456789abcdef";
+
+	uint64_t Size = CacheDirectorySize;
+	memcpy(Path->Data, CacheDirectory, Size);
+
+	Path->Data[Size++] = '/';
+
+	for (int32_t Shift = 60; Shift >= 0; Shift -= 4)
+	{
+		Path->Data[Size++] = (uint8_t)Digits[(Key >> Shift) & 0xF];
+	}
+
+	memcpy(Path->Data + Size, ".adtx", 5);
+	Size += 5;
+
+	Path->Data[Size] = '\0';
+
+	byte_string Result = ByteString(Path->Data, Size);
+	return Result;
+}
+
+
+static void
+CreateTextureCacheDirectory(void)
+{
+	uint8_t Directory[sizeof(CacheDirectory)];
+	memcpy(Directory, CacheDirectory, sizeof(Directory));
+
+	for (uint64_t Idx = 1; Idx <= CacheDirectorySize; ++Idx)
+	{
+		if (Directory[Idx] == '/' || Directory[Idx] == '\0')
+		{
+			uint8_t Separator = Directory[Idx];
+
+			Directory[Idx] = '\0';
+			OSCreateDirectory(ByteString(Directory, Idx));
+			Directory[Idx] = Separator;
+		}
+	}
+}
+
+// ==============================================
+// <Jobs> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+	uint64_t Key;
+	buffer   Baked;
+} texture_cache_write;
+
+
+typedef struct
+{
+	texture_cache_write *Writes;
+	uint32_t             WriteCount;
+	uint32_t             NextWrite;
+} texture_cache_work;
+
+
+static void
+WriteCachedTexturesJob(platform_work_queue *Queue, void *Data)
+{
+	(void)Queue;
+
+	texture_cache_work *Work = (texture_cache_work *)Data;
+
+	for (;;)
+	{
+		uint32_t Ticket = AtomicIncrement32(&Work->NextWrite) - 1;
+		if (Ticket >= Work->WriteCount)
+		{
+			break;
+		}
+
+		// A write cut short leaves a file whose size does not match its header, loads reject it.
+
+		texture_cache_path Path;
+		WriteBufferToFile(MakeTextureCachePath(Work->Writes[Ticket].Key, &Path), &Work->Writes[Ticket].Baked);
+	}
+}
+
+// ==============================================
+// <Texture Cache> : PUBLIC
+// ==============================================
+
+
+bool
+SetTextureCacheDirectory(byte_string Directory)
+{
+	bool Result = IsValidByteString(Directory) && Directory.Size <= TEXTURE_CACHE_DIRECTORY_MAX;
+
+	if (Result)
+	{
+		memcpy(CacheDirectory, Directory.Data, Directory.Size);
+
+		CacheDirectory[Directory.Size] = '\0';
+		CacheDirectorySize             = Directory.Size;
+	}
+
+	return Result;
+}
+
+
+uint64_t
+MakeTextureCacheKey(uint64_t ContentHash)
+{
+	uint64_t Result = CombineHash(ContentHash, BAKED_ASSET_VERSION);
+	Result = CombineHash(Result, TEXTURE_CACHE_VERSION);
+
+	// 0 means "not cached" in loaded_texture.
+	Result = Result ? Result : 1;
+
+	return Result;
+}
+
+
+bool
+LoadCachedTexture(uint64_t Key, loaded_texture *Texture, uint8_t *Memory, uint64_t MemorySize)
+{
+	assert(Texture);
+
+	texture_cache_path Path;
+	buffer             File   = OSMapFile(MakeTextureCachePath(Key, &Path));
+	bool               Result = false;
+
+	if (File.Data)
+	{
+		loaded_texture Cached   = ReadBakedTexture(&File);
+		uint64_t       DataSize = GetTextureDataSize(Cached.Width, Cached.Height, Cached.Format, Cached.MipCount);
+
+		if (Cached.Data && Memory && DataSize <= MemorySize)
+		{
+			memcpy(Memory, Cached.Data, DataSize);
+
+			Texture->Data          = Memory;
+			Texture->Width         = Cached.Width;
+			Texture->Height        = Cached.Height;
+			Texture->BytesPerPixel = Cached.BytesPerPixel;
+			Texture->MipCount      = Cached.MipCount;
+			Texture->Format        = Cached.Format;
+			Texture->HasAlpha      = Cached.HasAlpha;
+			Texture->CacheKey      = 0;
+			Texture->StreamKey     = Key;
+
+			Result = true;
+		}
+
+		OSUnmapFile(&File);
+	}
+
+	return Result;
+}
+
+
+bool
+LoadCachedTextureLevels(uint64_t Key, loaded_texture *Layout, uint32_t FirstLevel, uint8_t *Memory, uint64_t MemorySize)
+{
+	assert(Layout);
+
+	texture_cache_path Path;
+	buffer             File   = OSMapFile(MakeTextureCachePath(Key, &Path));
+	bool               Result = false;
+
+	if (File.Data)
+	{
+		// Only the pages holding the requested levels are touched, the larger ones are never read.
+
+		loaded_texture Cached = ReadBakedTexture(&File);
+
+		bool IsSame = Cached.Data                         &&
+		              Cached.Width    == Layout->Width    &&
+		              Cached.Height   == Layout->Height   &&
+		              Cached.Format   == Layout->Format   &&
+		              Cached.MipCount == Layout->MipCount;
+
+		if (IsSame && FirstLevel < Cached.MipCount)
+		{
+			uint64_t Skipped  = FirstLevel ? GetTextureDataSize(Cached.Width, Cached.Height, Cached.Format, FirstLevel) : 0;
+			uint64_t DataSize = GetTextureDataSize(Cached.Width, Cached.Height, Cached.Format, Cached.MipCount) - Skipped;
+
+			if (Memory && DataSize <= MemorySize)
+			{
+				memcpy(Memory, Cached.Data + Skipped, DataSize);
+				Result = true;
+			}
+		}
+
+		OSUnmapFile(&File);
+	}
+
+	return Result;
+}
+
+
+void
+StoreCachedTextures(loaded_texture **Textures, uint32_t Count, engine_memory *EngineMemory)
+{
+	assert(EngineMemory);
+
+	memory_arena  *Arena  = EngineMemory->FrameMemory;
+	memory_region  Region = EnterMemoryRegion(Arena);
+
+	texture_cache_work *Work = PushStruct(Arena, texture_cache_work);
+	Work->Writes     = PushArray(Arena, texture_cache_write, Count);
+	Work->WriteCount = 0;
+	Work->NextWrite  = 0;
+
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		loaded_texture *Texture = Textures[Idx];
+
+		if (Texture && Texture->CacheKey)
+		{
+			buffer Baked = BakeTexture(Texture, Arena);
+			if (IsBufferValid(&Baked))
+			{
+				Work->Writes[Work->WriteCount].Key   = Texture->CacheKey;
+				Work->Writes[Work->WriteCount].Baked = Baked;
+				Work->WriteCount += 1;
+
+				Texture->StreamKey = Texture->CacheKey;
+			}
+
+			Texture->CacheKey = 0;
+		}
+	}
+
+	if (Work->WriteCount)
+	{
+		CreateTextureCacheDirectory();
+
+		uint32_t    JobCount = Minimum(Minimum(OSGetProcessorCount() + 1, TEXTURE_CACHE_MAX_JOB_COUNT), Work->WriteCount);
+		job_counter Done     = {0};
+
+		for (uint32_t JobIdx = 0; JobIdx + 1 < JobCount; ++JobIdx)
+		{
+			EngineMemory->AddJob(EngineMemory->WorkQueue, JobPriority_Background, "write texture cache", WriteCachedTexturesJob, Work, &Done);
+		}
+
+		WriteCachedTexturesJob(EngineMemory->WorkQueue, Work);
+		EngineMemory->WaitForCounter(EngineMemory->WorkQueue, &Done);
+	}
+
+	LeaveMemoryRegion(Region);
+}
+
+
+bool
+RemoveCachedTexture(uint64_t Key)
+{
+	texture_cache_path Path;
+
+	bool Result = OSDeleteFile(MakeTextureCachePath(Key, &Path));
+	return Result;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "engine/rendering/assets.h"
+
+// ==============================================
+// <Texture Cache>
+// ==============================================
+
+// Textures the importer finished (packed, mips generated, blocks encoded) are kept on disk as baked
+// textures, keyed by what went into them: the bytes of every source image and how they were packed
+// (textures/texture_pack.h). A hit skips the decode, the packing and the encode, the sources are
+// still read to compute the key.
+
+#define TEXTURE_CACHE_DIRECTORY     "cache/textures"
+#define TEXTURE_CACHE_DIRECTORY_MAX 256
+
+// Bump whenever the importer would produce different bytes for the same source.
+#define TEXTURE_CACHE_VERSION       3
+
+typedef struct engine_memory engine_memory;
+
+
+// Moves the cache away from TEXTURE_CACHE_DIRECTORY, created on the next store. Fails when Directory
+// is longer than TEXTURE_CACHE_DIRECTORY_MAX. No cache job may be running.
+bool     SetTextureCacheDirectory(byte_string Directory);
+
+// ContentHash covers the inputs, the versions are mixed in here. Never 0.
+uint64_t MakeTextureCacheKey     (uint64_t ContentHash);
+
+// Copies the cached texture into Memory and points Texture at it. Fails when nothing valid is
+// stored under Key or it needs more than MemorySize bytes. Safe to call from a job.
+bool     LoadCachedTexture       (uint64_t Key, loaded_texture *Texture, uint8_t *Memory, uint64_t MemorySize);
+
+// Copies levels FirstLevel and below of the texture stored under Key into Memory, back to back like
+// a chain that starts at FirstLevel. Layout is what the caller expects to find (size, format and
+// level count), anything else stored there fails. Safe to call from a job.
+bool     LoadCachedTextureLevels (uint64_t Key, loaded_texture *Layout, uint32_t FirstLevel, uint8_t *Memory, uint64_t MemorySize);
+
+// Writes every texture that has a CacheKey from the work queue, then clears the keys. Must be
+// called from the thread that owns the queue.
+void     StoreCachedTextures     (loaded_texture **Textures, uint32_t Count, engine_memory *EngineMemory);
+
+// Deletes what is stored under Key. No job may be reading it.
+bool     RemoveCachedTexture     (uint64_t Key);
\ No newline at end of file
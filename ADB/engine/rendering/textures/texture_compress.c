@@ -0,0 +1,1540 @@
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "platform/parallel.h"
+#include "texture_compress.h"
+#include "texture_mips.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BC_SSE2 1
+#include <emmintrin.h>
+#else
+#define BC_SSE2 0
+#endif
+
+// A band is a run of block rows of one level. Sized so a single large texture still spreads over
+// every worker.
+#define BC_BAND_BLOCK_COUNT 1024
+
+// ==============================================
+// <Block Math> : INTERNAL
+// ==============================================
+
+// The 16 texels of a block, channel by channel, as floats in [0, 255]. The helpers work on one
+// channel row at a time, four texels per SSE register.
+
+
+typedef struct
+{
+	float Texels[4][16];
+} bc_block;
+
+
+#if BC_SSE2
+
+static float
+HorizontalAdd(__m128 Value)
+{
+	__m128 Shuffled = _mm_shuffle_ps(Value, Value, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 Sums     = _mm_add_ps(Value, Shuffled);
+
+	Shuffled = _mm_movehl_ps(Shuffled, Sums);
+	Sums     = _mm_add_ss(Sums, Shuffled);
+
+	float Result = _mm_cvtss_f32(Sums);
+	return Result;
+}
+
+#endif
+
+
+static float
+Dot16(float *A, float *B)
+{
+#if BC_SSE2
+	__m128 Sum = _mm_mul_ps(_mm_loadu_ps(A), _mm_loadu_ps(B));
+	Sum = _mm_add_ps(Sum, _mm_mul_ps(_mm_loadu_ps(A +  4), _mm_loadu_ps(B +  4)));
+	Sum = _mm_add_ps(Sum, _mm_mul_ps(_mm_loadu_ps(A +  8), _mm_loadu_ps(B +  8)));
+	Sum = _mm_add_ps(Sum, _mm_mul_ps(_mm_loadu_ps(A + 12), _mm_loadu_ps(B + 12)));
+
+	float Result = HorizontalAdd(Sum);
+#else
+	float Result = 0.0f;
+	for (uint32_t Idx = 0; Idx < 16; ++Idx)
+	{
+		Result += A[Idx] * B[Idx];
+	}
+#endif
+
+	return Result;
+}
+
+
+static float
+Sum16(float *A)
+{
+#if BC_SSE2
+	__m128 Sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(A), _mm_loadu_ps(A + 4)), _mm_add_ps(_mm_loadu_ps(A + 8), _mm_loadu_ps(A + 12)));
+
+	float Result = HorizontalAdd(Sum);
+#else
+	float Result = 0.0f;
+	for (uint32_t Idx = 0; Idx < 16; ++Idx)
+	{
+		Result += A[Idx];
+	}
+#endif
+
+	return Result;
+}
+
+
+static void
+Range16(float *A, float *Min, float *Max)
+{
+#if BC_SSE2
+	__m128 Low  = _mm_min_ps(_mm_min_ps(_mm_loadu_ps(A), _mm_loadu_ps(A + 4)), _mm_min_ps(_mm_loadu_ps(A + 8), _mm_loadu_ps(A + 12)));
+	__m128 High = _mm_max_ps(_mm_max_ps(_mm_loadu_ps(A), _mm_loadu_ps(A + 4)), _mm_max_ps(_mm_loadu_ps(A + 8), _mm_loadu_ps(A + 12)));
+
+	Low  = _mm_min_ps(Low,  _mm_shuffle_ps(Low,  Low,  _MM_SHUFFLE(1, 0, 3, 2)));
+	Low  = _mm_min_ps(Low,  _mm_shuffle_ps(Low,  Low,  _MM_SHUFFLE(2, 3, 0, 1)));
+	High = _mm_max_ps(High, _mm_shuffle_ps(High, High, _MM_SHUFFLE(1, 0, 3, 2)));
+	High = _mm_max_ps(High, _mm_shuffle_ps(High, High, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	*Min = _mm_cvtss_f32(Low);
+	*Max = _mm_cvtss_f32(High);
+#else
+	*Min = A[0];
+	*Max = A[0];
+	for (uint32_t Idx = 1; Idx < 16; ++Idx)
+	{
+		*Min = A[Idx] < *Min ? A[Idx] : *Min;
+		*Max = A[Idx] > *Max ? A[Idx] : *Max;
+	}
+#endif
+}
+
+
+// Out[Texel] = dot(Texel - Origin, Axis), over the channels [FirstChannel, FirstChannel + ChannelCount).
+
+static void
+ProjectTexels(bc_block *Block, uint32_t FirstChannel, uint32_t ChannelCount, float *Origin, float *Axis, float *Out)
+{
+#if BC_SSE2
+	for (uint32_t Lane = 0; Lane < 16; Lane += 4)
+	{
+		__m128 Sum = _mm_setzero_ps();
+
+		for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+		{
+			__m128 Texels = _mm_sub_ps(_mm_loadu_ps(Block->Texels[FirstChannel + Channel] + Lane), _mm_set1_ps(Origin[Channel]));
+			Sum = _mm_add_ps(Sum, _mm_mul_ps(Texels, _mm_set1_ps(Axis[Channel])));
+		}
+
+		_mm_storeu_ps(Out + Lane, Sum);
+	}
+#else
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		Out[Texel] = 0.0f;
+
+		for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+		{
+			Out[Texel] += (Block->Texels[FirstChannel + Channel][Texel] - Origin[Channel]) * Axis[Channel];
+		}
+	}
+#endif
+}
+
+
+// Positions[Texel] = round(T[Texel] * Scale) clamped to [0, MaxPosition]. Weights[Texel] is how far
+// that position sits from the first endpoint towards the second, from WeightTable.
+
+static void
+QuantizePositions(float *T, float Scale, uint32_t MaxPosition, float *WeightTable, uint8_t *Positions, float *Weights)
+{
+	int32_t Rounded[16];
+
+#if BC_SSE2
+	for (uint32_t Lane = 0; Lane < 16; Lane += 4)
+	{
+		__m128 Value = _mm_mul_ps(_mm_loadu_ps(T + Lane), _mm_set1_ps(Scale));
+		Value = _mm_min_ps(_mm_max_ps(Value, _mm_setzero_ps()), _mm_set1_ps((float)MaxPosition));
+
+		_mm_storeu_si128((__m128i *)(Rounded + Lane), _mm_cvtps_epi32(Value));
+	}
+#else
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		float Value = T[Texel] * Scale;
+		Value = Value < 0.0f ? 0.0f : (Value > (float)MaxPosition ? (float)MaxPosition : Value);
+
+		Rounded[Texel] = (int32_t)(Value + 0.5f);
+	}
+#endif
+
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		Positions[Texel] = (uint8_t)Rounded[Texel];
+		Weights[Texel]   = WeightTable[Rounded[Texel]];
+	}
+}
+
+
+// Squared error of the texels against A + (B - A) * Weights.
+
+static float
+ComputeFitError(bc_block *Block, uint32_t FirstChannel, uint32_t ChannelCount, float *A, float *B, float *Weights)
+{
+#if BC_SSE2
+	__m128 Sum = _mm_setzero_ps();
+
+	for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		__m128 Start = _mm_set1_ps(A[Channel]);
+		__m128 Delta = _mm_set1_ps(B[Channel] - A[Channel]);
+
+		for (uint32_t Lane = 0; Lane < 16; Lane += 4)
+		{
+			__m128 Fitted = _mm_add_ps(Start, _mm_mul_ps(Delta, _mm_loadu_ps(Weights + Lane)));
+			__m128 Error  = _mm_sub_ps(_mm_loadu_ps(Block->Texels[FirstChannel + Channel] + Lane), Fitted);
+
+			Sum = _mm_add_ps(Sum, _mm_mul_ps(Error, Error));
+		}
+	}
+
+	float Result = HorizontalAdd(Sum);
+#else
+	float Result = 0.0f;
+
+	for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		for (uint32_t Texel = 0; Texel < 16; ++Texel)
+		{
+			float Error = Block->Texels[FirstChannel + Channel][Texel] - (A[Channel] + (B[Channel] - A[Channel]) * Weights[Texel]);
+			Result     += Error * Error;
+		}
+	}
+#endif
+
+	return Result;
+}
+
+
+// Least squares endpoints for fixed weights. Fails when every texel sits on the same position.
+
+static bool
+SolveEndpoints(bc_block *Block, uint32_t FirstChannel, uint32_t ChannelCount, float *Weights, float *A, float *B)
+{
+	float Inverse[16];
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		Inverse[Texel] = 1.0f - Weights[Texel];
+	}
+
+	float AA          = Dot16(Inverse, Inverse);
+	float BB          = Dot16(Weights, Weights);
+	float AB          = Dot16(Inverse, Weights);
+	float Determinant = AA * BB - AB * AB;
+
+	bool Result = fabsf(Determinant) > 1e-6f;
+	if (Result)
+	{
+		for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+		{
+			float AX = Dot16(Inverse, Block->Texels[FirstChannel + Channel]);
+			float BX = Dot16(Weights, Block->Texels[FirstChannel + Channel]);
+
+			A[Channel] = (AX * BB - BX * AB) / Determinant;
+			B[Channel] = (BX * AA - AX * AB) / Determinant;
+
+			A[Channel] = A[Channel] < 0.0f ? 0.0f : (A[Channel] > 255.0f ? 255.0f : A[Channel]);
+			B[Channel] = B[Channel] < 0.0f ? 0.0f : (B[Channel] > 255.0f ? 255.0f : B[Channel]);
+		}
+	}
+
+	return Result;
+}
+
+
+// Mean and dominant direction of the texels, by power iteration on the covariance matrix.
+
+static void
+ComputePrincipalAxis(bc_block *Block, uint32_t FirstChannel, uint32_t ChannelCount, float *Mean, float *Axis)
+{
+	bc_block Centered;
+	float    Covariance[4][4];
+
+	for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		float *Texels = Block->Texels[FirstChannel + Channel];
+
+		Mean[Channel] = Sum16(Texels) / 16.0f;
+
+		for (uint32_t Texel = 0; Texel < 16; ++Texel)
+		{
+			Centered.Texels[Channel][Texel] = Texels[Texel] - Mean[Channel];
+		}
+	}
+
+	uint32_t Largest = 0;
+
+	for (uint32_t Row = 0; Row < ChannelCount; ++Row)
+	{
+		for (uint32_t Column = Row; Column < ChannelCount; ++Column)
+		{
+			Covariance[Row][Column] = Dot16(Centered.Texels[Row], Centered.Texels[Column]);
+			Covariance[Column][Row] = Covariance[Row][Column];
+		}
+
+		Largest = Covariance[Row][Row] > Covariance[Largest][Largest] ? Row : Largest;
+	}
+
+	// Start from the column of the channel that varies the most, it is never orthogonal to the
+	// answer unless the block is flat.
+
+	for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		Axis[Channel] = Covariance[Channel][Largest];
+	}
+
+	for (uint32_t Iteration = 0; Iteration < 8; ++Iteration)
+	{
+		float Next[4] = {0};
+		float Longest = 0.0f;
+
+		for (uint32_t Row = 0; Row < ChannelCount; ++Row)
+		{
+			for (uint32_t Column = 0; Column < ChannelCount; ++Column)
+			{
+				Next[Row] += Covariance[Row][Column] * Axis[Column];
+			}
+
+			Longest = Maximum(Longest, fabsf(Next[Row]));
+		}
+
+		for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+		{
+			Axis[Channel] = Longest > 0.0f ? Next[Channel] / Longest : 0.0f;
+		}
+	}
+
+	float Length = 0.0f;
+	for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		Length += Axis[Channel] * Axis[Channel];
+	}
+
+	Length = sqrtf(Length);
+
+	for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		Axis[Channel] = Length > 1e-6f ? Axis[Channel] / Length : 0.0f;
+	}
+}
+
+// ==============================================
+// <Endpoint Fitting> : INTERNAL
+// ==============================================
+
+// Every format here interpolates linearly between two endpoints, so one fitting loop serves them
+// all: start from the principal axis, pick positions, solve for better endpoints, repeat. Only the
+// endpoint precision and the interpolation weights differ.
+
+
+typedef void bc_quantize_endpoints(float *A, float *B, uint32_t ChannelCount);
+
+
+typedef struct
+{
+	uint32_t               MaxPosition;
+	float                  Weights[16];
+	bc_quantize_endpoints *Quantize;
+} bc_palette;
+
+
+typedef struct
+{
+	// Quantized endpoints, expanded back to [0, 255].
+	float   A[4];
+	float   B[4];
+	uint8_t Positions[16];
+	float   Error;
+} bc_fit;
+
+
+static float
+QuantizeToBits(float Value, uint32_t Bits)
+{
+	// Expanded by bit replication, the way the hardware decodes it.
+
+	uint32_t Max      = (1u << Bits) - 1;
+	uint32_t Code     = (uint32_t)(Value * (float)Max / 255.0f + 0.5f);
+	uint32_t Expanded = (Code << (8 - Bits)) | (Code >> (2 * Bits - 8));
+
+	float Result = (float)Expanded;
+	return Result;
+}
+
+
+static void
+QuantizeRGB565(float *A, float *B, uint32_t ChannelCount)
+{
+	(void)ChannelCount;
+
+	A[0] = QuantizeToBits(A[0], 5);
+	A[1] = QuantizeToBits(A[1], 6);
+	A[2] = QuantizeToBits(A[2], 5);
+	B[0] = QuantizeToBits(B[0], 5);
+	B[1] = QuantizeToBits(B[1], 6);
+	B[2] = QuantizeToBits(B[2], 5);
+}
+
+
+static void
+QuantizeUNorm8(float *A, float *B, uint32_t ChannelCount)
+{
+	for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		A[Channel] = floorf(A[Channel] + 0.5f);
+		B[Channel] = floorf(B[Channel] + 0.5f);
+	}
+}
+
+
+static void
+QuantizeEndpointWithParity(float *Endpoint, uint32_t ChannelCount)
+{
+	// 7 bits per channel plus one low bit shared by all channels of the endpoint.
+
+	float Best[4];
+	float BestError = 0.0f;
+
+	for (uint32_t Parity = 0; Parity < 2; ++Parity)
+	{
+		float Candidate[4];
+		float Error = 0.0f;
+
+		for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+		{
+			int32_t Code = (int32_t)floorf((Endpoint[Channel] - (float)Parity) * 0.5f + 0.5f);
+			Code = Code < 0 ? 0 : (Code > 127 ? 127 : Code);
+
+			Candidate[Channel] = (float)((Code << 1) | (int32_t)Parity);
+			Error             += (Candidate[Channel] - Endpoint[Channel]) * (Candidate[Channel] - Endpoint[Channel]);
+		}
+
+		if (Parity == 0 || Error < BestError)
+		{
+			memcpy(Best, Candidate, sizeof(float) * ChannelCount);
+			BestError = Error;
+		}
+	}
+
+	memcpy(Endpoint, Best, sizeof(float) * ChannelCount);
+}
+
+
+static void
+QuantizeRGBA7777P(float *A, float *B, uint32_t ChannelCount)
+{
+	QuantizeEndpointWithParity(A, ChannelCount);
+	QuantizeEndpointWithParity(B, ChannelCount);
+}
+
+
+// BC7 modes 4 and 5 store endpoints at 5, 6, 7 or 8 bits per channel, no parity bit.
+
+static void
+QuantizeUNormBits(float *A, float *B, uint32_t ChannelCount, uint32_t Bits)
+{
+	for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		A[Channel] = QuantizeToBits(A[Channel], Bits);
+		B[Channel] = QuantizeToBits(B[Channel], Bits);
+	}
+}
+
+
+static void
+QuantizeUNorm5(float *A, float *B, uint32_t ChannelCount)
+{
+	QuantizeUNormBits(A, B, ChannelCount, 5);
+}
+
+
+static void
+QuantizeUNorm6(float *A, float *B, uint32_t ChannelCount)
+{
+	QuantizeUNormBits(A, B, ChannelCount, 6);
+}
+
+
+static void
+QuantizeUNorm7(float *A, float *B, uint32_t ChannelCount)
+{
+	QuantizeUNormBits(A, B, ChannelCount, 7);
+}
+
+
+// BC7 interpolation weights, out of 64, for 2, 3 and 4-bit indices.
+
+static const uint8_t BC7Weights2[4]  = {0, 21, 43, 64};
+static const uint8_t BC7Weights3[8]  = {0, 9, 18, 27, 37, 46, 55, 64};
+static const uint8_t BC7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+
+static void
+InitBC7Palette(bc_palette *Palette, uint32_t IndexBits, bc_quantize_endpoints *Quantize)
+{
+	const uint8_t *Weights = IndexBits == 2 ? BC7Weights2 : (IndexBits == 3 ? BC7Weights3 : BC7Weights4);
+
+	Palette->MaxPosition = (1u << IndexBits) - 1;
+	Palette->Quantize    = Quantize;
+
+	for (uint32_t Position = 0; Position <= Palette->MaxPosition; ++Position)
+	{
+		Palette->Weights[Position] = (float)Weights[Position] / 64.0f;
+	}
+}
+
+
+static void
+InitPalette(bc_palette *Palette, TextureFormat_Type Format, bool IsSingleChannel)
+{
+	if (Format == TextureFormat_BC7)
+	{
+		InitBC7Palette(Palette, 4, QuantizeRGBA7777P);
+	}
+	else
+	{
+		Palette->MaxPosition = IsSingleChannel ? 7 : 3;
+		Palette->Quantize    = IsSingleChannel ? QuantizeUNorm8 : QuantizeRGB565;
+
+		for (uint32_t Position = 0; Position <= Palette->MaxPosition; ++Position)
+		{
+			Palette->Weights[Position] = (float)Position / (float)Palette->MaxPosition;
+		}
+	}
+}
+
+
+static void
+PlaceTexels(bc_block *Block, uint32_t FirstChannel, uint32_t ChannelCount, bc_palette *Palette, float *A, float *B,
+            uint8_t *Positions, float *Weights)
+{
+	float Delta[4];
+	float Length = 0.0f;
+
+	for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+	{
+		Delta[Channel] = B[Channel] - A[Channel];
+		Length        += Delta[Channel] * Delta[Channel];
+	}
+
+	if (Length > 1e-6f)
+	{
+		float T[16];
+		ProjectTexels(Block, FirstChannel, ChannelCount, A, Delta, T);
+		QuantizePositions(T, (float)Palette->MaxPosition / Length, Palette->MaxPosition, Palette->Weights, Positions, Weights);
+	}
+	else
+	{
+		memset(Positions, 0, 16);
+		memset(Weights, 0, sizeof(float) * 16);
+	}
+}
+
+
+static bc_fit
+FitEndpoints(bc_block *Block, uint32_t FirstChannel, uint32_t ChannelCount, bc_palette *Palette, uint32_t RefineCount)
+{
+	bc_fit Result = {0};
+	float  A[4];
+	float  B[4];
+
+	if (ChannelCount == 1)
+	{
+		Range16(Block->Texels[FirstChannel], A, B);
+	}
+	else
+	{
+		float Mean[4];
+		float Axis[4];
+		float T[16];
+		float Low;
+		float High;
+
+		ComputePrincipalAxis(Block, FirstChannel, ChannelCount, Mean, Axis);
+		ProjectTexels(Block, FirstChannel, ChannelCount, Mean, Axis, T);
+		Range16(T, &Low, &High);
+
+		for (uint32_t Channel = 0; Channel < ChannelCount; ++Channel)
+		{
+			A[Channel] = Mean[Channel] + Axis[Channel] * Low;
+			B[Channel] = Mean[Channel] + Axis[Channel] * High;
+
+			A[Channel] = A[Channel] < 0.0f ? 0.0f : (A[Channel] > 255.0f ? 255.0f : A[Channel]);
+			B[Channel] = B[Channel] < 0.0f ? 0.0f : (B[Channel] > 255.0f ? 255.0f : B[Channel]);
+		}
+	}
+
+	for (uint32_t Pass = 0; Pass <= RefineCount; ++Pass)
+	{
+		bc_fit Fit;
+		float  Weights[16];
+
+		memcpy(Fit.A, A, sizeof(A));
+		memcpy(Fit.B, B, sizeof(B));
+		Palette->Quantize(Fit.A, Fit.B, ChannelCount);
+
+		PlaceTexels(Block, FirstChannel, ChannelCount, Palette, Fit.A, Fit.B, Fit.Positions, Weights);
+		Fit.Error = ComputeFitError(Block, FirstChannel, ChannelCount, Fit.A, Fit.B, Weights);
+
+		if (Pass == 0 || Fit.Error < Result.Error)
+		{
+			Result = Fit;
+		}
+
+		if (Result.Error == 0.0f || !SolveEndpoints(Block, FirstChannel, ChannelCount, Weights, A, B))
+		{
+			break;
+		}
+	}
+
+	return Result;
+}
+
+// ==============================================
+// <Block Encoding> : INTERNAL
+// ==============================================
+
+
+static uint32_t
+GetRefineCount(TextureQuality_Type Quality)
+{
+	uint32_t Result = Quality == TextureQuality_High ? 4 : 1;
+	return Result;
+}
+
+
+static void
+EncodeBC1Block(bc_block *Block, uint8_t *Out, uint32_t RefineCount)
+{
+	bc_palette Palette;
+	InitPalette(&Palette, TextureFormat_BC1, false);
+
+	bc_fit Fit = FitEndpoints(Block, 0, 3, &Palette, RefineCount);
+
+	uint16_t Color0 = (uint16_t)((((uint32_t)Fit.A[0] >> 3) << 11) | (((uint32_t)Fit.A[1] >> 2) << 5) | ((uint32_t)Fit.A[2] >> 3));
+	uint16_t Color1 = (uint16_t)((((uint32_t)Fit.B[0] >> 3) << 11) | (((uint32_t)Fit.B[1] >> 2) << 5) | ((uint32_t)Fit.B[2] >> 3));
+
+	// Four-color mode needs Color0 > Color1. Position 0 is Color0, 3 is Color1, 1 and 2 the thirds.
+
+	static const uint8_t Indices[4] = {0, 2, 3, 1};
+
+	bool     Swap = Color0 < Color1;
+	uint32_t Bits = 0;
+
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		uint32_t Position = Swap ? 3 - Fit.Positions[Texel] : Fit.Positions[Texel];
+		Position          = Color0 == Color1 ? 0 : Position;
+
+		Bits |= (uint32_t)Indices[Position] << (Texel * 2);
+	}
+
+	if (Swap)
+	{
+		uint16_t Temp = Color0;
+		Color0 = Color1;
+		Color1 = Temp;
+	}
+
+	memcpy(Out + 0, &Color0, 2);
+	memcpy(Out + 2, &Color1, 2);
+	memcpy(Out + 4, &Bits,   4);
+}
+
+
+static void
+EncodeBC4Block(bc_block *Block, uint32_t Channel, uint8_t *Out, uint32_t RefineCount)
+{
+	bc_palette Palette;
+	InitPalette(&Palette, TextureFormat_BC4, true);
+
+	bc_fit Fit = FitEndpoints(Block, Channel, 1, &Palette, RefineCount);
+
+	uint8_t Value0 = (uint8_t)Fit.A[0];
+	uint8_t Value1 = (uint8_t)Fit.B[0];
+
+	// Eight-value mode needs Value0 > Value1. Position 0 is Value0, 7 is Value1, the rest in between.
+
+	static const uint8_t Indices[8] = {0, 2, 3, 4, 5, 6, 7, 1};
+
+	bool     Swap = Value0 < Value1;
+	uint64_t Bits = 0;
+
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		uint32_t Position = Swap ? 7 - Fit.Positions[Texel] : Fit.Positions[Texel];
+		Position          = Value0 == Value1 ? 0 : Position;
+
+		Bits |= (uint64_t)Indices[Position] << (Texel * 3);
+	}
+
+	Out[0] = Swap ? Value1 : Value0;
+	Out[1] = Swap ? Value0 : Value1;
+
+	for (uint32_t Byte = 0; Byte < 6; ++Byte)
+	{
+		Out[2 + Byte] = (uint8_t)(Bits >> (Byte * 8));
+	}
+}
+
+
+static void
+WriteBits(uint64_t *Block, uint32_t *At, uint32_t Value, uint32_t Count)
+{
+	for (uint32_t Bit = 0; Bit < Count; ++Bit, ++*At)
+	{
+		Block[*At >> 6] |= (uint64_t)((Value >> Bit) & 1) << (*At & 63);
+	}
+}
+
+
+// Mode 6: one subset, RGBA 7.7.7.7 endpoints with a parity bit each, 4-bit indices. All four
+// channels sit on one line, fine for color, not for channels that vary on their own.
+
+static float
+EncodeBC7Mode6Block(bc_block *Block, uint8_t *Out, uint32_t RefineCount)
+{
+	bc_palette Palette;
+	InitPalette(&Palette, TextureFormat_BC7, false);
+
+	bc_fit Fit = FitEndpoints(Block, 0, 4, &Palette, RefineCount);
+
+	// The first texel's index drops its top bit, so it has to sit in the lower half.
+
+	bool Swap = Fit.Positions[0] >= 8;
+
+	float   *A       = Swap ? Fit.B : Fit.A;
+	float   *B       = Swap ? Fit.A : Fit.B;
+	uint64_t Bits[2] = {0};
+	uint32_t At      = 0;
+
+	WriteBits(Bits, &At, 1u << 6, 7);
+
+	for (uint32_t Channel = 0; Channel < 4; ++Channel)
+	{
+		WriteBits(Bits, &At, (uint32_t)A[Channel] >> 1, 7);
+		WriteBits(Bits, &At, (uint32_t)B[Channel] >> 1, 7);
+	}
+
+	WriteBits(Bits, &At, (uint32_t)A[0] & 1, 1);
+	WriteBits(Bits, &At, (uint32_t)B[0] & 1, 1);
+
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		uint32_t Position = Swap ? 15 - Fit.Positions[Texel] : Fit.Positions[Texel];
+		WriteBits(Bits, &At, Position, Texel == 0 ? 3 : 4);
+	}
+
+	assert(At == 128);
+
+	memcpy(Out + 0, &Bits[0], 8);
+	memcpy(Out + 8, &Bits[1], 8);
+
+	return Fit.Error;
+}
+
+
+static void
+WriteBC7Indices(uint64_t *Bits, uint32_t *At, bc_fit *Fit, uint32_t IndexBits, bool Swap)
+{
+	uint32_t MaxPosition = (1u << IndexBits) - 1;
+
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		uint32_t Position = Swap ? MaxPosition - Fit->Positions[Texel] : Fit->Positions[Texel];
+		WriteBits(Bits, At, Position, Texel == 0 ? IndexBits - 1 : IndexBits);
+	}
+}
+
+
+// Modes 4 and 5: one subset, but one channel keeps its own endpoints and indices, so it no longer
+// pulls the other three off their line. Rotation picks that channel (0 alpha, 1 red, 2 green,
+// 3 blue), it is swapped into alpha here and back by the decoder.
+//
+//   Mode 4 : RGB 5.5.5, A 6, 2-bit and 3-bit indices, IndexMode gives the 3-bit ones to RGB.
+//   Mode 5 : RGB 7.7.7, A 8, 2-bit indices for both.
+
+static float
+EncodeBC7SplitBlock(bc_block *Block, uint32_t Mode, uint32_t Rotation, uint32_t IndexMode, uint8_t *Out, uint32_t RefineCount)
+{
+	bc_block Rotated = *Block;
+
+	if (Rotation)
+	{
+		memcpy(Rotated.Texels[3],            Block->Texels[Rotation - 1], sizeof(Rotated.Texels[3]));
+		memcpy(Rotated.Texels[Rotation - 1], Block->Texels[3],            sizeof(Rotated.Texels[3]));
+	}
+
+	bool     IsMode4        = Mode == 4;
+	uint32_t ColorBits      = IsMode4 ? 5 : 7;
+	uint32_t AlphaBits      = IsMode4 ? 6 : 8;
+	uint32_t ColorIndexBits = IsMode4 && IndexMode ? 3 : 2;
+	uint32_t AlphaIndexBits = IsMode4 && !IndexMode ? 3 : 2;
+
+	bc_palette ColorPalette;
+	bc_palette AlphaPalette;
+	InitBC7Palette(&ColorPalette, ColorIndexBits, IsMode4 ? QuantizeUNorm5 : QuantizeUNorm7);
+	InitBC7Palette(&AlphaPalette, AlphaIndexBits, IsMode4 ? QuantizeUNorm6 : QuantizeUNorm8);
+
+	bc_fit Color = FitEndpoints(&Rotated, 0, 3, &ColorPalette, RefineCount);
+	bc_fit Alpha = FitEndpoints(&Rotated, 3, 1, &AlphaPalette, RefineCount);
+
+	// Both index sets drop the top bit of their first texel.
+
+	bool SwapColor = Color.Positions[0] > ColorPalette.MaxPosition / 2;
+	bool SwapAlpha = Alpha.Positions[0] > AlphaPalette.MaxPosition / 2;
+
+	float   *ColorA  = SwapColor ? Color.B : Color.A;
+	float   *ColorB  = SwapColor ? Color.A : Color.B;
+	float   *AlphaA  = SwapAlpha ? Alpha.B : Alpha.A;
+	float   *AlphaB  = SwapAlpha ? Alpha.A : Alpha.B;
+	uint64_t Bits[2] = {0};
+	uint32_t At      = 0;
+
+	WriteBits(Bits, &At, 1u << Mode, Mode + 1);
+	WriteBits(Bits, &At, Rotation, 2);
+
+	if (IsMode4)
+	{
+		WriteBits(Bits, &At, IndexMode, 1);
+	}
+
+	for (uint32_t Channel = 0; Channel < 3; ++Channel)
+	{
+		WriteBits(Bits, &At, (uint32_t)ColorA[Channel] >> (8 - ColorBits), ColorBits);
+		WriteBits(Bits, &At, (uint32_t)ColorB[Channel] >> (8 - ColorBits), ColorBits);
+	}
+
+	WriteBits(Bits, &At, (uint32_t)AlphaA[0] >> (8 - AlphaBits), AlphaBits);
+	WriteBits(Bits, &At, (uint32_t)AlphaB[0] >> (8 - AlphaBits), AlphaBits);
+
+	// The 2-bit set comes first. In mode 4 with IndexMode set that is the alpha one.
+
+	if (IndexMode)
+	{
+		WriteBC7Indices(Bits, &At, &Alpha, AlphaIndexBits, SwapAlpha);
+		WriteBC7Indices(Bits, &At, &Color, ColorIndexBits, SwapColor);
+	}
+	else
+	{
+		WriteBC7Indices(Bits, &At, &Color, ColorIndexBits, SwapColor);
+		WriteBC7Indices(Bits, &At, &Alpha, AlphaIndexBits, SwapAlpha);
+	}
+
+	assert(At == 128);
+
+	memcpy(Out + 0, &Bits[0], 8);
+	memcpy(Out + 8, &Bits[1], 8);
+
+	float Result = Color.Error + Alpha.Error;
+	return Result;
+}
+
+
+static void
+EncodeBC7Block(bc_block *Block, uint8_t *Out, TextureQuality_Type Quality)
+{
+	// Every block tries mode 6 and mode 5 in all four rotations, TextureQuality_High adds mode 4 in
+	// both index modes. The lowest error is kept. Four unrelated channels (textures/texture_pack.h)
+	// still lose more than BC5 and BC4 would: only one channel gets its own indices, the other three
+	// share a line.
+
+	uint32_t RefineCount = GetRefineCount(Quality);
+	uint32_t FirstMode   = Quality == TextureQuality_High ? 4 : 5;
+	uint8_t  Candidate[16];
+	float    BestError   = EncodeBC7Mode6Block(Block, Out, RefineCount);
+
+	for (uint32_t Mode = FirstMode; Mode <= 5 && BestError > 0.0f; ++Mode)
+	{
+		for (uint32_t Rotation = 0; Rotation < 4; ++Rotation)
+		{
+			for (uint32_t IndexMode = 0; IndexMode < (Mode == 4 ? 2u : 1u); ++IndexMode)
+			{
+				float Error = EncodeBC7SplitBlock(Block, Mode, Rotation, IndexMode, Candidate, RefineCount);
+
+				if (Error < BestError)
+				{
+					memcpy(Out, Candidate, sizeof(Candidate));
+					BestError = Error;
+				}
+			}
+		}
+	}
+}
+
+
+static void
+LoadBlock(texture_mip Mip, uint32_t BlockX, uint32_t BlockY, bc_block *Block)
+{
+	// Blocks hanging over the edge of a small level repeat the last row and column.
+
+	for (uint32_t Y = 0; Y < 4; ++Y)
+	{
+		uint32_t SourceY = Minimum(BlockY * 4 + Y, Mip.Height - 1);
+		uint8_t *Row     = Mip.Data + (uint64_t)SourceY * Mip.Pitch;
+
+		for (uint32_t X = 0; X < 4; ++X)
+		{
+			uint8_t *Texel = Row + Minimum(BlockX * 4 + X, Mip.Width - 1) * 4;
+
+			Block->Texels[0][Y * 4 + X] = (float)Texel[0];
+			Block->Texels[1][Y * 4 + X] = (float)Texel[1];
+			Block->Texels[2][Y * 4 + X] = (float)Texel[2];
+			Block->Texels[3][Y * 4 + X] = (float)Texel[3];
+		}
+	}
+}
+
+
+static void
+EncodeBlock(TextureFormat_Type Format, bc_block *Block, uint8_t *Out, TextureQuality_Type Quality)
+{
+	uint32_t RefineCount = GetRefineCount(Quality);
+
+	switch (Format)
+	{
+
+	case TextureFormat_BC1:
+	{
+		EncodeBC1Block(Block, Out, RefineCount);
+	} break;
+
+	case TextureFormat_BC3:
+	{
+		EncodeBC4Block(Block, 3, Out, RefineCount);
+		EncodeBC1Block(Block, Out + 8, RefineCount);
+	} break;
+
+	case TextureFormat_BC4:
+	{
+		EncodeBC4Block(Block, 0, Out, RefineCount);
+	} break;
+
+	case TextureFormat_BC5:
+	{
+		EncodeBC4Block(Block, 0, Out, RefineCount);
+		EncodeBC4Block(Block, 1, Out + 8, RefineCount);
+	} break;
+
+	case TextureFormat_BC7:
+	{
+		EncodeBC7Block(Block, Out, Quality);
+	} break;
+
+	default:
+	{
+		assert(!"Not a block format");
+	} break;
+
+	}
+}
+
+
+static void
+EncodeBand(loaded_texture *Source, loaded_texture *Dest, uint32_t Level, uint32_t FirstRow, uint32_t RowCount, TextureQuality_Type Quality)
+{
+	texture_mip SourceMip = GetTextureMip(Source, Level);
+	texture_mip DestMip   = GetTextureMip(Dest, Level);
+	uint32_t    BlockSize = GetFormatBlockSize(Dest->Format);
+	uint32_t    BlocksX   = (DestMip.Width + 3) / 4;
+
+	for (uint32_t BlockY = FirstRow; BlockY < FirstRow + RowCount; ++BlockY)
+	{
+		uint8_t *Out = DestMip.Data + (uint64_t)BlockY * DestMip.Pitch;
+
+		for (uint32_t BlockX = 0; BlockX < BlocksX; ++BlockX)
+		{
+			bc_block Block;
+			LoadBlock(SourceMip, BlockX, BlockY, &Block);
+			EncodeBlock(Dest->Format, &Block, Out + BlockX * BlockSize, Quality);
+		}
+	}
+}
+
+
+static bool
+CanCompressTexture(loaded_texture *Texture)
+{
+	bool Result = Texture && Texture->Data && Texture->Format == TextureFormat_RGBA8 && Texture->BytesPerPixel == 4 &&
+	              Texture->Width && Texture->Height && (Texture->Width % 4) == 0 && (Texture->Height % 4) == 0;
+	return Result;
+}
+
+
+static TextureFormat_Type
+ChooseColorFormat(loaded_texture *Texture, TextureQuality_Type Quality)
+{
+	TextureFormat_Type Result = Quality == TextureQuality_High ? TextureFormat_BC7 : (Texture->HasAlpha ? TextureFormat_BC3 : TextureFormat_BC1);
+	return Result;
+}
+
+
+static loaded_texture
+MakeEncodedTexture(loaded_texture *Texture, TextureFormat_Type Format, memory_arena *Arena)
+{
+	loaded_texture Result = *Texture;
+
+	Result.Format        = Format;
+	Result.BytesPerPixel = 0;
+	Result.MipCount      = Maximum(Texture->MipCount, 1);
+	Result.Data          = PushArray(Arena, uint8_t, GetTextureDataSize(Texture->Width, Texture->Height, Format, Result.MipCount));
+
+	return Result;
+}
+
+// ==============================================
+// <Block Decoding> : INTERNAL
+// ==============================================
+
+// What a sampler on the GPU would read back, for backends that sample on the CPU. Out holds the 16
+// texels of the block, RGBA8, row by row.
+
+
+static void
+ExpandRGB565(uint16_t Color, uint8_t *Out)
+{
+	uint32_t R = (Color >> 11) & 31;
+	uint32_t G = (Color >> 5)  & 63;
+	uint32_t B = Color         & 31;
+
+	Out[0] = (uint8_t)((R << 3) | (R >> 2));
+	Out[1] = (uint8_t)((G << 2) | (G >> 4));
+	Out[2] = (uint8_t)((B << 3) | (B >> 2));
+	Out[3] = 255;
+}
+
+
+// Inside BC3 the color block is always in four-color mode, whatever the order of its endpoints.
+
+static void
+DecodeBC1Block(uint8_t *In, uint8_t Out[16][4], bool HasTransparentMode)
+{
+	uint16_t Color0, Color1;
+	uint32_t Bits;
+
+	memcpy(&Color0, In + 0, 2);
+	memcpy(&Color1, In + 2, 2);
+	memcpy(&Bits,   In + 4, 4);
+
+	uint8_t Palette[4][4];
+	ExpandRGB565(Color0, Palette[0]);
+	ExpandRGB565(Color1, Palette[1]);
+
+	for (uint32_t Channel = 0; Channel < 3; ++Channel)
+	{
+		uint32_t A = Palette[0][Channel];
+		uint32_t B = Palette[1][Channel];
+
+		if (Color0 > Color1 || !HasTransparentMode)
+		{
+			Palette[2][Channel] = (uint8_t)((2 * A + B) / 3);
+			Palette[3][Channel] = (uint8_t)((A + 2 * B) / 3);
+		}
+		else
+		{
+			Palette[2][Channel] = (uint8_t)((A + B) / 2);
+			Palette[3][Channel] = 0;
+		}
+	}
+
+	Palette[2][3] = 255;
+	Palette[3][3] = Color0 > Color1 || !HasTransparentMode ? 255 : 0;
+
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		memcpy(Out[Texel], Palette[(Bits >> (Texel * 2)) & 3], 4);
+	}
+}
+
+
+static void
+DecodeBC4Block(uint8_t *In, uint8_t Out[16][4], uint32_t Channel)
+{
+	uint32_t Value0 = In[0];
+	uint32_t Value1 = In[1];
+	uint64_t Bits   = 0;
+
+	for (uint32_t Byte = 0; Byte < 6; ++Byte)
+	{
+		Bits |= (uint64_t)In[2 + Byte] << (Byte * 8);
+	}
+
+	uint8_t Palette[8] = {(uint8_t)Value0, (uint8_t)Value1};
+
+	for (uint32_t Idx = 1; Idx < 7; ++Idx)
+	{
+		if (Value0 > Value1)
+		{
+			Palette[Idx + 1] = (uint8_t)(((7 - Idx) * Value0 + Idx * Value1) / 7);
+		}
+		else if (Idx < 5)
+		{
+			Palette[Idx + 1] = (uint8_t)(((5 - Idx) * Value0 + Idx * Value1) / 5);
+		}
+	}
+
+	if (Value0 <= Value1)
+	{
+		Palette[6] = 0;
+		Palette[7] = 255;
+	}
+
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		Out[Texel][Channel] = Palette[(Bits >> (Texel * 3)) & 7];
+	}
+}
+
+
+static uint32_t
+ReadBits(uint64_t *Block, uint32_t *At, uint32_t Count)
+{
+	uint32_t Result = 0;
+
+	for (uint32_t Bit = 0; Bit < Count; ++Bit, ++*At)
+	{
+		Result |= (uint32_t)((Block[*At >> 6] >> (*At & 63)) & 1) << Bit;
+	}
+
+	return Result;
+}
+
+
+static uint32_t
+ExpandBits(uint32_t Code, uint32_t Bits)
+{
+	uint32_t Result = (Code << (8 - Bits)) | (Code >> (2 * Bits - 8));
+	return Result;
+}
+
+
+static void
+ReadBC7Indices(uint64_t *Bits, uint32_t *At, uint32_t IndexBits, uint32_t *Weights)
+{
+	const uint8_t *Table = IndexBits == 2 ? BC7Weights2 : (IndexBits == 3 ? BC7Weights3 : BC7Weights4);
+
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		Weights[Texel] = Table[ReadBits(Bits, At, Texel == 0 ? IndexBits - 1 : IndexBits)];
+	}
+}
+
+
+// Modes 4, 5 and 6, the ones EncodeBC7Block writes. Blocks in any other mode come out black.
+
+static void
+DecodeBC7Block(uint8_t *In, uint8_t Out[16][4])
+{
+	uint64_t Bits[2];
+	uint32_t Mode = 0;
+
+	memcpy(&Bits[0], In + 0, 8);
+	memcpy(&Bits[1], In + 8, 8);
+
+	while (Mode < 8 && !((Bits[0] >> Mode) & 1))
+	{
+		++Mode;
+	}
+
+	uint32_t At = Mode + 1;
+	uint32_t A[4], B[4];
+	uint32_t ColorWeights[16];
+	uint32_t AlphaWeights[16];
+	uint32_t Rotation = 0;
+
+	memset(Out, 0, 16 * 4);
+
+	if (Mode == 6)
+	{
+		for (uint32_t Channel = 0; Channel < 4; ++Channel)
+		{
+			A[Channel] = ReadBits(Bits, &At, 7) << 1;
+			B[Channel] = ReadBits(Bits, &At, 7) << 1;
+		}
+
+		uint32_t ParityA = ReadBits(Bits, &At, 1);
+		uint32_t ParityB = ReadBits(Bits, &At, 1);
+
+		for (uint32_t Channel = 0; Channel < 4; ++Channel)
+		{
+			A[Channel] |= ParityA;
+			B[Channel] |= ParityB;
+		}
+
+		ReadBC7Indices(Bits, &At, 4, ColorWeights);
+		memcpy(AlphaWeights, ColorWeights, sizeof(AlphaWeights));
+	}
+	else if (Mode == 4 || Mode == 5)
+	{
+		Rotation = ReadBits(Bits, &At, 2);
+
+		uint32_t IndexMode      = Mode == 4 ? ReadBits(Bits, &At, 1) : 0;
+		uint32_t ColorBits      = Mode == 4 ? 5 : 7;
+		uint32_t AlphaBits      = Mode == 4 ? 6 : 8;
+		uint32_t SecondSetBits  = Mode == 4 ? 3 : 2;
+
+		for (uint32_t Channel = 0; Channel < 4; ++Channel)
+		{
+			uint32_t EndpointBits = Channel < 3 ? ColorBits : AlphaBits;
+
+			A[Channel] = ExpandBits(ReadBits(Bits, &At, EndpointBits), EndpointBits);
+			B[Channel] = ExpandBits(ReadBits(Bits, &At, EndpointBits), EndpointBits);
+		}
+
+		ReadBC7Indices(Bits, &At, 2,             IndexMode ? AlphaWeights : ColorWeights);
+		ReadBC7Indices(Bits, &At, SecondSetBits, IndexMode ? ColorWeights : AlphaWeights);
+	}
+	else
+	{
+		for (uint32_t Texel = 0; Texel < 16; ++Texel)
+		{
+			Out[Texel][3] = 255;
+		}
+
+		return;
+	}
+
+	for (uint32_t Texel = 0; Texel < 16; ++Texel)
+	{
+		for (uint32_t Channel = 0; Channel < 4; ++Channel)
+		{
+			uint32_t Weight = Channel < 3 ? ColorWeights[Texel] : AlphaWeights[Texel];
+			Out[Texel][Channel] = (uint8_t)(((64 - Weight) * A[Channel] + Weight * B[Channel] + 32) >> 6);
+		}
+
+		if (Rotation)
+		{
+			uint8_t Swapped = Out[Texel][3];
+			Out[Texel][3]            = Out[Texel][Rotation - 1];
+			Out[Texel][Rotation - 1] = Swapped;
+		}
+	}
+}
+
+
+static void
+DecodeBlock(TextureFormat_Type Format, uint8_t *In, uint8_t Out[16][4])
+{
+	switch (Format)
+	{
+
+	case TextureFormat_BC1:
+	{
+		DecodeBC1Block(In, Out, true);
+	} break;
+
+	case TextureFormat_BC3:
+	{
+		DecodeBC1Block(In + 8, Out, false);
+		DecodeBC4Block(In, Out, 3);
+	} break;
+
+	// D3D reads the missing channels of BC4 and BC5 as 0, alpha as 1.
+
+	case TextureFormat_BC4:
+	case TextureFormat_BC5:
+	{
+		memset(Out, 0, 16 * 4);
+
+		for (uint32_t Texel = 0; Texel < 16; ++Texel)
+		{
+			Out[Texel][3] = 255;
+		}
+
+		DecodeBC4Block(In, Out, 0);
+
+		if (Format == TextureFormat_BC5)
+		{
+			DecodeBC4Block(In + 8, Out, 1);
+		}
+	} break;
+
+	case TextureFormat_BC7:
+	{
+		DecodeBC7Block(In, Out);
+	} break;
+
+	default:
+	{
+		assert(!"Not a block format");
+	} break;
+
+	}
+}
+
+// ==============================================
+// <Jobs> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+	loaded_texture *Source;
+	loaded_texture *Dest;
+	uint32_t        Level;
+	uint32_t        FirstRow;
+	uint32_t        RowCount;
+} bc_band;
+
+
+typedef struct
+{
+	bc_band             *Bands;
+	uint32_t             BandCount;
+	TextureQuality_Type  Quality;
+} bc_work;
+
+
+static void
+CompressBands(uint64_t First, uint64_t End, void *Context)
+{
+	bc_work *Work = (bc_work *)Context;
+
+	for (uint64_t BandIdx = First; BandIdx < End; ++BandIdx)
+	{
+		bc_band *Band = Work->Bands + BandIdx;
+		EncodeBand(Band->Source, Band->Dest, Band->Level, Band->FirstRow, Band->RowCount, Work->Quality);
+	}
+}
+
+// ==============================================
+// <Block Compression> : PUBLIC
+// ==============================================
+
+
+TextureFormat_Type
+ChooseTextureFormat(loaded_texture *Texture, MaterialMap_Type Map, TextureQuality_Type Quality)
+{
+	TextureFormat_Type Result = TextureFormat_RGBA8;
+
+	if (CanCompressTexture(Texture))
+	{
+		switch (Map)
+		{
+
+		case MaterialMap_Color:
+		{
+			Result = ChooseColorFormat(Texture, Quality);
+		} break;
+
+		case MaterialMap_Normal:
+		{
+			Result = TextureFormat_BC5;
+		} break;
+
+		case MaterialMap_Roughness:
+		case MaterialMap_Metalness:
+		case MaterialMap_Occlusion:
+		{
+			Result = TextureFormat_BC4;
+		} break;
+
+		default:
+		{
+		} break;
+
+		}
+	}
+
+	return Result;
+}
+
+
+TextureFormat_Type
+ChooseMaterialTextureFormat(loaded_texture *Texture, MaterialTexture_Type Type, TextureQuality_Type Quality)
+{
+	TextureFormat_Type Result = TextureFormat_RGBA8;
+
+	if (CanCompressTexture(Texture))
+	{
+		switch (Type)
+		{
+
+		case MaterialTexture_Albedo:
+		{
+			Result = ChooseColorFormat(Texture, Quality);
+		} break;
+
+		case MaterialTexture_Surface:
+		{
+			// Four unrelated channels, BC3 would squeeze the normal into 565.
+			Result = TextureFormat_BC7;
+		} break;
+
+		default:
+		{
+		} break;
+
+		}
+	}
+
+	return Result;
+}
+
+
+void
+CompressTexture(loaded_texture *Texture, TextureFormat_Type Format, TextureQuality_Type Quality, memory_arena *Arena)
+{
+	if (Format != TextureFormat_RGBA8 && CanCompressTexture(Texture))
+	{
+		loaded_texture Encoded = MakeEncodedTexture(Texture, Format, Arena);
+
+		if (Encoded.Data)
+		{
+			for (uint32_t Level = 0; Level < Encoded.MipCount; ++Level)
+			{
+				uint32_t BlockRows = (GetTextureMip(&Encoded, Level).Height + 3) / 4;
+				EncodeBand(Texture, &Encoded, Level, 0, BlockRows, Quality);
+			}
+
+			*Texture = Encoded;
+		}
+	}
+}
+
+
+void
+DecompressTexture(loaded_texture *Texture, memory_arena *Arena)
+{
+	uint32_t BlockSize = Texture && Texture->Data ? GetFormatBlockSize(Texture->Format) : 0;
+
+	if (BlockSize && Texture->Width && Texture->Height)
+	{
+		loaded_texture Decoded = *Texture;
+
+		Decoded.Format        = TextureFormat_RGBA8;
+		Decoded.BytesPerPixel = 4;
+		Decoded.MipCount      = Maximum(Texture->MipCount, 1);
+		Decoded.Data          = PushArray(Arena, uint8_t, GetTextureDataSize(Texture->Width, Texture->Height, TextureFormat_RGBA8, Decoded.MipCount));
+
+		for (uint32_t Level = 0; Decoded.Data && Level < Decoded.MipCount; ++Level)
+		{
+			texture_mip Source = GetTextureMip(Texture, Level);
+			texture_mip Dest   = GetTextureMip(&Decoded, Level);
+
+			for (uint32_t BlockY = 0; BlockY < (Dest.Height + 3) / 4; ++BlockY)
+			{
+				for (uint32_t BlockX = 0; BlockX < (Dest.Width + 3) / 4; ++BlockX)
+				{
+					uint8_t Texels[16][4];
+					DecodeBlock(Texture->Format, Source.Data + (uint64_t)BlockY * Source.Pitch + BlockX * BlockSize, Texels);
+
+					// Only the part of the block that lies inside the level.
+
+					for (uint32_t Y = 0; Y < 4 && BlockY * 4 + Y < Dest.Height; ++Y)
+					{
+						uint8_t *Row = Dest.Data + (uint64_t)(BlockY * 4 + Y) * Dest.Pitch;
+
+						for (uint32_t X = 0; X < 4 && BlockX * 4 + X < Dest.Width; ++X)
+						{
+							memcpy(Row + (BlockX * 4 + X) * 4, Texels[Y * 4 + X], 4);
+						}
+					}
+				}
+			}
+		}
+
+		if (Decoded.Data)
+		{
+			*Texture = Decoded;
+		}
+	}
+}
+
+
+void
+CompressTextures(loaded_texture **Textures, TextureFormat_Type *Formats, uint32_t Count, TextureQuality_Type Quality, engine_memory *EngineMemory)
+{
+	assert(EngineMemory);
+
+	memory_arena *Arena = EngineMemory->FrameMemory;
+
+	// The encoded chains outlive this call, so they go in before the region that holds the bands.
+
+	loaded_texture *Encoded = PushArray(Arena, loaded_texture, Count);
+
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		Encoded[Idx] = (loaded_texture){0};
+
+		if (Formats[Idx] != TextureFormat_RGBA8 && CanCompressTexture(Textures[Idx]))
+		{
+			Encoded[Idx] = MakeEncodedTexture(Textures[Idx], Formats[Idx], Arena);
+		}
+	}
+
+	memory_region Region = EnterMemoryRegion(Arena);
+
+	// Levels only read the RGBA chain and write their own part of the new one, so unlike mip
+	// generation everything can go out in a single batch.
+
+	uint32_t BandCount = 0;
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		for (uint32_t Level = 0; Encoded[Idx].Data && Level < Encoded[Idx].MipCount; ++Level)
+		{
+			texture_mip Mip         = GetTextureMip(Encoded + Idx, Level);
+			uint32_t    RowsPerBand = Maximum(BC_BAND_BLOCK_COUNT / ((Mip.Width + 3) / 4), 1);
+			uint32_t    BlockRows   = (Mip.Height + 3) / 4;
+
+			BandCount += (BlockRows + RowsPerBand - 1) / RowsPerBand;
+		}
+	}
+
+	bc_work *Work = PushStruct(Arena, bc_work);
+	Work->Bands     = PushArray(Arena, bc_band, BandCount);
+	Work->BandCount = 0;
+	Work->Quality   = Quality;
+
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		for (uint32_t Level = 0; Encoded[Idx].Data && Level < Encoded[Idx].MipCount; ++Level)
+		{
+			texture_mip Mip         = GetTextureMip(Encoded + Idx, Level);
+			uint32_t    RowsPerBand = Maximum(BC_BAND_BLOCK_COUNT / ((Mip.Width + 3) / 4), 1);
+			uint32_t    BlockRows   = (Mip.Height + 3) / 4;
+
+			for (uint32_t Row = 0; Row < BlockRows; Row += RowsPerBand)
+			{
+				bc_band *Band  = Work->Bands + Work->BandCount++;
+				Band->Source   = Textures[Idx];
+				Band->Dest     = Encoded + Idx;
+				Band->Level    = Level;
+				Band->FirstRow = Row;
+				Band->RowCount = Minimum(RowsPerBand, BlockRows - Row);
+			}
+		}
+	}
+
+	// A band is already a good amount of work, the loop may hand them out one at a time.
+
+	ParallelFor(Work->BandCount, 1, "compress bands", CompressBands, Work, JobPriority_Background, EngineMemory);
+
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		if (Encoded[Idx].Data)
+		{
+			*Textures[Idx] = Encoded[Idx];
+		}
+	}
+
+	LeaveMemoryRegion(Region);
+}
\ No newline at end of file
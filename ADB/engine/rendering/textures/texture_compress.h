@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "engine/rendering/assets.h"
+
+// ==============================================
+// <Block Compression>
+// ==============================================
+
+// Encodes RGBA8 textures, mips included, to the BC formats. The format follows what the texture
+// holds, either a single material slot (the baker works on those):
+//
+//   Color                           : BC1, or BC3 when the texture has alpha. BC7 (modes 4 to 6) at
+//                                     TextureQuality_High.
+//   Normal                          : BC5, X and Y in R and G. Z has to be rebuilt by whoever samples it.
+//   Roughness, Metalness, Occlusion : BC4, from R.
+//
+// or a packed material texture (textures/texture_pack.h):
+//
+//   Albedo  : as Color.
+//   Surface : BC7. Modes 4 and 5 give one channel its own indices, the other three still share
+//             a line, so the normal comes out noticeably worse than BC5 would leave it (RMSE about
+//             3.5 against 0.8 on a noisy normal with varying roughness). TextureQuality_High tries
+//             more modes and gets closer.
+//
+// Color is encoded as stored, in sRGB. Textures whose size is not a multiple of 4 stay RGBA8,
+// D3D11 wants whole blocks in the first level.
+
+typedef struct engine_memory engine_memory;
+
+
+typedef enum
+{
+	TextureQuality_Fast = 0, // Load time, one refinement pass.
+	TextureQuality_High = 1, // Offline, BC7 for color and more refinement.
+} TextureQuality_Type;
+
+
+// RGBA8 when the texture cannot be encoded.
+TextureFormat_Type ChooseTextureFormat         (loaded_texture *Texture, MaterialMap_Type Map, TextureQuality_Type Quality);
+TextureFormat_Type ChooseMaterialTextureFormat (loaded_texture *Texture, MaterialTexture_Type Type, TextureQuality_Type Quality);
+
+// Both replace Data with the encoded chain, pushed on the arena, and leave the texture alone when
+// the format is RGBA8. CompressTexture runs on the calling thread and may be used from inside a job.
+// CompressTextures spreads the blocks of every level of every texture over the work queue, it must
+// be called from the thread that owns the queue and allocates from its frame memory.
+
+void               CompressTexture             (loaded_texture *Texture, TextureFormat_Type Format, TextureQuality_Type Quality, memory_arena *Arena);
+void               CompressTextures            (loaded_texture **Textures, TextureFormat_Type *Formats, uint32_t Count, TextureQuality_Type Quality,
+                                                engine_memory *EngineMemory);
+
+// The other way, for backends that sample on the CPU: replaces Data with the RGBA8 levels, pushed
+// on the arena, and leaves RGBA8 textures alone. BC7 is only read back in the modes the encoder
+// writes (4 to 6), blocks in other modes come out black.
+
+void               DecompressTexture           (loaded_texture *Texture, memory_arena *Arena);
\ No newline at end of file
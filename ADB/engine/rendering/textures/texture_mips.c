@@ -0,0 +1,734 @@
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "texture_mips.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_SSE2 1
+#include <emmintrin.h>
+#else
+#define MIP_SSE2 0
+#endif
+
+// Bands are sized by destination pixels, small enough that a single large texture still spreads
+// over every worker.
+#define MIP_BAND_PIXEL_COUNT 16384
+#define MIP_MAX_JOB_COUNT    64
+
+// ==============================================
+// <Pixels> : INTERNAL
+// ==============================================
+
+// Filtering works on one RGBA pixel at a time, as four floats in [0, 1]. Colors are converted to
+// linear light on the way in and back on the way out.
+
+
+typedef struct
+{
+	float   SRGBToLinear[256];
+	float   UNormToFloat[256];
+
+	// Indexed by sqrt(linear) * (count - 1): spreads the entries evenly over the sRGB curve, so the
+	// lookup rounds to the same byte as the exact conversion.
+	uint8_t LinearToSRGB[4096];
+} mip_tables;
+
+
+static void
+BuildMipTables(mip_tables *Tables)
+{
+	for (uint32_t Idx = 0; Idx < 256; ++Idx)
+	{
+		float Value = (float)Idx / 255.0f;
+
+		Tables->UNormToFloat[Idx] = Value;
+		Tables->SRGBToLinear[Idx] = Value <= 0.04045f ? Value / 12.92f : powf((Value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	for (uint32_t Idx = 0; Idx < ArrayCount(Tables->LinearToSRGB); ++Idx)
+	{
+		float Root   = (float)Idx / (float)(ArrayCount(Tables->LinearToSRGB) - 1);
+		float Linear = Root * Root;
+		float SRGB   = Linear <= 0.0031308f ? Linear * 12.92f : 1.055f * powf(Linear, 1.0f / 2.4f) - 0.055f;
+
+		Tables->LinearToSRGB[Idx] = (uint8_t)(SRGB * 255.0f + 0.5f);
+	}
+}
+
+
+#if MIP_SSE2
+
+typedef __m128 mip_pixel;
+
+
+static mip_pixel
+DecodePixel(uint8_t *At, float *ColorTable, float *AlphaTable)
+{
+	mip_pixel Result = _mm_setr_ps(ColorTable[At[0]], ColorTable[At[1]], ColorTable[At[2]], AlphaTable[At[3]]);
+	return Result;
+}
+
+
+static mip_pixel
+AddPixel(mip_pixel A, mip_pixel B)
+{
+	mip_pixel Result = _mm_add_ps(A, B);
+	return Result;
+}
+
+
+static mip_pixel
+ScalePixel(mip_pixel A, float Scale)
+{
+	mip_pixel Result = _mm_mul_ps(A, _mm_set1_ps(Scale));
+	return Result;
+}
+
+
+static mip_pixel
+MultiplyAddPixel(mip_pixel Sum, mip_pixel A, float Scale)
+{
+	mip_pixel Result = _mm_add_ps(Sum, _mm_mul_ps(A, _mm_set1_ps(Scale)));
+	return Result;
+}
+
+
+static mip_pixel
+ZeroPixel(void)
+{
+	mip_pixel Result = _mm_setzero_ps();
+	return Result;
+}
+
+
+static void
+EncodePixel(mip_pixel Pixel, uint8_t *Out, mip_tables *Tables, bool IsSRGB)
+{
+	Pixel = _mm_min_ps(_mm_max_ps(Pixel, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+
+	__m128i UNorm  = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Pixel, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+	__m128i Packed = _mm_packus_epi16(_mm_packs_epi32(UNorm, UNorm), _mm_setzero_si128());
+
+	uint32_t Value = (uint32_t)_mm_cvtsi128_si32(Packed);
+	memcpy(Out, &Value, 4);
+
+	if (IsSRGB)
+	{
+		float   Scale = (float)(ArrayCount(Tables->LinearToSRGB) - 1);
+		__m128i Index = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sqrt_ps(Pixel), _mm_set1_ps(Scale)), _mm_set1_ps(0.5f)));
+
+		uint32_t Indices[4];
+		_mm_storeu_si128((__m128i *)Indices, Index);
+
+		Out[0] = Tables->LinearToSRGB[Indices[0]];
+		Out[1] = Tables->LinearToSRGB[Indices[1]];
+		Out[2] = Tables->LinearToSRGB[Indices[2]];
+	}
+}
+
+#else
+
+typedef struct
+{
+	float E[4];
+} mip_pixel;
+
+
+static mip_pixel
+DecodePixel(uint8_t *At, float *ColorTable, float *AlphaTable)
+{
+	mip_pixel Result = {{ColorTable[At[0]], ColorTable[At[1]], ColorTable[At[2]], AlphaTable[At[3]]}};
+	return Result;
+}
+
+
+static mip_pixel
+AddPixel(mip_pixel A, mip_pixel B)
+{
+	mip_pixel Result = {{A.E[0] + B.E[0], A.E[1] + B.E[1], A.E[2] + B.E[2], A.E[3] + B.E[3]}};
+	return Result;
+}
+
+
+static mip_pixel
+ScalePixel(mip_pixel A, float Scale)
+{
+	mip_pixel Result = {{A.E[0] * Scale, A.E[1] * Scale, A.E[2] * Scale, A.E[3] * Scale}};
+	return Result;
+}
+
+
+static mip_pixel
+MultiplyAddPixel(mip_pixel Sum, mip_pixel A, float Scale)
+{
+	mip_pixel Result = AddPixel(Sum, ScalePixel(A, Scale));
+	return Result;
+}
+
+
+static mip_pixel
+ZeroPixel(void)
+{
+	mip_pixel Result = {0};
+	return Result;
+}
+
+
+static void
+EncodePixel(mip_pixel Pixel, uint8_t *Out, mip_tables *Tables, bool IsSRGB)
+{
+	float Scale = (float)(ArrayCount(Tables->LinearToSRGB) - 1);
+
+	for (uint32_t Channel = 0; Channel < 4; ++Channel)
+	{
+		float Value = Pixel.E[Channel] < 0.0f ? 0.0f : (Pixel.E[Channel] > 1.0f ? 1.0f : Pixel.E[Channel]);
+
+		if (IsSRGB && Channel < 3)
+		{
+			Out[Channel] = Tables->LinearToSRGB[(uint32_t)(sqrtf(Value) * Scale + 0.5f)];
+		}
+		else
+		{
+			Out[Channel] = (uint8_t)(Value * 255.0f + 0.5f);
+		}
+	}
+}
+
+#endif
+
+// ==============================================
+// <Filters> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+	mip_tables     Tables;
+	MipFilter_Type Filter;
+
+	// Kaiser taps for source texels at -3.5 .. +3.5 from the destination texel center, in source
+	// texel units. The same for every pixel since each level is exactly half the previous one.
+	float          Weights[8];
+} mip_filter;
+
+
+static double
+BesselI0(double X)
+{
+	double Result = 1.0;
+	double Term   = 1.0;
+
+	for (uint32_t K = 1; K < 32; ++K)
+	{
+		Term   *= (X / (2.0 * K)) * (X / (2.0 * K));
+		Result += Term;
+	}
+
+	return Result;
+}
+
+
+static void
+BuildMipFilter(mip_filter *Filter, MipFilter_Type Type)
+{
+	// Half-band sinc for the 2x reduction, windowed over +-4 source texels with alpha = 4.
+
+	double Alpha = 4.0;
+	double Total = 0.0;
+
+	for (uint32_t Tap = 0; Tap < 8; ++Tap)
+	{
+		double Distance = (double)Tap - 3.5;
+		double X        = Distance * 0.5 * 3.14159265358979323846;
+		double Sinc     = X != 0.0 ? sin(X) / X : 1.0;
+		double Window   = BesselI0(Alpha * sqrt(1.0 - (Distance / 4.0) * (Distance / 4.0))) / BesselI0(Alpha);
+
+		Filter->Weights[Tap] = (float)(Sinc * Window);
+		Total               += Sinc * Window;
+	}
+
+	for (uint32_t Tap = 0; Tap < 8; ++Tap)
+	{
+		Filter->Weights[Tap] = (float)(Filter->Weights[Tap] / Total);
+	}
+
+	Filter->Filter = Type;
+	BuildMipTables(&Filter->Tables);
+}
+
+
+static uint32_t
+ClampIndex(int32_t Index, uint32_t Count)
+{
+	uint32_t Result = Index < 0 ? 0 : ((uint32_t)Index >= Count ? Count - 1 : (uint32_t)Index);
+	return Result;
+}
+
+
+static void
+FilterBandBox(mip_filter *Filter, texture_mip Source, texture_mip Dest, uint32_t FirstRow, uint32_t RowCount, bool IsSRGB)
+{
+	float *ColorTable = IsSRGB ? Filter->Tables.SRGBToLinear : Filter->Tables.UNormToFloat;
+	float *AlphaTable = Filter->Tables.UNormToFloat;
+
+	// Odd sizes drop their last row or column, the usual power-of-two-down convention.
+
+	for (uint32_t Y = FirstRow; Y < FirstRow + RowCount; ++Y)
+	{
+		uint8_t *Row0 = Source.Data + (uint64_t)ClampIndex(Y * 2 + 0, Source.Height) * Source.Width * 4;
+		uint8_t *Row1 = Source.Data + (uint64_t)ClampIndex(Y * 2 + 1, Source.Height) * Source.Width * 4;
+		uint8_t *Out  = Dest.Data   + (uint64_t)Y * Dest.Width * 4;
+
+		for (uint32_t X = 0; X < Dest.Width; ++X)
+		{
+			uint32_t X0 = ClampIndex(X * 2 + 0, Source.Width) * 4;
+			uint32_t X1 = ClampIndex(X * 2 + 1, Source.Width) * 4;
+
+			mip_pixel Sum = AddPixel(AddPixel(DecodePixel(Row0 + X0, ColorTable, AlphaTable), DecodePixel(Row0 + X1, ColorTable, AlphaTable)),
+			                         AddPixel(DecodePixel(Row1 + X0, ColorTable, AlphaTable), DecodePixel(Row1 + X1, ColorTable, AlphaTable)));
+
+			EncodePixel(ScalePixel(Sum, 0.25f), Out + X * 4, &Filter->Tables, IsSRGB);
+		}
+	}
+}
+
+
+// Scratch holds 8 horizontally filtered rows (Dest.Width each) plus one decoded source row.
+
+static uint64_t
+GetKaiserScratchCount(uint32_t SourceWidth, uint32_t DestWidth)
+{
+	uint64_t Result = (uint64_t)DestWidth * 8 + SourceWidth;
+	return Result;
+}
+
+
+static void
+FilterBandKaiser(mip_filter *Filter, texture_mip Source, texture_mip Dest, uint32_t FirstRow, uint32_t RowCount, bool IsSRGB, mip_pixel *Scratch)
+{
+	float     *ColorTable = IsSRGB ? Filter->Tables.SRGBToLinear : Filter->Tables.UNormToFloat;
+	float     *AlphaTable = Filter->Tables.UNormToFloat;
+	mip_pixel *Decoded    = Scratch + (uint64_t)Dest.Width * 8;
+	int32_t    RingRows[8];
+
+	// Source row R lives in ring slot R & 7. The 8 rows one output row needs are consecutive, so
+	// they never collide, and moving down one output row only filters two new ones.
+
+	for (uint32_t Slot = 0; Slot < 8; ++Slot)
+	{
+		RingRows[Slot] = -1;
+	}
+
+	for (uint32_t Y = FirstRow; Y < FirstRow + RowCount; ++Y)
+	{
+		uint32_t SourceRows[8];
+
+		for (uint32_t Tap = 0; Tap < 8; ++Tap)
+		{
+			uint32_t SourceY = ClampIndex((int32_t)(Y * 2 + Tap) - 3, Source.Height);
+			uint32_t Slot    = SourceY & 7;
+
+			SourceRows[Tap] = SourceY;
+
+			if (RingRows[Slot] != (int32_t)SourceY)
+			{
+				uint8_t   *In  = Source.Data + (uint64_t)SourceY * Source.Width * 4;
+				mip_pixel *Row = Scratch + (uint64_t)Slot * Dest.Width;
+
+				for (uint32_t X = 0; X < Source.Width; ++X)
+				{
+					Decoded[X] = DecodePixel(In + X * 4, ColorTable, AlphaTable);
+				}
+
+				for (uint32_t X = 0; X < Dest.Width; ++X)
+				{
+					mip_pixel Sum = ZeroPixel();
+
+					for (uint32_t XTap = 0; XTap < 8; ++XTap)
+					{
+						Sum = MultiplyAddPixel(Sum, Decoded[ClampIndex((int32_t)(X * 2 + XTap) - 3, Source.Width)], Filter->Weights[XTap]);
+					}
+
+					Row[X] = Sum;
+				}
+
+				RingRows[Slot] = (int32_t)SourceY;
+			}
+		}
+
+		uint8_t *Out = Dest.Data + (uint64_t)Y * Dest.Width * 4;
+
+		for (uint32_t X = 0; X < Dest.Width; ++X)
+		{
+			mip_pixel Sum = ZeroPixel();
+
+			for (uint32_t Tap = 0; Tap < 8; ++Tap)
+			{
+				Sum = MultiplyAddPixel(Sum, Scratch[(uint64_t)(SourceRows[Tap] & 7) * Dest.Width + X], Filter->Weights[Tap]);
+			}
+
+			EncodePixel(Sum, Out + X * 4, &Filter->Tables, IsSRGB);
+		}
+	}
+}
+
+
+static void
+FilterBand(mip_filter *Filter, loaded_texture *Texture, uint32_t Level, uint32_t FirstRow, uint32_t RowCount, mip_pixel *Scratch)
+{
+	texture_mip Source = GetTextureMip(Texture, Level - 1);
+	texture_mip Dest   = GetTextureMip(Texture, Level);
+
+	if (Filter->Filter == MipFilter_Kaiser)
+	{
+		FilterBandKaiser(Filter, Source, Dest, FirstRow, RowCount, Texture->IsSRGB, Scratch);
+	}
+	else
+	{
+		FilterBandBox(Filter, Source, Dest, FirstRow, RowCount, Texture->IsSRGB);
+	}
+}
+
+
+static bool
+CanGenerateMips(loaded_texture *Texture)
+{
+	bool Result = Texture && Texture->Data && Texture->Width && Texture->Height && Texture->Format == TextureFormat_RGBA8 &&
+	              Texture->BytesPerPixel == 4 && Texture->MipCount <= 1;
+	return Result;
+}
+
+// ==============================================
+// <Jobs> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+	loaded_texture *Texture;
+	uint32_t        FirstRow;
+	uint32_t        RowCount;
+} mip_band;
+
+
+typedef struct
+{
+	mip_filter *Filter;
+	uint32_t    Level;
+	mip_band   *Bands;
+	uint32_t    BandCount;
+	uint32_t    NextBand;
+} mip_level_work;
+
+
+typedef struct
+{
+	mip_level_work *Work;
+	mip_pixel      *Scratch;
+} mip_job;
+
+
+static void
+MipBandJob(platform_work_queue *Queue, void *Data)
+{
+	(void)Queue;
+
+	mip_job        *Job  = (mip_job *)Data;
+	mip_level_work *Work = Job->Work;
+
+	for (;;)
+	{
+		uint32_t Ticket = AtomicIncrement32(&Work->NextBand) - 1;
+		if (Ticket >= Work->BandCount)
+		{
+			break;
+		}
+
+		mip_band *Band = Work->Bands + Ticket;
+		FilterBand(Work->Filter, Band->Texture, Work->Level, Band->FirstRow, Band->RowCount, Job->Scratch);
+	}
+}
+
+// ==============================================
+// <Mip Chains> : PUBLIC
+// ==============================================
+
+
+uint32_t
+GetMipCount(uint32_t Width, uint32_t Height)
+{
+	uint32_t Result  = 1;
+	uint32_t Largest = Maximum(Width, Height);
+
+	while (Largest > 1 && Result < MAX_TEXTURE_MIP_COUNT)
+	{
+		Largest >>= 1;
+		++Result;
+	}
+
+	return Result;
+}
+
+
+uint64_t
+GetMipChainSize(uint32_t Width, uint32_t Height, uint32_t BytesPerPixel)
+{
+	uint64_t Result = 0;
+	uint32_t Count  = GetMipCount(Width, Height);
+
+	for (uint32_t Level = 0; Level < Count; ++Level)
+	{
+		Result += (uint64_t)Width * Height * BytesPerPixel;
+
+		Width  = Maximum(Width  >> 1, 1);
+		Height = Maximum(Height >> 1, 1);
+	}
+
+	return Result;
+}
+
+
+texture_mip
+GetTextureMip(loaded_texture *Texture, uint32_t Level)
+{
+	texture_mip Result = {0};
+
+	if (Texture && Texture->Data && Level < Maximum(Texture->MipCount, 1))
+	{
+		uint32_t BlockSize = GetFormatBlockSize(Texture->Format);
+
+		Result.Data   = Texture->Data;
+		Result.Width  = Texture->Width;
+		Result.Height = Texture->Height;
+
+		for (uint32_t Idx = 0; Idx < Level; ++Idx)
+		{
+			if (BlockSize)
+			{
+				Result.Data += GetMipSize(Result.Width, Result.Height, Texture->Format);
+			}
+			else
+			{
+				Result.Data += (uint64_t)Result.Width * Result.Height * Texture->BytesPerPixel;
+			}
+
+			Result.Width  = Maximum(Result.Width  >> 1, 1);
+			Result.Height = Maximum(Result.Height >> 1, 1);
+		}
+
+		Result.Pitch = BlockSize ? ((Result.Width + 3) / 4) * BlockSize : Result.Width * Texture->BytesPerPixel;
+	}
+
+	return Result;
+}
+
+
+uint32_t
+GetFormatBlockSize(TextureFormat_Type Format)
+{
+	uint32_t Result = 0;
+
+	switch (Format)
+	{
+
+	case TextureFormat_BC1:
+	case TextureFormat_BC4:
+	{
+		Result = 8;
+	} break;
+
+	case TextureFormat_BC3:
+	case TextureFormat_BC5:
+	case TextureFormat_BC7:
+	{
+		Result = 16;
+	} break;
+
+	default:
+	{
+	} break;
+
+	}
+
+	return Result;
+}
+
+
+uint64_t
+GetMipSize(uint32_t Width, uint32_t Height, TextureFormat_Type Format)
+{
+	uint32_t BlockSize = GetFormatBlockSize(Format);
+	uint64_t Result    = 0;
+
+	if (BlockSize)
+	{
+		Result = (uint64_t)((Width + 3) / 4) * ((Height + 3) / 4) * BlockSize;
+	}
+	else
+	{
+		Result = (uint64_t)Width * Height * 4;
+	}
+
+	return Result;
+}
+
+
+uint64_t
+GetTextureDataSize(uint32_t Width, uint32_t Height, TextureFormat_Type Format, uint32_t MipCount)
+{
+	uint64_t Result = 0;
+
+	for (uint32_t Level = 0; Level < Maximum(MipCount, 1); ++Level)
+	{
+		Result += GetMipSize(Width, Height, Format);
+
+		Width  = Maximum(Width  >> 1, 1);
+		Height = Maximum(Height >> 1, 1);
+	}
+
+	return Result;
+}
+
+
+void
+GenerateMipChain(loaded_texture *Texture, MipFilter_Type Filter, memory_arena *Arena)
+{
+	if (CanGenerateMips(Texture))
+	{
+		memory_region Region = EnterMemoryRegion(Arena);
+
+		mip_filter *MipFilter = PushStruct(Arena, mip_filter);
+		mip_pixel  *Scratch   = 0;
+
+		BuildMipFilter(MipFilter, Filter);
+
+		if (Filter == MipFilter_Kaiser)
+		{
+			Scratch = PushArrayAligned(Arena, mip_pixel, GetKaiserScratchCount(Texture->Width, Maximum(Texture->Width >> 1, 1)), 16);
+		}
+
+		Texture->MipCount = GetMipCount(Texture->Width, Texture->Height);
+
+		for (uint32_t Level = 1; Level < Texture->MipCount; ++Level)
+		{
+			FilterBand(MipFilter, Texture, Level, 0, GetTextureMip(Texture, Level).Height, Scratch);
+		}
+
+		LeaveMemoryRegion(Region);
+	}
+}
+
+
+void
+GenerateMipChains(loaded_texture **Textures, uint32_t Count, MipFilter_Type Filter, engine_memory *EngineMemory)
+{
+	assert(EngineMemory);
+
+	memory_arena  *Arena  = EngineMemory->FrameMemory;
+	memory_region  Region = EnterMemoryRegion(Arena);
+
+	mip_filter *MipFilter = PushStruct(Arena, mip_filter);
+	BuildMipFilter(MipFilter, Filter);
+
+	loaded_texture **Pending      = PushArray(Arena, loaded_texture *, Count);
+	uint32_t         PendingCount = 0;
+	uint32_t         LevelCount   = 0;
+	uint32_t         MaxWidth     = 1;
+
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		if (CanGenerateMips(Textures[Idx]))
+		{
+			Textures[Idx]->MipCount = GetMipCount(Textures[Idx]->Width, Textures[Idx]->Height);
+			Pending[PendingCount++] = Textures[Idx];
+
+			LevelCount = Maximum(LevelCount, Textures[Idx]->MipCount);
+			MaxWidth   = Maximum(MaxWidth, Textures[Idx]->Width);
+		}
+	}
+
+	uint32_t JobCount = Minimum(OSGetProcessorCount() + 1, MIP_MAX_JOB_COUNT);
+	mip_job *Jobs     = PushArray(Arena, mip_job, JobCount);
+
+	for (uint32_t JobIdx = 0; JobIdx < JobCount; ++JobIdx)
+	{
+		Jobs[JobIdx].Scratch = 0;
+
+		if (Filter == MipFilter_Kaiser)
+		{
+			Jobs[JobIdx].Scratch = PushArrayAligned(Arena, mip_pixel, GetKaiserScratchCount(MaxWidth, Maximum(MaxWidth >> 1, 1)), 16);
+		}
+	}
+
+	// Every level reads the one above it, so levels are a barrier. Within a level, all textures'
+	// bands go out together.
+
+	for (uint32_t Level = 1; Level < LevelCount; ++Level)
+	{
+		memory_region LevelRegion = EnterMemoryRegion(Arena);
+
+		uint32_t BandCount = 0;
+		for (uint32_t Idx = 0; Idx < PendingCount; ++Idx)
+		{
+			if (Level < Pending[Idx]->MipCount)
+			{
+				texture_mip Mip         = GetTextureMip(Pending[Idx], Level);
+				uint32_t    RowsPerBand = Maximum(MIP_BAND_PIXEL_COUNT / Mip.Width, 1);
+
+				BandCount += (Mip.Height + RowsPerBand - 1) / RowsPerBand;
+			}
+		}
+
+		mip_level_work *Work = PushStruct(Arena, mip_level_work);
+		Work->Filter    = MipFilter;
+		Work->Level     = Level;
+		Work->Bands     = PushArray(Arena, mip_band, BandCount);
+		Work->BandCount = 0;
+		Work->NextBand  = 0;
+
+		for (uint32_t Idx = 0; Idx < PendingCount; ++Idx)
+		{
+			if (Level < Pending[Idx]->MipCount)
+			{
+				texture_mip Mip         = GetTextureMip(Pending[Idx], Level);
+				uint32_t    RowsPerBand = Maximum(MIP_BAND_PIXEL_COUNT / Mip.Width, 1);
+
+				for (uint32_t Row = 0; Row < Mip.Height; Row += RowsPerBand)
+				{
+					mip_band *Band = Work->Bands + Work->BandCount++;
+					Band->Texture  = Pending[Idx];
+					Band->FirstRow = Row;
+					Band->RowCount = Minimum(RowsPerBand, Mip.Height - Row);
+				}
+			}
+		}
+
+		// No more jobs than bands, the last one runs on this thread while the others are picked up.
+
+		uint32_t    LevelJobCount = Minimum(JobCount, Work->BandCount);
+		job_counter LevelDone     = {0};
+
+		for (uint32_t JobIdx = 0; JobIdx < LevelJobCount; ++JobIdx)
+		{
+			Jobs[JobIdx].Work = Work;
+
+			if (JobIdx + 1 < LevelJobCount)
+			{
+				EngineMemory->AddJob(EngineMemory->WorkQueue, JobPriority_Background, "mip band", MipBandJob, Jobs + JobIdx, &LevelDone);
+			}
+		}
+
+		if (LevelJobCount)
+		{
+			MipBandJob(EngineMemory->WorkQueue, Jobs + LevelJobCount - 1);
+			EngineMemory->WaitForCounter(EngineMemory->WorkQueue, &LevelDone);
+		}
+
+		LeaveMemoryRegion(LevelRegion);
+	}
+
+	LeaveMemoryRegion(Region);
+}
\ No newline at end of file
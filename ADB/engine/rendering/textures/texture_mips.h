@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "engine/rendering/assets.h"
+
+// ==============================================
+// <Mip Chains>
+// ==============================================
+
+// A texture with MipCount > 1 stores its levels back to back in Data, largest first, each level
+// half the size of the previous one (rounded down, at least 1). In the block formats a level
+// takes whole 4x4 blocks, even the ones smaller than a block. Only RGBA8 textures that do not
+// have mips yet are filtered. Color data (IsSRGB) is averaged in linear space, alpha and
+// non-color data as they are.
+
+#define MAX_TEXTURE_MIP_COUNT 16
+
+typedef struct engine_memory engine_memory;
+
+
+typedef enum
+{
+	MipFilter_Box    = 0, // 2x2 average, cheap enough for load time.
+	MipFilter_Kaiser = 1, // 8-tap Kaiser-windowed sinc, sharper, meant for offline baking.
+} MipFilter_Type;
+
+
+typedef struct
+{
+	uint8_t *Data;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t Pitch;   // Bytes from one row to the next, rows of blocks in the block formats.
+} texture_mip;
+
+
+uint32_t    GetMipCount        (uint32_t Width, uint32_t Height);
+uint64_t    GetMipChainSize    (uint32_t Width, uint32_t Height, uint32_t BytesPerPixel);
+texture_mip GetTextureMip      (loaded_texture *Texture, uint32_t Level);
+
+// Sizes in the given format, RGBA8 counts 4 bytes per texel. GetFormatBlockSize is the size of
+// a 4x4 block, 0 for RGBA8.
+
+uint32_t    GetFormatBlockSize (TextureFormat_Type Format);
+uint64_t    GetMipSize         (uint32_t Width, uint32_t Height, TextureFormat_Type Format);
+uint64_t    GetTextureDataSize (uint32_t Width, uint32_t Height, TextureFormat_Type Format, uint32_t MipCount);
+
+// Both expect Data to have room for GetMipChainSize bytes and fill in every level below the first.
+// GenerateMipChain runs on the calling thread and may be used from inside a job. GenerateMipChains
+// splits each level of every texture into row bands and runs them on the work queue, level by
+// level, so it must be called from the thread that owns the queue. Arena provides scratch.
+
+void        GenerateMipChain   (loaded_texture *Texture, MipFilter_Type Filter, memory_arena *Arena);
+void        GenerateMipChains  (loaded_texture **Textures, uint32_t Count, MipFilter_Type Filter, engine_memory *EngineMemory);
\ No newline at end of file
@@ -0,0 +1,540 @@
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "texture_pack.h"
+#include "texture_mips.h"
+#include "texture_cache.h"
+
+#define PACK_MAX_JOB_COUNT 64
+
+// ==============================================
+// <Layout> : INTERNAL
+// ==============================================
+
+// Where each channel of a packed texture is copied from. The modulator, when the material has one,
+// is multiplied into RGB afterwards.
+
+
+typedef struct
+{
+	MaterialMap_Type Map;
+	uint32_t         Channel;
+} pack_channel;
+
+
+static const pack_channel PackLayouts[MaterialTexture_Count][4] =
+{
+	[MaterialTexture_Albedo]  = {{MaterialMap_Color,  0}, {MaterialMap_Color,  1}, {MaterialMap_Color,     2}, {MaterialMap_Color,     3}},
+	[MaterialTexture_Surface] = {{MaterialMap_Normal, 0}, {MaterialMap_Normal, 1}, {MaterialMap_Roughness, 0}, {MaterialMap_Metalness, 0}},
+};
+
+
+static const MaterialMap_Type PackModulators[MaterialTexture_Count] =
+{
+	[MaterialTexture_Albedo]  = MaterialMap_Occlusion,
+	[MaterialTexture_Surface] = MaterialMap_Count,
+};
+
+
+static bool
+IsPackedFrom(MaterialTexture_Type Type, MaterialMap_Type Map)
+{
+	bool Result = PackModulators[Type] == Map;
+
+	for (uint32_t Channel = 0; Channel < 4 && !Result; ++Channel)
+	{
+		Result = PackLayouts[Type][Channel].Map == Map;
+	}
+
+	return Result;
+}
+
+
+static void
+GetPackDefaults(material_data *Material, MaterialTexture_Type Type, uint8_t *Defaults)
+{
+	if (Type == MaterialTexture_Surface)
+	{
+		// The usual Blinn-Phong to GGX mapping, Ns = 2 / r^2 - 2 with r the perceptual roughness.
+
+		float Shininess = Maximum(Material->Shininess, 0.0f);
+		float Roughness = sqrtf(2.0f / (Shininess + 2.0f));
+
+		Defaults[0] = 128;
+		Defaults[1] = 128;
+		Defaults[2] = (uint8_t)(Roughness * 255.0f + 0.5f);
+		Defaults[3] = 0;
+	}
+	else
+	{
+		memset(Defaults, 0xFF, 4);
+	}
+}
+
+// ==============================================
+// <Packing> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+	MaterialTexture_Type  Type;
+	loaded_texture       *Output;
+	texture_to_load      *Sources[MaterialMap_Count]; // Only the maps this texture is packed from.
+	uint8_t               Defaults[4];
+	uint64_t              CacheKey;                   // 0 when the texture cache is not used.
+
+	// Room for the RGBA8 chain at Width x Height, which is as large as anything the cache holds.
+	// Sources are shared (textures/texture_sources.h), a lone color map is copied rather than mipped
+	// in place, and Row is then not needed.
+	uint8_t              *Memory;
+	uint64_t              MemorySize;
+	uint8_t              *Row;
+	uint32_t              Width;
+	uint32_t              Height;
+	bool                  IsCopy;
+	bool                  IsCached;
+} pack_task;
+
+
+// Each phase waits on the previous one: the lookups decide which sources must be decoded, and every
+// source is decoded once however many tasks it feeds. Only the lookups are waited on here, packing
+// is held on the decode counter and starts as soon as the last decode is done.
+
+typedef enum
+{
+	PackPhase_Lookup = 0,
+	PackPhase_Decode = 1,
+	PackPhase_Pack   = 2,
+	PackPhase_Count  = 3,
+} PackPhase_Type;
+
+
+typedef struct pack_work pack_work;
+
+typedef struct
+{
+	pack_work        *Work;
+	PackPhase_Type    Phase;
+	uint32_t          ItemCount;
+	uint32_t          NextItem;
+	job_counter       Done;
+} pack_phase;
+
+
+typedef struct pack_work
+{
+	pack_phase        Phases[PackPhase_Count];
+
+	pack_task        *Tasks;
+	texture_to_load **Decodes;
+
+	// Occlusion[A][C] is the sRGB value C darkened by the occlusion A, only built when some material
+	// has an occlusion map.
+	uint8_t         (*Occlusion)[256];
+} pack_work;
+
+
+static void
+BuildOcclusionTable(uint8_t (*Table)[256])
+{
+	float SRGBToLinear[256];
+
+	for (uint32_t Idx = 0; Idx < 256; ++Idx)
+	{
+		float Value = (float)Idx / 255.0f;
+		SRGBToLinear[Idx] = Value <= 0.04045f ? Value / 12.92f : powf((Value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	for (uint32_t Occlusion = 0; Occlusion < 256; ++Occlusion)
+	{
+		for (uint32_t Color = 0; Color < 256; ++Color)
+		{
+			float Linear = SRGBToLinear[Color] * ((float)Occlusion / 255.0f);
+			float SRGB   = Linear <= 0.0031308f ? Linear * 12.92f : 1.055f * powf(Linear, 1.0f / 2.4f) - 0.055f;
+
+			Table[Occlusion][Color] = (uint8_t)(SRGB * 255.0f + 0.5f);
+		}
+	}
+}
+
+
+// Row Y of Source at Width x Height. Bilinear on the stored values, sRGB included, sources of a
+// different size are rare enough that the error does not matter.
+
+static void
+LoadSourceRow(loaded_texture *Source, uint32_t Y, uint32_t Width, uint32_t Height, uint8_t *Row)
+{
+	if (Source->Width == Width && Source->Height == Height)
+	{
+		memcpy(Row, Source->Data + (uint64_t)Y * Width * 4, (uint64_t)Width * 4);
+	}
+	else
+	{
+		float    SourceY = Maximum(((float)Y + 0.5f) * (float)Source->Height / (float)Height - 0.5f, 0.0f);
+		uint32_t Y0      = Minimum((uint32_t)SourceY, Source->Height - 1);
+		uint32_t Y1      = Minimum(Y0 + 1, Source->Height - 1);
+		float    FY      = SourceY - (float)Y0;
+
+		uint8_t *Row0 = Source->Data + (uint64_t)Y0 * Source->Width * 4;
+		uint8_t *Row1 = Source->Data + (uint64_t)Y1 * Source->Width * 4;
+
+		for (uint32_t X = 0; X < Width; ++X)
+		{
+			float    SourceX = Maximum(((float)X + 0.5f) * (float)Source->Width / (float)Width - 0.5f, 0.0f);
+			uint32_t X0      = Minimum((uint32_t)SourceX, Source->Width - 1);
+			uint32_t X1      = Minimum(X0 + 1, Source->Width - 1);
+			float    FX      = SourceX - (float)X0;
+
+			for (uint32_t Channel = 0; Channel < 4; ++Channel)
+			{
+				float Top    = Row0[X0 * 4 + Channel] + (Row0[X1 * 4 + Channel] - Row0[X0 * 4 + Channel]) * FX;
+				float Bottom = Row1[X0 * 4 + Channel] + (Row1[X1 * 4 + Channel] - Row1[X0 * 4 + Channel]) * FX;
+
+				Row[X * 4 + Channel] = (uint8_t)(Top + (Bottom - Top) * FY + 0.5f);
+			}
+		}
+	}
+}
+
+
+static void
+PackRows(pack_task *Task, loaded_texture **Maps, uint8_t (*Occlusion)[256])
+{
+	const pack_channel *Layout    = PackLayouts[Task->Type];
+	MaterialMap_Type    Modulator = PackModulators[Task->Type];
+
+	for (uint32_t Y = 0; Y < Task->Height; ++Y)
+	{
+		uint8_t *Out = Task->Memory + (uint64_t)Y * Task->Width * 4;
+
+		for (uint32_t X = 0; X < Task->Width; ++X)
+		{
+			memcpy(Out + X * 4, Task->Defaults, 4);
+		}
+
+		// One source row at a time, each is scattered into the channels it feeds.
+
+		for (uint32_t Map = 0; Map < MaterialMap_Count; ++Map)
+		{
+			if (Maps[Map] && Map != Modulator)
+			{
+				LoadSourceRow(Maps[Map], Y, Task->Width, Task->Height, Task->Row);
+
+				for (uint32_t Channel = 0; Channel < 4; ++Channel)
+				{
+					if (Layout[Channel].Map == (MaterialMap_Type)Map)
+					{
+						for (uint32_t X = 0; X < Task->Width; ++X)
+						{
+							Out[X * 4 + Channel] = Task->Row[X * 4 + Layout[Channel].Channel];
+						}
+					}
+				}
+			}
+		}
+
+		if (Modulator < MaterialMap_Count && Maps[Modulator] && Occlusion)
+		{
+			LoadSourceRow(Maps[Modulator], Y, Task->Width, Task->Height, Task->Row);
+
+			for (uint32_t X = 0; X < Task->Width; ++X)
+			{
+				uint8_t *Darken = Occlusion[Task->Row[X * 4]];
+
+				Out[X * 4 + 0] = Darken[Out[X * 4 + 0]];
+				Out[X * 4 + 1] = Darken[Out[X * 4 + 1]];
+				Out[X * 4 + 2] = Darken[Out[X * 4 + 2]];
+			}
+		}
+	}
+}
+
+
+static void
+RunPackTask(pack_task *Task, uint8_t (*Occlusion)[256])
+{
+	// Maps that failed to decode are treated as missing.
+
+	loaded_texture *Maps[MaterialMap_Count] = {0};
+	bool            AnyDecoded              = false;
+
+	for (uint32_t Map = 0; Map < MaterialMap_Count; ++Map)
+	{
+		if (Task->Sources[Map] && Task->Sources[Map]->Output->Data)
+		{
+			Maps[Map]  = Task->Sources[Map]->Output;
+			AnyDecoded = true;
+		}
+	}
+
+	if (AnyDecoded)
+	{
+		loaded_texture *Output   = Task->Output;
+		bool            HasAlpha = false;
+
+		if (Task->IsCopy)
+		{
+			memcpy(Task->Memory, Maps[MaterialMap_Color]->Data, (uint64_t)Task->Width * Task->Height * 4);
+			HasAlpha = Maps[MaterialMap_Color]->HasAlpha;
+		}
+		else
+		{
+			PackRows(Task, Maps, Occlusion);
+
+			uint64_t PixelCount = (uint64_t)Task->Width * Task->Height;
+			for (uint64_t Idx = 0; Idx < PixelCount && !HasAlpha; ++Idx)
+			{
+				HasAlpha = Task->Memory[Idx * 4 + 3] != 0xFF;
+			}
+		}
+
+		Output->Data          = Task->Memory;
+		Output->Width         = Task->Width;
+		Output->Height        = Task->Height;
+		Output->BytesPerPixel = 4;
+		Output->MipCount      = 1;
+		Output->Format        = TextureFormat_RGBA8;
+		Output->HasAlpha      = HasAlpha;
+		Output->CacheKey      = Task->CacheKey;
+	}
+}
+
+
+static void
+PackTextureJob(platform_work_queue *Queue, void *Data)
+{
+	(void)Queue;
+
+	pack_phase *Phase = (pack_phase *)Data;
+	pack_work  *Work  = Phase->Work;
+
+	for (;;)
+	{
+		uint32_t Ticket = AtomicIncrement32(&Phase->NextItem) - 1;
+		if (Ticket >= Phase->ItemCount)
+		{
+			break;
+		}
+
+		switch (Phase->Phase)
+		{
+
+		case PackPhase_Lookup:
+		{
+			pack_task *Task = Work->Tasks + Ticket;
+			Task->IsCached  = Task->CacheKey && LoadCachedTexture(Task->CacheKey, Task->Output, Task->Memory, Task->MemorySize);
+		} break;
+
+		case PackPhase_Decode:
+		{
+			DecodeTexture(Work->Decodes[Ticket]);
+		} break;
+
+		case PackPhase_Pack:
+		{
+			if (!Work->Tasks[Ticket].IsCached)
+			{
+				RunPackTask(Work->Tasks + Ticket, Work->Occlusion);
+			}
+		} break;
+
+		default:
+		{
+			assert(!"Not a pack phase");
+		} break;
+
+		}
+	}
+}
+
+
+// Every job drains the same tickets. The thread that waits on Done runs them as well, nothing is
+// kept back for it.
+
+static void
+StartPackPhase(pack_work *Work, PackPhase_Type Type, uint32_t ItemCount, job_counter *Dependency, engine_memory *EngineMemory)
+{
+	pack_phase *Phase = Work->Phases + Type;
+
+	Phase->Work      = Work;
+	Phase->Phase     = Type;
+	Phase->ItemCount = ItemCount;
+	Phase->NextItem  = 0;
+	Phase->Done      = (job_counter){0};
+
+	uint32_t JobCount = Minimum(Minimum(OSGetProcessorCount() + 1, PACK_MAX_JOB_COUNT), ItemCount);
+
+	for (uint32_t JobIdx = 0; JobIdx < JobCount; ++JobIdx)
+	{
+		EngineMemory->AddJobAfter(EngineMemory->WorkQueue, JobPriority_Background, Dependency, "pack texture", PackTextureJob, Phase, &Phase->Done);
+	}
+}
+
+// ==============================================
+// <Material Texture Packing> : PUBLIC
+// ==============================================
+
+
+byte_string
+MakeMaterialTexturePath(byte_string *MapPaths, MaterialTexture_Type Type, memory_arena *Arena)
+{
+	byte_string Parts[MaterialMap_Count];
+	uint32_t    PartCount = 0;
+
+	for (uint32_t Map = 0; Map < MaterialMap_Count; ++Map)
+	{
+		if (IsPackedFrom(Type, (MaterialMap_Type)Map) && IsValidByteString(MapPaths[Map]))
+		{
+			Parts[PartCount++] = MapPaths[Map];
+		}
+	}
+
+	byte_string Result = ByteString(0, 0);
+
+	if (PartCount == 1)
+	{
+		Result = Parts[0];
+	}
+	else if (PartCount > 1)
+	{
+		Result = ConcatenateStrings(Parts, PartCount, ByteStringLiteral("|"), Arena);
+	}
+
+	return Result;
+}
+
+
+void
+PackMaterialTextures(material_to_pack *Materials, uint32_t Count, engine_memory *EngineMemory)
+{
+	assert(EngineMemory);
+
+	memory_arena *Arena = EngineMemory->FrameMemory;
+
+	// The packed pixels outlive this call, so they go in before the region that holds the tasks.
+
+	pack_task *Tasks     = PushArray(Arena, pack_task, Count * MaterialTexture_Count);
+	uint32_t   TaskCount = 0;
+
+	for (uint32_t MaterialIdx = 0; MaterialIdx < Count; ++MaterialIdx)
+	{
+		material_to_pack *Material = Materials + MaterialIdx;
+
+		for (uint32_t Type = 0; Type < MaterialTexture_Count; ++Type)
+		{
+			loaded_texture *Output = Material->Output->Textures + Type;
+			pack_task      *Task   = Tasks + TaskCount;
+
+			Output->Data          = 0;
+			Output->Width         = 0;
+			Output->Height        = 0;
+			Output->BytesPerPixel = 0;
+			Output->MipCount      = 0;
+			Output->Format        = TextureFormat_RGBA8;
+			Output->IsSRGB        = Type == MaterialTexture_Albedo;
+			Output->HasAlpha      = false;
+			Output->CacheKey      = 0;
+			Output->StreamKey     = 0;
+
+			memset(Task, 0, sizeof(pack_task));
+
+			Task->Type   = (MaterialTexture_Type)Type;
+			Task->Output = Output;
+			GetPackDefaults(Material->Output, Task->Type, Task->Defaults);
+
+			// Maps whose header could not be read have no pixels reserved and count as missing.
+
+			uint32_t SourceCount = 0;
+			bool     UseCache    = !Material->Uncached[Type];
+			uint64_t ContentHash = CombineHash(Type, ((uint32_t)Task->Defaults[0] << 24) | ((uint32_t)Task->Defaults[1] << 16) |
+			                                         ((uint32_t)Task->Defaults[2] <<  8) |  (uint32_t)Task->Defaults[3]);
+
+			for (uint32_t Map = 0; Map < MaterialMap_Count; ++Map)
+			{
+				texture_to_load *Load = Material->Loads[Map];
+
+				if (Load && Load->Pixels && IsPackedFrom(Task->Type, (MaterialMap_Type)Map))
+				{
+					Task->Sources[Map] = Load;
+					Task->Width        = Maximum(Task->Width, Load->Width);
+					Task->Height       = Maximum(Task->Height, Load->Height);
+
+					UseCache    = UseCache && Load->UseCache;
+					ContentHash = CombineHash(ContentHash, CombineHash(Map, Load->SourceHash));
+					SourceCount += 1;
+				}
+			}
+
+			if (SourceCount)
+			{
+				Task->CacheKey   = UseCache ? MakeTextureCacheKey(ContentHash) : 0;
+				Task->MemorySize = GetMipChainSize(Task->Width, Task->Height, 4);
+				Task->IsCopy     = SourceCount == 1 && Task->Sources[MaterialMap_Color];
+				Task->Memory     = PushArray(Arena, uint8_t, Task->MemorySize);
+
+				TaskCount += Task->Memory ? 1 : 0;
+			}
+		}
+	}
+
+	memory_region Region = EnterMemoryRegion(Arena);
+
+	pack_work *Work = PushStruct(Arena, pack_work);
+	Work->Tasks     = Tasks;
+	Work->Decodes   = PushArray(Arena, texture_to_load *, TaskCount * MaterialMap_Count);
+	Work->Occlusion = 0;
+
+	StartPackPhase(Work, PackPhase_Lookup, TaskCount, 0, EngineMemory);
+	EngineMemory->WaitForCounter(EngineMemory->WorkQueue, &Work->Phases[PackPhase_Lookup].Done);
+
+	// What the misses need and no earlier import decoded yet, once each. A task only has a few
+	// sources and there are not many tasks, the linear search is fine.
+
+	uint32_t DecodeCount = 0;
+	bool     Occludes    = false;
+
+	for (uint32_t Idx = 0; Idx < TaskCount; ++Idx)
+	{
+		pack_task *Task = Tasks + Idx;
+
+		for (uint32_t Map = 0; Map < MaterialMap_Count && !Task->IsCached; ++Map)
+		{
+			texture_to_load *Source = Task->Sources[Map];
+			bool             IsNew  = Source && !Source->Output->Data;
+
+			for (uint32_t Decode = 0; Decode < DecodeCount && IsNew; ++Decode)
+			{
+				IsNew = Work->Decodes[Decode] != Source;
+			}
+
+			if (IsNew)
+			{
+				Work->Decodes[DecodeCount++] = Source;
+			}
+
+			Occludes = Occludes || (Source && Map == PackModulators[Task->Type]);
+		}
+
+		if (!Task->IsCached && !Task->IsCopy)
+		{
+			Task->Row = PushArray(Arena, uint8_t, (uint64_t)Task->Width * 4);
+		}
+	}
+
+	if (Occludes)
+	{
+		Work->Occlusion = (uint8_t (*)[256])PushArray(Arena, uint8_t, 256 * 256);
+		BuildOcclusionTable(Work->Occlusion);
+	}
+
+	StartPackPhase(Work, PackPhase_Decode, DecodeCount, 0, EngineMemory);
+	StartPackPhase(Work, PackPhase_Pack, TaskCount, &Work->Phases[PackPhase_Decode].Done, EngineMemory);
+
+	EngineMemory->WaitForCounter(EngineMemory->WorkQueue, &Work->Phases[PackPhase_Pack].Done);
+
+	LeaveMemoryRegion(Region);
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "engine/rendering/assets.h"
+
+// ==============================================
+// <Material Texture Packing>
+// ==============================================
+
+// The maps of a material are imported as at most two RGBA8 textures instead of one per map, most
+// maps only use one or two channels:
+//
+//   Albedo  : RGB color, A opacity. Occlusion is multiplied into RGB, in linear space.
+//   Surface : RG normal X and Y, B roughness, A metalness. Z is rebuilt by whoever samples it.
+//
+// A channel whose map is missing gets a default: white, a flat normal, the roughness the material's
+// shininess stands for and no metal. A texture none of whose maps are present is left empty. Maps of
+// different sizes are resampled (bilinear, as stored) to the largest one.
+
+typedef struct engine_memory engine_memory;
+
+
+typedef struct
+{
+	material_data   *Output;                          // Shininess and MapPaths already set.
+	texture_to_load *Loads[MaterialMap_Count];        // 0 for unused slots. Read, maybe shared and decoded already.
+	bool             Uncached[MaterialTexture_Count]; // Neither looked up in nor written to the texture cache.
+} material_to_pack;
+
+
+// The path a packed texture is known by, the paths of its maps joined. A lone color map keeps its own.
+byte_string MakeMaterialTexturePath (byte_string *MapPaths, MaterialTexture_Type Type, memory_arena *Arena);
+
+// Fills Textures of every material, without mips. When all of a texture's maps were read with
+// UseCache it is first looked up in textures/texture_cache.h, the maps are only decoded on a miss
+// and CacheKey is set. A map shared by several materials is decoded once, and not again when an
+// earlier call did (textures/texture_sources.h). Must be called from the thread that owns the queue,
+// allocates from its frame memory.
+void        PackMaterialTextures    (material_to_pack *Materials, uint32_t Count, engine_memory *EngineMemory);
\ No newline at end of file
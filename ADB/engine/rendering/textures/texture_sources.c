@@ -0,0 +1,188 @@
+#include <assert.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "texture_sources.h"
+#include "engine/rendering/asset_archive.h"
+
+#define TEXTURE_SOURCE_HASH_COUNT 1024
+#define INVALID_TEXTURE_SOURCE    0xFFFFFFFF
+
+// ==============================================
+// <Table> : INTERNAL
+// ==============================================
+
+// Sources are never removed one by one, their memory is not either: the table lives in its own
+// arena, which goes away as a whole once every source was released.
+
+
+typedef struct
+{
+	memory_arena   *Arena;
+	uint32_t        HashTable[TEXTURE_SOURCE_HASH_COUNT];
+	texture_source *Sources;
+	uint32_t        SourceCount;
+	uint32_t        HeldCount;   // Sources with a RefCount.
+} texture_source_table;
+
+
+static texture_source_table *TextureSources;
+
+
+static texture_source_table *
+GetTextureSources(void)
+{
+	if (!TextureSources)
+	{
+		memory_arena_params Params =
+		{
+			.AllocatedFromFile = __FILE__,
+			.AllocatedFromLine = __LINE__,
+			.ReserveSize       = MiB(256),
+			.CommitSize        = KiB(64),
+		};
+
+		memory_arena *Arena = AllocateArena(Params);
+		if (Arena)
+		{
+			texture_source_table *Table = PushStruct(Arena, texture_source_table);
+			texture_source       *Array = PushArray(Arena, texture_source, TEXTURE_SOURCE_MAX_COUNT);
+
+			if (Table && Array)
+			{
+				Table->Arena       = Arena;
+				Table->Sources     = Array;
+				Table->SourceCount = 0;
+				Table->HeldCount   = 0;
+
+				for (uint32_t Slot = 0; Slot < TEXTURE_SOURCE_HASH_COUNT; ++Slot)
+				{
+					Table->HashTable[Slot] = INVALID_TEXTURE_SOURCE;
+				}
+
+				TextureSources = Table;
+			}
+			else
+			{
+				ReleaseArena(Arena);
+			}
+		}
+	}
+
+	return TextureSources;
+}
+
+
+static texture_source *
+FindTextureSource(texture_source_table *Table, resource_uuid UUID)
+{
+	texture_source *Result = 0;
+
+	uint32_t Index = Table->HashTable[UUID.Value & (TEXTURE_SOURCE_HASH_COUNT - 1)];
+	while (Index != INVALID_TEXTURE_SOURCE)
+	{
+		texture_source *Source = Table->Sources + Index;
+		if (Source->UUID.Value == UUID.Value)
+		{
+			Result = Source;
+			break;
+		}
+
+		Index = Source->NextSameHash;
+	}
+
+	return Result;
+}
+
+
+static void
+ReadTextureSourceJob(platform_work_queue *Queue, void *Data)
+{
+	ReadTextureSource(Queue, (texture_to_load *)Data);
+}
+
+// ==============================================
+// <Texture Sources> : PUBLIC
+// ==============================================
+
+
+texture_source *
+AcquireTextureSource(byte_string Path, engine_memory *EngineMemory)
+{
+	assert(EngineMemory);
+
+	texture_source_table *Table  = IsValidByteString(Path) ? GetTextureSources() : 0;
+	texture_source       *Result = 0;
+
+	if (Table)
+	{
+		resource_uuid UUID = MakeResourceUUID(Path);
+
+		Result = FindTextureSource(Table, UUID);
+
+		if (!Result && Table->SourceCount < TEXTURE_SOURCE_MAX_COUNT)
+		{
+			uint32_t  Index = Table->SourceCount++;
+			uint32_t *Slot  = Table->HashTable + (UUID.Value & (TEXTURE_SOURCE_HASH_COUNT - 1));
+
+			Result = Table->Sources + Index;
+			memset(Result, 0, sizeof(texture_source));
+
+			Result->UUID         = UUID;
+			Result->NextSameHash = *Slot;
+			*Slot                = Index;
+
+			// Always hashed, whether the texture cache is used is up to each import.
+
+			Result->Texture.Path  = ByteStringCopy(Path, Table->Arena);
+			Result->Load.Output   = &Result->Texture;
+			Result->Load.Map      = MaterialMap_Count;
+			Result->Load.UseCache = true;
+
+			Result->Load.FileContent = BeginAssetRead(Result->Texture.Path, Table->Arena);
+			PrepareTextureLoad(&Result->Load, Table->Arena);
+
+			EngineMemory->AddJob(EngineMemory->WorkQueue, JobPriority_Background, "read texture source", ReadTextureSourceJob, &Result->Load, &Result->Read);
+		}
+
+		if (Result)
+		{
+			Table->HeldCount += Result->RefCount == 0 ? 1 : 0;
+			Result->RefCount += 1;
+		}
+	}
+
+	return Result;
+}
+
+
+void
+ReleaseTextureSource(texture_source *Source)
+{
+	if (Source)
+	{
+		assert(TextureSources);
+		assert(Source->RefCount > 0);
+
+		Source->RefCount -= 1;
+		TextureSources->HeldCount -= Source->RefCount == 0 ? 1 : 0;
+	}
+}
+
+
+bool
+TrimTextureSources(void)
+{
+	bool Result = false;
+
+	if (TextureSources && TextureSources->HeldCount == 0)
+	{
+		ReleaseArena(TextureSources->Arena);
+
+		TextureSources = 0;
+		Result         = true;
+	}
+
+	return Result;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "engine/rendering/assets.h"
+
+// ==============================================
+// <Texture Sources>
+// ==============================================
+
+// The source images named by materials, shared by every material and every file that names the same
+// one. Sources are keyed by MakeResourceUUID of their path, so "a/../b.png" and "b.png" are read
+// once. The first acquire starts the read (hashed for textures/texture_cache.h) on the work queue,
+// the pixels are decoded by whichever import first needs them and stay decoded for the next one.
+//
+// A source whose last reference is released stays around, a later file naming it skips the read and
+// the decode. TrimTextureSources gives the memory back, which only happens once nothing holds a
+// reference, the sources share one arena.
+
+#define TEXTURE_SOURCE_MAX_COUNT 4096
+
+typedef struct engine_memory engine_memory;
+
+
+typedef struct
+{
+	resource_uuid   UUID;
+	uint32_t        RefCount;
+	uint32_t        NextSameHash;
+
+	texture_to_load Load;    // Load.Output is Texture.
+	loaded_texture  Texture; // Data is only set once decoded.
+	job_counter     Read;    // Zero once Load holds the file.
+} texture_source;
+
+
+// Returns 0 when the path is empty or the table is full. Must be called from the thread that owns
+// the queue, the read may still be in flight until Read is back at zero.
+texture_source * AcquireTextureSource (byte_string Path, engine_memory *EngineMemory);
+void             ReleaseTextureSource (texture_source *Source);
+
+// Returns true when the memory was released, false while some source is still referenced.
+bool             TrimTextureSources   (void);
\ No newline at end of file
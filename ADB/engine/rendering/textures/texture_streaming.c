@@ -0,0 +1,505 @@
+#include <assert.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "texture_streaming.h"
+#include "texture_cache.h"
+#include "texture_mips.h"
+
+// ==============================================
+// <Streamer> : INTERNAL
+// ==============================================
+
+
+typedef enum
+{
+	StreamRead_Free    = 0,
+	StreamRead_Pending = 1,
+	StreamRead_Done    = 2,
+	StreamRead_Failed  = 3,
+} StreamRead_Type;
+
+
+typedef struct
+{
+	uint32_t        State;        // StreamRead_Type, the job stores it once Memory is filled.
+	uint32_t        TextureIdx;
+	uint32_t        FirstLevel;
+	uint64_t        Key;
+	loaded_texture  Layout;
+	uint8_t        *Memory;
+	uint64_t        Size;
+} texture_stream_read;
+
+
+typedef struct
+{
+	loaded_texture Layout;                            // The chain as stored in the cache, Data is not set.
+	uint64_t       ChainSizes[MAX_TEXTURE_MIP_COUNT]; // Bytes from each level down to the last one.
+	uint8_t        Snapped[MAX_TEXTURE_MIP_COUNT];    // The closest level at or above each one that can be resident.
+
+	uint8_t       *Data;                              // Levels ResidentLevel and below.
+	uint32_t       ResidentLevel;
+	uint32_t       TailLevel;
+	uint32_t       WantedLevel;                       // Before the bias.
+	uint32_t       TargetLevel;
+	float          ScreenSize;                        // Largest request of the frame, 0 when there was none.
+
+	bool           IsReading;
+	bool           IsBroken;                          // A read failed, the texture keeps what it has.
+	bool           IsChanged;
+} streamed_texture;
+
+
+typedef struct texture_streamer
+{
+	streamed_texture     *Textures;
+	uint32_t              TextureCount;
+	uint32_t              MaxTextureCount;
+	texture_stream_read   Reads[TEXTURE_STREAM_MAX_READ_COUNT];
+	texture_stream_stats  Stats;
+} texture_streamer;
+
+
+static uint32_t
+GetLevelSize(uint32_t Size, uint32_t Level)
+{
+	uint32_t Result = Maximum(Size >> Level, 1);
+	return Result;
+}
+
+
+// D3D11 wants the top level of a block compressed texture to be whole blocks, a chain can only
+// start where both sides are a multiple of 4. The level the import started from always can.
+
+static bool
+CanStartChainAt(loaded_texture *Layout, uint32_t Level)
+{
+	bool Result = Level == 0 || GetFormatBlockSize(Layout->Format) == 0;
+
+	if (!Result)
+	{
+		uint32_t Width  = GetLevelSize(Layout->Width,  Level);
+		uint32_t Height = GetLevelSize(Layout->Height, Level);
+
+		Result = (Width % 4) == 0 && (Height % 4) == 0;
+	}
+
+	return Result;
+}
+
+
+// Chains get their own pages so a texture that changes level gives its memory back at once.
+
+static uint8_t *
+AllocateChain(uint64_t Size)
+{
+	uint8_t *Result = (uint8_t *)OSReserve(Size);
+
+	if (Result && !OSCommit(Result, Size))
+	{
+		OSRelease(Result, Size);
+		Result = 0;
+	}
+
+	return Result;
+}
+
+
+static void
+SetResidentChain(streamed_texture *Texture, uint8_t *Data, uint32_t Level, texture_stream_stats *Stats)
+{
+	if (Texture->Data)
+	{
+		uint64_t Size = Texture->ChainSizes[Texture->ResidentLevel];
+
+		OSRelease(Texture->Data, Size);
+		Stats->ResidentBytes -= Size;
+	}
+
+	Texture->Data          = Data;
+	Texture->ResidentLevel = Level;
+	Texture->IsChanged     = true;
+}
+
+
+// The level whose size is closest to the pixels it covers without going under: a texture that fills
+// 300 rows of the view keeps the 512 level. Assumes it spans its surface once, tiling would need more.
+
+static uint32_t
+GetWantedLevel(streamed_texture *Texture, float Pixels)
+{
+	uint32_t Result = Texture->TailLevel;
+
+	if (Pixels > 0.f)
+	{
+		uint32_t Size = Maximum(Texture->Layout.Width, Texture->Layout.Height);
+
+		Result = 0;
+		while (Result < Texture->TailLevel && (float)GetLevelSize(Size, Result + 1) >= Pixels)
+		{
+			++Result;
+		}
+	}
+
+	return Result;
+}
+
+
+static uint32_t
+GetBiasedLevel(streamed_texture *Texture, uint32_t Bias)
+{
+	uint32_t Result = Texture->ResidentLevel;
+
+	if (!Texture->IsBroken)
+	{
+		Result = Texture->Snapped[Minimum(Texture->WantedLevel + Bias, Texture->TailLevel)];
+	}
+
+	return Result;
+}
+
+
+static void
+ReadStreamedLevelsJob(platform_work_queue *Queue, void *Data)
+{
+	(void)Queue;
+
+	texture_stream_read *Read   = (texture_stream_read *)Data;
+	bool                 IsRead = LoadCachedTextureLevels(Read->Key, &Read->Layout, Read->FirstLevel, Read->Memory, Read->Size);
+
+	AtomicStore32(&Read->State, IsRead ? StreamRead_Done : StreamRead_Failed);
+}
+
+
+static void
+CompleteStreamReads(texture_streamer *Streamer)
+{
+	texture_stream_stats *Stats = &Streamer->Stats;
+
+	for (uint32_t ReadIdx = 0; ReadIdx < TEXTURE_STREAM_MAX_READ_COUNT; ++ReadIdx)
+	{
+		texture_stream_read *Read  = Streamer->Reads + ReadIdx;
+		uint32_t             State = AtomicLoad32(&Read->State);
+
+		if (State == StreamRead_Done || State == StreamRead_Failed)
+		{
+			streamed_texture *Texture = Streamer->Textures + Read->TextureIdx;
+
+			if (State == StreamRead_Done)
+			{
+				SetResidentChain(Texture, Read->Memory, Read->FirstLevel, Stats);
+
+				Stats->BytesRead += Read->Size;
+				Stats->ReadCount += 1;
+			}
+			else
+			{
+				OSRelease(Read->Memory, Read->Size);
+
+				Stats->ResidentBytes   -= Read->Size;
+				Stats->FailedReadCount += 1;
+				Texture->IsBroken       = true;
+			}
+
+			Texture->IsReading = false;
+
+			Read->Memory = 0;
+			Read->State  = StreamRead_Free;
+
+			Stats->PendingReadCount -= 1;
+		}
+	}
+}
+
+
+// The smallest bias that fits the budget. Tails are kept whatever it costs, past that point the
+// bias stops growing.
+
+static uint32_t
+FindStreamingBias(texture_streamer *Streamer)
+{
+	uint32_t Result = 0;
+
+	for (uint32_t Bias = 0; Bias < MAX_TEXTURE_MIP_COUNT; ++Bias)
+	{
+		uint64_t Total     = 0;
+		bool     IsAtTails = true;
+
+		for (uint32_t Idx = 0; Idx < Streamer->TextureCount; ++Idx)
+		{
+			streamed_texture *Texture = Streamer->Textures + Idx;
+			uint32_t          Level   = GetBiasedLevel(Texture, Bias);
+
+			Total     += Texture->ChainSizes[Level];
+			IsAtTails &= Texture->IsBroken || Texture->WantedLevel + Bias >= Texture->TailLevel;
+		}
+
+		if (Bias == 0)
+		{
+			Streamer->Stats.WantedBytes = Total;
+		}
+
+		Result = Bias;
+
+		if (Total <= Streamer->Stats.Budget || IsAtTails)
+		{
+			break;
+		}
+	}
+
+	return Result;
+}
+
+
+static streamed_texture *
+FindNextRaise(texture_streamer *Streamer)
+{
+	streamed_texture *Result = 0;
+
+	for (uint32_t Idx = 0; Idx < Streamer->TextureCount; ++Idx)
+	{
+		streamed_texture *Texture = Streamer->Textures + Idx;
+
+		bool IsCandidate = !Texture->IsReading && !Texture->IsBroken && Texture->TargetLevel < Texture->ResidentLevel;
+
+		if (IsCandidate && (!Result || Texture->ScreenSize > Result->ScreenSize))
+		{
+			Result = Texture;
+		}
+	}
+
+	return Result;
+}
+
+// ==============================================
+// <Streamer> : PUBLIC
+// ==============================================
+
+
+texture_streamer *
+CreateTextureStreamer(uint64_t Budget, uint32_t MaxTextureCount, memory_arena *Arena)
+{
+	texture_streamer *Result = PushStruct(Arena, texture_streamer);
+
+	if (Result)
+	{
+		memset(Result, 0, sizeof(texture_streamer));
+
+		Result->Textures        = PushArray(Arena, streamed_texture, MaxTextureCount);
+		Result->MaxTextureCount = Result->Textures ? MaxTextureCount : 0;
+		Result->Stats.Budget    = Budget;
+	}
+
+	return Result;
+}
+
+
+uint32_t
+AddStreamedTexture(texture_streamer *Streamer, loaded_texture *Texture)
+{
+	assert(Streamer && Texture);
+
+	uint32_t Result   = 0;
+	uint32_t MipCount = Texture->MipCount;
+
+	bool CanStream = Texture->StreamKey && Texture->Data && MipCount > 1 && MipCount <= MAX_TEXTURE_MIP_COUNT &&
+	                 Streamer->TextureCount < Streamer->MaxTextureCount;
+
+	if (CanStream)
+	{
+		streamed_texture *Streamed = Streamer->Textures + Streamer->TextureCount;
+		memset(Streamed, 0, sizeof(streamed_texture));
+
+		// The path belongs to the import, it is not kept.
+
+		Streamed->Layout      = *Texture;
+		Streamed->Layout.Data = 0;
+		Streamed->Layout.Path = (byte_string){0};
+
+		uint64_t Total = GetTextureDataSize(Texture->Width, Texture->Height, Texture->Format, MipCount);
+
+		for (uint32_t Level = 0; Level < MipCount; ++Level)
+		{
+			Streamed->ChainSizes[Level] = Total - (Level ? GetTextureDataSize(Texture->Width, Texture->Height, Texture->Format, Level) : 0);
+
+			uint32_t Snapped = Level;
+			while (!CanStartChainAt(&Streamed->Layout, Snapped))
+			{
+				--Snapped;
+			}
+
+			Streamed->Snapped[Level] = (uint8_t)Snapped;
+		}
+
+		uint32_t Tail = 0;
+		while (Tail + 1 < MipCount && Maximum(GetLevelSize(Texture->Width, Tail), GetLevelSize(Texture->Height, Tail)) > TEXTURE_STREAM_TAIL_SIZE)
+		{
+			++Tail;
+		}
+
+		Tail = Streamed->Snapped[Tail];
+
+		uint8_t *Data = Tail ? AllocateChain(Streamed->ChainSizes[Tail]) : 0;
+		if (Data)
+		{
+			memcpy(Data, Texture->Data + (Total - Streamed->ChainSizes[Tail]), Streamed->ChainSizes[Tail]);
+
+			Streamed->Data          = Data;
+			Streamed->ResidentLevel = Tail;
+			Streamed->TailLevel     = Tail;
+			Streamed->WantedLevel   = Tail;
+			Streamed->TargetLevel   = Tail;
+
+			Streamer->Stats.ResidentBytes += Streamed->ChainSizes[Tail];
+			Streamer->TextureCount        += 1;
+
+			byte_string Path = Texture->Path;
+
+			GetStreamedTexture(Streamer, Streamer->TextureCount, Texture);
+			Texture->Path = Path;
+
+			Result = Streamer->TextureCount;
+		}
+	}
+
+	return Result;
+}
+
+
+void
+RequestStreamedTexture(texture_streamer *Streamer, uint32_t Id, float ScreenSize)
+{
+	if (Streamer && Id && Id <= Streamer->TextureCount)
+	{
+		streamed_texture *Texture = Streamer->Textures + (Id - 1);
+		Texture->ScreenSize = Maximum(Texture->ScreenSize, ScreenSize);
+	}
+}
+
+
+void
+UpdateTextureStreaming(texture_streamer *Streamer, uint32_t ViewHeight, engine_memory *EngineMemory)
+{
+	assert(Streamer && EngineMemory);
+
+	texture_stream_stats *Stats = &Streamer->Stats;
+
+	CompleteStreamReads(Streamer);
+
+	for (uint32_t Idx = 0; Idx < Streamer->TextureCount; ++Idx)
+	{
+		streamed_texture *Texture = Streamer->Textures + Idx;
+		Texture->WantedLevel = GetWantedLevel(Texture, Texture->ScreenSize * (float)ViewHeight);
+	}
+
+	Stats->Bias = FindStreamingBias(Streamer);
+
+	// Lowering only copies what is already resident, it happens right away and makes room for the reads.
+
+	for (uint32_t Idx = 0; Idx < Streamer->TextureCount; ++Idx)
+	{
+		streamed_texture *Texture = Streamer->Textures + Idx;
+		Texture->TargetLevel = GetBiasedLevel(Texture, Stats->Bias);
+
+		if (!Texture->IsReading && Texture->TargetLevel > Texture->ResidentLevel)
+		{
+			uint64_t Size = Texture->ChainSizes[Texture->TargetLevel];
+			uint8_t *Data = AllocateChain(Size);
+
+			if (Data)
+			{
+				memcpy(Data, Texture->Data + (Texture->ChainSizes[Texture->ResidentLevel] - Size), Size);
+
+				Stats->ResidentBytes += Size;
+				SetResidentChain(Texture, Data, Texture->TargetLevel, Stats);
+			}
+		}
+	}
+
+	for (uint32_t ReadIdx = 0; ReadIdx < TEXTURE_STREAM_MAX_READ_COUNT; ++ReadIdx)
+	{
+		texture_stream_read *Read = Streamer->Reads + ReadIdx;
+
+		if (Read->State == StreamRead_Free)
+		{
+			streamed_texture *Texture = FindNextRaise(Streamer);
+			if (!Texture)
+			{
+				break;
+			}
+
+			uint64_t Size = Texture->ChainSizes[Texture->TargetLevel];
+			uint8_t *Data = AllocateChain(Size);
+
+			if (!Data)
+			{
+				break;
+			}
+
+			Read->TextureIdx = (uint32_t)(Texture - Streamer->Textures);
+			Read->FirstLevel = Texture->TargetLevel;
+			Read->Key        = Texture->Layout.StreamKey;
+			Read->Layout     = Texture->Layout;
+			Read->Memory     = Data;
+			Read->Size       = Size;
+			Read->State      = StreamRead_Pending;
+
+			Texture->IsReading = true;
+
+			Stats->ResidentBytes    += Size;
+			Stats->PendingReadCount += 1;
+
+			EngineMemory->AddJob(EngineMemory->WorkQueue, JobPriority_Background, "read streamed levels", ReadStreamedLevelsJob, Read, 0);
+		}
+	}
+
+	for (uint32_t Idx = 0; Idx < Streamer->TextureCount; ++Idx)
+	{
+		Streamer->Textures[Idx].ScreenSize = 0.f;
+	}
+
+	Stats->TextureCount = Streamer->TextureCount;
+}
+
+
+bool
+GetStreamedTexture(texture_streamer *Streamer, uint32_t Id, loaded_texture *Texture)
+{
+	assert(Texture);
+
+	bool Result = false;
+
+	if (Streamer && Id && Id <= Streamer->TextureCount)
+	{
+		streamed_texture *Streamed = Streamer->Textures + (Id - 1);
+		uint32_t          Level    = Streamed->ResidentLevel;
+
+		*Texture = Streamed->Layout;
+
+		Texture->Data     = Streamed->Data;
+		Texture->Width    = GetLevelSize(Streamed->Layout.Width,  Level);
+		Texture->Height   = GetLevelSize(Streamed->Layout.Height, Level);
+		Texture->MipCount = Streamed->Layout.MipCount - Level;
+
+		Result              = Streamed->IsChanged;
+		Streamed->IsChanged = false;
+	}
+
+	return Result;
+}
+
+
+texture_stream_stats
+GetTextureStreamStats(texture_streamer *Streamer)
+{
+	texture_stream_stats Result = {0};
+
+	if (Streamer)
+	{
+		Result = Streamer->Stats;
+	}
+
+	return Result;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "engine/rendering/assets.h"
+
+// ==============================================
+// <Texture Streaming>
+// ==============================================
+
+// Keeps only the levels of a texture that its size on screen calls for. A texture added to the
+// streamer gives up everything above its tail (the first level no larger than
+// TEXTURE_STREAM_TAIL_SIZE), the larger levels are read back from the texture cache
+// (textures/texture_cache.h) when something asks for them. A baked texture stores its levels back to
+// back, so a read copies a suffix of the file and never touches the levels above it.
+//
+// Each frame the callers report how much of the view each texture covers, the update turns that into
+// the level to keep and drops levels from every texture alike until their sum fits the budget. Lower
+// levels are given back at once, higher ones are read on the work queue, the largest textures on
+// screen first, TEXTURE_STREAM_MAX_READ_COUNT at a time. A read holds its chain next to the one it
+// replaces until it lands, which can take the total over the budget for a few frames. Tails always
+// stay, when they alone exceed the budget the streamer keeps them and nothing more.
+//
+// Nothing here knows about the renderer: GetStreamedTexture says when the levels changed and hands
+// out the new chain, which stays valid until the next update.
+
+#define TEXTURE_STREAM_TAIL_SIZE       64
+#define TEXTURE_STREAM_MAX_READ_COUNT  8
+
+typedef struct engine_memory    engine_memory;
+typedef struct texture_streamer texture_streamer;
+
+
+typedef struct
+{
+	uint64_t Budget;
+	uint64_t ResidentBytes;  // Chains held, reads in flight included.
+	uint64_t WantedBytes;    // What the levels asked for this frame would take, before the bias.
+	uint64_t BytesRead;      // Since the streamer was created.
+	uint32_t ReadCount;
+	uint32_t FailedReadCount;
+	uint32_t PendingReadCount;
+	uint32_t TextureCount;
+	uint32_t Bias;           // Levels dropped from every texture to fit the budget.
+} texture_stream_stats;
+
+
+texture_streamer *   CreateTextureStreamer   (uint64_t Budget, uint32_t MaxTextureCount, memory_arena *Arena);
+
+// Returns 0 and leaves the texture alone when it cannot be streamed: not in the texture cache, no
+// levels above the tail, or (block formats) no level above the tail whose size is whole blocks.
+// Otherwise copies the tail and points Texture at it.
+uint32_t             AddStreamedTexture      (texture_streamer *Streamer, loaded_texture *Texture);
+
+// ScreenSize is the part of the view height the texture covers, the largest request of the frame
+// wins. Textures nobody asked for fall back to their tail.
+void                 RequestStreamedTexture  (texture_streamer *Streamer, uint32_t Id, float ScreenSize);
+
+// Must be called from the thread that owns the queue, once per frame. Reads are never waited on.
+void                 UpdateTextureStreaming  (texture_streamer *Streamer, uint32_t ViewHeight, engine_memory *EngineMemory);
+
+// Returns true when the levels changed since the last call for this texture.
+bool                 GetStreamedTexture      (texture_streamer *Streamer, uint32_t Id, loaded_texture *Texture);
+texture_stream_stats GetTextureStreamStats   (texture_streamer *Streamer);
\ No newline at end of file
@@ -12,6 +12,14 @@
 #include "../utilities.h"
 #include "parser_obj.h"
 #include "platform/platform.h"
+#include "platform/profiler.h"
+#include "engine/rendering/asset_archive.h"
+#include "engine/rendering/textures/texture_mips.h"
+#include "engine/rendering/textures/texture_compress.h"
+#include "engine/rendering/textures/texture_cache.h"
+#include "engine/rendering/textures/texture_pack.h"
+#include "engine/rendering/textures/texture_atlas.h"
+#include "engine/rendering/textures/texture_sources.h"
 
 
 // ==============================================
@@ -44,9 +52,9 @@ typedef struct
     float          Shininess;
     float          Opacity;
 
-    loaded_texture ColorTexture;
-    loaded_texture NormalTexture;
-    loaded_texture RoughnessTexture;
+    // Sources are held until the maps are packed, see textures/texture_sources.h.
+    byte_string      MapPaths[MaterialMap_Count];
+    texture_source  *Sources[MaterialMap_Count];
 } obj_material;
 
 
@@ -88,12 +96,12 @@ FindMaterialPath(byte_string Name, obj_material_list *List)
 
 
 static obj_material_node *
-ParseMTLFromFile(byte_string Path, engine_memory *EngineMemory)
+ParseMTLFromFile(byte_string Path, ObjParseFlag_Type Flags, engine_memory *EngineMemory)
 {
     obj_material_node *First = 0;
     obj_material_node *Last  = 0;
 
-    buffer FileBuffer = ReadFileInBuffer(Path, EngineMemory->FrameMemory);
+    buffer FileBuffer = ReadAssetInBuffer(Path, EngineMemory->FrameMemory);
 
     if (IsBufferValid(&FileBuffer))
     {
@@ -123,7 +131,8 @@ ParseMTLFromFile(byte_string Path, engine_memory *EngineMemory)
                         obj_material_node *Node = PushStruct(EngineMemory->FrameMemory, obj_material_node);
                         if (Node)
                         {
-                            Node->Next = 0;
+                            Node->Next  = 0;
+                            Node->Value = (obj_material){0};
                             Node->Value.Name = MaterialName;
                             Node->Value.Path = MaterialPath;
                             // Node->Value.Ambient   = {0, 0, 0};
@@ -196,28 +205,34 @@ ParseMTLFromFile(byte_string Path, engine_memory *EngineMemory)
 
             case 'm':
             {
-                texture_to_load *ToLoad = PushStruct(EngineMemory->FrameMemory, texture_to_load);
-
-                if (Last && ToLoad)
+                if (Last)
                 {
-                    byte_string NormalMap    = ByteStringLiteral("ap_Bump");
-                    byte_string ColorMap     = ByteStringLiteral("ap_Kd");
-                    byte_string RoughnessMap = ByteStringLiteral("ap_Ns");
+                    byte_string      NormalMap    = ByteStringLiteral("ap_Bump");
+                    byte_string      ColorMap     = ByteStringLiteral("ap_Kd");
+                    byte_string      RoughnessMap = ByteStringLiteral("ap_Ns");
+                    byte_string      MetalnessMap = ByteStringLiteral("ap_Pm");
+                    byte_string      OcclusionMap = ByteStringLiteral("ap_Ka"); // The ambient map, commonly baked occlusion.
+                    MaterialMap_Type Map          = MaterialMap_Count;
                     
                     if (BufferStartsWith(NormalMap, &FileBuffer))
                     {
-                        ToLoad->Output = &Last->Value.NormalTexture;
-                        ToLoad->Id     = 0;
+                        Map = MaterialMap_Normal;
                     }
                     else if (BufferStartsWith(ColorMap, &FileBuffer))
                     {
-                        ToLoad->Output = &Last->Value.ColorTexture;
-                        ToLoad->Id     = 1;
+                        Map = MaterialMap_Color;
                     }
                     else if (BufferStartsWith(RoughnessMap, &FileBuffer))
                     {
-                        ToLoad->Output = &Last->Value.RoughnessTexture;
-                        ToLoad->Id     = 2;
+                        Map = MaterialMap_Roughness;
+                    }
+                    else if (BufferStartsWith(MetalnessMap, &FileBuffer))
+                    {
+                        Map = MaterialMap_Metalness;
+                    }
+                    else if (BufferStartsWith(OcclusionMap, &FileBuffer))
+                    {
+                        Map = MaterialMap_Occlusion;
                     }
                     else
                     {
@@ -229,10 +244,19 @@ ParseMTLFromFile(byte_string Path, engine_memory *EngineMemory)
                     byte_string TextureName = ParseToIdentifier(&FileBuffer);
                     byte_string TexturePath = ReplaceFileName(Path, TextureName, EngineMemory->FrameMemory);
                     
-                    ToLoad->FileContent  = ReadFileInBuffer(TexturePath, EngineMemory->FrameMemory);
-                    ToLoad->Output->Path = TexturePath;
-                    
-                    EngineMemory->AddEntry(EngineMemory->WorkQueue, LoadTextureFromDisk, ToLoad);
+                    if (Map < MaterialMap_Count)
+                    {
+                        Last->Value.MapPaths[Map] = TexturePath;
+
+                        // Only read here, and only the first time any material names the file.
+                        // Decoding waits until the packed texture missed the cache.
+
+                        if (!(Flags & ObjParseFlag_SkipTextures))
+                        {
+                            ReleaseTextureSource(Last->Value.Sources[Map]);
+                            Last->Value.Sources[Map] = AcquireTextureSource(TexturePath, EngineMemory);
+                        }
+                    }
                 }
                 else
                 {
@@ -358,13 +382,159 @@ typedef struct
 } obj_mesh_list;
 
 
+// Materials whose only texture is a small albedo, and whose UVs stay inside [0, 1], share atlas
+// pages (textures/texture_atlas.h) so their draws batch together. They are picked before the maps
+// are packed: the atlas needs their RGBA8 pixels, so they skip the texture cache.
+
+static bool *
+FindAtlasMaterials(asset_file_data *FileData, material_to_pack *Packs, memory_arena *Arena)
+{
+    bool *Result = PushArray(Arena, bool, FileData->MaterialCount);
+
+    for (uint32_t MaterialIdx = 0; MaterialIdx < FileData->MaterialCount; ++MaterialIdx)
+    {
+        material_to_pack *Pack      = Packs + MaterialIdx;
+        texture_to_load  *Color     = Pack->Loads[MaterialMap_Color];
+        texture_to_load  *Occlusion = Pack->Loads[MaterialMap_Occlusion];
+        uint32_t          Width     = Maximum(Color ? Color->Width : 0, Occlusion ? Occlusion->Width : 0);
+        uint32_t          Height    = Maximum(Color ? Color->Height : 0, Occlusion ? Occlusion->Height : 0);
+
+        Result[MaterialIdx] = FitsTextureAtlas(Width, Height) && !Pack->Loads[MaterialMap_Normal] &&
+                              !Pack->Loads[MaterialMap_Roughness] && !Pack->Loads[MaterialMap_Metalness];
+    }
+
+    for (uint32_t MeshIdx = 0; MeshIdx < FileData->MeshCount; ++MeshIdx)
+    {
+        asset_mesh_data *Mesh = FileData->Meshes + MeshIdx;
+
+        for (uint32_t SubmeshIdx = 0; SubmeshIdx < Mesh->SubmeshCount; ++SubmeshIdx)
+        {
+            asset_submesh_data *Submesh = Mesh->Submeshes + SubmeshIdx;
+
+            for (uint32_t MaterialIdx = 0; MaterialIdx < FileData->MaterialCount; ++MaterialIdx)
+            {
+                if (Result[MaterialIdx] && ByteStringCompare(Submesh->MaterialPath, FileData->Materials[MaterialIdx].Path))
+                {
+                    // A little slack for exporters that write 1.000001.
+
+                    for (uint32_t Idx = 0; Idx < Submesh->VertexCount && Result[MaterialIdx]; ++Idx)
+                    {
+                        vec2 UV = FileData->Vertices[Submesh->VertexOffset + Idx].Texture;
+                        Result[MaterialIdx] = UV.X >= -0.001f && UV.X <= 1.001f && UV.Y >= -0.001f && UV.Y <= 1.001f;
+                    }
+                }
+            }
+        }
+    }
+
+    for (uint32_t MaterialIdx = 0; MaterialIdx < FileData->MaterialCount; ++MaterialIdx)
+    {
+        Packs[MaterialIdx].Uncached[MaterialTexture_Albedo] |= Result[MaterialIdx];
+    }
+
+    return Result;
+}
+
+
+// Builds the pages once the albedo textures are packed, and moves the UVs of every submesh that uses
+// an atlased material. PageOf[MaterialIdx] is where its albedo went. The materials keep their own
+// albedo until the pages are done, see ParseObjFromFile.
+
+static loaded_texture *
+BuildMaterialAtlases(asset_file_data *FileData, bool *InAtlas, uint32_t *PageOf, byte_string Path, uint32_t *PageCount, memory_arena *Arena)
+{
+    texture_atlas_item *Items     = PushArray(Arena, texture_atlas_item, FileData->MaterialCount);
+    uint32_t           *ItemOf    = PushArray(Arena, uint32_t, FileData->MaterialCount);
+    uint32_t            ItemCount = 0;
+
+    for (uint32_t MaterialIdx = 0; MaterialIdx < FileData->MaterialCount; ++MaterialIdx)
+    {
+        loaded_texture *Albedo = &FileData->Materials[MaterialIdx].Textures[MaterialTexture_Albedo];
+
+        // The decode may have failed, or given something other than what the header said.
+
+        InAtlas[MaterialIdx] = InAtlas[MaterialIdx] && Albedo->Data && Albedo->Format == TextureFormat_RGBA8 &&
+                               Albedo->MipCount <= 1 && FitsTextureAtlas(Albedo->Width, Albedo->Height);
+
+        if (InAtlas[MaterialIdx])
+        {
+            ItemOf[MaterialIdx]      = ItemCount;
+            Items[ItemCount].Texture = Albedo;
+            ItemCount               += 1;
+        }
+    }
+
+    loaded_texture *Pages = BuildTextureAtlases(Items, ItemCount, PageCount, Arena);
+
+    for (uint32_t PageIdx = 0; PageIdx < *PageCount; ++PageIdx)
+    {
+        uint8_t  Name[16] = "atlas";
+        uint32_t Size     = 5;
+        uint8_t  Digits[10];
+        uint32_t DigitCount = 0;
+
+        for (uint32_t Value = PageIdx; DigitCount == 0 || Value; Value /= 10)
+        {
+            Digits[DigitCount++] = (uint8_t)('0' + Value % 10);
+        }
+
+        while (DigitCount)
+        {
+            Name[Size++] = Digits[--DigitCount];
+        }
+
+        byte_string NameParts[2] = {StripExtensionName(Path), ByteString(Name, Size)};
+        Pages[PageIdx].Path = ConcatenateStrings(NameParts, 2, ByteStringLiteral("::"), Arena);
+    }
+
+    for (uint32_t MeshIdx = 0; MeshIdx < FileData->MeshCount; ++MeshIdx)
+    {
+        asset_mesh_data *Mesh = FileData->Meshes + MeshIdx;
+
+        for (uint32_t SubmeshIdx = 0; SubmeshIdx < Mesh->SubmeshCount; ++SubmeshIdx)
+        {
+            asset_submesh_data *Submesh = Mesh->Submeshes + SubmeshIdx;
+
+            for (uint32_t MaterialIdx = 0; MaterialIdx < FileData->MaterialCount; ++MaterialIdx)
+            {
+                if (InAtlas[MaterialIdx] && ByteStringCompare(Submesh->MaterialPath, FileData->Materials[MaterialIdx].Path))
+                {
+                    texture_atlas_item *Item = Items + ItemOf[MaterialIdx];
+
+                    for (uint32_t Idx = 0; Idx < Submesh->VertexCount; ++Idx)
+                    {
+                        vec2 *UV = &FileData->Vertices[Submesh->VertexOffset + Idx].Texture;
+                        UV->X = Minimum(Maximum(UV->X, 0.0f), 1.0f) * Item->Scale.X + Item->Offset.X;
+                        UV->Y = Minimum(Maximum(UV->Y, 0.0f), 1.0f) * Item->Scale.Y + Item->Offset.Y;
+                    }
+
+                    break;
+                }
+            }
+        }
+    }
+
+    for (uint32_t MaterialIdx = 0; MaterialIdx < FileData->MaterialCount; ++MaterialIdx)
+    {
+        if (InAtlas[MaterialIdx])
+        {
+            PageOf[MaterialIdx] = Items[ItemOf[MaterialIdx]].Page;
+        }
+    }
+
+    return Pages;
+}
+
+
 // I still am unsure about the allocation strategy so force a huge number for now.
 #define MAX_ATTRIBUTE_PER_FILE 1'000'000
 
 
 asset_file_data
-ParseObjFromFile(byte_string Path, engine_memory *EngineMemory)
+ParseObjFromFile(byte_string Path, ObjParseFlag_Type Flags, engine_memory *EngineMemory)
 {
+    TIMED_BLOCK_BEGIN(ParseObjFromFile);
+
     asset_file_data FileData = {0};
 
     // Initialize the parsing state
@@ -372,7 +542,7 @@ ParseObjFromFile(byte_string Path, engine_memory *EngineMemory)
 
     obj_mesh_list     *MeshList          = PushStruct(EngineMemory->FrameMemory, obj_mesh_list);
     obj_material_list *MaterialList      = PushStruct(EngineMemory->FrameMemory, obj_material_list);
-    buffer             FileBuffer        = ReadFileInBuffer(Path, EngineMemory->FrameMemory);
+    buffer             FileBuffer        = ReadAssetInBuffer(Path, EngineMemory->FrameMemory);
     vec3              *PositionBuffer    = PushArray(EngineMemory->FrameMemory, vec3, MAX_ATTRIBUTE_PER_FILE);
     uint32_t           PositionCount     = 0;
     vec3              *NormalBuffer      = PushArray(EngineMemory->FrameMemory, vec3, MAX_ATTRIBUTE_PER_FILE);
@@ -384,6 +554,12 @@ ParseObjFromFile(byte_string Path, engine_memory *EngineMemory)
 
     if (IsBufferValid(&FileBuffer) && PositionBuffer && NormalBuffer && TextureBuffer && VertexBuffer && MeshList && MaterialList && EngineMemory->FrameMemory)
     {
+        TIMED_BLOCK_ELEMENTS(ParseObjFromFile, FileBuffer.Size);
+
+        // The arena may hand back memory from a popped region, nothing here can assume it is zeroed.
+        *MeshList     = (obj_mesh_list){0};
+        *MaterialList = (obj_material_list){0};
+
         while (IsBufferValid(&FileBuffer) && IsBufferInBounds(&FileBuffer))
         {
             SkipWhitespaces(&FileBuffer);
@@ -621,7 +797,7 @@ ParseObjFromFile(byte_string Path, engine_memory *EngineMemory)
                     byte_string LibName = ParseToIdentifier(&FileBuffer);
                     byte_string Lib     = ReplaceFileName(Path, LibName, EngineMemory->FrameMemory);
 
-                    for (obj_material_node *Node = ParseMTLFromFile(Lib, EngineMemory); Node != 0; Node = Node->Next)
+                    for (obj_material_node *Node = ParseMTLFromFile(Lib, Flags, EngineMemory); Node != 0; Node = Node->Next)
                     {
                         if (MaterialList)
                         {
@@ -671,10 +847,6 @@ ParseObjFromFile(byte_string Path, engine_memory *EngineMemory)
 
             case '\0':
             {
-                // Wait on all the threaded work we enqueued. This might be too early. Perhaps we want to be lazier.
-                // Issue is we can't since we copy into the materials array. It's looks easily fixable, unsure yet.
-                EngineMemory->CompleteWork(EngineMemory->WorkQueue);
-
                 FileData.Vertices      = PushArray(EngineMemory->FrameMemory, mesh_vertex_data, VertexCount);
                 FileData.VertexCount   = 0;
                 FileData.Meshes        = PushArray(EngineMemory->FrameMemory, asset_mesh_data, MeshList->Count);
@@ -682,6 +854,10 @@ ParseObjFromFile(byte_string Path, engine_memory *EngineMemory)
                 FileData.Materials     = PushArray(EngineMemory->FrameMemory, material_data, MaterialList->Count);
                 FileData.MaterialCount = 0;
 
+                // The gather from the attribute buffers, one element per vertex.
+
+                TIMED_BLOCK_BEGIN(AssembleObjVertices);
+
                 for (obj_mesh_node *MeshNode = MeshList->First; MeshNode != 0; MeshNode = MeshNode->Next)
                 {
                     obj_mesh         Mesh     = MeshNode->Value;
@@ -716,15 +892,123 @@ ParseObjFromFile(byte_string Path, engine_memory *EngineMemory)
                     }
                 }
 
+                TIMED_BLOCK_ELEMENTS(AssembleObjVertices, FileData.VertexCount);
+                TIMED_BLOCK_END(AssembleObjVertices);
+
                 for (obj_material_node *MaterialNode = MaterialList->First; MaterialNode != 0; MaterialNode = MaterialNode->Next)
                 {
                     material_data *MaterialData = FileData.Materials + FileData.MaterialCount++;
-                    MaterialData->Textures[MaterialMap_Color]     = MaterialNode->Value.ColorTexture;
-                    MaterialData->Textures[MaterialMap_Normal]    = MaterialNode->Value.NormalTexture;
-                    MaterialData->Textures[MaterialMap_Roughness] = MaterialNode->Value.RoughnessTexture;
-                    MaterialData->Opacity                         = MaterialNode->Value.Opacity;
-                    MaterialData->Shininess                       = MaterialNode->Value.Shininess;
-                    MaterialData->Path                            = MaterialNode->Value.Path;
+                    MaterialData->Opacity       = MaterialNode->Value.Opacity;
+                    MaterialData->Shininess     = MaterialNode->Value.Shininess;
+                    MaterialData->Path          = MaterialNode->Value.Path;
+
+                    for (uint32_t MapIdx = 0; MapIdx < MaterialMap_Count; ++MapIdx)
+                    {
+                        MaterialData->MapPaths[MapIdx] = MaterialNode->Value.MapPaths[MapIdx];
+                    }
+
+                    for (uint32_t TextureIdx = 0; TextureIdx < MaterialTexture_Count; ++TextureIdx)
+                    {
+                        byte_string TexturePath = MakeMaterialTexturePath(MaterialData->MapPaths, (MaterialTexture_Type)TextureIdx, EngineMemory->FrameMemory);
+                        MaterialData->Textures[TextureIdx] = (loaded_texture){.Path = TexturePath};
+                    }
+                }
+
+                if (!(Flags & ObjParseFlag_SkipTextures))
+                {
+                    material_to_pack *Packs     = PushArray(EngineMemory->FrameMemory, material_to_pack, FileData.MaterialCount);
+                    uint32_t          PackCount = 0;
+
+                    for (obj_material_node *MaterialNode = MaterialList->First; MaterialNode != 0; MaterialNode = MaterialNode->Next)
+                    {
+                        material_to_pack *Pack = Packs + PackCount;
+                        Pack->Output = FileData.Materials + PackCount;
+                        PackCount   += 1;
+
+                        for (uint32_t MapIdx = 0; MapIdx < MaterialMap_Count; ++MapIdx)
+                        {
+                            texture_source *Source = MaterialNode->Value.Sources[MapIdx];
+                            Pack->Loads[MapIdx] = Source ? &Source->Load : 0;
+
+                            // Only the reads this file started or shares, whatever else runs on the queue keeps going.
+
+                            if (Source)
+                            {
+                                EngineMemory->WaitForCounter(EngineMemory->WorkQueue, &Source->Read);
+                            }
+                        }
+
+                        for (uint32_t TextureIdx = 0; TextureIdx < MaterialTexture_Count; ++TextureIdx)
+                        {
+                            Pack->Uncached[TextureIdx] = (Flags & ObjParseFlag_SkipTextureCache) != 0;
+                        }
+                    }
+
+                    bool *InAtlas = 0;
+                    if (!(Flags & ObjParseFlag_SkipTextureAtlas))
+                    {
+                        InAtlas = FindAtlasMaterials(&FileData, Packs, EngineMemory->FrameMemory);
+                    }
+
+                    PackMaterialTextures(Packs, PackCount, EngineMemory);
+
+                    uint32_t       *PageOf    = PushArray(EngineMemory->FrameMemory, uint32_t, PackCount);
+                    uint32_t        PageCount = 0;
+                    loaded_texture *Pages     = 0;
+
+                    if (InAtlas)
+                    {
+                        Pages = BuildMaterialAtlases(&FileData, InAtlas, PageOf, Path, &PageCount, EngineMemory->FrameMemory);
+                    }
+
+                    // The pages go through the rest of the import in place of the albedo textures
+                    // they hold.
+
+                    uint32_t              MaxCount     = PackCount * MaterialTexture_Count + PageCount;
+                    loaded_texture      **Textures     = PushArray(EngineMemory->FrameMemory, loaded_texture *, MaxCount);
+                    MaterialTexture_Type *Types        = PushArray(EngineMemory->FrameMemory, MaterialTexture_Type, MaxCount);
+                    TextureFormat_Type   *Formats      = PushArray(EngineMemory->FrameMemory, TextureFormat_Type, MaxCount);
+                    uint32_t              TextureCount = 0;
+
+                    for (uint32_t MaterialIdx = 0; MaterialIdx < PackCount; ++MaterialIdx)
+                    {
+                        for (uint32_t TextureIdx = 0; TextureIdx < MaterialTexture_Count; ++TextureIdx)
+                        {
+                            if (TextureIdx != MaterialTexture_Albedo || !InAtlas || !InAtlas[MaterialIdx])
+                            {
+                                Textures[TextureCount] = &FileData.Materials[MaterialIdx].Textures[TextureIdx];
+                                Types[TextureCount]    = (MaterialTexture_Type)TextureIdx;
+                                TextureCount          += 1;
+                            }
+                        }
+                    }
+
+                    for (uint32_t PageIdx = 0; PageIdx < PageCount; ++PageIdx)
+                    {
+                        Textures[TextureCount] = Pages + PageIdx;
+                        Types[TextureCount]    = MaterialTexture_Albedo;
+                        TextureCount          += 1;
+                    }
+
+                    // Textures that came from the cache are already done, each step skips them.
+
+                    GenerateMipChains(Textures, TextureCount, MipFilter_Box, EngineMemory);
+
+                    for (uint32_t Idx = 0; Idx < TextureCount; ++Idx)
+                    {
+                        Formats[Idx] = ChooseMaterialTextureFormat(Textures[Idx], Types[Idx], TextureQuality_Fast);
+                    }
+
+                    CompressTextures(Textures, Formats, TextureCount, TextureQuality_Fast, EngineMemory);
+                    StoreCachedTextures(Textures, TextureCount, EngineMemory);
+
+                    for (uint32_t MaterialIdx = 0; MaterialIdx < PackCount && Pages; ++MaterialIdx)
+                    {
+                        if (InAtlas[MaterialIdx])
+                        {
+                            FileData.Materials[MaterialIdx].Textures[MaterialTexture_Albedo] = Pages[PageOf[MaterialIdx]];
+                        }
+                    }
                 }
                 
             } break;
@@ -736,7 +1020,20 @@ ParseObjFromFile(byte_string Path, engine_memory *EngineMemory)
 
             }
         }
+
+        // The packed textures no longer need the sources, they stay decoded for the next file that
+        // names them.
+
+        for (obj_material_node *MaterialNode = MaterialList->First; MaterialNode != 0; MaterialNode = MaterialNode->Next)
+        {
+            for (uint32_t MapIdx = 0; MapIdx < MaterialMap_Count; ++MapIdx)
+            {
+                ReleaseTextureSource(MaterialNode->Value.Sources[MapIdx]);
+            }
+        }
     }
 
+    TIMED_BLOCK_END(ParseObjFromFile);
+
     return FileData;
 }
\ No newline at end of file
@@ -4,5 +4,25 @@
 #include "engine/rendering/assets.h"
 
 
+typedef enum
+{
+    ObjParseFlag_None         = 0,
+
+    // Texture paths are still resolved, but nothing is read or decoded. No work is pushed to the
+    // queue, which makes it safe to call from inside a job (the offline baker does).
+    ObjParseFlag_SkipTextures = 1 << 0,
+
+    // Textures are decoded and encoded again instead of coming from textures/texture_cache.h, and
+    // nothing is written to the cache.
+    ObjParseFlag_SkipTextureCache = 1 << 1,
+
+    // Small albedo textures keep their own texture instead of going into a shared atlas, and the
+    // UVs are left as they are in the file.
+    ObjParseFlag_SkipTextureAtlas = 1 << 2,
+} ObjParseFlag_Type;
+
 typedef struct engine_memory engine_memory;
-asset_file_data ParseObjFromFile(byte_string Path, engine_memory *EngineMemory);
\ No newline at end of file
+
+// The texture sources read for the materials are kept for the files parsed after this one, see
+// textures/texture_sources.h. TrimTextureSources frees them once the importing is done.
+asset_file_data ParseObjFromFile(byte_string Path, ObjParseFlag_Type Flags, engine_memory *EngineMemory);
\ No newline at end of file
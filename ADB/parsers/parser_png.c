@@ -0,0 +1,1159 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "parser_png.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PNG_SSE2 1
+#include <emmintrin.h>
+#else
+#define PNG_SSE2 0
+#endif
+
+// ==============================================
+// <Inflate> : INTERNAL
+// ==============================================
+
+// Codes of up to PNG_FAST_BITS bits resolve with a single table lookup, longer ones walk the
+// canonical code ranges. With 10 bits almost every literal/length code in real images is fast.
+
+#define PNG_FAST_BITS 10
+#define PNG_FAST_MASK ((1 << PNG_FAST_BITS) - 1)
+
+
+typedef struct
+{
+    uint16_t Fast[1 << PNG_FAST_BITS]; // (Symbol << 4) | Length, 0 when the code is longer
+    uint32_t MaxCode[17];              // First code of the next length, left-aligned on 16 bits
+    uint16_t FirstCode[16];
+    uint16_t FirstSymbol[16];
+    uint16_t Symbols[288];
+} png_huffman;
+
+
+typedef struct
+{
+    uint8_t  *At;
+    uint8_t  *End;
+    uint64_t  Bits;
+    uint32_t  BitCount;
+    uint32_t  Overrun;
+
+    png_huffman Literals;
+    png_huffman Distances;
+    png_huffman Lengths;
+} png_inflate;
+
+
+static const uint16_t LengthBase[29]  = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t  LengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+static const uint16_t DistanceBase[30]  = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t  DistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static const uint8_t  CodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+
+static uint32_t
+ReverseBits(uint32_t Value, uint32_t Count)
+{
+    Value = ((Value & 0xAAAA) >> 1) | ((Value & 0x5555) << 1);
+    Value = ((Value & 0xCCCC) >> 2) | ((Value & 0x3333) << 2);
+    Value = ((Value & 0xF0F0) >> 4) | ((Value & 0x0F0F) << 4);
+    Value = ((Value & 0xFF00) >> 8) | ((Value & 0x00FF) << 8);
+
+    uint32_t Result = Value >> (16 - Count);
+    return Result;
+}
+
+
+static void
+RefillBits(png_inflate *Inflate)
+{
+    // Whole 64-bit loads while there is room, the bytes past BitCount are re-read next time and
+    // OR in the same values. The tail is fed one byte at a time and zero-padded past the end.
+
+    if (Inflate->End - Inflate->At >= 8)
+    {
+        uint64_t Word;
+        memcpy(&Word, Inflate->At, sizeof(Word));
+
+        Inflate->Bits     |= Word << Inflate->BitCount;
+        Inflate->At       += (63 - Inflate->BitCount) >> 3;
+        Inflate->BitCount |= 56;
+    }
+    else
+    {
+        while (Inflate->BitCount <= 56)
+        {
+            if (Inflate->At < Inflate->End)
+            {
+                Inflate->Bits |= (uint64_t)*Inflate->At++ << Inflate->BitCount;
+            }
+            else
+            {
+                ++Inflate->Overrun;
+            }
+
+            Inflate->BitCount += 8;
+        }
+    }
+}
+
+
+static uint32_t
+ReadBits(png_inflate *Inflate, uint32_t Count)
+{
+    if (Inflate->BitCount < Count)
+    {
+        RefillBits(Inflate);
+    }
+
+    uint32_t Result = (uint32_t)(Inflate->Bits & ((1ull << Count) - 1));
+
+    Inflate->Bits    >>= Count;
+    Inflate->BitCount -= Count;
+
+    return Result;
+}
+
+
+static bool
+BuildHuffman(png_huffman *Huffman, uint8_t *Lengths, uint32_t Count)
+{
+    uint32_t SizeCount[16] = {0};
+    uint32_t NextCode[16]  = {0};
+    bool     Result        = true;
+
+    for (uint32_t Idx = 0; Idx < Count; ++Idx)
+    {
+        ++SizeCount[Lengths[Idx]];
+    }
+
+    SizeCount[0] = 0;
+
+    // A complete code with no length past PNG_FAST_BITS writes every fast slot, the clear is only
+    // needed otherwise. Code length tables and the literals of small images are mostly like that.
+
+    uint32_t Space = 0;
+    for (uint32_t Length = 1; Length <= PNG_FAST_BITS; ++Length)
+    {
+        Space += SizeCount[Length] << (PNG_FAST_BITS - Length);
+    }
+
+    if (Space != (1u << PNG_FAST_BITS))
+    {
+        memset(Huffman->Fast, 0, sizeof(Huffman->Fast));
+    }
+
+    uint32_t Code   = 0;
+    uint32_t Symbol = 0;
+
+    for (uint32_t Length = 1; Length < 16 && Result; ++Length)
+    {
+        NextCode[Length]            = Code;
+        Huffman->FirstCode[Length]   = (uint16_t)Code;
+        Huffman->FirstSymbol[Length] = (uint16_t)Symbol;
+
+        Code   += SizeCount[Length];
+        Symbol += SizeCount[Length];
+
+        // Over-subscribed code sets are corrupt. Incomplete ones are legal (a lone distance code).
+        Result = Code <= (1u << Length);
+
+        Huffman->MaxCode[Length] = Code << (16 - Length);
+        Code <<= 1;
+    }
+
+    Huffman->MaxCode[16] = 0x10000;
+
+    for (uint32_t Idx = 0; Idx < Count && Result; ++Idx)
+    {
+        uint32_t Length = Lengths[Idx];
+        if (Length)
+        {
+            uint32_t Slot = NextCode[Length] - Huffman->FirstCode[Length] + Huffman->FirstSymbol[Length];
+            Huffman->Symbols[Slot] = (uint16_t)Idx;
+
+            if (Length <= PNG_FAST_BITS)
+            {
+                uint16_t Entry = (uint16_t)((Idx << 4) | Length);
+
+                for (uint32_t Fill = ReverseBits(NextCode[Length], Length); Fill < (1 << PNG_FAST_BITS); Fill += (1u << Length))
+                {
+                    Huffman->Fast[Fill] = Entry;
+                }
+            }
+
+            ++NextCode[Length];
+        }
+    }
+
+    return Result;
+}
+
+
+// Returns -1 on an invalid code.
+
+static int32_t
+DecodeSymbol(png_inflate *Inflate, png_huffman *Huffman)
+{
+    if (Inflate->BitCount < 16)
+    {
+        RefillBits(Inflate);
+    }
+
+    int32_t  Result = -1;
+    uint32_t Entry  = Huffman->Fast[Inflate->Bits & PNG_FAST_MASK];
+
+    if (Entry)
+    {
+        uint32_t Length = Entry & 15;
+
+        Inflate->Bits    >>= Length;
+        Inflate->BitCount -= Length;
+        Result             = (int32_t)(Entry >> 4);
+    }
+    else
+    {
+        uint32_t Code = ReverseBits((uint32_t)(Inflate->Bits & 0xFFFF), 16);
+
+        uint32_t Length = PNG_FAST_BITS + 1;
+        while (Length < 16 && Code >= Huffman->MaxCode[Length])
+        {
+            ++Length;
+        }
+
+        if (Length < 16)
+        {
+            uint32_t Slot = (Code >> (16 - Length)) - Huffman->FirstCode[Length] + Huffman->FirstSymbol[Length];
+
+            Inflate->Bits    >>= Length;
+            Inflate->BitCount -= Length;
+            Result             = Slot < 288 ? (int32_t)Huffman->Symbols[Slot] : -1;
+        }
+    }
+
+    return Result;
+}
+
+
+static bool
+ReadDynamicTables(png_inflate *Inflate)
+{
+    uint32_t LiteralCount  = ReadBits(Inflate, 5) + 257;
+    uint32_t DistanceCount = ReadBits(Inflate, 5) + 1;
+    uint32_t LengthCount   = ReadBits(Inflate, 4) + 4;
+
+    uint8_t CodeLengths[19] = {0};
+    for (uint32_t Idx = 0; Idx < LengthCount; ++Idx)
+    {
+        CodeLengths[CodeLengthOrder[Idx]] = (uint8_t)ReadBits(Inflate, 3);
+    }
+
+    bool Result = LiteralCount <= 286 && DistanceCount <= 30 && BuildHuffman(&Inflate->Lengths, CodeLengths, 19);
+
+    // Literal/length and distance lengths are one sequence, repeats may cross from one to the other.
+
+    uint8_t  Lengths[286 + 30];
+    uint32_t Total = LiteralCount + DistanceCount;
+    uint32_t Count = 0;
+
+    while (Result && Count < Total)
+    {
+        int32_t  Symbol = DecodeSymbol(Inflate, &Inflate->Lengths);
+        uint32_t Repeat = 0;
+        uint8_t  Value  = 0;
+
+        if (Symbol < 0)
+        {
+            Result = false;
+        }
+        else if (Symbol < 16)
+        {
+            Lengths[Count++] = (uint8_t)Symbol;
+        }
+        else if (Symbol == 16)
+        {
+            Result = Count > 0;
+            Repeat = ReadBits(Inflate, 2) + 3;
+            Value  = Result ? Lengths[Count - 1] : 0;
+        }
+        else if (Symbol == 17)
+        {
+            Repeat = ReadBits(Inflate, 3) + 3;
+        }
+        else
+        {
+            Repeat = ReadBits(Inflate, 7) + 11;
+        }
+
+        if (Result && Repeat)
+        {
+            Result = Count + Repeat <= Total;
+            if (Result)
+            {
+                memset(Lengths + Count, Value, Repeat);
+                Count += Repeat;
+            }
+        }
+    }
+
+    Result = Result && Lengths[256] != 0;
+    Result = Result && BuildHuffman(&Inflate->Literals, Lengths, LiteralCount);
+    Result = Result && BuildHuffman(&Inflate->Distances, Lengths + LiteralCount, DistanceCount);
+
+    return Result;
+}
+
+
+// The fixed codes never change, they are built by the first decode that needs them and shared by
+// every thread after that. Small images are mostly fixed blocks, building them per block cost more
+// than decoding the block.
+
+static png_huffman       FixedLiterals;
+static png_huffman       FixedDistances;
+static uint32_t volatile FixedTableState; // 0 not built, 1 being built, 2 ready.
+
+static void
+BuildFixedTables(void)
+{
+    if (AtomicLoad32(&FixedTableState) != 2)
+    {
+        if (AtomicCompareExchange32(&FixedTableState, 0, 1))
+        {
+            uint8_t Lengths[288];
+
+            memset(Lengths +   0, 8, 144);
+            memset(Lengths + 144, 9, 112);
+            memset(Lengths + 256, 7,  24);
+            memset(Lengths + 280, 8,   8);
+            BuildHuffman(&FixedLiterals, Lengths, 288);
+
+            memset(Lengths, 5, 30);
+            BuildHuffman(&FixedDistances, Lengths, 30);
+
+            AtomicStore32(&FixedTableState, 2);
+        }
+        else
+        {
+            while (AtomicLoad32(&FixedTableState) != 2)
+            {
+                // Another thread is building them, that is a few microseconds.
+            }
+        }
+    }
+}
+
+
+static void
+CopyMatch(uint8_t *Out, uint8_t *OutEnd, uint32_t Distance, uint32_t Length)
+{
+    uint8_t *From = Out - Distance;
+
+#if PNG_SSE2
+    // 16-byte chunks may write up to 15 bytes past the match, which the next symbols overwrite.
+    // Only safe when the chunks do not overlap their source and do not run off the buffer.
+
+    if (Distance >= 16 && (uint64_t)(OutEnd - Out) >= Length + 16)
+    {
+        for (uint32_t Copied = 0; Copied < Length; Copied += 16)
+        {
+            _mm_storeu_si128((__m128i *)(Out + Copied), _mm_loadu_si128((__m128i *)(From + Copied)));
+        }
+    }
+    else
+#else
+    (void)OutEnd;
+#endif
+    if (Distance == 1)
+    {
+        memset(Out, *From, Length);
+    }
+    else if (Distance >= Length)
+    {
+        memcpy(Out, From, Length);
+    }
+    else
+    {
+        for (uint32_t Idx = 0; Idx < Length; ++Idx)
+        {
+            Out[Idx] = From[Idx];
+        }
+    }
+}
+
+
+static bool
+InflateBlock(png_inflate *Inflate, png_huffman *Literals, png_huffman *Distances, uint8_t *Start, uint8_t **Out, uint8_t *OutEnd)
+{
+    bool     Result = true;
+    uint8_t *At     = *Out;
+
+    for (;;)
+    {
+        int32_t Symbol = DecodeSymbol(Inflate, Literals);
+
+        if (Symbol < 256)
+        {
+            if (Symbol < 0 || At >= OutEnd)
+            {
+                Result = false;
+                break;
+            }
+
+            *At++ = (uint8_t)Symbol;
+        }
+        else if (Symbol == 256)
+        {
+            break;
+        }
+        else
+        {
+            Symbol -= 257;
+            if (Symbol >= 29)
+            {
+                Result = false;
+                break;
+            }
+
+            uint32_t Length = LengthBase[Symbol] + ReadBits(Inflate, LengthExtra[Symbol]);
+
+            int32_t DistanceSymbol = DecodeSymbol(Inflate, Distances);
+            if (DistanceSymbol < 0 || DistanceSymbol >= 30)
+            {
+                Result = false;
+                break;
+            }
+
+            uint32_t Distance = DistanceBase[DistanceSymbol] + ReadBits(Inflate, DistanceExtra[DistanceSymbol]);
+
+            if (Distance > (uint64_t)(At - Start) || Length > (uint64_t)(OutEnd - At))
+            {
+                Result = false;
+                break;
+            }
+
+            CopyMatch(At, OutEnd, Distance, Length);
+            At += Length;
+        }
+    }
+
+    *Out = At;
+    return Result;
+}
+
+
+static bool
+ReadStoredBlock(png_inflate *Inflate, uint8_t **Out, uint8_t *OutEnd)
+{
+    ReadBits(Inflate, Inflate->BitCount & 7);
+
+    uint32_t Length  = ReadBits(Inflate, 16);
+    uint32_t NLength = ReadBits(Inflate, 16);
+    bool     Result  = (Length ^ 0xFFFF) == NLength && Length <= (uint64_t)(OutEnd - *Out);
+
+    // Drain what is already in the bit buffer, then copy the rest straight from the input.
+
+    while (Result && Length && Inflate->BitCount >= 8)
+    {
+        *(*Out)++ = (uint8_t)ReadBits(Inflate, 8);
+        --Length;
+    }
+
+    if (Result && Length)
+    {
+        Inflate->Bits     = 0;
+        Inflate->BitCount = 0;
+
+        // Draining must not have reached the zero padding, those bytes were never in the input.
+        Result = Inflate->Overrun == 0 && Length <= (uint64_t)(Inflate->End - Inflate->At);
+        if (Result)
+        {
+            memcpy(*Out, Inflate->At, Length);
+
+            *Out        += Length;
+            Inflate->At += Length;
+        }
+    }
+
+    return Result;
+}
+
+
+static bool
+Inflate(png_inflate *Inflate, uint8_t *Input, uint64_t InputSize, uint8_t *Output, uint64_t OutputSize)
+{
+    // zlib wrapper: deflate, no preset dictionary, valid header check. The Adler-32 trailer is not
+    // verified, the image data would have failed to decode long before.
+
+    bool Result = InputSize >= 2 && (Input[0] & 15) == 8 && (Input[1] & 32) == 0 && ((Input[0] << 8) | Input[1]) % 31 == 0;
+
+    Inflate->At       = Input + 2;
+    Inflate->End      = Input + InputSize;
+    Inflate->Bits     = 0;
+    Inflate->BitCount = 0;
+    Inflate->Overrun  = 0;
+
+    uint8_t *Out     = Output;
+    uint8_t *OutEnd  = Output + OutputSize;
+    bool     IsFinal = false;
+
+    while (Result && !IsFinal)
+    {
+        IsFinal = ReadBits(Inflate, 1);
+
+        switch (ReadBits(Inflate, 2))
+        {
+
+        case 0:
+        {
+            Result = ReadStoredBlock(Inflate, &Out, OutEnd);
+        } break;
+
+        case 1:
+        {
+            BuildFixedTables();
+            Result = InflateBlock(Inflate, &FixedLiterals, &FixedDistances, Output, &Out, OutEnd);
+        } break;
+
+        case 2:
+        {
+            Result = ReadDynamicTables(Inflate) && InflateBlock(Inflate, &Inflate->Literals, &Inflate->Distances, Output, &Out, OutEnd);
+        } break;
+
+        default:
+        {
+            Result = false;
+        } break;
+
+        }
+
+        // Zero padding past the end of the input is fine to peek at, consuming it is not.
+        Result = Result && Inflate->Overrun * 8 <= Inflate->BitCount;
+    }
+
+    Result = Result && Out == OutEnd;
+    return Result;
+}
+
+// ==============================================
+// <Unfiltering> : INTERNAL
+// ==============================================
+
+
+typedef enum
+{
+    PNGFilter_None    = 0,
+    PNGFilter_Sub     = 1,
+    PNGFilter_Up      = 2,
+    PNGFilter_Average = 3,
+    PNGFilter_Paeth   = 4,
+} PNGFilter_Type;
+
+
+static uint8_t
+PaethPredictor(int32_t A, int32_t B, int32_t C)
+{
+    int32_t P  = A + B - C;
+    int32_t PA = P > A ? P - A : A - P;
+    int32_t PB = P > B ? P - B : B - P;
+    int32_t PC = P > C ? P - C : C - P;
+
+    uint8_t Result = (uint8_t)((PA <= PB && PA <= PC) ? A : (PB <= PC ? B : C));
+    return Result;
+}
+
+
+static void
+UnfilterRowScalar(PNGFilter_Type Filter, uint8_t *Row, uint8_t *Prior, uint32_t Size, uint32_t Stride)
+{
+    switch (Filter)
+    {
+
+    case PNGFilter_Sub:
+    {
+        for (uint32_t Idx = Stride; Idx < Size; ++Idx)
+        {
+            Row[Idx] += Row[Idx - Stride];
+        }
+    } break;
+
+    case PNGFilter_Up:
+    {
+        for (uint32_t Idx = 0; Idx < Size; ++Idx)
+        {
+            Row[Idx] += Prior[Idx];
+        }
+    } break;
+
+    case PNGFilter_Average:
+    {
+        for (uint32_t Idx = 0; Idx < Size; ++Idx)
+        {
+            uint32_t Left = Idx >= Stride ? Row[Idx - Stride] : 0;
+            Row[Idx] += (uint8_t)((Left + Prior[Idx]) >> 1);
+        }
+    } break;
+
+    case PNGFilter_Paeth:
+    {
+        for (uint32_t Idx = 0; Idx < Size; ++Idx)
+        {
+            int32_t Left      = Idx >= Stride ? Row[Idx - Stride]   : 0;
+            int32_t UpperLeft = Idx >= Stride ? Prior[Idx - Stride] : 0;
+
+            Row[Idx] += PaethPredictor(Left, Prior[Idx], UpperLeft);
+        }
+    } break;
+
+    default:
+    {
+    } break;
+
+    }
+}
+
+
+#if PNG_SSE2
+
+// Sub, Average and Paeth depend on the pixel to the left, so only the bytes of one pixel are
+// processed together. Up has no such dependency and runs 16 bytes at a time.
+
+static __m128i
+LoadPixel(uint8_t *At, uint32_t Stride)
+{
+    uint32_t Value = 0;
+
+    if (Stride == 4)
+    {
+        memcpy(&Value, At, 4);
+    }
+    else
+    {
+        Value = At[0] | ((uint32_t)At[1] << 8) | ((uint32_t)At[2] << 16);
+    }
+
+    __m128i Result = _mm_cvtsi32_si128((int)Value);
+    return Result;
+}
+
+
+static void
+StorePixel(uint8_t *At, __m128i Pixel, uint32_t Stride)
+{
+    uint32_t Value = (uint32_t)_mm_cvtsi128_si32(Pixel);
+
+    if (Stride == 4)
+    {
+        memcpy(At, &Value, 4);
+    }
+    else
+    {
+        At[0] = (uint8_t)(Value >>  0);
+        At[1] = (uint8_t)(Value >>  8);
+        At[2] = (uint8_t)(Value >> 16);
+    }
+}
+
+
+static void
+UnfilterRowSSE2(PNGFilter_Type Filter, uint8_t *Row, uint8_t *Prior, uint32_t Size, uint32_t Stride)
+{
+    __m128i Zero = _mm_setzero_si128();
+
+    switch (Filter)
+    {
+
+    case PNGFilter_Sub:
+    {
+        __m128i Left = Zero;
+        for (uint32_t Idx = 0; Idx < Size; Idx += Stride)
+        {
+            Left = _mm_add_epi8(LoadPixel(Row + Idx, Stride), Left);
+            StorePixel(Row + Idx, Left, Stride);
+        }
+    } break;
+
+    case PNGFilter_Up:
+    {
+        uint32_t Idx = 0;
+        for (; Idx + 16 <= Size; Idx += 16)
+        {
+            __m128i Value = _mm_add_epi8(_mm_loadu_si128((__m128i *)(Row + Idx)), _mm_loadu_si128((__m128i *)(Prior + Idx)));
+            _mm_storeu_si128((__m128i *)(Row + Idx), Value);
+        }
+
+        for (; Idx < Size; ++Idx)
+        {
+            Row[Idx] += Prior[Idx];
+        }
+    } break;
+
+    case PNGFilter_Average:
+    {
+        // avg_epu8 rounds up, the filter rounds down: subtract the carry of the odd sums.
+
+        __m128i One  = _mm_set1_epi8(1);
+        __m128i Left = Zero;
+
+        for (uint32_t Idx = 0; Idx < Size; Idx += Stride)
+        {
+            __m128i Up      = LoadPixel(Prior + Idx, Stride);
+            __m128i Average = _mm_sub_epi8(_mm_avg_epu8(Left, Up), _mm_and_si128(_mm_xor_si128(Left, Up), One));
+
+            Left = _mm_add_epi8(LoadPixel(Row + Idx, Stride), Average);
+            StorePixel(Row + Idx, Left, Stride);
+        }
+    } break;
+
+    case PNGFilter_Paeth:
+    {
+        // Works on 16-bit lanes. With P = A + B - C: |P - A| = |B - C|, |P - B| = |A - C| and
+        // |P - C| = |(A - C) + (B - C)|.
+
+        __m128i A = Zero;
+        __m128i C = Zero;
+
+        for (uint32_t Idx = 0; Idx < Size; Idx += Stride)
+        {
+            __m128i B = _mm_unpacklo_epi8(LoadPixel(Prior + Idx, Stride), Zero);
+            __m128i X = _mm_unpacklo_epi8(LoadPixel(Row + Idx, Stride), Zero);
+
+            __m128i BC = _mm_sub_epi16(B, C);
+            __m128i AC = _mm_sub_epi16(A, C);
+
+            __m128i PA = _mm_max_epi16(BC, _mm_sub_epi16(Zero, BC));
+            __m128i PB = _mm_max_epi16(AC, _mm_sub_epi16(Zero, AC));
+            __m128i PC = _mm_add_epi16(BC, AC);
+            PC         = _mm_max_epi16(PC, _mm_sub_epi16(Zero, PC));
+
+            __m128i UseA = _mm_and_si128(_mm_cmpgt_epi16(_mm_add_epi16(PB, _mm_set1_epi16(1)), PA), _mm_cmpgt_epi16(_mm_add_epi16(PC, _mm_set1_epi16(1)), PA));
+            __m128i UseB = _mm_andnot_si128(UseA, _mm_cmpgt_epi16(_mm_add_epi16(PC, _mm_set1_epi16(1)), PB));
+            __m128i UseC = _mm_andnot_si128(_mm_or_si128(UseA, UseB), _mm_set1_epi16(-1));
+
+            __m128i Predictor = _mm_or_si128(_mm_or_si128(_mm_and_si128(UseA, A), _mm_and_si128(UseB, B)), _mm_and_si128(UseC, C));
+
+            A = _mm_and_si128(_mm_add_epi16(X, Predictor), _mm_set1_epi16(0xFF));
+            C = B;
+
+            StorePixel(Row + Idx, _mm_packus_epi16(A, Zero), Stride);
+        }
+    } break;
+
+    default:
+    {
+    } break;
+
+    }
+}
+
+#endif
+
+
+static bool
+UnfilterImage(uint8_t *Filtered, uint32_t Height, uint32_t RowSize, uint32_t Stride, uint8_t *ZeroRow)
+{
+    bool     Result = true;
+    uint8_t *Prior  = ZeroRow;
+
+    memset(ZeroRow, 0, RowSize);
+
+    for (uint32_t Y = 0; Y < Height && Result; ++Y)
+    {
+        uint8_t        *Row    = Filtered + (uint64_t)Y * (RowSize + 1);
+        PNGFilter_Type  Filter = (PNGFilter_Type)Row[0];
+
+        Row += 1;
+        Result = Filter <= PNGFilter_Paeth;
+
+#if PNG_SSE2
+        // The pixel loads and stores move Stride bytes, rows are always a whole number of pixels here.
+        if (Stride == 3 || Stride == 4)
+        {
+            UnfilterRowSSE2(Filter, Row, Prior, RowSize, Stride);
+        }
+        else
+#endif
+        {
+            UnfilterRowScalar(Filter, Row, Prior, RowSize, Stride);
+        }
+
+        Prior = Row;
+    }
+
+    return Result;
+}
+
+// ==============================================
+// <Conversion> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    uint32_t Palette[256];
+    bool     HasTransparentKey;
+    uint16_t TransparentKey[3];
+} png_color_state;
+
+
+static uint32_t
+PackRGBA(uint32_t R, uint32_t G, uint32_t B, uint32_t A)
+{
+    uint32_t Result = R | (G << 8) | (B << 16) | (A << 24);
+    return Result;
+}
+
+
+static uint32_t
+ReadSample(uint8_t *Row, uint32_t Index, uint32_t BitDepth)
+{
+    uint32_t Result = 0;
+
+    switch (BitDepth)
+    {
+    case 16: Result = ((uint32_t)Row[Index * 2] << 8) | Row[Index * 2 + 1];              break;
+    case 8:  Result = Row[Index];                                                         break;
+    default: Result = (Row[(Index * BitDepth) >> 3] >> (8 - BitDepth - ((Index * BitDepth) & 7))) & ((1u << BitDepth) - 1); break;
+    }
+
+    return Result;
+}
+
+
+static uint32_t
+ScaleSample(uint32_t Sample, uint32_t BitDepth)
+{
+    static const uint32_t Scales[9] = {0, 255, 85, 0, 17, 0, 0, 0, 1};
+
+    uint32_t Result = BitDepth == 16 ? Sample >> 8 : Sample * Scales[BitDepth];
+    return Result;
+}
+
+
+static void
+ExpandRow(uint8_t *Row, uint32_t *Out, png_info Info, png_color_state *State)
+{
+    uint32_t Width = Info.Width;
+    uint32_t Depth = Info.BitDepth;
+
+    switch (Info.ColorType)
+    {
+
+    case 0:
+    {
+        if (Depth == 8 && !State->HasTransparentKey)
+        {
+            for (uint32_t X = 0; X < Width; ++X)
+            {
+                Out[X] = PackRGBA(Row[X], Row[X], Row[X], 255);
+            }
+        }
+        else
+        {
+            for (uint32_t X = 0; X < Width; ++X)
+            {
+                uint32_t Sample = ReadSample(Row, X, Depth);
+                uint32_t Gray   = ScaleSample(Sample, Depth);
+                uint32_t Alpha  = State->HasTransparentKey && Sample == State->TransparentKey[0] ? 0 : 255;
+
+                Out[X] = PackRGBA(Gray, Gray, Gray, Alpha);
+            }
+        }
+    } break;
+
+    case 2:
+    {
+        if (Depth == 8 && !State->HasTransparentKey)
+        {
+            for (uint32_t X = 0; X < Width; ++X)
+            {
+                uint8_t *Pixel = Row + X * 3;
+                Out[X] = PackRGBA(Pixel[0], Pixel[1], Pixel[2], 255);
+            }
+        }
+        else
+        {
+            for (uint32_t X = 0; X < Width; ++X)
+            {
+                uint32_t R = ReadSample(Row, X * 3 + 0, Depth);
+                uint32_t G = ReadSample(Row, X * 3 + 1, Depth);
+                uint32_t B = ReadSample(Row, X * 3 + 2, Depth);
+
+                bool IsKey = State->HasTransparentKey && R == State->TransparentKey[0] && G == State->TransparentKey[1] && B == State->TransparentKey[2];
+
+                Out[X] = PackRGBA(ScaleSample(R, Depth), ScaleSample(G, Depth), ScaleSample(B, Depth), IsKey ? 0 : 255);
+            }
+        }
+    } break;
+
+    case 3:
+    {
+        for (uint32_t X = 0; X < Width; ++X)
+        {
+            Out[X] = State->Palette[ReadSample(Row, X, Depth)];
+        }
+    } break;
+
+    case 4:
+    {
+        if (Depth == 8)
+        {
+            for (uint32_t X = 0; X < Width; ++X)
+            {
+                uint8_t *Pixel = Row + X * 2;
+                Out[X] = PackRGBA(Pixel[0], Pixel[0], Pixel[0], Pixel[1]);
+            }
+        }
+        else
+        {
+            for (uint32_t X = 0; X < Width; ++X)
+            {
+                uint32_t Gray  = ScaleSample(ReadSample(Row, X * 2 + 0, Depth), Depth);
+                uint32_t Alpha = ScaleSample(ReadSample(Row, X * 2 + 1, Depth), Depth);
+
+                Out[X] = PackRGBA(Gray, Gray, Gray, Alpha);
+            }
+        }
+    } break;
+
+    case 6:
+    {
+        if (Depth == 8)
+        {
+            memcpy(Out, Row, (uint64_t)Width * 4);
+        }
+        else
+        {
+            for (uint32_t X = 0; X < Width; ++X)
+            {
+                uint8_t *Pixel = Row + X * 8;
+                Out[X] = PackRGBA(Pixel[0], Pixel[2], Pixel[4], Pixel[6]);
+            }
+        }
+    } break;
+
+    default:
+    {
+    } break;
+
+    }
+}
+
+
+static uint32_t
+GetChannelCount(uint32_t ColorType)
+{
+    static const uint32_t Channels[7] = {1, 0, 3, 1, 2, 0, 4};
+
+    uint32_t Result = ColorType < 7 ? Channels[ColorType] : 0;
+    return Result;
+}
+
+
+static uint32_t
+ReadU32BigEndian(uint8_t *At)
+{
+    uint32_t Result = ((uint32_t)At[0] << 24) | ((uint32_t)At[1] << 16) | ((uint32_t)At[2] << 8) | At[3];
+    return Result;
+}
+
+
+static uint64_t
+AlignScratch(uint64_t Offset)
+{
+    uint64_t Result = (Offset + 15) & ~15ull;
+    return Result;
+}
+
+// ==============================================
+// <.PNG File Parsing> : PUBLIC
+// ==============================================
+
+
+png_info
+ReadPNGInfo(uint8_t *Data, uint64_t Size)
+{
+    static const uint8_t Signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+    png_info Result = {0};
+
+    if (Data && Size >= 33 && memcmp(Data, Signature, 8) == 0 && ReadU32BigEndian(Data + 8) == 13 && memcmp(Data + 12, "IHDR", 4) == 0)
+    {
+        Result.Width     = ReadU32BigEndian(Data + 16);
+        Result.Height    = ReadU32BigEndian(Data + 20);
+        Result.BitDepth  = Data[24];
+        Result.ColorType = Data[25];
+        Result.Interlace = Data[28];
+
+        uint32_t Depth         = Result.BitDepth;
+        bool     IsValidDepth  = false;
+
+        switch (Result.ColorType)
+        {
+        case 0:  IsValidDepth = Depth == 1 || Depth == 2 || Depth == 4 || Depth == 8 || Depth == 16; break;
+        case 3:  IsValidDepth = Depth == 1 || Depth == 2 || Depth == 4 || Depth == 8;                break;
+        case 2:
+        case 4:
+        case 6:  IsValidDepth = Depth == 8 || Depth == 16;                                           break;
+        default: IsValidDepth = false;                                                               break;
+        }
+
+        // The size limit keeps every row and offset computation inside 32 bits.
+        Result.IsSupported = IsValidDepth && Data[26] == 0 && Data[27] == 0 && Result.Interlace == 0 &&
+                             Result.Width > 0 && Result.Height > 0 && Result.Width <= (1 << 14) && Result.Height <= (1 << 14);
+    }
+
+    return Result;
+}
+
+
+uint64_t
+GetPNGScratchSize(png_info Info, uint64_t FileSize)
+{
+    uint64_t RowSize = ((uint64_t)Info.Width * GetChannelCount(Info.ColorType) * Info.BitDepth + 7) / 8;
+
+    uint64_t Result = AlignScratch(sizeof(png_inflate));
+    Result += AlignScratch(sizeof(png_color_state));
+    Result += AlignScratch(FileSize);
+    Result += AlignScratch((RowSize + 1) * Info.Height);
+    Result += AlignScratch(RowSize);
+
+    return Result;
+}
+
+
+bool
+DecodePNG(uint8_t *Data, uint64_t Size, uint8_t *Pixels, uint8_t *Scratch, uint64_t ScratchSize, bool FlipVertically)
+{
+    png_info Info   = ReadPNGInfo(Data, Size);
+    bool     Result = Info.IsSupported && Pixels && Scratch && ScratchSize >= GetPNGScratchSize(Info, Size);
+
+    if (Result)
+    {
+        uint32_t Channels = GetChannelCount(Info.ColorType);
+        uint32_t RowSize  = (Info.Width * Channels * Info.BitDepth + 7) / 8;
+        uint32_t Stride   = (Channels * Info.BitDepth + 7) / 8;
+
+        uint64_t         Offset   = 0;
+        png_inflate     *Inflater = (png_inflate *)(Scratch + Offset);  Offset += AlignScratch(sizeof(png_inflate));
+        png_color_state *State    = (png_color_state *)(Scratch + Offset); Offset += AlignScratch(sizeof(png_color_state));
+        uint8_t         *Packed   = Scratch + Offset;                    Offset += AlignScratch(Size);
+        uint8_t         *Filtered = Scratch + Offset;                    Offset += AlignScratch((uint64_t)(RowSize + 1) * Info.Height);
+        uint8_t         *ZeroRow  = Scratch + Offset;
+
+        for (uint32_t Idx = 0; Info.ColorType == 3 && Idx < 256; ++Idx)
+        {
+            State->Palette[Idx] = PackRGBA(0, 0, 0, 255);
+        }
+
+        State->HasTransparentKey = false;
+
+        // Walk the chunks, gathering every IDAT into one contiguous zlib stream. CRCs are not checked.
+        // A single IDAT, what small images have, is inflated where it is in the file.
+
+        uint8_t *Stream      = 0;
+        uint64_t PackedSize  = 0;
+        uint64_t ChunkAt     = 8;
+        bool     HasPalette  = false;
+        bool     IsEnd       = false;
+
+        while (Result && !IsEnd && ChunkAt + 12 <= Size)
+        {
+            uint32_t ChunkSize = ReadU32BigEndian(Data + ChunkAt);
+            uint8_t *Type      = Data + ChunkAt + 4;
+            uint8_t *Body      = Data + ChunkAt + 8;
+
+            Result = ChunkSize <= Size - ChunkAt - 12;
+            if (!Result)
+            {
+                break;
+            }
+
+            if (memcmp(Type, "IDAT", 4) == 0)
+            {
+                if (!PackedSize)
+                {
+                    Stream = Body;
+                }
+                else
+                {
+                    if (Stream != Packed)
+                    {
+                        memcpy(Packed, Stream, PackedSize);
+                        Stream = Packed;
+                    }
+
+                    memcpy(Packed + PackedSize, Body, ChunkSize);
+                }
+
+                PackedSize += ChunkSize;
+            }
+            else if (memcmp(Type, "PLTE", 4) == 0)
+            {
+                Result     = ChunkSize % 3 == 0 && ChunkSize / 3 <= 256;
+                HasPalette = true;
+
+                for (uint32_t Idx = 0; Result && Idx < ChunkSize / 3; ++Idx)
+                {
+                    State->Palette[Idx] = PackRGBA(Body[Idx * 3 + 0], Body[Idx * 3 + 1], Body[Idx * 3 + 2], 255);
+                }
+            }
+            else if (memcmp(Type, "tRNS", 4) == 0)
+            {
+                if (Info.ColorType == 3)
+                {
+                    Result = ChunkSize <= 256;
+                    for (uint32_t Idx = 0; Result && Idx < ChunkSize; ++Idx)
+                    {
+                        State->Palette[Idx] = (State->Palette[Idx] & 0x00FFFFFF) | ((uint32_t)Body[Idx] << 24);
+                    }
+                }
+                else if (Info.ColorType == 0 || Info.ColorType == 2)
+                {
+                    Result = ChunkSize == Channels * 2;
+                    for (uint32_t Idx = 0; Result && Idx < Channels; ++Idx)
+                    {
+                        State->TransparentKey[Idx] = (uint16_t)((Body[Idx * 2] << 8) | Body[Idx * 2 + 1]);
+                    }
+
+                    State->HasTransparentKey = Result;
+                }
+            }
+            else if (memcmp(Type, "IEND", 4) == 0)
+            {
+                IsEnd = true;
+            }
+            else if (memcmp(Type, "IHDR", 4) == 0)
+            {
+                // Already read by ReadPNGInfo.
+            }
+            else
+            {
+                // Bit 5 of the first letter clear means critical: we cannot skip what we do not know.
+                Result = (Type[0] & 32) != 0;
+            }
+
+            ChunkAt += (uint64_t)ChunkSize + 12;
+        }
+
+        Result = Result && PackedSize && (Info.ColorType != 3 || HasPalette);
+        Result = Result && Inflate(Inflater, Stream, PackedSize, Filtered, (uint64_t)(RowSize + 1) * Info.Height);
+        Result = Result && UnfilterImage(Filtered, Info.Height, RowSize, Stride, ZeroRow);
+
+        for (uint32_t Y = 0; Result && Y < Info.Height; ++Y)
+        {
+            uint8_t  *Row    = Filtered + (uint64_t)Y * (RowSize + 1) + 1;
+            uint32_t  OutY   = FlipVertically ? Info.Height - 1 - Y : Y;
+            uint32_t *OutRow = (uint32_t *)(Pixels + (uint64_t)OutY * Info.Width * 4);
+
+            ExpandRow(Row, OutRow, Info, State);
+        }
+    }
+
+    return Result;
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+
+// ==============================================
+// <.PNG File Parsing>
+// ==============================================
+
+// Non-interlaced PNGs of every color type and bit depth decode to RGBA8 here. Anything else
+// (interlaced images, other formats, files we reject) is left to stb_image by the caller.
+
+
+typedef struct
+{
+    uint32_t Width;
+    uint32_t Height;
+    uint8_t  BitDepth;
+    uint8_t  ColorType;
+    uint8_t  Interlace;
+    bool     IsSupported;
+} png_info;
+
+
+// Only needs the first 33 bytes of the file.
+png_info ReadPNGInfo       (uint8_t *Data, uint64_t Size);
+
+// The decoder does not allocate. Pixels must hold Width * Height * 4 bytes and Scratch must hold
+// GetPNGScratchSize bytes, both are written from whichever thread runs the decode.
+uint64_t GetPNGScratchSize (png_info Info, uint64_t FileSize);
+bool     DecodePNG         (uint8_t *Data, uint64_t Size, uint8_t *Pixels, uint8_t *Scratch, uint64_t ScratchSize, bool FlipVertically);
\ No newline at end of file
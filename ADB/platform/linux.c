@@ -0,0 +1,677 @@
+#ifdef __linux__
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
+#include <ucontext.h>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "utilities.h"
+#include "platform.h"
+#include "work_queue.h"
+
+// Headless/tool platform layer. There is no window or renderer here, this only provides what the
+// command-line tools and the engine code need from the OS.
+
+// ==============================================
+// <Memory> : PUBLIC
+// ==============================================
+
+void *OSReserve(size_t Size)
+{
+	void *Result = mmap(0, Size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (Result == MAP_FAILED)
+	{
+		Result = 0;
+	}
+
+	return Result;
+}
+
+bool OSCommit(void *At, size_t Size)
+{
+	bool Result = At && mprotect(At, Size, PROT_READ | PROT_WRITE) == 0;
+	return Result;
+}
+
+void OSRelease(void *At, size_t Size)
+{
+	munmap(At, Size);
+}
+
+// ==============================================
+// <Timing> : PUBLIC
+// ==============================================
+
+uint64_t OSReadTimer(void)
+{
+	struct timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+
+	uint64_t Result = (uint64_t)Time.tv_sec * 1000000000ull + (uint64_t)Time.tv_nsec;
+	return Result;
+}
+
+uint64_t OSGetTimerFrequency(void)
+{
+	return 1000000000ull;
+}
+
+// Type and config of each PerfCounter_Type for perf_event_open.
+
+static const uint64_t LinuxPerfEvents[PerfCounter_Count][2] =
+{
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+bool OSOpenPerfCounters(os_perf_counters *Counters)
+{
+	Counters->Group     = -1;
+	Counters->Available = 0;
+
+	for (uint32_t Type = 0; Type < PerfCounter_Count; ++Type)
+	{
+		struct perf_event_attr Attribute = {0};
+		Attribute.size           = sizeof(Attribute);
+		Attribute.type           = (uint32_t)LinuxPerfEvents[Type][0];
+		Attribute.config         = LinuxPerfEvents[Type][1];
+		Attribute.read_format    = PERF_FORMAT_GROUP;
+		Attribute.exclude_kernel = 1;
+		Attribute.exclude_hv     = 1;
+
+		int Descriptor = (int)syscall(SYS_perf_event_open, &Attribute, 0, -1, Counters->Group, PERF_FLAG_FD_CLOEXEC);
+		if (Descriptor >= 0)
+		{
+			Counters->Group      = Counters->Group < 0 ? Descriptor : Counters->Group;
+			Counters->Available |= 1u << Type;
+		}
+	}
+
+	bool Result = Counters->Group >= 0;
+	return Result;
+}
+
+void OSReadPerfCounters(os_perf_counters *Counters, uint64_t Values[PerfCounter_Count])
+{
+	// A group read is the number of counters, then their values in the order they were opened.
+
+	uint64_t Group[1 + PerfCounter_Count] = {0};
+	bool     Read                         = Counters->Group >= 0 && read(Counters->Group, Group, sizeof(Group)) > 0;
+	uint32_t Member                       = 0;
+
+	for (uint32_t Type = 0; Type < PerfCounter_Count; ++Type)
+	{
+		bool Counted = Read && (Counters->Available & (1u << Type)) && Member < Group[0];
+		Values[Type] = Counted ? Group[1 + Member++] : 0;
+	}
+}
+
+// ==============================================
+// <Files> : PUBLIC
+// ==============================================
+
+os_file_list OSListDirectory(byte_string Path, memory_arena *Arena)
+{
+	os_file_list Result = {0};
+
+	if (IsValidByteString(Path) && Arena)
+	{
+		DIR *Directory = opendir((const char *)Path.Data);
+		if (Directory)
+		{
+			for (struct dirent *Entry = readdir(Directory); Entry != 0; Entry = readdir(Directory))
+			{
+				if (strcmp(Entry->d_name, ".") == 0 || strcmp(Entry->d_name, "..") == 0)
+				{
+					continue;
+				}
+
+				os_file_node *Node = PushStruct(Arena, os_file_node);
+				if (Node)
+				{
+					byte_string PathParts[2] = {Path, ByteString((uint8_t *)Entry->d_name, strlen(Entry->d_name))};
+
+					Node->Next        = 0;
+					Node->Path        = ConcatenateStrings(PathParts, 2, ByteStringLiteral("/"), Arena);
+					Node->IsDirectory = Entry->d_type == DT_DIR;
+
+					if (Entry->d_type == DT_UNKNOWN)
+					{
+						struct stat Stat;
+						if (stat((const char *)Node->Path.Data, &Stat) == 0)
+						{
+							Node->IsDirectory = S_ISDIR(Stat.st_mode);
+						}
+					}
+
+					if (!Result.First)
+					{
+						Result.First = Node;
+						Result.Last  = Node;
+					}
+					else
+					{
+						Result.Last->Next = Node;
+						Result.Last       = Node;
+					}
+
+					++Result.Count;
+				}
+			}
+
+			closedir(Directory);
+		}
+	}
+
+	return Result;
+}
+
+bool OSCreateDirectory(byte_string Path)
+{
+	bool Result = false;
+
+	if (IsValidByteString(Path))
+	{
+		Result = mkdir((const char *)Path.Data, 0755) == 0 || errno == EEXIST;
+	}
+
+	return Result;
+}
+
+bool OSDeleteFile(byte_string Path)
+{
+	bool Result = false;
+
+	if (IsValidByteString(Path))
+	{
+		Result = unlink((const char *)Path.Data) == 0;
+	}
+
+	return Result;
+}
+
+bool OSDeleteDirectory(byte_string Path)
+{
+	bool Result = false;
+
+	if (IsValidByteString(Path))
+	{
+		Result = rmdir((const char *)Path.Data) == 0;
+	}
+
+	return Result;
+}
+
+buffer OSMapFile(byte_string Path)
+{
+	buffer Result = {0};
+
+	if (IsValidByteString(Path))
+	{
+		int File = open((const char *)Path.Data, O_RDONLY);
+		if (File >= 0)
+		{
+			struct stat Stat;
+			if (fstat(File, &Stat) == 0 && Stat.st_size > 0)
+			{
+				void *Data = mmap(0, (size_t)Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+				if (Data != MAP_FAILED)
+				{
+					Result.Data = (uint8_t *)Data;
+					Result.Size = (size_t)Stat.st_size;
+				}
+			}
+
+			close(File);
+		}
+	}
+
+	return Result;
+}
+
+void OSUnmapFile(buffer *File)
+{
+	if (File && File->Data)
+	{
+		munmap(File->Data, File->Size);
+
+		File->Data = 0;
+		File->Size = 0;
+	}
+}
+
+// ==============================================
+// <Threading> : INTERNAL
+// ==============================================
+
+
+typedef struct os_semaphore
+{
+    sem_t Handle;
+} os_semaphore;
+
+
+typedef struct
+{
+    os_thread_proc *Proc;
+    void           *Parameter;
+} linux_thread_start;
+
+
+static void *
+LinuxThreadProc(void *Parameter)
+{
+    linux_thread_start *Start = (linux_thread_start *)Parameter;
+    Start->Proc(Start->Parameter);
+
+    return 0;
+}
+
+
+// swapcontext also saves and restores the signal mask, one system call per switch. Fine for jobs
+// that only switch when they wait.
+
+typedef struct os_fiber
+{
+    ucontext_t     Context;
+    os_fiber_proc *Proc;
+    void          *Parameter;
+} os_fiber;
+
+
+// makecontext only passes ints, the fiber comes in two halves.
+
+static void
+LinuxFiberProc(unsigned int High, unsigned int Low)
+{
+    os_fiber *Fiber = (os_fiber *)(((uintptr_t)High << 32) | (uintptr_t)Low);
+    Fiber->Proc(Fiber->Parameter);
+
+    assert(!"A fiber returned");
+}
+
+
+// sysfs files hold a line of text, a missing one reads as empty.
+
+static void
+LinuxReadSysFile(char *Path, char *Buffer, size_t Size)
+{
+    int     File  = open(Path, O_RDONLY);
+    ssize_t Count = File >= 0 ? read(File, Buffer, Size - 1) : -1;
+
+    Buffer[Count > 0 ? Count : 0] = '\0';
+
+    if (File >= 0)
+    {
+        close(File);
+    }
+}
+
+
+static uint32_t
+LinuxReadSysNumber(char *Path, uint32_t Default)
+{
+    char Buffer[32];
+    LinuxReadSysFile(Path, Buffer, sizeof(Buffer));
+
+    uint32_t Result = (Buffer[0] >= '0' && Buffer[0] <= '9') ? (uint32_t)strtoul(Buffer, 0, 10) : Default;
+    return Result;
+}
+
+
+// Processor lists look like "0-3,8,10-11".
+
+static void
+LinuxParseCpuList(char *Text, cpu_set_t *Set)
+{
+    CPU_ZERO(Set);
+
+    while (*Text >= '0' && *Text <= '9')
+    {
+        uint32_t First = (uint32_t)strtoul(Text, &Text, 10);
+        uint32_t Last  = *Text == '-' ? (uint32_t)strtoul(Text + 1, &Text, 10) : First;
+
+        for (uint32_t Cpu = First; Cpu <= Last && Cpu < CPU_SETSIZE; ++Cpu)
+        {
+            CPU_SET(Cpu, Set);
+        }
+
+        Text += *Text == ',' ? 1 : 0;
+    }
+}
+
+
+// ==============================================
+// <Threading> : PUBLIC
+// ==============================================
+
+
+// The affinity mask rather than what is online, taskset and containers hand out fewer.
+
+uint32_t
+OSGetProcessorCount(void)
+{
+    cpu_set_t Allowed;
+    long      Online = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t  Result = sched_getaffinity(0, sizeof(Allowed), &Allowed) == 0 ? (uint32_t)CPU_COUNT(&Allowed) :
+                       Online > 0                                           ? (uint32_t)Online             : 1;
+    return Result;
+}
+
+
+// Everything comes from sysfs. Cores are told apart by package and core id, core ids repeat across
+// packages. Nodes are read from their processor lists, without any every processor is on node 0.
+
+os_topology
+OSGetTopology(memory_arena *Arena)
+{
+    os_topology Result = {0};
+    cpu_set_t   Allowed;
+
+    uint32_t      Count      = sched_getaffinity(0, sizeof(Allowed), &Allowed) == 0 ? (uint32_t)CPU_COUNT(&Allowed) : 0;
+    os_processor *Processors = Count ? PushArray(Arena, os_processor, Count) : 0;
+
+    memory_region Region   = EnterMemoryRegion(Arena);
+    uint64_t     *CoreKeys = Count ? PushArray(Arena, uint64_t, Count) : 0;
+    uint32_t     *NodeOf   = PushArray(Arena, uint32_t, CPU_SETSIZE);
+    uint32_t     *NodeIds  = PushArray(Arena, uint32_t, CPU_SETSIZE);
+
+    if (Processors && CoreKeys && NodeOf && NodeIds)
+    {
+        char Path[128];
+        char Text[1024];
+
+        memset(NodeOf, 0, CPU_SETSIZE * sizeof(uint32_t));
+        memset(NodeIds, 0, CPU_SETSIZE * sizeof(uint32_t));
+
+        DIR *Nodes = opendir("/sys/devices/system/node");
+        for (struct dirent *Entry = Nodes ? readdir(Nodes) : 0; Entry; Entry = readdir(Nodes))
+        {
+            uint32_t Node = 0;
+
+            if (sscanf(Entry->d_name, "node%u", &Node) == 1 && Node < CPU_SETSIZE)
+            {
+                cpu_set_t Cpus;
+
+                snprintf(Path, sizeof(Path), "/sys/devices/system/node/node%u/cpulist", Node);
+                LinuxReadSysFile(Path, Text, sizeof(Text));
+                LinuxParseCpuList(Text, &Cpus);
+
+                for (uint32_t Cpu = 0; Cpu < CPU_SETSIZE; ++Cpu)
+                {
+                    NodeOf[Cpu] = CPU_ISSET(Cpu, &Cpus) ? Node : NodeOf[Cpu];
+                }
+            }
+        }
+
+        if (Nodes)
+        {
+            closedir(Nodes);
+        }
+
+        for (uint32_t Cpu = 0; Cpu < CPU_SETSIZE && Result.ProcessorCount < Count; ++Cpu)
+        {
+            if (!CPU_ISSET(Cpu, &Allowed))
+            {
+                continue;
+            }
+
+            snprintf(Path, sizeof(Path), "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", Cpu);
+            uint64_t Package = LinuxReadSysNumber(Path, 0);
+
+            snprintf(Path, sizeof(Path), "/sys/devices/system/cpu/cpu%u/topology/core_id", Cpu);
+            uint64_t Key = (Package << 32) | LinuxReadSysNumber(Path, Cpu);
+
+            os_processor *Processor = Processors + Result.ProcessorCount++;
+
+            Processor->Id     = Cpu;
+            Processor->Core   = Result.CoreCount;
+            Processor->Node   = NodeOf[Cpu];
+            Processor->Thread = 0;
+
+            for (uint32_t Core = 0; Core < Result.CoreCount; ++Core)
+            {
+                Processor->Core = CoreKeys[Core] == Key ? Core : Processor->Core;
+            }
+
+            if (Processor->Core == Result.CoreCount)
+            {
+                CoreKeys[Result.CoreCount++] = Key;
+            }
+
+            for (os_processor *Other = Processors; Other < Processor; ++Other)
+            {
+                Processor->Thread += Other->Core == Processor->Core ? 1 : 0;
+            }
+
+            NodeIds[Processor->Node] = 1;
+        }
+
+        // Node ids may have gaps, nodes without any processor of ours are dropped.
+
+        for (uint32_t Node = 0; Node < CPU_SETSIZE; ++Node)
+        {
+            if (NodeIds[Node])
+            {
+                NodeIds[Node] = Result.NodeCount++;
+            }
+        }
+
+        for (uint32_t Idx = 0; Idx < Result.ProcessorCount; ++Idx)
+        {
+            Processors[Idx].Node = NodeIds[Processors[Idx].Node];
+        }
+
+        Result.Processors = Processors;
+    }
+
+    LeaveMemoryRegion(Region);
+
+    return Result;
+}
+
+
+bool
+OSPinThread(uint32_t ProcessorId)
+{
+    bool      Result = false;
+    cpu_set_t Set;
+
+    if (ProcessorId < CPU_SETSIZE)
+    {
+        CPU_ZERO(&Set);
+        CPU_SET(ProcessorId, &Set);
+
+        Result = pthread_setaffinity_np(pthread_self(), sizeof(Set), &Set) == 0;
+    }
+
+    return Result;
+}
+
+
+bool
+OSStartThread(os_thread_proc *Proc, void *Parameter, memory_arena *Arena)
+{
+    bool                Result = false;
+    linux_thread_start *Start  = PushStruct(Arena, linux_thread_start);
+
+    if (Start)
+    {
+        Start->Proc      = Proc;
+        Start->Parameter = Parameter;
+
+        pthread_t Thread;
+        if (pthread_create(&Thread, 0, LinuxThreadProc, Start) == 0)
+        {
+            pthread_detach(Thread);
+            Result = true;
+        }
+    }
+
+    return Result;
+}
+
+
+os_semaphore *
+OSCreateSemaphore(memory_arena *Arena)
+{
+    os_semaphore *Result = PushStruct(Arena, os_semaphore);
+
+    if (Result && sem_init(&Result->Handle, 0, 0) != 0)
+    {
+        Result = 0;
+    }
+
+    return Result;
+}
+
+
+void
+OSSignalSemaphore(os_semaphore *Semaphore)
+{
+    sem_post(&Semaphore->Handle);
+}
+
+
+void
+OSWaitSemaphore(os_semaphore *Semaphore)
+{
+    while (sem_wait(&Semaphore->Handle) != 0 && errno == EINTR)
+    {
+    }
+}
+
+
+void
+OSYieldThread(void)
+{
+    sched_yield();
+}
+
+
+// The stack gets an uncommitted page below it, running off the end faults instead of scribbling
+// over whatever was mapped there.
+
+os_fiber *
+OSCreateFiber(os_fiber_proc *Proc, void *Parameter, size_t StackSize, memory_arena *Arena)
+{
+    os_fiber *Result   = PushStruct(Arena, os_fiber);
+    size_t    PageSize = (size_t)sysconf(_SC_PAGESIZE);
+    uint8_t  *Stack    = (uint8_t *)OSReserve(StackSize + PageSize);
+
+    if (Result && Stack && OSCommit(Stack + PageSize, StackSize) && getcontext(&Result->Context) == 0)
+    {
+        uintptr_t Address = (uintptr_t)Result;
+
+        Result->Proc                     = Proc;
+        Result->Parameter                = Parameter;
+        Result->Context.uc_stack.ss_sp   = Stack + PageSize;
+        Result->Context.uc_stack.ss_size = StackSize;
+        Result->Context.uc_link          = 0;
+
+        makecontext(&Result->Context, (void (*)(void))LinuxFiberProc, 2, (unsigned int)(Address >> 32), (unsigned int)Address);
+    }
+    else
+    {
+        if (Stack)
+        {
+            OSRelease(Stack, StackSize + PageSize);
+        }
+
+        Result = 0;
+    }
+
+    return Result;
+}
+
+
+void
+OSEnterFiber(os_fiber *Fiber)
+{
+    setcontext(&Fiber->Context);
+    assert(!"Could not enter the fiber");
+}
+
+
+void
+OSSwitchToFiber(os_fiber *From, os_fiber *To)
+{
+    swapcontext(&From->Context, &To->Context);
+}
+
+
+engine_memory
+OSCreateEngineMemory(uint32_t WorkerCount)
+{
+    engine_memory EngineMemory = { 0 };
+    {
+        {
+            memory_arena_params Params =
+            {
+                .AllocatedFromFile = __FILE__,
+                .AllocatedFromLine = __LINE__,
+                .ReserveSize       = MiB(128),
+                .CommitSize        = MiB(16),
+            };
+
+            EngineMemory.StateMemory = AllocateArena(Params);
+        }
+
+        {
+            memory_arena_params Params =
+            {
+                .AllocatedFromFile = __FILE__,
+                .AllocatedFromLine = __LINE__,
+                .ReserveSize       = GiB(2),
+                .CommitSize        = MiB(32),
+            };
+
+            EngineMemory.FrameMemory = AllocateArena(Params);
+        }
+    }
+
+    os_topology Topology = OSGetTopology(EngineMemory.StateMemory);
+
+    work_queue_params QueueParams =
+    {
+        .WorkerCount = WorkerCount ? WorkerCount : OSGetProcessorCount(),
+        .UseFibers   = true,
+        .Topology    = &Topology,
+    };
+
+    platform_work_queue *WorkQueue = CreateWorkQueue(QueueParams, EngineMemory.StateMemory);
+
+    EngineMemory.AddEntry       = AddWorkQueueEntry;
+    EngineMemory.CompleteWork   = CompleteWorkQueue;
+    EngineMemory.AddJob         = AddWorkQueueJob;
+    EngineMemory.AddJobAfter    = AddWorkQueueJobAfter;
+    EngineMemory.WaitForCounter = WaitForWorkQueueCounter;
+    EngineMemory.WorkQueue      = WorkQueue;
+    EngineMemory.WorkerCount    = GetWorkQueueWorkerCount(WorkQueue);
+
+    return EngineMemory;
+}
+
+#endif // __linux__
\ No newline at end of file
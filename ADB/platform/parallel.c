@@ -0,0 +1,187 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "utilities.h"
+#include "platform.h"
+#include "parallel.h"
+
+// With Grain 0 the smallest chunk still leaves every thread this many, enough to even out the end.
+#define PARALLEL_CHUNKS_PER_THREAD 16
+
+// Partials sit on their own cache lines, threads write theirs on every chunk.
+#define PARALLEL_PARTIAL_ALIGNMENT 64
+
+// ==============================================
+// <Parallel Loops> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    uint64_t                  Count;
+    uint64_t                  Grain;
+    uint64_t volatile         Next;
+    uint32_t                  ThreadCount;
+    const char               *Label;
+
+    parallel_for_callback    *ForCallback;
+    parallel_reduce_callback *ReduceCallback;
+    void                     *Context;
+
+    uint8_t                  *Partials;
+    uint64_t                  PartialStride;
+    uint32_t volatile         PartialCount;  // Handed out on a thread's first chunk, idle threads take none.
+} parallel_work;
+
+
+// Guided: a chunk is half of what is left split between the threads, never below the grain.
+
+static bool
+ClaimChunk(parallel_work *Work, uint64_t *First, uint64_t *End)
+{
+    bool Result = false;
+
+    for (;;)
+    {
+        uint64_t Next = AtomicLoad64(&Work->Next);
+
+        if (Next >= Work->Count)
+        {
+            break;
+        }
+
+        uint64_t Left = Work->Count - Next;
+        uint64_t Size = Minimum(Maximum(Left / (2 * Work->ThreadCount), Work->Grain), Left);
+
+        if (AtomicCompareExchange64(&Work->Next, Next, Next + Size))
+        {
+            *First = Next;
+            *End   = Next + Size;
+            Result = true;
+            break;
+        }
+    }
+
+    return Result;
+}
+
+
+static void
+ParallelJob(platform_work_queue *Queue, void *Data)
+{
+    (void)Queue;
+
+    parallel_work *Work    = (parallel_work *)Data;
+    uint8_t       *Partial = 0;
+    uint64_t       First   = 0;
+    uint64_t       End     = 0;
+
+    while (ClaimChunk(Work, &First, &End))
+    {
+        if (Work->ForCallback)
+        {
+            Work->ForCallback(First, End, Work->Context);
+        }
+        else
+        {
+            if (!Partial)
+            {
+                Partial = Work->Partials + (AtomicIncrement32(&Work->PartialCount) - 1) * Work->PartialStride;
+            }
+
+            Work->ReduceCallback(First, End, Work->Context, Partial);
+        }
+    }
+}
+
+
+// Picks the grain and the number of jobs, queues them and joins in. Everything the jobs read lives
+// in Work, on the caller's stack, which the wait keeps alive.
+
+static void
+RunParallelWork(parallel_work *Work, JobPriority_Type Priority, engine_memory *EngineMemory)
+{
+    uint32_t MaxThreadCount = EngineMemory->WorkerCount + 1;
+
+    if (!Work->Grain)
+    {
+        Work->Grain = Maximum(Work->Count / ((uint64_t)MaxThreadCount * PARALLEL_CHUNKS_PER_THREAD), 1);
+    }
+
+    uint64_t ChunkCount = (Work->Count + Work->Grain - 1) / Work->Grain;
+    uint32_t JobCount   = (uint32_t)Minimum((uint64_t)EngineMemory->WorkerCount, ChunkCount ? ChunkCount - 1 : 0);
+
+    Work->ThreadCount = JobCount + 1;
+
+    job_counter Done = {0};
+
+    for (uint32_t JobIdx = 0; JobIdx < JobCount; ++JobIdx)
+    {
+        EngineMemory->AddJob(EngineMemory->WorkQueue, Priority, Work->Label, ParallelJob, Work, &Done);
+    }
+
+    ParallelJob(EngineMemory->WorkQueue, Work);
+
+    if (JobCount)
+    {
+        EngineMemory->WaitForCounter(EngineMemory->WorkQueue, &Done);
+    }
+}
+
+// ==============================================
+// <Parallel Loops> : PUBLIC
+// ==============================================
+
+
+void
+ParallelFor(uint64_t Count, uint64_t Grain, const char *Label, parallel_for_callback *Callback, void *Context, JobPriority_Type Priority, engine_memory *EngineMemory)
+{
+    parallel_work Work = {0};
+
+    Work.Count       = Count;
+    Work.Grain       = Grain;
+    Work.Label       = Label;
+    Work.ForCallback = Callback;
+    Work.Context     = Context;
+
+    if (Count)
+    {
+        RunParallelWork(&Work, Priority, EngineMemory);
+    }
+}
+
+
+void
+ParallelReduce(uint64_t Count, uint64_t Grain, const char *Label, parallel_reduce_callback *Callback, parallel_combine_callback *Combine,
+               void *Result, uint32_t ResultSize, void *Context, JobPriority_Type Priority, memory_arena *Arena, engine_memory *EngineMemory)
+{
+    memory_region Region = EnterMemoryRegion(Arena);
+    parallel_work Work   = {0};
+    uint32_t      Slots  = EngineMemory->WorkerCount + 1;
+
+    Work.Count          = Count;
+    Work.Grain          = Grain;
+    Work.Label          = Label;
+    Work.ReduceCallback = Callback;
+    Work.Context        = Context;
+    Work.PartialStride  = AlignPow2(Maximum(ResultSize, 1), PARALLEL_PARTIAL_ALIGNMENT);
+    Work.Partials       = PushArrayAligned(Arena, uint8_t, Work.PartialStride * Slots, PARALLEL_PARTIAL_ALIGNMENT);
+
+    if (Count && Work.Partials)
+    {
+        for (uint32_t Slot = 0; Slot < Slots; ++Slot)
+        {
+            memcpy(Work.Partials + Slot * Work.PartialStride, Result, ResultSize);
+        }
+
+        RunParallelWork(&Work, Priority, EngineMemory);
+
+        for (uint32_t Slot = 0; Slot < Work.PartialCount; ++Slot)
+        {
+            Combine(Result, Work.Partials + Slot * Work.PartialStride, Context);
+        }
+    }
+
+    LeaveMemoryRegion(Region);
+}
\ No newline at end of file
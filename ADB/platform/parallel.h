@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "platform.h"
+
+// ==============================================
+// <Parallel Loops>
+// ==============================================
+
+// Splits [0, Count) into chunks and runs them on the work queue. One job goes out per worker
+// (EngineMemory->WorkerCount), the calling thread takes chunks as well and returns once every chunk
+// ran. Jobs that find nothing left return at once, the call never waits on more than it queued.
+//
+// Chunks are claimed from a shared cursor, each one a share of what is left: large while there is
+// plenty, down to Grain towards the end so that the threads finish together. A Grain of 0 lets the
+// loop pick one from Count and the number of threads. Pass a larger Grain when an index is cheap
+// and a chunk should amortize more than the claim.
+//
+// ParallelReduce gives every thread a partial of ResultSize bytes, copied from what Result holds on
+// entry (the identity), and folds the partials into Result with Combine once the loop is done.
+// Partials are folded in no particular order, Combine must not care.
+//
+// Both may be called from inside a job. They queue in the given lane and wait like WaitForCounter.
+// Label names their jobs in traces, the part the calling thread runs is not a job of its own.
+
+typedef void parallel_for_callback     (uint64_t First, uint64_t End, void *Context);
+typedef void parallel_reduce_callback  (uint64_t First, uint64_t End, void *Context, void *Partial);
+typedef void parallel_combine_callback (void *Result, void *Partial, void *Context);
+
+
+void ParallelFor     (uint64_t Count, uint64_t Grain, const char *Label, parallel_for_callback *Callback, void *Context, JobPriority_Type Priority, engine_memory *EngineMemory);
+
+void ParallelReduce  (uint64_t Count, uint64_t Grain, const char *Label, parallel_reduce_callback *Callback, parallel_combine_callback *Combine,
+                      void *Result, uint32_t ResultSize, void *Context, JobPriority_Type Priority, memory_arena *Arena, engine_memory *EngineMemory);
\ No newline at end of file
@@ -1,15 +1,156 @@
 #pragma once
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utilities.h"
+
 
 // ==============================================
 // <Threading>
 // ==============================================
 
 
+// The work queue itself is platform/work_queue.h. AddEntry may be called from any thread, jobs
+// included. CompleteWork runs entries on the calling thread until everything added so far is done,
+// whoever added it: only code that owns the whole queue (tools, shutdown) should use it.
+//
+// Everything else counts its own jobs. AddJob adds one to Counter before queueing and takes it off
+// once the job returns, WaitForCounter runs other entries until the counter is back at zero.
+// AddJobAfter holds the job until Dependency reaches zero, a pipeline is a chain of counters and
+// nobody waits in between. A job that needs several batches has them share one counter.
+//
+// A counter must be zeroed before first use and may be reused once it is back at zero. It must
+// outlive the jobs counted on it and the jobs held on it, WaitForCounter is what makes that safe to
+// assume for a counter on the stack.
+//
+// Label names the job in traces (see work_queue.h), it must be a string literal or live as long.
+
 typedef struct platform_work_queue platform_work_queue;
+typedef struct job_waiter          job_waiter;
+
+
+// Jobs pick a lane. A worker only runs Normal jobs when it finds no Frame job, and Background ones
+// when it finds neither, except now and then so that background work is never starved outright.
+
+typedef enum
+{
+	JobPriority_Frame      = 0, // What the frame being built waits on: culling, command recording.
+	JobPriority_Normal     = 1,
+	JobPriority_Background = 2, // Reads, decodes, anything no frame waits on.
+	JobPriority_Count      = 3,
+} JobPriority_Type;
+
+
+typedef struct
+{
+	uint32_t volatile  Value;
+	uint32_t volatile  Lock;
+	job_waiter        *Waiters;
+} job_counter;
+
 typedef void platform_work_queue_callback(platform_work_queue *Queue, void *Data);
 typedef void platform_add_entry(platform_work_queue *Queue, platform_work_queue_callback *Callback, void *Data);
 typedef void platform_complete_work(platform_work_queue *Queue);
+typedef void platform_add_job(platform_work_queue *Queue, JobPriority_Type Priority, const char *Label, platform_work_queue_callback *Callback, void *Data, job_counter *Counter);
+typedef void platform_add_job_after(platform_work_queue *Queue, JobPriority_Type Priority, job_counter *Dependency, const char *Label, platform_work_queue_callback *Callback, void *Data, job_counter *Counter);
+typedef void platform_wait_for_counter(platform_work_queue *Queue, job_counter *Counter);
+
+// Logical processors the process may run on, OSGetTopology lists the same ones.
+
+uint32_t OSGetProcessorCount(void);
+
+// Where each logical processor sits: which physical core and which NUMA node. Cores and nodes are
+// numbered from 0 without gaps, a machine without NUMA is one node. Processors come in no particular
+// order, the work queue picks its own.
+
+typedef struct
+{
+	uint32_t Id;     // What OSPinThread takes. On Windows the group times 64 plus the number within it.
+	uint32_t Core;
+	uint32_t Node;
+	uint32_t Thread; // Hardware thread within the core, 0 for the first.
+} os_processor;
+
+
+typedef struct
+{
+	os_processor *Processors;
+	uint32_t      ProcessorCount;
+	uint32_t      CoreCount;
+	uint32_t      NodeCount;
+} os_topology;
+
+
+// OSGetTopology returns no processors when the OS will not say. OSPinThread keeps the calling thread
+// on one processor from then on. Pages land on the node of the thread that first writes them, on both
+// systems, which is how a pinned thread gets memory of its own node.
+
+os_topology    OSGetTopology     (memory_arena *Arena);
+bool           OSPinThread       (uint32_t ProcessorId);
+
+// Threads are detached, they run until the process exits. Semaphores count, a signal is never lost
+// when nobody waits yet. Both keep what they need on the arena.
+
+typedef struct os_semaphore os_semaphore;
+typedef void os_thread_proc(void *Parameter);
+
+bool           OSStartThread     (os_thread_proc *Proc, void *Parameter, memory_arena *Arena);
+os_semaphore * OSCreateSemaphore (memory_arena *Arena);
+void           OSSignalSemaphore (os_semaphore *Semaphore);
+void           OSWaitSemaphore   (os_semaphore *Semaphore);
+void           OSYieldThread     (void);
+
+// Fibers are stacks a thread switches between by hand. OSEnterFiber hands the calling thread over to
+// a fiber for good, the thread's own stack is never switched back to. After that the thread moves
+// between fibers with OSSwitchToFiber, From being the fiber it runs now. A fiber may be resumed by a
+// different thread than the one that left it. A fiber's proc must never return.
+
+typedef struct os_fiber os_fiber;
+typedef void os_fiber_proc(void *Parameter);
+
+os_fiber *     OSCreateFiber     (os_fiber_proc *Proc, void *Parameter, size_t StackSize, memory_arena *Arena);
+void           OSEnterFiber      (os_fiber *Fiber);
+void           OSSwitchToFiber   (os_fiber *From, os_fiber *To);
+
+#ifdef _MSC_VER
+#define ThreadLocal __declspec(thread)
+#else
+#define ThreadLocal _Thread_local
+#endif
+
+// ==============================================
+// <Atomics>
+// ==============================================
+
+// Increments and decrements return the new value, compare-exchanges whether New was stored. Loads
+// and stores are for flags one thread sets and another polls. Everything is sequentially consistent.
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AtomicIncrement32(Value)                    ((uint32_t)_InterlockedIncrement((long volatile *)(Value)))
+#define AtomicDecrement32(Value)                    ((uint32_t)_InterlockedDecrement((long volatile *)(Value)))
+#define AtomicLoad32(Value)                         ((uint32_t)_InterlockedOr((long volatile *)(Value), 0))
+#define AtomicStore32(Value, New)                   ((void)_InterlockedExchange((long volatile *)(Value), (long)(New)))
+#define AtomicCompareExchange32(Value, Old, New)    (_InterlockedCompareExchange((long volatile *)(Value), (long)(New), (long)(Old)) == (long)(Old))
+#define AtomicLoad64(Value)                         ((uint64_t)_InterlockedOr64((__int64 volatile *)(Value), 0))
+#define AtomicStore64(Value, New)                   ((void)_InterlockedExchange64((__int64 volatile *)(Value), (__int64)(New)))
+#define AtomicCompareExchange64(Value, Old, New)    (_InterlockedCompareExchange64((__int64 volatile *)(Value), (__int64)(New), (__int64)(Old)) == (__int64)(Old))
+#define AtomicLoadPointer(Value)                    _InterlockedCompareExchangePointer((void *volatile *)(Value), 0, 0)
+#define AtomicStorePointer(Value, New)              ((void)_InterlockedExchangePointer((void *volatile *)(Value), (New)))
+#else
+#define AtomicIncrement32(Value)                    __atomic_add_fetch((Value), 1, __ATOMIC_SEQ_CST)
+#define AtomicDecrement32(Value)                    __atomic_sub_fetch((Value), 1, __ATOMIC_SEQ_CST)
+#define AtomicLoad32(Value)                         __atomic_load_n((Value), __ATOMIC_SEQ_CST)
+#define AtomicStore32(Value, New)                   __atomic_store_n((Value), (New), __ATOMIC_SEQ_CST)
+#define AtomicCompareExchange32(Value, Old, New)    __sync_bool_compare_and_swap((Value), (Old), (New))
+#define AtomicLoad64(Value)                         __atomic_load_n((Value), __ATOMIC_SEQ_CST)
+#define AtomicStore64(Value, New)                   __atomic_store_n((Value), (New), __ATOMIC_SEQ_CST)
+#define AtomicCompareExchange64(Value, Old, New)    __sync_bool_compare_and_swap((Value), (Old), (New))
+#define AtomicLoadPointer(Value)                    __atomic_load_n((Value), __ATOMIC_SEQ_CST)
+#define AtomicStorePointer(Value, New)              __atomic_store_n((Value), (New), __ATOMIC_SEQ_CST)
+#endif
 
 // ==============================================
 // <Memory>
@@ -18,13 +159,100 @@ typedef void platform_complete_work(platform_work_queue *Queue);
 typedef struct memory_arena memory_arena;
 typedef struct engine_memory
 {
-	memory_arena           *StateMemory;
-	memory_arena           *FrameMemory;
-	platform_add_entry     *AddEntry;
-	platform_complete_work *CompleteWork;
-	platform_work_queue    *WorkQueue;
+	memory_arena              *StateMemory;
+	memory_arena              *FrameMemory;
+	platform_add_entry        *AddEntry;
+	platform_complete_work    *CompleteWork;
+	platform_add_job          *AddJob;
+	platform_add_job_after    *AddJobAfter;
+	platform_wait_for_counter *WaitForCounter;
+	platform_work_queue       *WorkQueue;
+	uint32_t                   WorkerCount; // The thread that owns the queue not counted.
 } engine_memory;
 
 void *OSReserve(size_t Size);
 bool  OSCommit(void *At, size_t Size);
-void  OSRelease(void *At, size_t Size);
\ No newline at end of file
+void  OSRelease(void *At, size_t Size);
+
+// Allocates the state/frame arenas and starts the worker threads. A WorkerCount of 0 starts one
+// worker per logical processor. Workers are pinned, physical cores first (see work_queue.h).
+
+engine_memory OSCreateEngineMemory(uint32_t WorkerCount);
+
+// ==============================================
+// <Timing>
+// ==============================================
+
+uint64_t OSReadTimer(void);
+uint64_t OSGetTimerFrequency(void);
+
+// The processor's timestamp counter: a few cycles to read, at a rate the OS does not report (the
+// profiler measures it against OSReadTimer). Where there is none it is OSReadTimer.
+
+#if defined(_MSC_VER)
+#define ReadCPUTimer() __rdtsc()
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ReadCPUTimer() __rdtsc()
+#else
+#define ReadCPUTimer() OSReadTimer()
+#endif
+
+// Hardware event counters of the calling thread, user mode only, read together. They can only be
+// had on Linux with perf events allowed (kernel.perf_event_paranoid) and a PMU the machine exposes,
+// OSOpenPerfCounters fails otherwise. Counters the processor will not count are left out of
+// Available and read as 0. Only the thread that opened them should read them.
+
+typedef enum
+{
+	PerfCounter_Cycles       = 0,
+	PerfCounter_Instructions = 1,
+	PerfCounter_L1Misses     = 2, // L1 data cache read misses.
+	PerfCounter_LLCMisses    = 3,
+	PerfCounter_BranchMisses = 4,
+	PerfCounter_Count        = 5,
+} PerfCounter_Type;
+
+
+typedef struct
+{
+	int32_t  Group;     // The first counter opened leads the group, -1 for none.
+	uint32_t Available; // A bit per PerfCounter_Type.
+} os_perf_counters;
+
+
+bool OSOpenPerfCounters(os_perf_counters *Counters);
+void OSReadPerfCounters(os_perf_counters *Counters, uint64_t Values[PerfCounter_Count]);
+
+// ==============================================
+// <Files>
+// ==============================================
+
+typedef struct os_file_node os_file_node;
+struct os_file_node
+{
+	os_file_node *Next;
+	byte_string   Path;
+	bool          IsDirectory;
+};
+
+typedef struct
+{
+	os_file_node *First;
+	os_file_node *Last;
+	uint32_t      Count;
+} os_file_list;
+
+// Paths are "Directory/Name" and null-terminated. "." and ".." are not listed.
+
+os_file_list OSListDirectory(byte_string Path, memory_arena *Arena);
+bool         OSCreateDirectory(byte_string Path);
+bool         OSDeleteFile(byte_string Path);
+
+// Only removes empty directories.
+bool         OSDeleteDirectory(byte_string Path);
+
+// Read-only mapping of a whole file. The buffer has no trailing null byte, unlike ReadFileInBuffer.
+
+buffer       OSMapFile(byte_string Path);
+void         OSUnmapFile(buffer *File);
\ No newline at end of file
@@ -0,0 +1,533 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "utilities.h"
+#include "platform.h"
+#include "profiler.h"
+
+// ==============================================
+// <Profiler> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    uint64_t volatile HitCount;
+    uint64_t volatile Elements;
+    uint64_t volatile Inclusive;
+    uint64_t volatile Exclusive;  // Children take theirs off, goes below zero while they run.
+    uint64_t volatile Events[PerfCounter_Count]; // Exclusive as well.
+} profile_anchor;
+
+
+// Anchors are written by the thread they belong to only, Seen by EndProfilerFrame only: what it
+// read last time, the frame gets the difference. Current is also reset by the thread a dropped block
+// ends on.
+
+typedef struct
+{
+    uint32_t volatile Current;                            // Innermost open zone, 0 for none.
+    bool              CountersTried;
+    os_perf_counters  Counters;
+    profile_anchor    Anchors[PROFILER_MAX_ZONE_COUNT];
+    profile_anchor    Seen[PROFILER_MAX_ZONE_COUNT];
+} profile_thread;
+
+
+typedef struct
+{
+    uint32_t volatile        Counting;
+    uint32_t volatile        CapturedFrame;            // Capture was on at some point in the current frame.
+    uint32_t volatile        ZoneCount;                // Zones are numbered from 1.
+    uint32_t volatile        ThreadCount;
+    const char              *ZoneNames[PROFILER_MAX_ZONE_COUNT];
+    profile_thread *volatile Threads[PROFILER_MAX_THREAD_COUNT];
+
+    // The timestamp counter's rate comes from how far it and OSReadTimer moved since capture was
+    // first turned on.
+    uint64_t volatile        CalibrationStart;
+    uint64_t volatile        CalibrationStartOS;
+    uint64_t                 Frequency;
+
+    // Only touched by the thread that ends frames.
+    profile_frame           *History;
+    uint64_t                 FrameCount;
+    uint64_t                 CapturedCount;
+    uint64_t                 FrameStart;
+} profiler_state;
+
+
+static profiler_state                  Profiler;
+static ThreadLocal profile_thread     *CurrentProfileThread;
+
+uint32_t volatile                      ProfilerCapturing;
+
+
+static profile_thread *
+GetProfileThread(void)
+{
+    profile_thread *Result = CurrentProfileThread;
+
+    if (!Result && AtomicLoad32(&Profiler.ThreadCount) < PROFILER_MAX_THREAD_COUNT)
+    {
+        uint32_t Slot = AtomicIncrement32(&Profiler.ThreadCount) - 1;
+        size_t   Size = sizeof(profile_thread);
+
+        if (Slot < PROFILER_MAX_THREAD_COUNT)
+        {
+            profile_thread *Thread = (profile_thread *)OSReserve(Size);
+
+            // Committed pages come zeroed. A slot that stays empty is skipped by EndProfilerFrame.
+
+            if (Thread && OSCommit(Thread, Size))
+            {
+                AtomicStorePointer(&Profiler.Threads[Slot], Thread);
+
+                CurrentProfileThread = Thread;
+                Result               = Thread;
+            }
+        }
+    }
+
+    return Result;
+}
+
+
+// Threads may race to register the same call site, the loser's number stays unused.
+
+static uint32_t
+RegisterProfileZone(uint32_t volatile *Zone, const char *Name)
+{
+    if (AtomicLoad32(&Profiler.ZoneCount) < PROFILER_MAX_ZONE_COUNT - 1)
+    {
+        uint32_t Index = AtomicIncrement32(&Profiler.ZoneCount);
+
+        if (Index < PROFILER_MAX_ZONE_COUNT)
+        {
+            Profiler.ZoneNames[Index] = Name;
+            AtomicCompareExchange32(Zone, 0, Index);
+        }
+    }
+
+    uint32_t Result = AtomicLoad32(Zone);
+    return Result;
+}
+
+
+static double
+TicksToMs(int64_t Ticks)
+{
+    double Result = Profiler.Frequency ? (double)Ticks * 1000.0 / (double)Profiler.Frequency : 0.0;
+    return Result;
+}
+
+
+// Zones that were never given elements count one per run.
+
+static double
+GetEventsPerElement(profile_zone_summary *Zone, PerfCounter_Type Type)
+{
+    uint64_t Elements = Zone->Elements ? Zone->Elements : Zone->HitCount;
+    double   Result   = Elements ? (double)Zone->Events[Type] / (double)Elements : 0.0;
+    return Result;
+}
+
+
+static double
+GetInstructionsPerCycle(profile_zone_summary *Zone)
+{
+    int64_t Cycles = Zone->Events[PerfCounter_Cycles];
+    double  Result = Cycles > 0 ? (double)Zone->Events[PerfCounter_Instructions] / (double)Cycles : 0.0;
+    return Result;
+}
+
+
+static void
+AppendProfile(buffer *Buffer, const char *Format, ...)
+{
+    va_list Args;
+    va_start(Args, Format);
+
+    size_t Left    = Buffer->Size - Buffer->At;
+    int    Written = Left ? vsnprintf((char *)Buffer->Data + Buffer->At, Left, Format, Args) : 0;
+
+    Buffer->At += Written > 0 ? Minimum((size_t)Written, Left - 1) : 0;
+
+    va_end(Args);
+}
+
+// ==============================================
+// <Profiler> : PUBLIC
+// ==============================================
+
+
+// The macros only call in while capture is on and already cleared Thread and Elements.
+
+bool
+BeginProfileBlock(profile_block *Block, uint32_t volatile *Zone, const char *Name)
+{
+    bool Result = false;
+
+    if (ProfilerCapturing)
+    {
+        profile_thread *Thread = GetProfileThread();
+        uint32_t        Index  = *Zone ? *Zone : RegisterProfileZone(Zone, Name);
+
+        if (Thread && Index)
+        {
+            Block->Thread       = Thread;
+            Block->Zone         = Index;
+            Block->Parent       = Thread->Current;
+            Block->OldInclusive = Thread->Anchors[Index].Inclusive;
+            Block->Counted      = false;
+            Thread->Current     = Index;
+
+            if (Profiler.Counting && !Thread->CountersTried)
+            {
+                OSOpenPerfCounters(&Thread->Counters);
+                Thread->CountersTried = true;
+            }
+
+            if (Profiler.Counting && Thread->Counters.Group >= 0)
+            {
+                OSReadPerfCounters(&Thread->Counters, Block->StartEvents);
+                Block->Counted = true;
+            }
+
+            Block->Start = ReadCPUTimer();
+            Result       = true;
+        }
+    }
+
+    return Result;
+}
+
+
+void
+EndProfileBlock(profile_block *Block)
+{
+    if (Block->Thread)
+    {
+        uint64_t        Elapsed = ReadCPUTimer() - Block->Start;
+        profile_thread *Thread  = (profile_thread *)Block->Thread;
+
+        if (Thread == CurrentProfileThread)
+        {
+            profile_anchor *Anchor = Thread->Anchors + Block->Zone;
+            profile_anchor *Parent = Thread->Anchors + Block->Parent;
+
+            // Inclusive is set rather than added: a zone inside itself ends first and the outer
+            // run then overwrites it with the whole span.
+
+            Parent->Exclusive -= Elapsed;
+            Anchor->Exclusive += Elapsed;
+            Anchor->Inclusive  = Block->OldInclusive + Elapsed;
+            Anchor->HitCount  += 1;
+            Anchor->Elements  += Block->Elements;
+
+            if (Block->Counted)
+            {
+                uint64_t Events[PerfCounter_Count];
+                OSReadPerfCounters(&Thread->Counters, Events);
+
+                for (uint32_t Type = 0; Type < PerfCounter_Count; ++Type)
+                {
+                    Parent->Events[Type] -= Events[Type] - Block->StartEvents[Type];
+                    Anchor->Events[Type] += Events[Type] - Block->StartEvents[Type];
+                }
+            }
+
+            Thread->Current = Block->Parent;
+        }
+        else
+        {
+            // The job came back on another thread. The times are lost, but the thread it began on
+            // would otherwise give this zone as the parent of everything it opens from now on.
+
+            AtomicCompareExchange32(&Thread->Current, Block->Zone, Block->Parent);
+        }
+    }
+}
+
+
+void
+SetProfilerCapture(bool Capture)
+{
+    if (Capture && !AtomicLoad64(&Profiler.CalibrationStartOS))
+    {
+        AtomicStore64(&Profiler.CalibrationStart, ReadCPUTimer());
+        AtomicStore64(&Profiler.CalibrationStartOS, OSReadTimer());
+    }
+
+    AtomicStore32(&ProfilerCapturing, Capture ? 1 : 0);
+
+    if (Capture)
+    {
+        AtomicStore32(&Profiler.CapturedFrame, 1);
+    }
+}
+
+
+bool
+IsProfilerCapturing(void)
+{
+    bool Result = AtomicLoad32(&ProfilerCapturing) != 0;
+    return Result;
+}
+
+
+// Threads open their counters on their first block after this, a thread that failed to does not
+// try again.
+
+void
+SetProfilerCounters(bool Count)
+{
+    AtomicStore32(&Profiler.Counting, Count ? 1 : 0);
+}
+
+
+bool
+IsProfilerCounting(void)
+{
+    bool Result = AtomicLoad32(&Profiler.Counting) != 0;
+    return Result;
+}
+
+
+void
+EndProfilerFrame(void)
+{
+    uint64_t Now      = ReadCPUTimer();
+    uint64_t NowOS    = OSReadTimer();
+    bool     Captured = AtomicLoad32(&Profiler.CapturedFrame) != 0;
+
+    AtomicStore32(&Profiler.CapturedFrame, AtomicLoad32(&ProfilerCapturing));
+
+    if (Captured && !Profiler.History)
+    {
+        size_t         Size    = PROFILER_HISTORY_FRAME_COUNT * sizeof(profile_frame);
+        profile_frame *History = (profile_frame *)OSReserve(Size);
+
+        Profiler.History = History && OSCommit(History, Size) ? History : 0;
+    }
+
+    uint64_t StartOS = AtomicLoad64(&Profiler.CalibrationStartOS);
+
+    if (StartOS && NowOS > StartOS)
+    {
+        double Ticks   = (double)(Now - AtomicLoad64(&Profiler.CalibrationStart));
+        double Seconds = (double)(NowOS - StartOS) / (double)OSGetTimerFrequency();
+
+        Profiler.Frequency = (uint64_t)(Ticks / Seconds);
+    }
+
+    profile_frame *Frame       = Captured && Profiler.History ? Profiler.History + Profiler.CapturedCount % PROFILER_HISTORY_FRAME_COUNT : 0;
+    uint32_t       ZoneCount   = Minimum(AtomicLoad32(&Profiler.ZoneCount) + 1, PROFILER_MAX_ZONE_COUNT);
+    uint32_t       ThreadCount = Minimum(AtomicLoad32(&Profiler.ThreadCount), PROFILER_MAX_THREAD_COUNT);
+
+    if (Frame)
+    {
+        memset(Frame->Zones, 0, ZoneCount * sizeof(profile_zone_summary));
+
+        Frame->Index     = Profiler.FrameCount;
+        Frame->Ticks     = Now - (Profiler.FrameStart ? Profiler.FrameStart : AtomicLoad64(&Profiler.CalibrationStart));
+        Frame->ZoneCount = ZoneCount;
+    }
+
+    // Threads keep running blocks while this reads, a block that ends meanwhile lands in this frame
+    // or the next one, never in both.
+
+    for (uint32_t ThreadIdx = 0; ThreadIdx < ThreadCount; ++ThreadIdx)
+    {
+        profile_thread *Thread = (profile_thread *)AtomicLoadPointer(&Profiler.Threads[ThreadIdx]);
+
+        for (uint32_t Zone = 1; Thread && Zone < ZoneCount; ++Zone)
+        {
+            profile_anchor *Anchor    = Thread->Anchors + Zone;
+            profile_anchor *Seen      = Thread->Seen + Zone;
+            uint64_t        HitCount  = Anchor->HitCount;
+            uint64_t        Elements  = Anchor->Elements;
+            uint64_t        Inclusive = Anchor->Inclusive;
+            uint64_t        Exclusive = Anchor->Exclusive;
+
+            if (Frame)
+            {
+                Frame->Zones[Zone].HitCount  += HitCount - Seen->HitCount;
+                Frame->Zones[Zone].Elements  += Elements - Seen->Elements;
+                Frame->Zones[Zone].Inclusive += (int64_t)(Inclusive - Seen->Inclusive);
+                Frame->Zones[Zone].Exclusive += (int64_t)(Exclusive - Seen->Exclusive);
+            }
+
+            Seen->HitCount  = HitCount;
+            Seen->Elements  = Elements;
+            Seen->Inclusive = Inclusive;
+            Seen->Exclusive = Exclusive;
+
+            for (uint32_t Type = 0; Type < PerfCounter_Count; ++Type)
+            {
+                uint64_t Events = Anchor->Events[Type];
+
+                if (Frame)
+                {
+                    Frame->Zones[Zone].Events[Type] += (int64_t)(Events - Seen->Events[Type]);
+                }
+
+                Seen->Events[Type] = Events;
+            }
+        }
+    }
+
+    Profiler.CapturedCount += Frame ? 1 : 0;
+    Profiler.FrameCount    += 1;
+    Profiler.FrameStart     = Now;
+}
+
+
+profile_frame *
+GetProfilerFrame(uint32_t Age)
+{
+    uint64_t       Kept   = Minimum(Profiler.CapturedCount, (uint64_t)PROFILER_HISTORY_FRAME_COUNT);
+    profile_frame *Result = 0;
+
+    if (Profiler.History && Age < Kept)
+    {
+        Result = Profiler.History + (Profiler.CapturedCount - 1 - Age) % PROFILER_HISTORY_FRAME_COUNT;
+    }
+
+    return Result;
+}
+
+
+const char *
+GetProfilerZoneName(uint32_t Zone)
+{
+    const char *Result = Zone && Zone < PROFILER_MAX_ZONE_COUNT && Profiler.ZoneNames[Zone] ? Profiler.ZoneNames[Zone] : "?";
+    return Result;
+}
+
+
+uint64_t
+GetProfilerFrequency(void)
+{
+    return Profiler.Frequency;
+}
+
+
+void
+PrintProfilerFrame(uint32_t Age)
+{
+    profile_frame *Frame = GetProfilerFrame(Age);
+
+    if (Frame)
+    {
+        uint32_t Order[PROFILER_MAX_ZONE_COUNT];
+        uint32_t OrderCount = 0;
+        bool     Counted    = false;
+
+        for (uint32_t Zone = 1; Zone < Frame->ZoneCount; ++Zone)
+        {
+            Counted = Counted || Frame->Zones[Zone].Events[PerfCounter_Cycles] || Frame->Zones[Zone].Events[PerfCounter_Instructions];
+
+            if (Frame->Zones[Zone].HitCount)
+            {
+                uint32_t Slot = OrderCount++;
+
+                for (; Slot > 0 && Frame->Zones[Order[Slot - 1]].Exclusive < Frame->Zones[Zone].Exclusive; --Slot)
+                {
+                    Order[Slot] = Order[Slot - 1];
+                }
+
+                Order[Slot] = Zone;
+            }
+        }
+
+        double FrameMs = TicksToMs((int64_t)Frame->Ticks);
+
+        printf("frame %llu: %.3f ms\n", (unsigned long long)Frame->Index, FrameMs);
+        printf("%14s %7s %14s %7s %10s %12s", "exclusive ms", "%", "inclusive ms", "%", "hits", "elements");
+
+        if (Counted)
+        {
+            printf(" %6s %10s %11s %10s", "IPC", "L1 miss/el", "LLC miss/el", "br miss/el");
+        }
+
+        printf("  zone\n");
+
+        for (uint32_t OrderIdx = 0; OrderIdx < OrderCount; ++OrderIdx)
+        {
+            profile_zone_summary *Zone        = Frame->Zones + Order[OrderIdx];
+            double                ExclusiveMs = TicksToMs(Zone->Exclusive);
+            double                InclusiveMs = TicksToMs(Zone->Inclusive);
+
+            printf("%14.3f %6.1f%% %14.3f %6.1f%% %10llu %12llu",
+                   ExclusiveMs, FrameMs > 0.0 ? 100.0 * ExclusiveMs / FrameMs : 0.0,
+                   InclusiveMs, FrameMs > 0.0 ? 100.0 * InclusiveMs / FrameMs : 0.0,
+                   (unsigned long long)Zone->HitCount, (unsigned long long)Zone->Elements);
+
+            if (Counted)
+            {
+                printf(" %6.2f %10.3f %11.3f %10.3f", GetInstructionsPerCycle(Zone), GetEventsPerElement(Zone, PerfCounter_L1Misses),
+                       GetEventsPerElement(Zone, PerfCounter_LLCMisses), GetEventsPerElement(Zone, PerfCounter_BranchMisses));
+            }
+
+            printf("  %s\n", GetProfilerZoneName(Order[OrderIdx]));
+        }
+    }
+}
+
+
+bool
+WriteProfilerHistory(byte_string Path, memory_arena *Arena)
+{
+    bool          Result     = false;
+    memory_region Region     = EnterMemoryRegion(Arena);
+    uint32_t      FrameCount = (uint32_t)Minimum(Profiler.CapturedCount, (uint64_t)PROFILER_HISTORY_FRAME_COUNT);
+    size_t        Capacity   = 64;
+
+    for (uint32_t Age = 0; Age < FrameCount; ++Age)
+    {
+        Capacity += (size_t)GetProfilerFrame(Age)->ZoneCount * 256;
+    }
+
+    buffer Buffer = {PushArray(Arena, uint8_t, Capacity), Capacity, 0};
+
+    if (Buffer.Data)
+    {
+        AppendProfile(&Buffer, "frame,frame_ms,zone,hits,elements,inclusive_ms,exclusive_ms,cycles,instructions,l1_misses,llc_misses,branch_misses\n");
+
+        for (uint32_t Age = FrameCount; Age-- > 0;)
+        {
+            profile_frame *Frame = GetProfilerFrame(Age);
+
+            for (uint32_t Zone = 1; Zone < Frame->ZoneCount; ++Zone)
+            {
+                profile_zone_summary *Summary = Frame->Zones + Zone;
+
+                if (Summary->HitCount)
+                {
+                    AppendProfile(&Buffer, "%llu,%.4f,%.64s,%llu,%llu,%.4f,%.4f",
+                                  (unsigned long long)Frame->Index, TicksToMs((int64_t)Frame->Ticks), GetProfilerZoneName(Zone),
+                                  (unsigned long long)Summary->HitCount, (unsigned long long)Summary->Elements,
+                                  TicksToMs(Summary->Inclusive), TicksToMs(Summary->Exclusive));
+
+                    for (uint32_t Type = 0; Type < PerfCounter_Count; ++Type)
+                    {
+                        AppendProfile(&Buffer, ",%lld", (long long)Summary->Events[Type]);
+                    }
+
+                    AppendProfile(&Buffer, "\n");
+                }
+            }
+        }
+
+        Buffer.Size = Buffer.At;
+        Result      = WriteBufferToFile(Path, &Buffer);
+    }
+
+    LeaveMemoryRegion(Region);
+
+    return Result;
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "platform.h"
+
+#define PROFILER_MAX_ZONE_COUNT      512
+#define PROFILER_MAX_THREAD_COUNT    256
+#define PROFILER_HISTORY_FRAME_COUNT 256
+
+// ==============================================
+// <Profiler>
+// ==============================================
+
+// Instrumented timing of named zones. A zone is the code between TIMED_BLOCK_BEGIN(Name) and
+// TIMED_BLOCK_END(Name) in one function, or the statement after TIMED_BLOCK(Name). Each thread adds
+// to counters of its own: how often a zone ran, its time inclusive of the zones opened inside it and
+// exclusive of them. A zone that recurses counts its outermost run once towards inclusive time.
+//
+// Nothing is recorded until capture is on. Until then a block is two stores and a test of
+// ProfilerCapturing inline, nothing is called. Once on, a block costs two calls, two reads of the
+// CPU timestamp counter and a few adds. Turning capture on or off is fine at any time, from any
+// thread, a block opened while it was off is not recorded even if it ends with capture on.
+//
+// EndProfilerFrame is called once per frame by the thread that owns the frame. It adds up what every
+// thread recorded since the last call into a frame summary, the last PROFILER_HISTORY_FRAME_COUNT
+// captured summaries are kept. A block still open at the end of a frame counts towards the frame it
+// ends in, exclusive times of its parents may then come out negative for one frame.
+//
+// Blocks must be closed on every path out of them and on the thread they were opened on. A job that
+// waits inside a block may come back on another thread (see work_queue.h), the block is then dropped
+// and the thread it was opened on goes back to the block's parent, unless a block opened there since
+// is still open.
+//
+// With counters on as well, every block also reads the thread's hardware counters (OSOpenPerfCounters
+// in platform.h) at both ends and zones add up the events exclusive of their children, like their
+// exclusive time. Where the OS will not hand counters out they stay 0. A read is a system call, a
+// zone run millions of times a frame is too fine for them: time a loop instead of its body and give
+// it the number of elements it went through with TIMED_BLOCK_ELEMENTS, summaries then report events
+// per element. A zone without elements counts one per run.
+
+typedef struct
+{
+    uint64_t  Start;
+    uint64_t  OldInclusive;
+    uint64_t  StartEvents[PerfCounter_Count];
+    uint64_t  Elements;
+    void     *Thread;        // Whose counters, 0 when the block is not recorded.
+    uint32_t  Zone;
+    uint32_t  Parent;
+    bool      Counted;       // StartEvents were read.
+    bool      Open;          // For TIMED_BLOCK.
+} profile_block;
+
+
+typedef struct
+{
+    uint64_t HitCount;
+    uint64_t Elements;       // TIMED_BLOCK_ELEMENTS, inclusive.
+    int64_t  Inclusive;      // CPU timer ticks, see GetProfilerFrequency.
+    int64_t  Exclusive;
+    int64_t  Events[PerfCounter_Count]; // Exclusive.
+} profile_zone_summary;
+
+
+typedef struct
+{
+    uint64_t             Index;       // Frames ended since the process started, captured or not.
+    uint64_t             Ticks;       // From the end of the previous frame to the end of this one.
+    uint32_t             ZoneCount;   // Zones registered when the frame ended, index 0 is unused.
+    profile_zone_summary Zones[PROFILER_MAX_ZONE_COUNT];
+} profile_frame;
+
+
+// Written by SetProfilerCapture only. Read without a fence on purpose, a block that misses a toggle
+// by a few instructions does not matter and an interlocked read on every block would.
+extern uint32_t volatile ProfilerCapturing;
+
+// Only Thread and Elements are set while capture is off, the rest of the block is left as it is.
+#define TIMED_BLOCK_BEGIN(Name)                                                                      \
+    static uint32_t volatile TimedZone_##Name;                                                       \
+    profile_block TimedBlock_##Name;                                                                 \
+    TimedBlock_##Name.Thread   = 0;                                                                  \
+    TimedBlock_##Name.Elements = 0;                                                                  \
+    (void)(ProfilerCapturing && BeginProfileBlock(&TimedBlock_##Name, &TimedZone_##Name, #Name))
+
+#define TIMED_BLOCK_END(Name) (TimedBlock_##Name.Thread ? EndProfileBlock(&TimedBlock_##Name) : (void)0)
+
+#define TIMED_BLOCK_ELEMENTS(Name, Count) (TimedBlock_##Name.Elements += (uint64_t)(Count))
+
+// Times the statement or braces that follow, which must not break or return out of it. Expands to
+// two statements, do not use it as the body of an if or a loop without braces. The condition opens
+// the block the one time it is tested with Open set.
+#define TIMED_BLOCK(Name)                                                                            \
+    static uint32_t volatile TimedZone_##Name;                                                       \
+    for (profile_block TimedBlock_##Name = {.Open = true};                                           \
+         TimedBlock_##Name.Open &&                                                                   \
+         ((void)(ProfilerCapturing && BeginProfileBlock(&TimedBlock_##Name, &TimedZone_##Name, #Name)), true); \
+         TIMED_BLOCK_END(Name), TimedBlock_##Name.Open = false)
+
+
+// Called through the macros. Begin returns whether the block is recorded, End is only called for
+// blocks that are.
+bool            BeginProfileBlock     (profile_block *Block, uint32_t volatile *Zone, const char *Name);
+void            EndProfileBlock       (profile_block *Block);
+
+void            SetProfilerCapture    (bool Capture);
+bool            IsProfilerCapturing   (void);
+void            SetProfilerCounters   (bool Count);
+bool            IsProfilerCounting    (void);
+void            EndProfilerFrame      (void);
+
+// Age 0 is the last frame ended, 0 is returned once there are no frames that old.
+profile_frame * GetProfilerFrame      (uint32_t Age);
+const char    * GetProfilerZoneName   (uint32_t Zone);
+uint64_t        GetProfilerFrequency  (void);
+
+// The summary of one frame to stdout, zones by exclusive time, with instructions per cycle and
+// misses per element when there were counters. The history as CSV, one line per zone that ran in a
+// frame, oldest frame first.
+void            PrintProfilerFrame    (uint32_t Age);
+bool            WriteProfilerHistory  (byte_string Path, memory_arena *Arena);
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 #include <assert.h>
+#include <string.h>
 
 #include "utilities.h"
 #include "engine/engine.h"
@@ -10,8 +11,11 @@
 #include <Windows.h>
 
 #include "platform.h"
+#include "work_queue.h"
+#include "profiler.h"
 #include "engine/rendering/renderer.h"
 #include "engine/rendering/d3d11/d3d11.h"
+#include "engine/rendering/textures/texture_streaming.h"
 
 // ==============================================
 // <Memory> : PUBLIC
@@ -35,6 +39,175 @@ void OSRelease(void *At, size_t Size)
 	VirtualFree(At, 0, MEM_RELEASE);
 }
 
+// ==============================================
+// <Timing> : PUBLIC
+// ==============================================
+
+uint64_t OSReadTimer(void)
+{
+	LARGE_INTEGER Counter;
+	QueryPerformanceCounter(&Counter);
+	return (uint64_t)Counter.QuadPart;
+}
+
+uint64_t OSGetTimerFrequency(void)
+{
+	LARGE_INTEGER Frequency;
+	QueryPerformanceFrequency(&Frequency);
+	return (uint64_t)Frequency.QuadPart;
+}
+
+// Windows has no user mode access to the PMU, only ETW sessions that need elevation and a reader.
+
+bool OSOpenPerfCounters(os_perf_counters *Counters)
+{
+	Counters->Group     = -1;
+	Counters->Available = 0;
+
+	return false;
+}
+
+void OSReadPerfCounters(os_perf_counters *Counters, uint64_t Values[PerfCounter_Count])
+{
+	for (uint32_t Type = 0; Type < PerfCounter_Count; ++Type)
+	{
+		Values[Type] = 0;
+	}
+}
+
+// ==============================================
+// <Files> : PUBLIC
+// ==============================================
+
+os_file_list OSListDirectory(byte_string Path, memory_arena *Arena)
+{
+	os_file_list Result = {0};
+
+	if (IsValidByteString(Path) && Arena)
+	{
+		byte_string PatternParts[2] = {Path, ByteStringLiteral("*")};
+		byte_string Pattern         = ConcatenateStrings(PatternParts, 2, ByteStringLiteral("/"), Arena);
+
+		WIN32_FIND_DATAA FindData;
+		HANDLE           FindHandle = FindFirstFileA((const char *)Pattern.Data, &FindData);
+		if (FindHandle != INVALID_HANDLE_VALUE)
+		{
+			do
+			{
+				if (strcmp(FindData.cFileName, ".") == 0 || strcmp(FindData.cFileName, "..") == 0)
+				{
+					continue;
+				}
+
+				os_file_node *Node = PushStruct(Arena, os_file_node);
+				if (Node)
+				{
+					byte_string PathParts[2] = {Path, ByteString((uint8_t *)FindData.cFileName, strlen(FindData.cFileName))};
+
+					Node->Next        = 0;
+					Node->Path        = ConcatenateStrings(PathParts, 2, ByteStringLiteral("/"), Arena);
+					Node->IsDirectory = (FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+
+					if (!Result.First)
+					{
+						Result.First = Node;
+						Result.Last  = Node;
+					}
+					else
+					{
+						Result.Last->Next = Node;
+						Result.Last       = Node;
+					}
+
+					++Result.Count;
+				}
+			} while (FindNextFileA(FindHandle, &FindData));
+
+			FindClose(FindHandle);
+		}
+	}
+
+	return Result;
+}
+
+bool OSCreateDirectory(byte_string Path)
+{
+	bool Result = false;
+
+	if (IsValidByteString(Path))
+	{
+		Result = CreateDirectoryA((const char *)Path.Data, 0) || GetLastError() == ERROR_ALREADY_EXISTS;
+	}
+
+	return Result;
+}
+
+bool OSDeleteFile(byte_string Path)
+{
+	bool Result = false;
+
+	if (IsValidByteString(Path))
+	{
+		Result = DeleteFileA((const char *)Path.Data);
+	}
+
+	return Result;
+}
+
+bool OSDeleteDirectory(byte_string Path)
+{
+	bool Result = false;
+
+	if (IsValidByteString(Path))
+	{
+		Result = RemoveDirectoryA((const char *)Path.Data);
+	}
+
+	return Result;
+}
+
+buffer OSMapFile(byte_string Path)
+{
+	buffer Result = {0};
+
+	if (IsValidByteString(Path))
+	{
+		HANDLE File = CreateFileA((const char *)Path.Data, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if (File != INVALID_HANDLE_VALUE)
+		{
+			LARGE_INTEGER Size;
+			if (GetFileSizeEx(File, &Size) && Size.QuadPart > 0)
+			{
+				// The view keeps the mapping alive, both handles can be closed right away.
+
+				HANDLE Mapping = CreateFileMappingA(File, 0, PAGE_READONLY, 0, 0, 0);
+				if (Mapping)
+				{
+					Result.Data = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+					Result.Size = Result.Data ? (size_t)Size.QuadPart : 0;
+
+					CloseHandle(Mapping);
+				}
+			}
+
+			CloseHandle(File);
+		}
+	}
+
+	return Result;
+}
+
+void OSUnmapFile(buffer *File)
+{
+	if (File && File->Data)
+	{
+		UnmapViewOfFile(File->Data);
+
+		File->Data = 0;
+		File->Size = 0;
+	}
+}
+
 // ==============================================
 // <Utilities>   : INTERNAL
 // ==============================================
@@ -64,103 +237,311 @@ Win32GetClientSize(HWND Window, int *OutWidth, int *OutHeight)
 // =============================================
 
 
-typedef struct
+typedef struct os_semaphore
 {
-    platform_work_queue_callback *Callback;
-    void                         *Data;
-} platform_work_queue_entry;
+    HANDLE Handle;
+} os_semaphore;
 
 
-typedef struct platform_work_queue
+typedef struct
 {
-    uint32_t volatile CompletionGoal;
-    uint32_t volatile CompletionCount;
+    os_thread_proc *Proc;
+    void           *Parameter;
+} win32_thread_start;
 
-    uint32_t volatile NextEntryToWrite;
-    uint32_t volatile NextEntryToRead;
-    HANDLE            SemaphoreHandle;
 
-    platform_work_queue_entry Entries[128];
-} platform_work_queue;
+static DWORD WINAPI
+Win32ThreadProc(LPVOID Parameter)
+{
+    win32_thread_start *Start = (win32_thread_start *)Parameter;
+    Start->Proc(Start->Parameter);
 
+    return 0;
+}
 
-typedef struct
+
+typedef struct os_fiber
 {
-    DWORD                ID;
-    platform_work_queue *Queue;
-} win32_thread_info;
+    LPVOID         Handle;
+    os_fiber_proc *Proc;
+    void          *Parameter;
+} os_fiber;
 
 
-static void
-Win32AddEntry(platform_work_queue *Queue, platform_work_queue_callback *Callback, void *Data)
+static VOID WINAPI
+Win32FiberProc(LPVOID Parameter)
 {
-    assert((Queue->NextEntryToWrite + 1) % ArrayCount(Queue->Entries) != Queue->NextEntryToRead);
+    os_fiber *Fiber = (os_fiber *)Parameter;
+    Fiber->Proc(Fiber->Parameter);
+
+    assert(!"A fiber returned");
+}
+
 
-    platform_work_queue_entry *Entry = Queue->Entries + Queue->NextEntryToWrite;
-    Entry->Callback = Callback;
-    Entry->Data     = Data;
+// ==============================================
+// <Threading> : PUBLIC
+// ==============================================
 
-    // Use Array count macro 
-    _WriteBarrier();
-    _mm_sfence();
-    Queue->NextEntryToWrite = (Queue->NextEntryToWrite + 1) % ArrayCount(Queue->Entries);
-    Queue->CompletionGoal  += 1;
 
-    ReleaseSemaphore(Queue->SemaphoreHandle, 1, 0);
+// GetSystemInfo only counts the processor group the process started in, at most 64.
+
+uint32_t
+OSGetProcessorCount(void)
+{
+    DWORD    Count  = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    uint32_t Result = Count ? (uint32_t)Count : 1;
+    return Result;
 }
 
 
-static bool
-Win32DoNextWorkQueueEntry(platform_work_queue *Queue)
+// Cores come with the groups and masks of their processors, nodes with the mask of theirs. A node
+// that spans several groups only reports its first here, the rest of it stays on node 0.
+
+os_topology
+OSGetTopology(memory_arena *Arena)
 {
-    bool ShouldSleep = false;
+    os_topology   Result     = {0};
+    DWORD         Size       = 0;
+    uint32_t      Count      = OSGetProcessorCount();
+    os_processor *Processors = PushArray(Arena, os_processor, Count);
+
+    GetLogicalProcessorInformationEx(RelationAll, 0, &Size);
 
-    uint32_t OriginalNextEntryToRead = Queue->NextEntryToRead;
-    uint32_t NewNextEntryToRead      = (OriginalNextEntryToRead + 1) % ArrayCount(Queue->Entries); // Use array count macro
-    if (OriginalNextEntryToRead != Queue->NextEntryToWrite)
+    memory_region Region = EnterMemoryRegion(Arena);
+    uint8_t      *Buffer = Size ? PushArray(Arena, uint8_t, Size) : 0;
+
+    if (Processors && Buffer && GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)Buffer, &Size))
     {
-        uint32_t Index = InterlockedCompareExchange((LONG volatile *)&Queue->NextEntryToRead, NewNextEntryToRead, OriginalNextEntryToRead);
-        if (Index == OriginalNextEntryToRead)
+        for (DWORD Offset = 0; Offset < Size; )
+        {
+            SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *Info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)(Buffer + Offset);
+
+            if (Info->Relationship == RelationProcessorCore)
+            {
+                uint32_t Thread = 0;
+
+                for (WORD GroupIdx = 0; GroupIdx < Info->Processor.GroupCount; ++GroupIdx)
+                {
+                    GROUP_AFFINITY Group = Info->Processor.GroupMask[GroupIdx];
+
+                    for (uint32_t Bit = 0; Bit < 64 && Result.ProcessorCount < Count; ++Bit)
+                    {
+                        if (Group.Mask & ((KAFFINITY)1 << Bit))
+                        {
+                            os_processor *Processor = Processors + Result.ProcessorCount++;
+
+                            Processor->Id     = (uint32_t)Group.Group * 64 + Bit;
+                            Processor->Core   = Result.CoreCount;
+                            Processor->Node   = 0;
+                            Processor->Thread = Thread++;
+                        }
+                    }
+                }
+
+                Result.CoreCount += 1;
+            }
+
+            Offset += Info->Size;
+        }
+
+        for (DWORD Offset = 0; Offset < Size; )
         {
-            platform_work_queue_entry Entry = Queue->Entries[Index];
-            Entry.Callback(Queue, Entry.Data);
-            InterlockedIncrement((LONG volatile *)&Queue->CompletionCount);
+            SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *Info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)(Buffer + Offset);
+
+            if (Info->Relationship == RelationNumaNode)
+            {
+                GROUP_AFFINITY Group = Info->NumaNode.GroupMask;
+
+                for (uint32_t Idx = 0; Idx < Result.ProcessorCount; ++Idx)
+                {
+                    os_processor *Processor = Processors + Idx;
+                    bool          InNode    = Processor->Id / 64 == Group.Group && (Group.Mask & ((KAFFINITY)1 << (Processor->Id % 64)));
+
+                    Processor->Node = InNode ? (uint32_t)Info->NumaNode.NodeNumber : Processor->Node;
+                }
+
+                Result.NodeCount = Maximum(Result.NodeCount, (uint32_t)Info->NumaNode.NodeNumber + 1);
+            }
+
+            Offset += Info->Size;
         }
+
+        Result.NodeCount  = Maximum(Result.NodeCount, 1);
+        Result.Processors = Processors;
     }
     else
     {
-        ShouldSleep = true;
+        Result.ProcessorCount = 0;
+        Result.CoreCount      = 0;
     }
 
-    return ShouldSleep;
+    LeaveMemoryRegion(Region);
+
+    return Result;
 }
 
 
-static void
-Win32CompleteAllWork(platform_work_queue *Queue)
+bool
+OSPinThread(uint32_t ProcessorId)
+{
+    GROUP_AFFINITY Affinity = {0};
+
+    Affinity.Group = (WORD)(ProcessorId / 64);
+    Affinity.Mask  = (KAFFINITY)1 << (ProcessorId % 64);
+
+    bool Result = SetThreadGroupAffinity(GetCurrentThread(), &Affinity, 0) != 0;
+    return Result;
+}
+
+
+bool
+OSStartThread(os_thread_proc *Proc, void *Parameter, memory_arena *Arena)
+{
+    bool                Result = false;
+    win32_thread_start *Start  = PushStruct(Arena, win32_thread_start);
+
+    if (Start)
+    {
+        Start->Proc      = Proc;
+        Start->Parameter = Parameter;
+
+        HANDLE ThreadHandle = CreateThread(0, 0, Win32ThreadProc, Start, 0, 0);
+        if (ThreadHandle)
+        {
+            CloseHandle(ThreadHandle);
+            Result = true;
+        }
+    }
+
+    return Result;
+}
+
+
+os_semaphore *
+OSCreateSemaphore(memory_arena *Arena)
 {
-    while (Queue->CompletionGoal != Queue->CompletionCount)
+    os_semaphore *Result = PushStruct(Arena, os_semaphore);
+
+    if (Result)
     {
-        Win32DoNextWorkQueueEntry(Queue);
+        // Signals may pile up while nobody sleeps, the count must not cap them.
+
+        Result->Handle = CreateSemaphoreEx(0, 0, MAXLONG, 0, 0, SEMAPHORE_ALL_ACCESS);
+        Result         = Result->Handle ? Result : 0;
     }
 
-    Queue->CompletionGoal  = 0;
-    Queue->CompletionCount = 0;
+    return Result;
 }
 
 
-static DWORD WINAPI
-ThreadProc(LPVOID lpParameter)
+void
+OSSignalSemaphore(os_semaphore *Semaphore)
 {
-    win32_thread_info *ThreadInfo = (win32_thread_info *)lpParameter;
+    ReleaseSemaphore(Semaphore->Handle, 1, 0);
+}
+
+
+void
+OSWaitSemaphore(os_semaphore *Semaphore)
+{
+    WaitForSingleObjectEx(Semaphore->Handle, INFINITE, FALSE);
+}
+
 
-    for (;;)
+void
+OSYieldThread(void)
+{
+    SwitchToThread();
+}
+
+
+// Jobs use floating point, the switches must carry its state along.
+
+os_fiber *
+OSCreateFiber(os_fiber_proc *Proc, void *Parameter, size_t StackSize, memory_arena *Arena)
+{
+    os_fiber *Result = PushStruct(Arena, os_fiber);
+
+    if (Result)
     {
-        if (Win32DoNextWorkQueueEntry(ThreadInfo->Queue))
+        Result->Proc      = Proc;
+        Result->Parameter = Parameter;
+        Result->Handle    = CreateFiberEx(StackSize, StackSize, FIBER_FLAG_FLOAT_SWITCH, Win32FiberProc, Result);
+        Result            = Result->Handle ? Result : 0;
+    }
+
+    return Result;
+}
+
+
+void
+OSEnterFiber(os_fiber *Fiber)
+{
+    ConvertThreadToFiberEx(0, FIBER_FLAG_FLOAT_SWITCH);
+    SwitchToFiber(Fiber->Handle);
+
+    assert(!"Could not enter the fiber");
+}
+
+
+void
+OSSwitchToFiber(os_fiber *From, os_fiber *To)
+{
+    (void)From;
+    SwitchToFiber(To->Handle);
+}
+
+
+engine_memory
+OSCreateEngineMemory(uint32_t WorkerCount)
+{
+    engine_memory EngineMemory = { 0 };
+    {
+        {
+            memory_arena_params Params =
+            {
+                .AllocatedFromFile = __FILE__,
+                .AllocatedFromLine = __LINE__,
+                .ReserveSize       = MiB(128),
+                .CommitSize        = MiB(16),
+            };
+
+            EngineMemory.StateMemory = AllocateArena(Params);
+        }
+
         {
-            WaitForSingleObjectEx(ThreadInfo->Queue->SemaphoreHandle, INFINITE, FALSE);
+            memory_arena_params Params =
+            {
+                .AllocatedFromFile = __FILE__,
+                .AllocatedFromLine = __LINE__,
+                .ReserveSize       = GiB(2),
+                .CommitSize        = MiB(32),
+            };
+
+            EngineMemory.FrameMemory = AllocateArena(Params);
         }
     }
+
+    os_topology Topology = OSGetTopology(EngineMemory.StateMemory);
+
+    work_queue_params QueueParams =
+    {
+        .WorkerCount = WorkerCount ? WorkerCount : OSGetProcessorCount(),
+        .UseFibers   = true,
+        .Topology    = &Topology,
+    };
+
+    platform_work_queue *WorkQueue = CreateWorkQueue(QueueParams, EngineMemory.StateMemory);
+
+    EngineMemory.AddEntry       = AddWorkQueueEntry;
+    EngineMemory.CompleteWork   = CompleteWorkQueue;
+    EngineMemory.AddJob         = AddWorkQueueJob;
+    EngineMemory.AddJobAfter    = AddWorkQueueJobAfter;
+    EngineMemory.WaitForCounter = WaitForWorkQueueCounter;
+    EngineMemory.WorkQueue      = WorkQueue;
+    EngineMemory.WorkerCount    = GetWorkQueueWorkerCount(WorkQueue);
+
+    return EngineMemory;
 }
 
 
@@ -168,6 +549,19 @@ ThreadProc(LPVOID lpParameter)
 // <Entry Point> : INTERNAL
 // ==============================================
 
+// Command-line tools bring their own main() and only link the OS layer above.
+
+#ifndef ADB_TOOL
+
+// What streamed textures may keep resident, tails included. See textures/texture_streaming.h.
+#define WIN32_TEXTURE_STREAM_BUDGET       MiB(256)
+#define WIN32_MAX_STREAMED_TEXTURE_COUNT  1024
+
+// F9 turns profiler capture on and off, F10 writes the frames captured so far next to the executable.
+#define WIN32_PROFILE_PATH                "profile.csv"
+
+static bool Win32WriteProfile;
+
 
 static LRESULT CALLBACK
 Win32MessageHandler(HWND Hwnd, UINT Message, WPARAM WParam, LPARAM LParam)
@@ -181,6 +575,18 @@ Win32MessageHandler(HWND Hwnd, UINT Message, WPARAM WParam, LPARAM LParam)
         return 0;
     } break;
 
+    case WM_KEYDOWN:
+    {
+        if (WParam == VK_F9)
+        {
+            SetProfilerCapture(!IsProfilerCapturing());
+        }
+        else if (WParam == VK_F10)
+        {
+            Win32WriteProfile = true;
+        }
+    } break;
+
     default: break;
 
     }
@@ -223,70 +629,13 @@ WinMain(HINSTANCE HInstance, HINSTANCE PrevInstance, LPSTR CmdLine, int CmdShow)
     HWND WindowHandle = Win32CreateWindow(1920, 1080, HInstance, CmdShow);
     BOOL Running      = true;
 
-    // Threading Stuff
-    platform_work_queue WorkQueue = {0};
-    {
-        SYSTEM_INFO SystemInfo;
-        GetSystemInfo(&SystemInfo);
-
-        DWORD               ProcessorCount  = SystemInfo.dwNumberOfProcessors;
-        win32_thread_info   ThreadInfos[32] = {0};
-        HANDLE              SemaphoreHandle = CreateSemaphoreEx(0, 0, ProcessorCount, 0, 0, SEMAPHORE_ALL_ACCESS);
-
-        assert(ProcessorCount < 32);
-
-        for (DWORD LogicalIndex = 0; LogicalIndex < ProcessorCount; ++LogicalIndex)
-        {
-            win32_thread_info *ThreadInfo = ThreadInfos + LogicalIndex;
-            ThreadInfo->ID                     = LogicalIndex;
-            ThreadInfo->Queue                  = &WorkQueue;
-            ThreadInfo->Queue->SemaphoreHandle = SemaphoreHandle;
-
-            DWORD ThreadID;
-            HANDLE ThreadHandle = CreateThread(0, 0, ThreadProc, ThreadInfo, 0, &ThreadID);
-            if (ThreadHandle)
-            {
-                CloseHandle(ThreadHandle);
-            }
-        }
-    }
-
-    engine_memory EngineMemory = { 0 };
-    {
-        {
-            memory_arena_params Params =
-            {
-                .AllocatedFromFile = __FILE__,
-                .AllocatedFromLine = __LINE__,
-                .ReserveSize       = MiB(128),
-                .CommitSize        = MiB(16),
-            };
-
-            EngineMemory.StateMemory = AllocateArena(Params);
-        }
-
-        {
-            memory_arena_params Params =
-            {
-                .AllocatedFromFile = __FILE__,
-                .AllocatedFromLine = __LINE__,
-                .ReserveSize       = GiB(2),
-                .CommitSize        = MiB(32),
-            };
-
-            EngineMemory.FrameMemory = AllocateArena(Params);
-        }
-
-        EngineMemory.AddEntry     = Win32AddEntry;
-        EngineMemory.CompleteWork = Win32CompleteAllWork;
-        EngineMemory.WorkQueue    = &WorkQueue;
-    }
-
+    engine_memory EngineMemory = OSCreateEngineMemory(0);
 
     renderer *Renderer = PushStruct(EngineMemory.StateMemory, renderer);
     Renderer->Backend        = D3D11Initialize(WindowHandle, EngineMemory.StateMemory);
     Renderer->Resources      = CreateResourceManager(EngineMemory.StateMemory);
     Renderer->ReferenceTable = CreateResourceReferenceTable(EngineMemory.StateMemory);
+    Renderer->Streamer       = CreateTextureStreamer(WIN32_TEXTURE_STREAM_BUDGET, WIN32_MAX_STREAMED_TEXTURE_COUNT, EngineMemory.StateMemory);
 
     while (Running)
     {
@@ -309,7 +658,14 @@ WinMain(HINSTANCE HInstance, HINSTANCE PrevInstance, LPSTR CmdLine, int CmdShow)
 
         // Frame Cleanup
         {
+            if (Win32WriteProfile)
+            {
+                WriteProfilerHistory(ByteStringLiteral(WIN32_PROFILE_PATH), EngineMemory.FrameMemory);
+                Win32WriteProfile = false;
+            }
+
             PopArenaTo(EngineMemory.FrameMemory, 0);
+            EndProfilerFrame();
         }
 
         Win32Sleep(8);
@@ -318,4 +674,6 @@ WinMain(HINSTANCE HInstance, HINSTANCE PrevInstance, LPSTR CmdLine, int CmdShow)
     return 0;
 }
 
+#endif // ADB_TOOL
+
 #endif // _WIN32
\ No newline at end of file
@@ -0,0 +1,1493 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "utilities.h"
+#include "platform.h"
+#include "work_queue.h"
+
+#define WORK_DEQUE_INITIAL_CAPACITY  256
+#define WORK_INJECT_INITIAL_CAPACITY 256
+#define WORK_WAITER_CHUNK_COUNT      256
+#define WORK_FIBERS_PER_WORKER       16
+#define WORK_FIBER_STACK_SIZE        MiB(1)
+#define WORK_LANE_STARVATION_LIMIT   32
+#define WORK_TRACE_EVENT_COUNT       65536 // Per thread, a power of two.
+
+// ==============================================
+// <Deques> : INTERNAL
+// ==============================================
+
+
+typedef struct
+{
+    platform_work_queue_callback *Callback;
+    void                         *Data;
+    job_counter                  *Counter;
+    const char                   *Label;
+    uint64_t                      Queued;   // Timer reading when added, only while tracing.
+} work_queue_entry;
+
+
+typedef struct work_queue_buffer work_queue_buffer;
+struct work_queue_buffer
+{
+    work_queue_buffer *Previous; // Outgrown, kept alive for stealers that still read it.
+    work_queue_entry  *Entries;
+    uint64_t           Mask;     // Capacity - 1, capacities are powers of two.
+};
+
+
+// Top and Bottom only grow, an entry lives in Entries[Index & Mask]. They sit on their own cache
+// lines, stealers hammer Top while the owner works on Bottom.
+
+typedef struct
+{
+    uint64_t volatile           Top;
+    uint8_t                     TopPadding[56];
+    uint64_t volatile           Bottom;
+    work_queue_buffer *volatile Buffer;
+    uint8_t                     BottomPadding[48];
+} work_deque;
+
+
+static work_queue_buffer *
+AllocateWorkBuffer(uint64_t Capacity, work_queue_buffer *Previous)
+{
+    uint64_t           Size   = sizeof(work_queue_buffer) + Capacity * sizeof(work_queue_entry);
+    work_queue_buffer *Result = (work_queue_buffer *)OSReserve(Size);
+
+    if (Result && OSCommit(Result, Size))
+    {
+        Result->Previous = Previous;
+        Result->Entries  = (work_queue_entry *)(Result + 1);
+        Result->Mask     = Capacity - 1;
+    }
+    else
+    {
+        assert(!"OUT OF MEMORY");
+        Result = 0;
+    }
+
+    return Result;
+}
+
+
+static void
+ReleaseWorkBuffer(work_queue_buffer *Buffer)
+{
+    OSRelease(Buffer, sizeof(work_queue_buffer) + (Buffer->Mask + 1) * sizeof(work_queue_entry));
+}
+
+
+// A stealer copies its slot before it knows the entry is its own, the owner may be refilling that
+// slot after a wrap. The copy is dropped when the steal fails, but it must still be read and written
+// one field at a time through atomics or it is a race.
+
+static work_queue_entry
+ReadWorkSlot(work_queue_entry *Slot)
+{
+    work_queue_entry Result;
+
+    Result.Callback = (platform_work_queue_callback *)AtomicLoadPointer(&Slot->Callback);
+    Result.Data     = AtomicLoadPointer(&Slot->Data);
+    Result.Counter  = (job_counter *)AtomicLoadPointer(&Slot->Counter);
+    Result.Label    = (const char *)AtomicLoadPointer(&Slot->Label);
+    Result.Queued   = AtomicLoad64(&Slot->Queued);
+
+    return Result;
+}
+
+
+static void
+WriteWorkSlot(work_queue_entry *Slot, work_queue_entry Entry)
+{
+    AtomicStorePointer(&Slot->Callback, Entry.Callback);
+    AtomicStorePointer(&Slot->Data, Entry.Data);
+    AtomicStorePointer(&Slot->Counter, Entry.Counter);
+    AtomicStorePointer(&Slot->Label, (void *)Entry.Label);
+    AtomicStore64(&Slot->Queued, Entry.Queued);
+}
+
+
+static void
+PushWorkDeque(work_deque *Deque, work_queue_entry Entry)
+{
+    uint64_t           Bottom = AtomicLoad64(&Deque->Bottom);
+    uint64_t           Top    = AtomicLoad64(&Deque->Top);
+    work_queue_buffer *Buffer = Deque->Buffer;
+
+    if (Bottom - Top > Buffer->Mask)
+    {
+        work_queue_buffer *Grown = AllocateWorkBuffer((Buffer->Mask + 1) * 2, Buffer);
+
+        for (uint64_t Index = Top; Index < Bottom; ++Index)
+        {
+            Grown->Entries[Index & Grown->Mask] = Buffer->Entries[Index & Buffer->Mask];
+        }
+
+        AtomicStorePointer(&Deque->Buffer, Grown);
+        Buffer = Grown;
+    }
+
+    WriteWorkSlot(Buffer->Entries + (Bottom & Buffer->Mask), Entry);
+    AtomicStore64(&Deque->Bottom, Bottom + 1);
+}
+
+
+// Owner only. Takes the newest entry, races the stealers for the last one.
+
+static bool
+PopWorkDeque(work_deque *Deque, work_queue_entry *Entry)
+{
+    bool Result = false;
+
+    // Only the owner moves Bottom and Top never passes it, an empty deque stays empty meanwhile.
+
+    uint64_t Bottom = AtomicLoad64(&Deque->Bottom);
+
+    if (Bottom != AtomicLoad64(&Deque->Top))
+    {
+        Bottom -= 1;
+        AtomicStore64(&Deque->Bottom, Bottom);
+
+        uint64_t Top = AtomicLoad64(&Deque->Top);
+
+        if ((int64_t)(Bottom - Top) >= 0)
+        {
+            *Entry = Deque->Buffer->Entries[Bottom & Deque->Buffer->Mask];
+            Result = true;
+
+            if (Bottom == Top)
+            {
+                Result = AtomicCompareExchange64(&Deque->Top, Top, Top + 1);
+                AtomicStore64(&Deque->Bottom, Bottom + 1);
+            }
+        }
+        else
+        {
+            AtomicStore64(&Deque->Bottom, Bottom + 1);
+        }
+    }
+
+    return Result;
+}
+
+
+// Any thread. Fails when the deque looked empty or another thread took the entry first.
+
+static bool
+StealWorkDeque(work_deque *Deque, work_queue_entry *Entry)
+{
+    bool Result = false;
+
+    uint64_t Top    = AtomicLoad64(&Deque->Top);
+    uint64_t Bottom = AtomicLoad64(&Deque->Bottom);
+
+    if ((int64_t)(Bottom - Top) > 0)
+    {
+        work_queue_buffer *Buffer = (work_queue_buffer *)AtomicLoadPointer(&Deque->Buffer);
+        work_queue_entry   Stolen = ReadWorkSlot(Buffer->Entries + (Top & Buffer->Mask));
+
+        if (AtomicCompareExchange64(&Deque->Top, Top, Top + 1))
+        {
+            *Entry = Stolen;
+            Result = true;
+        }
+    }
+
+    return Result;
+}
+
+
+static bool
+IsWorkDequeEmpty(work_deque *Deque)
+{
+    bool Result = (int64_t)(AtomicLoad64(&Deque->Bottom) - AtomicLoad64(&Deque->Top)) <= 0;
+    return Result;
+}
+
+// ==============================================
+// <Tracing> : INTERNAL
+// ==============================================
+
+
+typedef enum
+{
+    WorkTrace_Job   = 0,
+    WorkTrace_Sleep = 1,
+    WorkTrace_Wait  = 2,
+} WorkTrace_Type;
+
+
+typedef struct
+{
+    uint64_t    Start;
+    uint64_t    End;
+    uint64_t    Queued;  // First stretch of a job only, 0 otherwise.
+    const char *Label;
+    uint8_t     Type;
+    uint8_t     Lane;
+    bool        Stolen;
+    bool        Parked;  // The stretch ended with the job parking its fiber.
+} work_trace_event;
+
+
+// Written by whichever thread runs the worker. Count only grows, an event lives in
+// Events[Count & (WORK_TRACE_EVENT_COUNT - 1)] and the oldest one goes when the ring is full.
+
+typedef struct
+{
+    work_trace_event  *Events;
+    uint64_t volatile  Count;
+} work_trace_ring;
+
+
+// A traced job running on a fiber, lives on the fiber's stack while the job runs. Jobs that run
+// inside another one's wait stack up, parking ends a stretch for every one of them.
+
+typedef struct work_trace_job work_trace_job;
+struct work_trace_job
+{
+    work_trace_job   *Outer;
+    work_trace_event  Event;
+};
+
+
+static const char *TraceLaneNames[JobPriority_Count] = {"frame", "normal", "background"};
+
+
+static void
+RecordTraceEvent(work_trace_ring *Ring, work_trace_event Event)
+{
+    if (Ring->Events)
+    {
+        uint64_t Count = Ring->Count;
+
+        Ring->Events[Count & (WORK_TRACE_EVENT_COUNT - 1)] = Event;
+        AtomicStore64(&Ring->Count, Count + 1);
+    }
+}
+
+
+static void
+AppendTrace(buffer *Buffer, const char *Format, ...)
+{
+    va_list Args;
+    va_start(Args, Format);
+
+    size_t Left    = Buffer->Size - Buffer->At;
+    int    Written = Left ? vsnprintf((char *)Buffer->Data + Buffer->At, Left, Format, Args) : 0;
+
+    Buffer->At += Written > 0 ? Minimum((size_t)Written, Left - 1) : 0;
+
+    va_end(Args);
+}
+
+// ==============================================
+// <Work Queue> : INTERNAL
+// ==============================================
+
+
+typedef struct work_fiber work_fiber;
+
+typedef struct
+{
+    platform_work_queue *Queue;
+    uint32_t             Index;
+    uint32_t             Random;
+    uint32_t             Node;
+    uint32_t             Processor;  // os_processor Id, when Pinned.
+    bool                 Pinned;
+    uint32_t             PassedOver[JobPriority_Count]; // Entries taken from upper lanes while this one waited.
+    work_deque           Deques[JobPriority_Count];
+    work_trace_ring      Trace;
+
+    // Fibers only. A fiber cannot give itself back or park itself while it still runs on its own
+    // stack, it leaves that to whichever fiber the worker switches to next.
+    work_fiber          *Running;
+    work_fiber          *ToFree;
+    work_fiber          *ToPark;
+    job_counter         *ParkOn;
+} work_queue_worker;
+
+
+// Every fiber runs the worker loop, a job that waits parks the fiber it runs on and the worker goes
+// on with another one. Worker is only valid while the fiber runs, whoever switches to it sets it.
+
+struct work_fiber
+{
+    work_fiber        *NextFree;
+    os_fiber          *Fiber;
+    work_queue_worker *Worker;
+    uint32_t           Priority; // Of the entry it runs, the lane it is resumed in once parked.
+    uint32_t           Node;     // The pool it goes back to.
+    work_trace_job    *Jobs;     // Innermost traced job running on it.
+};
+
+
+typedef struct
+{
+    uint32_t volatile  Lock;
+    work_fiber        *Free;
+} work_fiber_pool;
+
+
+// Entries added by threads that own no deque. A lock is fine here, those threads are rare.
+// Locks in this file are only ever held for a few instructions, spinning is cheaper than a mutex.
+
+typedef struct
+{
+    uint32_t volatile  Lock;
+    uint32_t volatile  Count;
+    work_queue_buffer *Buffer;
+    uint64_t           Head;
+} work_inject_list;
+
+
+// A job held until its dependency reaches zero, hangs off the dependency's counter.
+
+struct job_waiter
+{
+    job_waiter       *Next;
+    work_queue_entry  Entry;
+    uint32_t          Priority;
+    work_fiber       *Fiber; // A parked fiber to resume rather than an entry to queue.
+};
+
+
+// Waiters are recycled through a free list, the list grows a chunk at a time and never shrinks.
+
+typedef struct
+{
+    uint32_t volatile  Lock;
+    job_waiter        *Free;
+} work_waiter_pool;
+
+
+typedef struct platform_work_queue
+{
+    work_queue_worker *Workers;      // [0] belongs to the thread that created the queue.
+    uint32_t           WorkerCount;  // Including [0].
+
+    uint32_t volatile  CompletionGoal;
+    uint32_t volatile  CompletionCount;
+    uint32_t volatile  SleepingCount;
+    os_semaphore      *Semaphore;
+
+    work_inject_list   Injected[JobPriority_Count];
+    uint32_t volatile  Depths[JobPriority_Count]; // Entries queued and not taken yet.
+    work_waiter_pool   Waiters;
+
+    bool               UseFibers;
+    work_inject_list   Ready[JobPriority_Count];  // Parked fibers whose counter reached zero, Data is the fiber.
+    work_fiber_pool   *FiberPools;                // One per node.
+    uint32_t           NodeCount;
+
+    uint32_t volatile  Tracing;
+    uint64_t           TraceStart;
+} platform_work_queue;
+
+
+static ThreadLocal work_queue_worker *CurrentWorker;
+static ThreadLocal uint32_t           CurrentRandom;
+
+
+// Read once per public call and passed down from there. A fiber may resume on another thread, a
+// thread local read before the switch could be reused after it.
+
+static work_queue_worker *
+GetCurrentWorker(platform_work_queue *Queue)
+{
+    work_queue_worker *Result = CurrentWorker && CurrentWorker->Queue == Queue ? CurrentWorker : 0;
+    return Result;
+}
+
+
+static uint32_t
+NextRandom(uint32_t *State)
+{
+    uint32_t Value = *State ? *State : 0x9E3779B9u;
+
+    Value ^= Value << 13;
+    Value ^= Value >> 17;
+    Value ^= Value << 5;
+
+    *State = Value;
+    return Value;
+}
+
+
+static void
+AcquireSpinLock(uint32_t volatile *Lock)
+{
+    while (!AtomicCompareExchange32(Lock, 0, 1))
+    {
+        OSYieldThread();
+    }
+}
+
+
+static void
+ReleaseSpinLock(uint32_t volatile *Lock)
+{
+    AtomicStore32(Lock, 0);
+}
+
+
+static void
+InjectEntry(work_inject_list *List, work_queue_entry Entry)
+{
+    AcquireSpinLock(&List->Lock);
+
+    work_queue_buffer *Buffer = List->Buffer;
+    uint64_t           Count  = List->Count;
+
+    if (Count > Buffer->Mask)
+    {
+        // Nobody reads the list without the lock, the old buffer can go right away.
+
+        work_queue_buffer *Grown = AllocateWorkBuffer((Buffer->Mask + 1) * 2, 0);
+
+        for (uint64_t Idx = 0; Idx < Count; ++Idx)
+        {
+            Grown->Entries[Idx] = Buffer->Entries[(List->Head + Idx) & Buffer->Mask];
+        }
+
+        ReleaseWorkBuffer(Buffer);
+
+        List->Buffer = Grown;
+        List->Head   = 0;
+        Buffer       = Grown;
+    }
+
+    Buffer->Entries[(List->Head + Count) & Buffer->Mask] = Entry;
+    AtomicStore32(&List->Count, (uint32_t)Count + 1);
+
+    ReleaseSpinLock(&List->Lock);
+}
+
+
+static bool
+TakeInjectedEntry(work_inject_list *List, work_queue_entry *Entry)
+{
+    bool Result = false;
+
+    if (AtomicLoad32(&List->Count))
+    {
+        AcquireSpinLock(&List->Lock);
+
+        if (List->Count)
+        {
+            *Entry = List->Buffer->Entries[List->Head & List->Buffer->Mask];
+
+            List->Head += 1;
+            AtomicStore32(&List->Count, List->Count - 1);
+
+            Result = true;
+        }
+
+        ReleaseSpinLock(&List->Lock);
+    }
+
+    return Result;
+}
+
+
+// One pass over every other deque, starting from a random one so thieves spread out. With several
+// nodes a worker makes that pass over its own node's workers first, then over the rest.
+
+static bool
+StealEntry(platform_work_queue *Queue, work_queue_worker *Thief, uint32_t Priority, work_queue_entry *Entry)
+{
+    bool     Result    = false;
+    uint32_t Start     = NextRandom(Thief ? &Thief->Random : &CurrentRandom) % Queue->WorkerCount;
+    uint32_t PassCount = Thief && Queue->NodeCount > 1 ? 2 : 1;
+
+    for (uint32_t Pass = 0; Pass < PassCount && !Result; ++Pass)
+    {
+        for (uint32_t Offset = 0; Offset < Queue->WorkerCount && !Result; ++Offset)
+        {
+            work_queue_worker *Victim = Queue->Workers + (Start + Offset) % Queue->WorkerCount;
+            bool               Near   = PassCount == 1 || (Victim->Node == Thief->Node) == (Pass == 0);
+
+            if (Victim != Thief && Near)
+            {
+                Result = StealWorkDeque(&Victim->Deques[Priority], Entry);
+            }
+        }
+    }
+
+    return Result;
+}
+
+
+// Entries are counted against the goal when they are added, held ones included, this only places
+// them.
+
+static void
+ScheduleEntry(platform_work_queue *Queue, work_queue_worker *Worker, uint32_t Priority, work_queue_entry Entry)
+{
+    AtomicIncrement32(&Queue->Depths[Priority]);
+
+    if (Worker)
+    {
+        PushWorkDeque(&Worker->Deques[Priority], Entry);
+    }
+    else
+    {
+        InjectEntry(&Queue->Injected[Priority], Entry);
+    }
+
+    if (AtomicLoad32(&Queue->SleepingCount))
+    {
+        OSSignalSemaphore(Queue->Semaphore);
+    }
+}
+
+
+static job_waiter *
+AllocateJobWaiter(work_waiter_pool *Pool)
+{
+    AcquireSpinLock(&Pool->Lock);
+
+    if (!Pool->Free)
+    {
+        uint64_t    Size  = WORK_WAITER_CHUNK_COUNT * sizeof(job_waiter);
+        job_waiter *Chunk = (job_waiter *)OSReserve(Size);
+
+        if (Chunk && OSCommit(Chunk, Size))
+        {
+            for (uint32_t Idx = 0; Idx < WORK_WAITER_CHUNK_COUNT; ++Idx)
+            {
+                Chunk[Idx].Next = Idx + 1 < WORK_WAITER_CHUNK_COUNT ? Chunk + Idx + 1 : 0;
+            }
+
+            Pool->Free = Chunk;
+        }
+    }
+
+    job_waiter *Result = Pool->Free;
+
+    if (Result)
+    {
+        Pool->Free = Result->Next;
+    }
+
+    ReleaseSpinLock(&Pool->Lock);
+
+    assert(Result && "OUT OF MEMORY");
+    return Result;
+}
+
+
+static void
+FreeJobWaiters(work_waiter_pool *Pool, job_waiter *First, job_waiter *Last)
+{
+    AcquireSpinLock(&Pool->Lock);
+
+    Last->Next = Pool->Free;
+    Pool->Free = First;
+
+    ReleaseSpinLock(&Pool->Lock);
+}
+
+
+// Only the last decrement takes the lock, the one that reaches zero happens under it together with
+// taking the waiters: a waiter is either added before and released here, or sees zero and runs at
+// once. Nothing touches the counter after the unlock, which is what WaitForCounter waits for.
+
+static void
+ReadyFiber(platform_work_queue *Queue, work_fiber *Fiber)
+{
+    work_queue_entry Entry = {0, Fiber, 0, 0, 0};
+
+    InjectEntry(&Queue->Ready[Fiber->Priority], Entry);
+
+    if (AtomicLoad32(&Queue->SleepingCount))
+    {
+        OSSignalSemaphore(Queue->Semaphore);
+    }
+}
+
+
+static void
+FinishJob(platform_work_queue *Queue, work_queue_worker *Worker, job_counter *Counter)
+{
+    job_waiter *Released = 0;
+
+    for (;;)
+    {
+        uint32_t Value = AtomicLoad32(&Counter->Value);
+
+        assert(Value > 0);
+
+        if (Value > 1)
+        {
+            if (AtomicCompareExchange32(&Counter->Value, Value, Value - 1))
+            {
+                break;
+            }
+        }
+        else
+        {
+            AcquireSpinLock(&Counter->Lock);
+
+            if (AtomicDecrement32(&Counter->Value) == 0)
+            {
+                Released         = Counter->Waiters;
+                Counter->Waiters = 0;
+            }
+
+            ReleaseSpinLock(&Counter->Lock);
+            break;
+        }
+    }
+
+    if (Released)
+    {
+        job_waiter *Last = Released;
+
+        for (job_waiter *Waiter = Released; Waiter; Waiter = Waiter->Next)
+        {
+            if (Waiter->Fiber)
+            {
+                ReadyFiber(Queue, Waiter->Fiber);
+            }
+            else
+            {
+                // Time spent held is not time spent queued.
+
+                Waiter->Entry.Queued = Waiter->Entry.Queued ? OSReadTimer() : 0;
+                ScheduleEntry(Queue, Worker, Waiter->Priority, Waiter->Entry);
+            }
+
+            Last = Waiter;
+        }
+
+        FreeJobWaiters(&Queue->Waiters, Released, Last);
+    }
+}
+
+
+// Lanes are tried from the top. A lane that was passed over WORK_LANE_STARVATION_LIMIT times while it
+// had entries waiting is tried first once: a steady stream of frame work slows the lanes below it
+// down but never stops them.
+//
+// Within a lane ready fibers go first, they hold entries that already started. Only a worker running
+// on a fiber may resume one, Entry then has no callback and Data is the fiber. A lane's depth goes
+// up before its entry is pushed, an empty lane is skipped without looking at any deque.
+
+static bool
+TakeNextEntry(platform_work_queue *Queue, work_queue_worker *Worker, bool TakeFibers, work_queue_entry *Entry, uint32_t *Priority, bool *Stolen)
+{
+    bool     Result  = false;
+    uint32_t Starved = JobPriority_Count;
+
+    for (uint32_t Lane = 0; Worker && Lane < JobPriority_Count && Starved == JobPriority_Count; ++Lane)
+    {
+        Starved = Worker->PassedOver[Lane] >= WORK_LANE_STARVATION_LIMIT ? Lane : Starved;
+    }
+
+    for (uint32_t Step = 0; Step <= JobPriority_Count && !Result; ++Step)
+    {
+        uint32_t Lane = Step == 0 ? Starved : Step - 1;
+
+        if (Lane == JobPriority_Count)
+        {
+            continue;
+        }
+
+        if (TakeFibers && TakeInjectedEntry(&Queue->Ready[Lane], Entry))
+        {
+            Result = true;
+        }
+        else if (AtomicLoad32(&Queue->Depths[Lane]))
+        {
+            bool Own = (Worker && PopWorkDeque(&Worker->Deques[Lane], Entry)) || TakeInjectedEntry(&Queue->Injected[Lane], Entry);
+
+            *Stolen = !Own && StealEntry(Queue, Worker, Lane, Entry);
+
+            if (Own || *Stolen)
+            {
+                AtomicDecrement32(&Queue->Depths[Lane]);
+                Result = true;
+            }
+        }
+
+        *Priority = Lane;
+    }
+
+    // A starved lane that came up empty lost its entries to other workers, it starts over as well.
+
+    if (Worker && Starved < JobPriority_Count)
+    {
+        Worker->PassedOver[Starved] = 0;
+    }
+
+    if (Result && Worker)
+    {
+        Worker->PassedOver[*Priority] = 0;
+
+        for (uint32_t Lane = *Priority + 1; Lane < JobPriority_Count; ++Lane)
+        {
+            Worker->PassedOver[Lane] += AtomicLoad32(&Queue->Depths[Lane]) ? 1 : 0;
+        }
+    }
+
+    return Result;
+}
+
+
+static void
+RunEntry(platform_work_queue *Queue, work_queue_worker *Worker, work_queue_entry Entry, uint32_t Priority, bool Stolen)
+{
+    // The entry may wait and come back on another worker's thread, whose deque is the one to push
+    // to from here on.
+
+    work_fiber     *Fiber    = Worker ? Worker->Running : 0;
+    uint32_t        Previous = Fiber ? Fiber->Priority : 0;
+    bool            Tracing  = Worker && AtomicLoad32(&Queue->Tracing);
+    work_trace_job  Job      = {0};
+
+    if (Fiber)
+    {
+        Fiber->Priority = Priority;
+    }
+
+    if (Tracing)
+    {
+        Job.Event.Type   = WorkTrace_Job;
+        Job.Event.Lane   = (uint8_t)Priority;
+        Job.Event.Label  = Entry.Label;
+        Job.Event.Queued = Entry.Queued;
+        Job.Event.Stolen = Stolen;
+        Job.Event.Start  = OSReadTimer();
+
+        if (Fiber)
+        {
+            Job.Outer   = Fiber->Jobs;
+            Fiber->Jobs = &Job;
+        }
+    }
+
+    Entry.Callback(Queue, Entry.Data);
+
+    if (Fiber)
+    {
+        Fiber->Priority = Previous;
+        Worker          = Fiber->Worker;
+    }
+
+    if (Tracing)
+    {
+        Job.Event.End = OSReadTimer();
+        RecordTraceEvent(&Worker->Trace, Job.Event);
+
+        if (Fiber)
+        {
+            Fiber->Jobs = Job.Outer;
+        }
+    }
+
+    if (Entry.Counter)
+    {
+        FinishJob(Queue, Worker, Entry.Counter);
+    }
+
+    AtomicIncrement32(&Queue->CompletionCount);
+}
+
+
+static bool
+RunNextEntry(platform_work_queue *Queue, work_queue_worker *Worker)
+{
+    work_queue_entry Entry    = {0};
+    uint32_t         Priority = 0;
+    bool             Stolen   = false;
+    bool             Result   = TakeNextEntry(Queue, Worker, false, &Entry, &Priority, &Stolen);
+
+    if (Result)
+    {
+        RunEntry(Queue, Worker, Entry, Priority, Stolen);
+    }
+
+    return Result;
+}
+
+
+static bool
+HasPendingEntries(platform_work_queue *Queue)
+{
+    bool Result = false;
+
+    for (uint32_t Lane = 0; Lane < JobPriority_Count && !Result; ++Lane)
+    {
+        Result = AtomicLoad32(&Queue->Injected[Lane].Count) != 0 || AtomicLoad32(&Queue->Ready[Lane].Count) != 0;
+
+        for (uint32_t Idx = 0; Idx < Queue->WorkerCount && !Result; ++Idx)
+        {
+            Result = !IsWorkDequeEmpty(&Queue->Workers[Idx].Deques[Lane]);
+        }
+    }
+
+    return Result;
+}
+
+
+// Sleeping is announced before the last look, an AddEntry that lands after that look sees the
+// announcement and signals.
+
+static void
+WaitForEntries(platform_work_queue *Queue, work_queue_worker *Worker)
+{
+    AtomicIncrement32(&Queue->SleepingCount);
+
+    if (!HasPendingEntries(Queue))
+    {
+        work_trace_event Sleep = {0};
+
+        Sleep.Type  = WorkTrace_Sleep;
+        Sleep.Label = "sleep";
+        Sleep.Start = AtomicLoad32(&Queue->Tracing) ? OSReadTimer() : 0;
+
+        OSWaitSemaphore(Queue->Semaphore);
+
+        if (Sleep.Start)
+        {
+            Sleep.End = OSReadTimer();
+            RecordTraceEvent(&Worker->Trace, Sleep);
+        }
+    }
+
+    AtomicDecrement32(&Queue->SleepingCount);
+}
+
+
+// The worker's own node first, a fiber from another node still beats waiting on the worker's stack.
+
+static work_fiber *
+TakeWorkFiber(platform_work_queue *Queue, work_queue_worker *Worker)
+{
+    work_fiber *Result = 0;
+
+    for (uint32_t Offset = 0; Offset < Queue->NodeCount && !Result; ++Offset)
+    {
+        work_fiber_pool *Pool = Queue->FiberPools + (Worker->Node + Offset) % Queue->NodeCount;
+
+        AcquireSpinLock(&Pool->Lock);
+
+        Result = Pool->Free;
+
+        if (Result)
+        {
+            Pool->Free = Result->NextFree;
+        }
+
+        ReleaseSpinLock(&Pool->Lock);
+    }
+
+    return Result;
+}
+
+
+static void
+FreeWorkFiber(platform_work_queue *Queue, work_fiber *Fiber)
+{
+    work_fiber_pool *Pool = Queue->FiberPools + Fiber->Node;
+
+    AcquireSpinLock(&Pool->Lock);
+
+    Fiber->NextFree = Pool->Free;
+    Pool->Free      = Fiber;
+
+    ReleaseSpinLock(&Pool->Lock);
+}
+
+
+// Runs on the fiber that was switched to, for the one that was left. A fiber parks under its
+// counter's lock like a held job does: either the counter is still counting and will resume it, or
+// it already reached zero and the fiber is ready now.
+
+static void
+FinishFiberSwitch(platform_work_queue *Queue, work_queue_worker *Worker)
+{
+    if (Worker->ToFree)
+    {
+        FreeWorkFiber(Queue, Worker->ToFree);
+        Worker->ToFree = 0;
+    }
+
+    if (Worker->ToPark)
+    {
+        work_fiber  *Fiber   = Worker->ToPark;
+        job_counter *Counter = Worker->ParkOn;
+        job_waiter  *Waiter  = AllocateJobWaiter(&Queue->Waiters);
+        bool         Parked  = false;
+
+        Worker->ToPark = 0;
+        Worker->ParkOn = 0;
+
+        AcquireSpinLock(&Counter->Lock);
+
+        if (AtomicLoad32(&Counter->Value))
+        {
+            Waiter->Fiber    = Fiber;
+            Waiter->Next     = Counter->Waiters;
+            Counter->Waiters = Waiter;
+            Parked           = true;
+        }
+
+        ReleaseSpinLock(&Counter->Lock);
+
+        if (!Parked)
+        {
+            FreeJobWaiters(&Queue->Waiters, Waiter, Waiter);
+            ReadyFiber(Queue, Fiber);
+        }
+    }
+}
+
+
+// Returns once something switches back to From, possibly on another worker.
+
+static void
+SwitchWorkFiber(platform_work_queue *Queue, work_queue_worker *Worker, work_fiber *From, work_fiber *To)
+{
+    To->Worker      = Worker;
+    Worker->Running = To;
+
+    OSSwitchToFiber(From->Fiber, To->Fiber);
+
+    FinishFiberSwitch(Queue, From->Worker);
+}
+
+
+// A fiber that resumes a parked one gives itself back to the pool.
+
+static void
+WorkFiberProc(void *Parameter)
+{
+    work_fiber          *Fiber = (work_fiber *)Parameter;
+    platform_work_queue *Queue = Fiber->Worker->Queue;
+
+    FinishFiberSwitch(Queue, Fiber->Worker);
+
+    for (;;)
+    {
+        work_queue_worker *Worker   = Fiber->Worker;
+        work_queue_entry   Entry    = {0};
+        uint32_t           Priority = 0;
+        bool               Stolen   = false;
+
+        if (!TakeNextEntry(Queue, Worker, true, &Entry, &Priority, &Stolen))
+        {
+            WaitForEntries(Queue, Worker);
+        }
+        else if (Entry.Callback)
+        {
+            RunEntry(Queue, Worker, Entry, Priority, Stolen);
+        }
+        else
+        {
+            Worker->ToFree = Fiber;
+            SwitchWorkFiber(Queue, Worker, Fiber, (work_fiber *)Entry.Data);
+        }
+    }
+}
+
+
+static void
+WorkQueueThreadProc(void *Parameter)
+{
+    work_queue_worker   *Worker = (work_queue_worker *)Parameter;
+    platform_work_queue *Queue  = Worker->Queue;
+
+    // Pinned before it touches anything, the deques are first written here and end up on the
+    // worker's node. Nobody reads a deque's buffer before its owner pushed to it.
+
+    if (Worker->Pinned)
+    {
+        OSPinThread(Worker->Processor);
+    }
+
+    for (uint32_t Lane = 0; Lane < JobPriority_Count; ++Lane)
+    {
+        Worker->Deques[Lane].Buffer = AllocateWorkBuffer(WORK_DEQUE_INITIAL_CAPACITY, 0);
+    }
+
+    work_fiber *Fiber = Queue->UseFibers ? TakeWorkFiber(Queue, Worker) : 0;
+
+    CurrentWorker = Worker;
+
+    if (Fiber)
+    {
+        Fiber->Worker   = Worker;
+        Worker->Running = Fiber;
+
+        OSEnterFiber(Fiber->Fiber);
+    }
+
+    for (;;)
+    {
+        if (!RunNextEntry(Queue, Worker))
+        {
+            WaitForEntries(Queue, Worker);
+        }
+    }
+}
+
+
+// Workers take processors in this order: the first hardware thread of every core before any second
+// one, each time node by node.
+
+static bool
+IsProcessorBefore(os_processor A, os_processor B)
+{
+    bool Result = A.Thread != B.Thread ? A.Thread < B.Thread :
+                  A.Node   != B.Node   ? A.Node   < B.Node   :
+                                         A.Core   < B.Core;
+    return Result;
+}
+
+// ==============================================
+// <Work Queue> : PUBLIC
+// ==============================================
+
+
+platform_work_queue *
+CreateWorkQueue(work_queue_params Params, memory_arena *Arena)
+{
+    os_topology         *Topology    = Params.Topology && Params.Topology->ProcessorCount ? Params.Topology : 0;
+    uint32_t             WorkerCount = Params.WorkerCount;
+    uint32_t             NodeCount   = Topology ? Maximum(Topology->NodeCount, 1) : 1;
+    platform_work_queue *Queue       = PushStruct(Arena, platform_work_queue);
+    work_queue_worker   *Workers     = PushArray(Arena, work_queue_worker, WorkerCount + 1);
+    work_fiber_pool     *FiberPools  = PushArray(Arena, work_fiber_pool, NodeCount);
+    os_processor        *Order       = Topology ? PushArray(Arena, os_processor, Topology->ProcessorCount) : 0;
+
+    if (Queue && Workers && FiberPools && (Order || !Topology))
+    {
+        memset(Queue, 0, sizeof(platform_work_queue));
+        memset(Workers, 0, sizeof(work_queue_worker) * (WorkerCount + 1));
+        memset(FiberPools, 0, sizeof(work_fiber_pool) * NodeCount);
+
+        Queue->Workers         = Workers;
+        Queue->WorkerCount     = WorkerCount + 1;
+        Queue->Semaphore       = OSCreateSemaphore(Arena);
+        Queue->FiberPools      = FiberPools;
+        Queue->NodeCount       = NodeCount;
+
+        for (uint32_t Lane = 0; Lane < JobPriority_Count; ++Lane)
+        {
+            Queue->Injected[Lane].Buffer = AllocateWorkBuffer(WORK_INJECT_INITIAL_CAPACITY, 0);
+        }
+
+        // Processors in the order workers take them, see work_queue.h. Few enough for an insertion
+        // sort.
+
+        for (uint32_t Idx = 0; Topology && Idx < Topology->ProcessorCount; ++Idx)
+        {
+            os_processor Processor = Topology->Processors[Idx];
+            uint32_t     Slot      = Idx;
+
+            for (; Slot > 0 && IsProcessorBefore(Processor, Order[Slot - 1]); --Slot)
+            {
+                Order[Slot] = Order[Slot - 1];
+            }
+
+            Order[Slot] = Processor;
+        }
+
+        for (uint32_t Idx = 0; Idx < Queue->WorkerCount; ++Idx)
+        {
+            work_queue_worker *Worker = Workers + Idx;
+
+            Worker->Queue  = Queue;
+            Worker->Index  = Idx;
+            Worker->Random = 0x9E3779B9u * (Idx + 1);
+
+            if (Topology && Idx > 0)
+            {
+                os_processor Processor = Order[(Idx - 1) % Topology->ProcessorCount];
+
+                Worker->Node      = Processor.Node < NodeCount ? Processor.Node : 0;
+                Worker->Processor = Processor.Id;
+                Worker->Pinned    = true;
+            }
+
+            // Workers other than [0] allocate their buffers themselves once they run.
+
+            for (uint32_t Lane = 0; Lane < JobPriority_Count; ++Lane)
+            {
+                Worker->Deques[Lane].Top    = 1;
+                Worker->Deques[Lane].Bottom = 1;
+                Worker->Deques[Lane].Buffer = Idx == 0 ? AllocateWorkBuffer(WORK_DEQUE_INITIAL_CAPACITY, 0) : 0;
+            }
+        }
+
+        // All fibers are made up front, the arena is not ours to touch once the workers run. When
+        // the pool runs dry a waiting job falls back to running entries on its own stack. A fiber
+        // belongs to the node of the worker it was made for, whoever first runs it touches its stack.
+
+        if (Params.UseFibers)
+        {
+            for (uint32_t Lane = 0; Lane < JobPriority_Count; ++Lane)
+            {
+                Queue->Ready[Lane].Buffer = AllocateWorkBuffer(WORK_INJECT_INITIAL_CAPACITY, 0);
+            }
+
+            for (uint32_t Idx = 0; Idx < WorkerCount * WORK_FIBERS_PER_WORKER; ++Idx)
+            {
+                work_fiber *Fiber = PushStruct(Arena, work_fiber);
+
+                if (Fiber)
+                {
+                    Fiber->Worker   = 0;
+                    Fiber->Priority = JobPriority_Normal;
+                    Fiber->Node     = Workers[1 + Idx / WORK_FIBERS_PER_WORKER].Node;
+                    Fiber->Jobs     = 0;
+                    Fiber->Fiber    = OSCreateFiber(WorkFiberProc, Fiber, WORK_FIBER_STACK_SIZE, Arena);
+
+                    if (Fiber->Fiber)
+                    {
+                        Fiber->NextFree              = FiberPools[Fiber->Node].Free;
+                        FiberPools[Fiber->Node].Free = Fiber;
+                        Queue->UseFibers             = true;
+                    }
+                }
+            }
+        }
+
+        CurrentWorker = Workers;
+
+        for (uint32_t Idx = 1; Idx < Queue->WorkerCount; ++Idx)
+        {
+            OSStartThread(WorkQueueThreadProc, Workers + Idx, Arena);
+        }
+    }
+    else
+    {
+        Queue = 0;
+    }
+
+    return Queue;
+}
+
+
+void
+AddWorkQueueEntry(platform_work_queue *Queue, platform_work_queue_callback *Callback, void *Data)
+{
+    AddWorkQueueJob(Queue, JobPriority_Normal, "entry", Callback, Data, 0);
+}
+
+
+void
+AddWorkQueueJob(platform_work_queue *Queue, JobPriority_Type Priority, const char *Label, platform_work_queue_callback *Callback, void *Data, job_counter *Counter)
+{
+    uint64_t         Queued = AtomicLoad32(&Queue->Tracing) ? OSReadTimer() : 0;
+    work_queue_entry Entry  = {Callback, Data, Counter, Label, Queued};
+
+    // Counted before it can run, neither CompleteWork nor WaitForCounter sees more done than added.
+
+    AtomicIncrement32(&Queue->CompletionGoal);
+
+    if (Counter)
+    {
+        AtomicIncrement32(&Counter->Value);
+    }
+
+    ScheduleEntry(Queue, GetCurrentWorker(Queue), Priority, Entry);
+}
+
+
+void
+AddWorkQueueJobAfter(platform_work_queue *Queue, JobPriority_Type Priority, job_counter *Dependency, const char *Label, platform_work_queue_callback *Callback, void *Data, job_counter *Counter)
+{
+    uint64_t         Queued = AtomicLoad32(&Queue->Tracing) ? OSReadTimer() : 0;
+    work_queue_entry Entry  = {Callback, Data, Counter, Label, Queued};
+
+    // The job counts as added right away, whoever waits on Counter waits for the held job too.
+
+    AtomicIncrement32(&Queue->CompletionGoal);
+
+    if (Counter)
+    {
+        AtomicIncrement32(&Counter->Value);
+    }
+
+    bool Held = false;
+
+    if (Dependency && AtomicLoad32(&Dependency->Value))
+    {
+        job_waiter *Waiter = AllocateJobWaiter(&Queue->Waiters);
+
+        AcquireSpinLock(&Dependency->Lock);
+
+        if (AtomicLoad32(&Dependency->Value))
+        {
+            Waiter->Entry       = Entry;
+            Waiter->Priority    = Priority;
+            Waiter->Fiber       = 0;
+            Waiter->Next        = Dependency->Waiters;
+            Dependency->Waiters = Waiter;
+            Held                = true;
+        }
+
+        ReleaseSpinLock(&Dependency->Lock);
+
+        if (!Held)
+        {
+            FreeJobWaiters(&Queue->Waiters, Waiter, Waiter);
+        }
+    }
+
+    if (!Held)
+    {
+        ScheduleEntry(Queue, GetCurrentWorker(Queue), Priority, Entry);
+    }
+}
+
+
+void
+WaitForWorkQueueCounter(platform_work_queue *Queue, job_counter *Counter)
+{
+    work_queue_worker *Worker = GetCurrentWorker(Queue);
+
+    // Zero is reached under the lock, the lock being free as well means the last job is done with
+    // the counter.
+    //
+    // A job on a fiber parks it and the worker goes on with a fresh fiber, which picks the next
+    // entry by lane like any other. With the pool empty it resumes a ready fiber directly. Everything
+    // else, and fibers when there is neither, runs entries right here until the counter is done.
+
+    work_trace_event Wait = {0};
+
+    Wait.Type  = WorkTrace_Wait;
+    Wait.Label = "wait";
+    Wait.Start = Worker && !Worker->Running && AtomicLoad32(&Queue->Tracing) ? OSReadTimer() : 0;
+
+    while (AtomicLoad32(&Counter->Value) || AtomicLoad32(&Counter->Lock))
+    {
+        work_fiber       *Self  = Worker ? Worker->Running : 0;
+        work_fiber       *Next  = Self ? TakeWorkFiber(Queue, Worker) : 0;
+        work_queue_entry  Ready = {0};
+
+        for (uint32_t Lane = 0; Self && !Next && Lane < JobPriority_Count; ++Lane)
+        {
+            Next = TakeInjectedEntry(&Queue->Ready[Lane], &Ready) ? (work_fiber *)Ready.Data : 0;
+        }
+
+        if (Next)
+        {
+            // Every traced job on this fiber stops here and starts again wherever it is resumed.
+
+            for (work_trace_job *Job = Self->Jobs; Job; Job = Job->Outer)
+            {
+                Job->Event.End    = OSReadTimer();
+                Job->Event.Parked = true;
+                RecordTraceEvent(&Worker->Trace, Job->Event);
+
+                Job->Event.Queued = 0;
+                Job->Event.Stolen = false;
+                Job->Event.Parked = false;
+            }
+
+            Worker->ToPark = Self;
+            Worker->ParkOn = Counter;
+
+            SwitchWorkFiber(Queue, Worker, Self, Next);
+
+            for (work_trace_job *Job = Self->Jobs; Job; Job = Job->Outer)
+            {
+                Job->Event.Start = OSReadTimer();
+            }
+        }
+        else if (!RunNextEntry(Queue, Worker))
+        {
+            OSYieldThread();
+        }
+
+        Worker = Self ? Self->Worker : Worker;
+    }
+
+    if (Wait.Start)
+    {
+        Wait.End = OSReadTimer();
+        RecordTraceEvent(&Worker->Trace, Wait);
+    }
+}
+
+
+void
+CompleteWorkQueue(platform_work_queue *Queue)
+{
+    work_queue_worker *Worker = GetCurrentWorker(Queue);
+    work_trace_event   Wait   = {0};
+
+    Wait.Type  = WorkTrace_Wait;
+    Wait.Label = "complete";
+    Wait.Start = Worker && AtomicLoad32(&Queue->Tracing) ? OSReadTimer() : 0;
+
+    // Done is read before added, both only grow: once they match, everything added before the
+    // first read has run.
+
+    for (;;)
+    {
+        uint32_t Done  = AtomicLoad32(&Queue->CompletionCount);
+        uint32_t Added = AtomicLoad32(&Queue->CompletionGoal);
+
+        if (Done == Added)
+        {
+            break;
+        }
+
+        if (!RunNextEntry(Queue, Worker))
+        {
+            OSYieldThread();
+        }
+    }
+
+    if (Wait.Start)
+    {
+        Wait.End = OSReadTimer();
+        RecordTraceEvent(&Worker->Trace, Wait);
+    }
+}
+
+
+uint32_t
+GetWorkQueueWorkerCount(platform_work_queue *Queue)
+{
+    uint32_t Result = Queue ? Queue->WorkerCount - 1 : 0;
+    return Result;
+}
+
+
+uint32_t
+GetWorkQueueDepth(platform_work_queue *Queue, JobPriority_Type Priority)
+{
+    uint32_t Result = Queue ? AtomicLoad32(&Queue->Depths[Priority]) : 0;
+    return Result;
+}
+
+// Rings are allocated the first time a trace starts and kept. Every thread of the queue may be
+// recording into its ring while the counts are reset: only start a trace while the queue is idle
+// or accept that the first events may be stale.
+
+void
+StartWorkQueueTrace(platform_work_queue *Queue)
+{
+    size_t Size = WORK_TRACE_EVENT_COUNT * sizeof(work_trace_event);
+
+    for (uint32_t Idx = 0; Queue && Idx < Queue->WorkerCount; ++Idx)
+    {
+        work_trace_ring *Ring = &Queue->Workers[Idx].Trace;
+
+        if (!Ring->Events)
+        {
+            work_trace_event *Events = (work_trace_event *)OSReserve(Size);
+            Ring->Events             = Events && OSCommit(Events, Size) ? Events : 0;
+        }
+
+        AtomicStore64(&Ring->Count, 0);
+    }
+
+    if (Queue)
+    {
+        Queue->TraceStart = OSReadTimer();
+        AtomicStore32(&Queue->Tracing, 1);
+    }
+}
+
+
+void
+StopWorkQueueTrace(platform_work_queue *Queue)
+{
+    if (Queue)
+    {
+        AtomicStore32(&Queue->Tracing, 0);
+    }
+}
+
+
+// Jobs that started while tracing still record when they end, write once they are done. Times are
+// microseconds from StartTrace, events that began before it are clipped to it.
+
+bool
+WriteWorkQueueTrace(platform_work_queue *Queue, byte_string Path, memory_arena *Arena)
+{
+    bool          Result      = false;
+    memory_region Region      = EnterMemoryRegion(Arena);
+    uint32_t      ThreadCount = Queue ? Queue->WorkerCount : 0;
+    double        Frequency   = (double)OSGetTimerFrequency();
+    size_t        Capacity    = 64;
+
+    for (uint32_t Idx = 0; Idx < ThreadCount; ++Idx)
+    {
+        uint64_t Count = AtomicLoad64(&Queue->Workers[Idx].Trace.Count);
+        Capacity += 128 + Minimum(Count, (uint64_t)WORK_TRACE_EVENT_COUNT) * 256;
+    }
+
+    buffer Buffer = {PushArray(Arena, uint8_t, Capacity), Capacity, 0};
+
+    if (Queue && Buffer.Data)
+    {
+        AppendTrace(&Buffer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        for (uint32_t Idx = 0; Idx < ThreadCount; ++Idx)
+        {
+            work_trace_ring *Ring  = &Queue->Workers[Idx].Trace;
+            uint64_t         Count = AtomicLoad64(&Ring->Count);
+            uint64_t         First = Count > WORK_TRACE_EVENT_COUNT ? Count - WORK_TRACE_EVENT_COUNT : 0;
+
+            if (Idx == 0)
+            {
+                AppendTrace(&Buffer, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"main\"}}");
+            }
+            else
+            {
+                AppendTrace(&Buffer, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"worker %u\"}}", Idx, Idx);
+            }
+
+            for (uint64_t EventIdx = First; Ring->Events && EventIdx < Count; ++EventIdx)
+            {
+                work_trace_event Event = Ring->Events[EventIdx & (WORK_TRACE_EVENT_COUNT - 1)];
+                uint64_t         Start = Maximum(Event.Start, Queue->TraceStart);
+                uint64_t         End   = Maximum(Event.End, Start);
+                const char      *Label = Event.Label ? Event.Label : "job";
+
+                double StartUs  = (double)(Start - Queue->TraceStart) * 1e6 / Frequency;
+                double LengthUs = (double)(End - Start) * 1e6 / Frequency;
+
+                AppendTrace(&Buffer, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"%.64s\"",
+                            Idx, StartUs, LengthUs, Label);
+
+                if (Event.Type == WorkTrace_Job)
+                {
+                    double QueuedUs = Event.Queued && Event.Queued < Event.Start ? (double)(Event.Start - Event.Queued) * 1e6 / Frequency : 0.0;
+
+                    AppendTrace(&Buffer, ",\"cat\":\"job\",\"args\":{\"lane\":\"%s\",\"queued_us\":%.3f,\"stolen\":%s,\"parked\":%s}}",
+                                TraceLaneNames[Event.Lane < JobPriority_Count ? Event.Lane : JobPriority_Normal], QueuedUs,
+                                Event.Stolen ? "true" : "false", Event.Parked ? "true" : "false");
+                }
+                else
+                {
+                    AppendTrace(&Buffer, ",\"cat\":\"%s\"}", Event.Type == WorkTrace_Sleep ? "sleep" : "wait");
+                }
+            }
+        }
+
+        AppendTrace(&Buffer, "\n]}\n");
+
+        Buffer.Size = Buffer.At;
+        Result      = WriteBufferToFile(Path, &Buffer);
+    }
+
+    LeaveMemoryRegion(Region);
+
+    return Result;
+}
\ No newline at end of file
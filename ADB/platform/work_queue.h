@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "utilities.h"
+#include "platform.h"
+
+// ==============================================
+// <Work Queue>
+// ==============================================
+
+// A work-stealing scheduler behind the platform_add_entry/platform_complete_work pair. Every worker
+// thread owns a Chase-Lev deque: it pushes and pops its own end without locking, idle workers steal
+// the oldest entry from the other end of a victim picked at random. The thread that creates the
+// queue owns a deque as well, it only runs entries from inside CompleteWork. Any other thread adds
+// to a shared list that workers drain before stealing.
+//
+// Nothing is bounded: deques grow as needed (the buffers they outgrow are kept until the process
+// exits, a stealer may still be reading one). Workers with nothing to run or steal sleep on a
+// semaphore that every AddEntry signals while someone sleeps.
+//
+// CompleteWork waits for everything added to the queue by anyone, it must not be called from
+// inside an entry. Counters (job_counter in platform.h) only wait for their own jobs and may be
+// waited on from inside one: the waiting thread runs whatever else is queued meanwhile. A job held
+// on a dependency is kept on the dependency's counter and queued by whichever job takes it to zero.
+//
+// With UseFibers every worker runs its entries on fibers from a pool. A job that waits on a counter
+// parks its fiber on the counter instead of running other entries on top of itself: the worker takes
+// another fiber and carries on, the parked one is resumed by whichever worker is free once the
+// counter is done. Deep chains of waiting jobs then cost fibers, not workers. The thread that owns
+// the queue and threads outside it still wait the old way, as do fibers when the pool is empty.
+// Jobs must not hold a thread local across a wait, they may come back on another thread.
+//
+// Every worker keeps one deque per lane (JobPriority_Type in platform.h), so do the shared lists.
+// Lanes are strict, a worker looks at a lane only once every lane above it came up empty. A worker
+// that passed over waiting lower lanes WORK_LANE_STARVATION_LIMIT times in a row looks from the
+// bottom once. Entries added through AddEntry are Normal.
+//
+// Given a topology, each worker is pinned to a processor of its own: the first hardware thread of
+// every core before any second one, a node's cores before the next node's. More workers than
+// processors start over at the top. A worker allocates its deques once pinned and its fibers come
+// from a pool for its node, so both live in its node's memory. Thieves try the workers on their own
+// node before the others. The thread that creates the queue is never pinned.
+//
+// A trace records what every thread of the queue does between StartTrace and StopTrace, each thread
+// into a ring of its own that keeps the last WORK_TRACE_EVENT_COUNT events. Jobs are recorded per
+// stretch they run on one thread: a job that parks ends a stretch there and starts another wherever
+// it is resumed. Each stretch knows its label and lane, the first one of a job also how long the job
+// sat in the queue and whether it was stolen. Workers record the time they sleep, threads that wait
+// on a counter without parking record the wait. Jobs run by threads outside the queue are not seen.
+// WriteTrace writes the rings out as Chrome trace JSON (chrome://tracing, ui.perfetto.dev), after
+// StopTrace and before the next StartTrace.
+
+typedef struct
+{
+    uint32_t     WorkerCount;
+    bool         UseFibers;
+    os_topology *Topology;    // Optional, only read while the queue is created.
+} work_queue_params;
+
+
+platform_work_queue * CreateWorkQueue         (work_queue_params Params, memory_arena *Arena);
+
+void                  AddWorkQueueEntry       (platform_work_queue *Queue, platform_work_queue_callback *Callback, void *Data);
+void                  CompleteWorkQueue       (platform_work_queue *Queue);
+
+void                  AddWorkQueueJob         (platform_work_queue *Queue, JobPriority_Type Priority, const char *Label, platform_work_queue_callback *Callback, void *Data, job_counter *Counter);
+void                  AddWorkQueueJobAfter    (platform_work_queue *Queue, JobPriority_Type Priority, job_counter *Dependency, const char *Label, platform_work_queue_callback *Callback, void *Data, job_counter *Counter);
+void                  WaitForWorkQueueCounter (platform_work_queue *Queue, job_counter *Counter);
+
+// Worker threads, the thread that created the queue is not counted.
+uint32_t              GetWorkQueueWorkerCount (platform_work_queue *Queue);
+
+// Entries of the lane queued and not picked up yet. Held jobs and parked fibers are not counted.
+uint32_t              GetWorkQueueDepth       (platform_work_queue *Queue, JobPriority_Type Priority);
+
+void                  StartWorkQueueTrace     (platform_work_queue *Queue);
+void                  StopWorkQueueTrace      (platform_work_queue *Queue);
+bool                  WriteWorkQueueTrace     (platform_work_queue *Queue, byte_string Path, memory_arena *Arena);
\ No newline at end of file
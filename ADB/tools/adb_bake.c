@@ -0,0 +1,873 @@
+// adb-bake: offline asset baker.
+//
+//   adb-bake <source directory> <cache directory> [--jobs N] [--force] [--trace <file>] [--profile <file> [--counters]]
+//
+// Scans the source directory for .obj files and follows mtllib -> map_* references to build the
+// dependency graph (OBJ -> MTL -> textures). Every OBJ whose inputs changed since the last run is
+// imported the way the engine imports it (parsers/parser_obj.h), which stores its packed, mipped and
+// encoded textures in the texture cache (textures/texture_cache.h), then a per-asset timing report is
+// printed. The engine then finds every texture in the cache and only reads the sources to hash them.
+// Textures go to <cache directory>/textures, "cache" fills TEXTURE_CACHE_DIRECTORY. Meshes are still
+// loaded from their source.
+//
+// Node keys are content hashes kept in <cache directory>/bake.manifest, next to the textures, so
+// clearing the cache also clears the manifest. Timestamps are useless on fresh CI checkouts, hashes
+// are not.
+//
+// --trace writes what every thread did during the run as Chrome trace JSON (ui.perfetto.dev).
+// --profile times the instrumented zones (platform/profiler.h) over the whole run, as one frame:
+// prints the summary and writes it as CSV. --counters adds hardware counters where the OS allows.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "platform/work_queue.h"
+#include "platform/profiler.h"
+#include "engine/rendering/assets.h"
+#include "engine/rendering/textures/texture_cache.h"
+#include "engine/rendering/textures/texture_sources.h"
+#include "engine/rendering/textures/texture_mips.h"
+#include "parsers/parser_obj.h"
+
+#define MAX_BAKE_NODE_COUNT   65536
+
+#define BAKE_MANIFEST_MAGIC   0x4B424441 // 'ADBK'
+#define BAKE_MANIFEST_VERSION 2
+
+// ==============================================
+// <Graph>
+// ==============================================
+
+
+typedef enum
+{
+    BakeNode_None    = 0,
+    BakeNode_Obj     = 1,
+    BakeNode_Mtl     = 2,
+    BakeNode_Texture = 3,
+} BakeNode_Type;
+
+
+typedef enum
+{
+    BakeStatus_Pending  = 0,
+    BakeStatus_Scanned  = 1,
+    BakeStatus_UpToDate = 2,
+    BakeStatus_Baked    = 3,
+    BakeStatus_Failed   = 4,
+} BakeStatus_Type;
+
+
+typedef struct bake_dependency bake_dependency;
+struct bake_dependency
+{
+    bake_dependency *Next;
+    byte_string      Path;
+    uint32_t         Node;
+};
+
+
+typedef struct
+{
+    BakeNode_Type    Type;
+    BakeStatus_Type  Status;
+    const char      *Error;
+
+    byte_string      Path;
+    uint64_t         UUID;
+
+    // Key is the content hash combined with every input that ends up in the output. A node is
+    // up to date when the key matches the one recorded by the previous run.
+    uint64_t         ContentHash;
+    uint64_t         Key;
+    uint64_t         PreviousKey;
+    bool             HasPreviousKey;
+
+    bake_dependency *FirstDependency;
+    uint32_t         DependencyCount;
+
+    uint64_t         ScanTicks;
+    uint64_t         BakeTicks;
+    uint64_t         OutputSize;
+} bake_node;
+
+
+typedef struct
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t EntryCount;
+    uint32_t Reserved;
+} bake_manifest_header;
+
+
+// Paths follow the entries back to back, PathOffset counts from the first byte after the last entry.
+
+typedef struct
+{
+    uint64_t UUID;
+    uint64_t Key;
+    uint32_t PathOffset;
+    uint32_t PathSize;
+} bake_manifest_entry;
+
+
+typedef struct bake_context bake_context;
+
+
+// One per drain job. Arena holds results that outlive the node (dependency lists), Scratch is
+// rewound after every node.
+
+typedef struct
+{
+    bake_context *Context;
+    memory_arena *Arena;
+    memory_arena *Scratch;
+} bake_job;
+
+
+struct bake_context
+{
+    engine_memory     *EngineMemory;
+    byte_string        SourceDirectory;
+    byte_string        OutputDirectory;
+    bool               Force;
+
+    bake_node         *Nodes;
+    uint32_t           NodeCount;
+    uint32_t          *NodeTable;
+    uint32_t           NodeTableMask;
+
+    bake_job          *Jobs; // One per worker and one for the main thread.
+    uint32_t           JobCount;
+
+    uint32_t          *Tickets;
+    uint32_t           TicketCount;
+    uint32_t volatile  NextTicket;
+};
+
+
+static bool
+EndsWithNoCase(byte_string String, byte_string Suffix)
+{
+    bool Result = String.Size >= Suffix.Size;
+
+    for (uint64_t Idx = 0; Result && Idx < Suffix.Size; ++Idx)
+    {
+        uint8_t A = String.Data[String.Size - Suffix.Size + Idx];
+        uint8_t B = Suffix.Data[Idx];
+
+        if (A >= 'A' && A <= 'Z') A += 'a' - 'A';
+        if (B >= 'A' && B <= 'Z') B += 'a' - 'A';
+
+        Result = A == B;
+    }
+
+    return Result;
+}
+
+
+static uint32_t
+FindOrAddNode(bake_context *Context, BakeNode_Type Type, byte_string Path, memory_arena *Arena)
+{
+    uint64_t UUID   = HashByteString(Path);
+    uint32_t Slot   = (uint32_t)UUID & Context->NodeTableMask;
+    uint32_t Result = 0;
+
+    for (;;)
+    {
+        uint32_t Entry = Context->NodeTable[Slot];
+
+        if (Entry == 0)
+        {
+            assert(Context->NodeCount < MAX_BAKE_NODE_COUNT);
+
+            Result = Context->NodeCount++;
+
+            bake_node *Node = Context->Nodes + Result;
+            memset(Node, 0, sizeof(bake_node));
+
+            Node->Type   = Type;
+            Node->Status = BakeStatus_Pending;
+            Node->Path   = ByteStringCopy(Path, Arena);
+            Node->UUID   = UUID;
+
+            Context->NodeTable[Slot] = Result + 1;
+            break;
+        }
+
+        // Paths can share a hash, the path decides.
+
+        if (Context->Nodes[Entry - 1].UUID == UUID && ByteStringCompare(Context->Nodes[Entry - 1].Path, Path))
+        {
+            Result = Entry - 1;
+            break;
+        }
+
+        Slot = (Slot + 1) & Context->NodeTableMask;
+    }
+
+    return Result;
+}
+
+
+static void
+CollectSourceFiles(bake_context *Context, byte_string Directory, memory_arena *Arena)
+{
+    os_file_list Files = OSListDirectory(Directory, Arena);
+
+    for (os_file_node *File = Files.First; File != 0; File = File->Next)
+    {
+        if (File->IsDirectory)
+        {
+            CollectSourceFiles(Context, File->Path, Arena);
+        }
+        else if (EndsWithNoCase(File->Path, ByteStringLiteral(".obj")))
+        {
+            FindOrAddNode(Context, BakeNode_Obj, File->Path, Arena);
+        }
+    }
+}
+
+// ==============================================
+// <Scanning>
+// ==============================================
+
+static bool
+LineStartsWithKeyword(buffer *File, byte_string Keyword)
+{
+    bool Result = File->At + Keyword.Size < File->Size &&
+                  memcmp(File->Data + File->At, Keyword.Data, Keyword.Size) == 0 &&
+                  IsWhiteSpace(File->Data[File->At + Keyword.Size]);
+
+    return Result;
+}
+
+
+static void
+ScanDependencies(bake_node *Node, buffer *File, byte_string *Keywords, uint32_t KeywordCount, memory_arena *Arena)
+{
+    while (IsBufferInBounds(File))
+    {
+        SkipWhitespaces(File);
+
+        for (uint32_t KeywordIdx = 0; KeywordIdx < KeywordCount && IsBufferInBounds(File); ++KeywordIdx)
+        {
+            if (LineStartsWithKeyword(File, Keywords[KeywordIdx]))
+            {
+                File->At += Keywords[KeywordIdx].Size;
+                SkipWhitespaces(File);
+
+                byte_string Name = ParseToIdentifier(File);
+                if (IsValidByteString(Name))
+                {
+                    bake_dependency *Dependency = PushStruct(Arena, bake_dependency);
+                    Dependency->Path = ReplaceFileName(Node->Path, Name, Arena);
+                    Dependency->Node = 0;
+                    Dependency->Next = Node->FirstDependency;
+
+                    Node->FirstDependency  = Dependency;
+                    Node->DependencyCount += 1;
+                }
+
+                break;
+            }
+        }
+
+        while (IsBufferInBounds(File) && !IsNewLine(GetNextToken(File)))
+        {
+        }
+    }
+}
+
+
+static void
+ScanNode(bake_job *Job, bake_node *Node)
+{
+    // Only the statements the importer understands are followed, anything else is not an edge.
+
+    byte_string ObjDependencyKeywords[] =
+    {
+        ByteStringLiteral("mtllib"),
+    };
+
+    byte_string MtlDependencyKeywords[] =
+    {
+        ByteStringLiteral("map_Kd"),
+        ByteStringLiteral("map_Bump"),
+        ByteStringLiteral("map_Ns"),
+        ByteStringLiteral("map_Pm"),
+        ByteStringLiteral("map_Ka"),
+    };
+
+    memory_region Region = EnterMemoryRegion(Job->Scratch);
+
+    buffer File = ReadFileInBuffer(Node->Path, Job->Scratch);
+    if (IsBufferValid(&File))
+    {
+        Node->ContentHash = HashByteString(ByteString(File.Data, File.Size));
+        Node->Status      = BakeStatus_Scanned;
+
+        if (Node->Type == BakeNode_Obj)
+        {
+            ScanDependencies(Node, &File, ObjDependencyKeywords, ArrayCount(ObjDependencyKeywords), Job->Arena);
+        }
+        else if (Node->Type == BakeNode_Mtl)
+        {
+            ScanDependencies(Node, &File, MtlDependencyKeywords, ArrayCount(MtlDependencyKeywords), Job->Arena);
+        }
+    }
+    else
+    {
+        Node->Status = BakeStatus_Failed;
+        Node->Error  = "could not read file";
+    }
+
+    LeaveMemoryRegion(Region);
+}
+
+static void
+ScanJob(platform_work_queue *Queue, void *Data)
+{
+    (void)Queue;
+
+    bake_job     *Job     = (bake_job *)Data;
+    bake_context *Context = Job->Context;
+
+    for (;;)
+    {
+        uint32_t Ticket = AtomicIncrement32(&Context->NextTicket) - 1;
+        if (Ticket >= Context->TicketCount)
+        {
+            break;
+        }
+
+        bake_node     *Node   = Context->Nodes + Context->Tickets[Ticket];
+        uint64_t       Start  = OSReadTimer();
+        memory_region  Region = EnterMemoryRegion(Job->Scratch);
+
+        ScanNode(Job, Node);
+        Node->ScanTicks = OSReadTimer() - Start;
+
+        LeaveMemoryRegion(Region);
+    }
+}
+
+
+static void
+RunScanPhase(bake_context *Context, uint32_t *Tickets, uint32_t TicketCount)
+{
+    engine_memory *EngineMemory = Context->EngineMemory;
+
+    Context->Tickets     = Tickets;
+    Context->TicketCount = TicketCount;
+    Context->NextTicket  = 0;
+
+    if (TicketCount)
+    {
+        job_counter Done = {0};
+
+        for (uint32_t JobIdx = 0; JobIdx < Context->JobCount; ++JobIdx)
+        {
+            EngineMemory->AddJob(EngineMemory->WorkQueue, JobPriority_Normal, "scan", ScanJob, Context->Jobs + JobIdx, &Done);
+        }
+
+        EngineMemory->WaitForCounter(EngineMemory->WorkQueue, &Done);
+    }
+}
+
+
+// Turns the dependency paths found by the scan into nodes and returns the ones that are new.
+
+static uint32_t
+LinkDependencies(bake_context *Context, BakeNode_Type From, BakeNode_Type To, uint32_t *Tickets, memory_arena *Arena)
+{
+    uint32_t NodeCount   = Context->NodeCount;
+    uint32_t TicketCount = 0;
+
+    for (uint32_t NodeIdx = 0; NodeIdx < NodeCount; ++NodeIdx)
+    {
+        bake_node *Node = Context->Nodes + NodeIdx;
+
+        if (Node->Type == From)
+        {
+            for (bake_dependency *Dependency = Node->FirstDependency; Dependency != 0; Dependency = Dependency->Next)
+            {
+                uint32_t Before = Context->NodeCount;
+
+                Dependency->Node = FindOrAddNode(Context, To, Dependency->Path, Arena);
+
+                if (Context->NodeCount != Before)
+                {
+                    Tickets[TicketCount++] = Dependency->Node;
+                }
+            }
+        }
+    }
+
+    return TicketCount;
+}
+
+// ==============================================
+// <Baking>
+// ==============================================
+
+
+// The key covers everything the import reads: the OBJ itself (its UVs decide which materials go to
+// an atlas instead of the cache), its MTL files and their maps.
+
+static void
+MakeObjKey(bake_context *Context, bake_node *Node)
+{
+    uint64_t Hash = Node->ContentHash;
+
+    for (bake_dependency *Mtl = Node->FirstDependency; Mtl != 0; Mtl = Mtl->Next)
+    {
+        bake_node *MtlNode = Context->Nodes + Mtl->Node;
+        Hash = CombineHash(Hash, MtlNode->ContentHash);
+
+        for (bake_dependency *Map = MtlNode->FirstDependency; Map != 0; Map = Map->Next)
+        {
+            Hash = CombineHash(Hash, Context->Nodes[Map->Node].ContentHash);
+        }
+    }
+
+    Node->Key = MakeTextureCacheKey(Hash);
+}
+
+
+// Runs the engine's own import, same flags as LoadEngineScene, so the cache ends up with exactly
+// the entries the engine looks for. Must run on the thread that owns the work queue.
+
+static void
+BakeObjNode(bake_context *Context, bake_node *Node)
+{
+    engine_memory *EngineMemory = Context->EngineMemory;
+
+    if (!Context->Force && Node->HasPreviousKey && Node->PreviousKey == Node->Key)
+    {
+        Node->Status = BakeStatus_UpToDate;
+        return;
+    }
+
+    memory_region   Region   = EnterMemoryRegion(EngineMemory->FrameMemory);
+    asset_file_data FileData = ParseObjFromFile(Node->Path, ObjParseFlag_None, EngineMemory);
+
+    if (FileData.MeshCount)
+    {
+        // Only textures that went through the cache have a stream key, atlas pages are rebuilt at load.
+
+        for (uint32_t MaterialIdx = 0; MaterialIdx < FileData.MaterialCount; ++MaterialIdx)
+        {
+            for (uint32_t TextureIdx = 0; TextureIdx < MaterialTexture_Count; ++TextureIdx)
+            {
+                loaded_texture *Texture = &FileData.Materials[MaterialIdx].Textures[TextureIdx];
+
+                if (Texture->StreamKey)
+                {
+                    Node->OutputSize += GetTextureDataSize(Texture->Width, Texture->Height, Texture->Format, Texture->MipCount);
+                }
+            }
+        }
+
+        Node->Status = BakeStatus_Baked;
+    }
+    else
+    {
+        Node->Status = BakeStatus_Failed;
+        Node->Error  = "could not import";
+    }
+
+    LeaveMemoryRegion(Region);
+}
+
+// ==============================================
+// <Manifest>
+// ==============================================
+
+
+static void
+ReadManifest(bake_context *Context, byte_string Path, memory_arena *Arena)
+{
+    buffer File = ReadFileInBuffer(Path, Arena);
+
+    if (IsBufferValid(&File) && File.Size >= sizeof(bake_manifest_header))
+    {
+        bake_manifest_header *Header  = (bake_manifest_header *)File.Data;
+        bake_manifest_entry  *Entries = (bake_manifest_entry *)(Header + 1);
+        uint64_t              Strings = sizeof(bake_manifest_header) + (uint64_t)Header->EntryCount * sizeof(bake_manifest_entry);
+
+        bool IsValid = Header->Magic   == BAKE_MANIFEST_MAGIC   &&
+                       Header->Version == BAKE_MANIFEST_VERSION &&
+                       Strings <= File.Size;
+
+        for (uint32_t EntryIdx = 0; IsValid && EntryIdx < Header->EntryCount; ++EntryIdx)
+        {
+            bake_manifest_entry *Stored = Entries + EntryIdx;
+
+            if (Strings + Stored->PathOffset + Stored->PathSize > File.Size)
+            {
+                continue;
+            }
+
+            // Paths can share a hash, an entry only counts for the path it was written for.
+
+            byte_string StoredPath = ByteString(File.Data + Strings + Stored->PathOffset, Stored->PathSize);
+            uint32_t    Slot       = (uint32_t)Stored->UUID & Context->NodeTableMask;
+
+            for (uint32_t Entry = Context->NodeTable[Slot]; Entry != 0; Entry = Context->NodeTable[Slot])
+            {
+                bake_node *Node = Context->Nodes + Entry - 1;
+                if (Node->UUID == Stored->UUID && ByteStringCompare(Node->Path, StoredPath))
+                {
+                    Node->PreviousKey    = Stored->Key;
+                    Node->HasPreviousKey = true;
+                    break;
+                }
+
+                Slot = (Slot + 1) & Context->NodeTableMask;
+            }
+        }
+    }
+}
+
+
+static bool
+WriteManifest(bake_context *Context, byte_string Path, memory_arena *Arena)
+{
+    uint64_t PathSize = 0;
+    uint32_t Count    = 0;
+
+    for (uint32_t NodeIdx = 0; NodeIdx < Context->NodeCount; ++NodeIdx)
+    {
+        bake_node *Node = Context->Nodes + NodeIdx;
+
+        if (Node->Status == BakeStatus_Baked || Node->Status == BakeStatus_UpToDate)
+        {
+            PathSize += Node->Path.Size;
+            Count    += 1;
+        }
+    }
+
+    uint64_t              Strings  = sizeof(bake_manifest_header) + Count * sizeof(bake_manifest_entry);
+    bake_manifest_header *Header   = (bake_manifest_header *)PushArray(Arena, uint8_t, Strings + PathSize);
+    bake_manifest_entry  *Entries  = (bake_manifest_entry *)(Header + 1);
+    uint32_t              At       = 0;
+
+    Header->Magic      = BAKE_MANIFEST_MAGIC;
+    Header->Version    = BAKE_MANIFEST_VERSION;
+    Header->EntryCount = 0;
+    Header->Reserved   = 0;
+
+    for (uint32_t NodeIdx = 0; NodeIdx < Context->NodeCount; ++NodeIdx)
+    {
+        bake_node *Node = Context->Nodes + NodeIdx;
+
+        if (Node->Status == BakeStatus_Baked || Node->Status == BakeStatus_UpToDate)
+        {
+            bake_manifest_entry *Entry = Entries + Header->EntryCount;
+
+            Entry->UUID       = Node->UUID;
+            Entry->Key        = Node->Key;
+            Entry->PathOffset = At;
+            Entry->PathSize   = (uint32_t)Node->Path.Size;
+
+            memcpy((uint8_t *)Header + Strings + At, Node->Path.Data, Node->Path.Size);
+
+            At                 += (uint32_t)Node->Path.Size;
+            Header->EntryCount += 1;
+        }
+    }
+
+    buffer File =
+    {
+        .Data = (uint8_t *)Header,
+        .Size = Strings + PathSize,
+        .At   = 0,
+    };
+
+    bool Result = WriteBufferToFile(Path, &File);
+    return Result;
+}
+
+// ==============================================
+// <Report>
+// ==============================================
+
+
+static bake_node *SortNodes;
+
+
+static int
+CompareNodeTime(const void *A, const void *B)
+{
+    bake_node *NodeA = SortNodes + *(const uint32_t *)A;
+    bake_node *NodeB = SortNodes + *(const uint32_t *)B;
+
+    uint64_t TimeA = NodeA->ScanTicks + NodeA->BakeTicks;
+    uint64_t TimeB = NodeB->ScanTicks + NodeB->BakeTicks;
+
+    int Result = TimeA < TimeB ? 1 : (TimeA > TimeB ? -1 : 0);
+    return Result;
+}
+
+
+static uint32_t
+PrintReport(bake_context *Context, uint64_t WallTicks, memory_arena *Arena)
+{
+    static const char *StatusNames[] =
+    {
+        [BakeStatus_Pending]  = "pending",
+        [BakeStatus_Scanned]  = "scanned",
+        [BakeStatus_UpToDate] = "up-to-date",
+        [BakeStatus_Baked]    = "baked",
+        [BakeStatus_Failed]   = "FAILED",
+    };
+
+    double    TicksToMs   = 1000.0 / (double)OSGetTimerFrequency();
+    uint32_t *Order       = PushArray(Arena, uint32_t, Context->NodeCount);
+    uint32_t  StatusCount[ArrayCount(StatusNames)] = {0};
+    uint32_t  TypeCount[BakeNode_Texture + 1]      = {0};
+    uint64_t  BusyTicks   = 0;
+
+    for (uint32_t NodeIdx = 0; NodeIdx < Context->NodeCount; ++NodeIdx)
+    {
+        Order[NodeIdx] = NodeIdx;
+    }
+
+    SortNodes = Context->Nodes;
+    qsort(Order, Context->NodeCount, sizeof(uint32_t), CompareNodeTime);
+
+    printf("%-10s %10s %10s %12s  %s\n", "status", "scan ms", "bake ms", "output", "asset");
+
+    for (uint32_t OrderIdx = 0; OrderIdx < Context->NodeCount; ++OrderIdx)
+    {
+        bake_node *Node = Context->Nodes + Order[OrderIdx];
+
+        printf("%-10s %10.2f %10.2f %12llu  %s%s%s\n", StatusNames[Node->Status],
+               Node->ScanTicks * TicksToMs, Node->BakeTicks * TicksToMs, (unsigned long long)Node->OutputSize,
+               (const char *)Node->Path.Data, Node->Error ? " : " : "", Node->Error ? Node->Error : "");
+
+        StatusCount[Node->Status] += 1;
+        TypeCount[Node->Type]     += 1;
+        BusyTicks                 += Node->ScanTicks + Node->BakeTicks;
+    }
+
+    printf("\nadb-bake: %u nodes (%u obj, %u mtl, %u texture) | %u baked, %u up to date, %u failed | %.2f ms wall, %.2f ms busy, %u jobs\n",
+           Context->NodeCount, TypeCount[BakeNode_Obj], TypeCount[BakeNode_Mtl], TypeCount[BakeNode_Texture],
+           StatusCount[BakeStatus_Baked], StatusCount[BakeStatus_UpToDate], StatusCount[BakeStatus_Failed],
+           WallTicks * TicksToMs, BusyTicks * TicksToMs, Context->JobCount);
+
+    return StatusCount[BakeStatus_Failed];
+}
+
+// ==============================================
+// <Entry Point>
+// ==============================================
+
+
+static byte_string
+TrimTrailingSeparators(char *Argument)
+{
+    byte_string Result = ByteString((uint8_t *)Argument, strlen(Argument));
+
+    while (Result.Size > 1 && (Result.Data[Result.Size - 1] == '/' || Result.Data[Result.Size - 1] == '\\'))
+    {
+        Result.Data[--Result.Size] = '\0';
+    }
+
+    return Result;
+}
+
+
+int
+main(int ArgCount, char **Args)
+{
+    char    *Source      = 0;
+    char    *Output      = 0;
+    char    *Trace       = 0;
+    char    *Profile     = 0;
+    uint32_t WorkerCount = 0;
+    bool     Force       = false;
+    bool     Counters    = false;
+
+    for (int ArgIdx = 1; ArgIdx < ArgCount; ++ArgIdx)
+    {
+        if (strcmp(Args[ArgIdx], "--jobs") == 0 && ArgIdx + 1 < ArgCount)
+        {
+            WorkerCount = (uint32_t)atoi(Args[++ArgIdx]);
+        }
+        else if (strcmp(Args[ArgIdx], "--force") == 0)
+        {
+            Force = true;
+        }
+        else if (strcmp(Args[ArgIdx], "--trace") == 0 && ArgIdx + 1 < ArgCount)
+        {
+            Trace = Args[++ArgIdx];
+        }
+        else if (strcmp(Args[ArgIdx], "--profile") == 0 && ArgIdx + 1 < ArgCount)
+        {
+            Profile = Args[++ArgIdx];
+        }
+        else if (strcmp(Args[ArgIdx], "--counters") == 0)
+        {
+            Counters = true;
+        }
+        else if (!Source)
+        {
+            Source = Args[ArgIdx];
+        }
+        else if (!Output)
+        {
+            Output = Args[ArgIdx];
+        }
+    }
+
+    if (!Source || !Output)
+    {
+        fprintf(stderr, "usage: adb-bake <source directory> <cache directory> [--jobs N] [--force] [--trace <file>] [--profile <file> [--counters]]\n");
+        return 2;
+    }
+
+    if (Profile)
+    {
+        SetProfilerCounters(Counters);
+        SetProfilerCapture(true);
+    }
+
+    uint64_t      Start        = OSReadTimer();
+    engine_memory EngineMemory = OSCreateEngineMemory(WorkerCount);
+    memory_arena *Arena        = EngineMemory.StateMemory;
+
+    if (Trace)
+    {
+        StartWorkQueueTrace(EngineMemory.WorkQueue);
+    }
+
+    bake_context *Context = PushStruct(Arena, bake_context);
+    memset(Context, 0, sizeof(bake_context));
+
+    Context->EngineMemory    = &EngineMemory;
+    Context->SourceDirectory = TrimTrailingSeparators(Source);
+    Context->OutputDirectory = TrimTrailingSeparators(Output);
+    Context->Force           = Force;
+    Context->Nodes           = PushArray(Arena, bake_node, MAX_BAKE_NODE_COUNT);
+    Context->NodeTable       = PushArray(Arena, uint32_t, MAX_BAKE_NODE_COUNT * 2);
+    Context->NodeTableMask   = MAX_BAKE_NODE_COUNT * 2 - 1;
+    Context->JobCount        = (WorkerCount ? WorkerCount : OSGetProcessorCount()) + 1;
+    Context->Jobs            = PushArray(Arena, bake_job, Context->JobCount);
+
+    memset(Context->NodeTable, 0, MAX_BAKE_NODE_COUNT * 2 * sizeof(uint32_t));
+
+    for (uint32_t JobIdx = 0; JobIdx < Context->JobCount; ++JobIdx)
+    {
+        memory_arena_params Params =
+        {
+            .AllocatedFromFile = __FILE__,
+            .AllocatedFromLine = __LINE__,
+            .ReserveSize       = MiB(256),
+            .CommitSize        = MiB(1),
+        };
+
+        Context->Jobs[JobIdx].Context = Context;
+        Context->Jobs[JobIdx].Arena   = AllocateArena(Params);
+        Context->Jobs[JobIdx].Scratch = AllocateArena(Params);
+    }
+
+    uint32_t *Tickets     = PushArray(Arena, uint32_t, MAX_BAKE_NODE_COUNT);
+    uint32_t  TicketCount = 0;
+
+    // Discovery: OBJ files come from the directory, everything else is reached through edges.
+    {
+        CollectSourceFiles(Context, Context->SourceDirectory, EngineMemory.FrameMemory);
+
+        for (uint32_t NodeIdx = 0; NodeIdx < Context->NodeCount; ++NodeIdx)
+        {
+            Tickets[TicketCount++] = NodeIdx;
+        }
+
+        RunScanPhase(Context, Tickets, TicketCount);
+
+        TicketCount = LinkDependencies(Context, BakeNode_Obj, BakeNode_Mtl, Tickets, Arena);
+        RunScanPhase(Context, Tickets, TicketCount);
+
+        TicketCount = LinkDependencies(Context, BakeNode_Mtl, BakeNode_Texture, Tickets, Arena);
+        RunScanPhase(Context, Tickets, TicketCount);
+    }
+
+    byte_string ManifestParts[2] = {Context->OutputDirectory, ByteStringLiteral("bake.manifest")};
+    byte_string ManifestPath     = ConcatenateStrings(ManifestParts, 2, ByteStringLiteral("/"), Arena);
+
+    ReadManifest(Context, ManifestPath, EngineMemory.FrameMemory);
+
+    // OBJ files are imported one after the other on this thread, each import spreads its textures
+    // over the work queue.
+    {
+        byte_string CacheParts[2] = {Context->OutputDirectory, ByteStringLiteral("textures")};
+        byte_string CachePath     = ConcatenateStrings(CacheParts, 2, ByteStringLiteral("/"), Arena);
+
+        if (!SetTextureCacheDirectory(CachePath))
+        {
+            fprintf(stderr, "adb-bake: %s is too long\n", (const char *)CachePath.Data);
+            return 2;
+        }
+
+        OSCreateDirectory(Context->OutputDirectory);
+
+        for (uint32_t NodeIdx = 0; NodeIdx < Context->NodeCount; ++NodeIdx)
+        {
+            bake_node *Node = Context->Nodes + NodeIdx;
+
+            if (Node->Type == BakeNode_Obj && Node->Status == BakeStatus_Scanned)
+            {
+                uint64_t BakeStart = OSReadTimer();
+
+                MakeObjKey(Context, Node);
+                BakeObjNode(Context, Node);
+
+                Node->BakeTicks = OSReadTimer() - BakeStart;
+            }
+        }
+
+        TrimTextureSources();
+    }
+
+    if (!WriteManifest(Context, ManifestPath, EngineMemory.FrameMemory))
+    {
+        fprintf(stderr, "adb-bake: could not write %s\n", (const char *)ManifestPath.Data);
+    }
+
+    uint32_t FailedCount = PrintReport(Context, OSReadTimer() - Start, EngineMemory.FrameMemory);
+
+    if (Trace)
+    {
+        StopWorkQueueTrace(EngineMemory.WorkQueue);
+
+        if (!WriteWorkQueueTrace(EngineMemory.WorkQueue, ByteString((uint8_t *)Trace, strlen(Trace)), EngineMemory.FrameMemory))
+        {
+            fprintf(stderr, "adb-bake: could not write %s\n", Trace);
+        }
+    }
+
+    if (Profile)
+    {
+        SetProfilerCapture(false);
+        EndProfilerFrame();
+
+        printf("\n");
+        PrintProfilerFrame(0);
+
+        if (!WriteProfilerHistory(ByteString((uint8_t *)Profile, strlen(Profile)), EngineMemory.FrameMemory))
+        {
+            fprintf(stderr, "adb-bake: could not write %s\n", Profile);
+        }
+    }
+
+    return FailedCount ? 1 : 0;
+}
\ No newline at end of file
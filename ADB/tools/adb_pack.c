@@ -0,0 +1,385 @@
+// adb-pack: asset archive writer.
+//
+//   adb-pack <archive> <directory>... [--compress] [--jobs N] [--trace <file>]
+//
+// Packs every file found under the given directories into a single archive the engine can mount
+// (see engine/rendering/asset_archive.h). Entries are keyed by the resource uuid of their path as
+// written on the command line, so pack from the directory the engine runs in: "adb-pack data.adbpak
+// data" serves "data/strawberry.obj". Reading and compression run on the work queue, --trace writes
+// what its threads did as Chrome trace JSON.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "platform/work_queue.h"
+#include "engine/rendering/assets.h"
+#include "engine/rendering/asset_archive.h"
+
+#define MAX_PACK_ENTRY_COUNT 65536
+
+// ==============================================
+// <Packing>
+// ==============================================
+
+
+typedef struct
+{
+    byte_string              Path;
+    resource_uuid            UUID;
+    bool                     Failed;
+
+    // Filled by the jobs. Data is the raw file without the null byte ReadFileInBuffer adds.
+    uint8_t                 *Data;
+    uint32_t                 Size;
+    uint8_t                 *Packed;
+    uint32_t                 PackedSize;
+    ArchiveCompression_Type  Compression;
+    uint64_t                 Ticks;
+} pack_entry;
+
+
+typedef struct pack_context pack_context;
+
+typedef struct
+{
+    pack_context *Context;
+    memory_arena *Arena;
+} pack_job;
+
+
+struct pack_context
+{
+    engine_memory *EngineMemory;
+    bool           Compress;
+
+    pack_entry    *Entries;
+    uint32_t       EntryCount;
+    uint32_t       NextTicket;
+
+    pack_job      *Jobs; // One per worker and one for the main thread.
+    uint32_t       JobCount;
+};
+
+
+static void
+CollectFiles(pack_context *Context, byte_string Directory, memory_arena *Arena)
+{
+    os_file_list Files = OSListDirectory(Directory, Arena);
+
+    for (os_file_node *File = Files.First; File != 0; File = File->Next)
+    {
+        if (File->IsDirectory)
+        {
+            CollectFiles(Context, File->Path, Arena);
+        }
+        else if (Context->EntryCount < MAX_PACK_ENTRY_COUNT)
+        {
+            pack_entry *Entry = Context->Entries + Context->EntryCount++;
+
+            memset(Entry, 0, sizeof(pack_entry));
+            Entry->Path = File->Path;
+            Entry->UUID = MakeResourceUUID(File->Path);
+        }
+        else
+        {
+            fprintf(stderr, "adb-pack: more than %d files, %s skipped\n", MAX_PACK_ENTRY_COUNT, (const char *)File->Path.Data);
+        }
+    }
+}
+
+
+static void
+PackEntry(pack_job *Job, pack_entry *Entry)
+{
+    // The job arena is never popped, everything read here stays alive until the archive is written.
+
+    buffer File = ReadFileInBuffer(Entry->Path, Job->Arena);
+
+    if (!IsBufferValid(&File) || File.Size - 1 >= UINT32_MAX)
+    {
+        Entry->Failed = true;
+        return;
+    }
+
+    Entry->Data        = File.Data;
+    Entry->Size        = (uint32_t)(File.Size - 1);
+    Entry->Packed      = Entry->Data;
+    Entry->PackedSize  = Entry->Size;
+    Entry->Compression = ArchiveCompression_None;
+
+    if (Job->Context->Compress)
+    {
+        uint64_t Bound  = GetCompressBound(Entry->Size);
+        uint8_t *Packed = PushArray(Job->Arena, uint8_t, Bound);
+        uint64_t Size   = CompressLZ(Entry->Data, Entry->Size, Packed, Bound);
+
+        // Already compressed formats (PNG, JPEG) barely shrink. Storing those keeps them zero-copy
+        // at load time instead of paying for a decompression that saves nothing.
+
+        if (Size && Size < Entry->Size - Entry->Size / 16)
+        {
+            Entry->Packed      = Packed;
+            Entry->PackedSize  = (uint32_t)Size;
+            Entry->Compression = ArchiveCompression_LZ;
+        }
+    }
+}
+
+
+static void
+PackJob(platform_work_queue *Queue, void *Data)
+{
+    (void)Queue;
+
+    pack_job     *Job     = (pack_job *)Data;
+    pack_context *Context = Job->Context;
+
+    for (;;)
+    {
+        uint32_t Ticket = AtomicIncrement32(&Context->NextTicket) - 1;
+        if (Ticket >= Context->EntryCount)
+        {
+            break;
+        }
+
+        pack_entry *Entry = Context->Entries + Ticket;
+        uint64_t    Start = OSReadTimer();
+
+        PackEntry(Job, Entry);
+
+        Entry->Ticks = OSReadTimer() - Start;
+    }
+}
+
+
+static bool
+WriteArchive(pack_context *Context, const char *Path, memory_arena *Arena)
+{
+    FILE *File = fopen(Path, "wb");
+    if (!File)
+    {
+        return false;
+    }
+
+    uint32_t SlotCount = 16;
+    while (SlotCount < Context->EntryCount * 2)
+    {
+        SlotCount *= 2;
+    }
+
+    asset_archive_entry *Slots = PushArray(Arena, asset_archive_entry, SlotCount);
+    memset(Slots, 0, SlotCount * sizeof(asset_archive_entry));
+
+    asset_archive_header Header = {0};
+    Header.Magic   = ASSET_ARCHIVE_MAGIC;
+    Header.Version = ASSET_ARCHIVE_VERSION;
+
+    // Header first so offsets are right, it is rewritten once the slot table offset is known.
+
+    bool     Result = fwrite(&Header, sizeof(Header), 1, File) == 1;
+    uint64_t Offset = sizeof(Header);
+
+    for (uint32_t EntryIdx = 0; Result && EntryIdx < Context->EntryCount; ++EntryIdx)
+    {
+        pack_entry *Entry = Context->Entries + EntryIdx;
+        if (Entry->Failed)
+        {
+            continue;
+        }
+
+        uint32_t Slot = (uint32_t)Entry->UUID.Value & (SlotCount - 1);
+        while (Slots[Slot].UUID != 0 && Slots[Slot].UUID != Entry->UUID.Value)
+        {
+            Slot = (Slot + 1) & (SlotCount - 1);
+        }
+
+        if (Slots[Slot].UUID == Entry->UUID.Value)
+        {
+            fprintf(stderr, "adb-pack: %s has the same uuid as an earlier file, skipped\n", (const char *)Entry->Path.Data);
+            Entry->Failed = true;
+            continue;
+        }
+
+        uint8_t Terminator = 0;
+
+        Result = fwrite(Entry->Packed, 1, Entry->PackedSize, File) == Entry->PackedSize &&
+                 fwrite(&Terminator, 1, 1, File) == 1;
+
+        Slots[Slot].UUID        = Entry->UUID.Value;
+        Slots[Slot].Offset      = Offset;
+        Slots[Slot].PackedSize  = Entry->PackedSize;
+        Slots[Slot].Size        = Entry->Size;
+        Slots[Slot].Compression = Entry->Compression;
+
+        Offset += Entry->PackedSize + 1;
+        Header.EntryCount += 1;
+    }
+
+    // Keep the table aligned, it is read in place from the mapping.
+
+    while (Result && (Offset % 8) != 0)
+    {
+        uint8_t Padding = 0;
+
+        Result  = fwrite(&Padding, 1, 1, File) == 1;
+        Offset += 1;
+    }
+
+    Header.SlotCount  = SlotCount;
+    Header.SlotOffset = Offset;
+
+    Result = Result && fwrite(Slots, sizeof(asset_archive_entry), SlotCount, File) == SlotCount;
+    Result = Result && fseek(File, 0, SEEK_SET) == 0 && fwrite(&Header, sizeof(Header), 1, File) == 1;
+    Result = (fclose(File) == 0) && Result;
+
+    return Result;
+}
+
+// ==============================================
+// <Entry Point>
+// ==============================================
+
+
+int
+main(int ArgCount, char **Args)
+{
+    char    *Output         = 0;
+    char    *Trace          = 0;
+    char    *Directories[64];
+    uint32_t DirectoryCount = 0;
+    uint32_t WorkerCount    = 0;
+    bool     Compress       = false;
+
+    for (int ArgIdx = 1; ArgIdx < ArgCount; ++ArgIdx)
+    {
+        if (strcmp(Args[ArgIdx], "--jobs") == 0 && ArgIdx + 1 < ArgCount)
+        {
+            WorkerCount = (uint32_t)atoi(Args[++ArgIdx]);
+        }
+        else if (strcmp(Args[ArgIdx], "--compress") == 0)
+        {
+            Compress = true;
+        }
+        else if (strcmp(Args[ArgIdx], "--trace") == 0 && ArgIdx + 1 < ArgCount)
+        {
+            Trace = Args[++ArgIdx];
+        }
+        else if (!Output)
+        {
+            Output = Args[ArgIdx];
+        }
+        else if (DirectoryCount < ArrayCount(Directories))
+        {
+            Directories[DirectoryCount++] = Args[ArgIdx];
+        }
+    }
+
+    if (!Output || !DirectoryCount)
+    {
+        fprintf(stderr, "usage: adb-pack <archive> <directory>... [--compress] [--jobs N] [--trace <file>]\n");
+        return 2;
+    }
+
+    uint64_t      Start        = OSReadTimer();
+    engine_memory EngineMemory = OSCreateEngineMemory(WorkerCount);
+    memory_arena *Arena        = EngineMemory.StateMemory;
+
+    if (Trace)
+    {
+        StartWorkQueueTrace(EngineMemory.WorkQueue);
+    }
+
+    pack_context *Context = PushStruct(Arena, pack_context);
+    memset(Context, 0, sizeof(pack_context));
+
+    Context->EngineMemory = &EngineMemory;
+    Context->Compress     = Compress;
+    Context->Entries      = PushArray(Arena, pack_entry, MAX_PACK_ENTRY_COUNT);
+    Context->JobCount     = (WorkerCount ? WorkerCount : OSGetProcessorCount()) + 1;
+    Context->Jobs         = PushArray(Arena, pack_job, Context->JobCount);
+
+    for (uint32_t DirectoryIdx = 0; DirectoryIdx < DirectoryCount; ++DirectoryIdx)
+    {
+        byte_string Directory = ByteString((uint8_t *)Directories[DirectoryIdx], strlen(Directories[DirectoryIdx]));
+        while (Directory.Size > 1 && (Directory.Data[Directory.Size - 1] == '/' || Directory.Data[Directory.Size - 1] == '\\'))
+        {
+            Directory.Data[--Directory.Size] = '\0';
+        }
+
+        CollectFiles(Context, Directory, Arena);
+    }
+
+    job_counter Done = {0};
+
+    for (uint32_t JobIdx = 0; JobIdx < Context->JobCount; ++JobIdx)
+    {
+        memory_arena_params Params =
+        {
+            .AllocatedFromFile = __FILE__,
+            .AllocatedFromLine = __LINE__,
+            .ReserveSize       = MiB(256),
+            .CommitSize        = MiB(1),
+        };
+
+        Context->Jobs[JobIdx].Context = Context;
+        Context->Jobs[JobIdx].Arena   = AllocateArena(Params);
+
+        EngineMemory.AddJob(EngineMemory.WorkQueue, JobPriority_Normal, "pack", PackJob, Context->Jobs + JobIdx, &Done);
+    }
+
+    EngineMemory.WaitForCounter(EngineMemory.WorkQueue, &Done);
+
+    if (Trace)
+    {
+        StopWorkQueueTrace(EngineMemory.WorkQueue);
+
+        if (!WriteWorkQueueTrace(EngineMemory.WorkQueue, ByteString((uint8_t *)Trace, strlen(Trace)), EngineMemory.FrameMemory))
+        {
+            fprintf(stderr, "adb-pack: could not write %s\n", Trace);
+        }
+    }
+
+    if (!WriteArchive(Context, Output, EngineMemory.FrameMemory))
+    {
+        fprintf(stderr, "adb-pack: could not write %s\n", Output);
+        return 1;
+    }
+
+    uint64_t RawSize      = 0;
+    uint64_t PackedSize   = 0;
+    uint32_t PackedCount  = 0;
+    uint32_t FailedCount  = 0;
+    uint64_t BusyTicks    = 0;
+
+    for (uint32_t EntryIdx = 0; EntryIdx < Context->EntryCount; ++EntryIdx)
+    {
+        pack_entry *Entry = Context->Entries + EntryIdx;
+
+        if (Entry->Failed)
+        {
+            fprintf(stderr, "adb-pack: failed to pack %s\n", (const char *)Entry->Path.Data);
+            ++FailedCount;
+            continue;
+        }
+
+        RawSize     += Entry->Size;
+        PackedSize  += Entry->PackedSize;
+        PackedCount += Entry->Compression == ArchiveCompression_LZ;
+        BusyTicks   += Entry->Ticks;
+    }
+
+    double TicksToMs = 1000.0 / (double)OSGetTimerFrequency();
+
+    printf("adb-pack: %u files (%u compressed, %u failed) | %llu -> %llu bytes (%.1f%%) | %.2f ms wall, %.2f ms busy, %u jobs\n",
+           Context->EntryCount - FailedCount, PackedCount, FailedCount,
+           (unsigned long long)RawSize, (unsigned long long)PackedSize, RawSize ? 100.0 * (double)PackedSize / (double)RawSize : 100.0,
+           (double)(OSReadTimer() - Start) * TicksToMs, (double)BusyTicks * TicksToMs, Context->JobCount);
+
+    return FailedCount ? 1 : 0;
+}
\ No newline at end of file
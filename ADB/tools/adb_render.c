@@ -0,0 +1,194 @@
+// adb-render: draws the engine's scene on the CPU.
+//
+//   adb-render [--obj <file>]... [--width N] [--height N] [--entities N] [--frames N] [--jobs N] [--out <file.tga>]
+//
+// Runs UpdateEngine like the window does, with the software backend (engine/rendering/software/
+// software_renderer.h) in place of D3D11, on machines without a GPU or to check what a frame should
+// look like. The scene is every --obj file, data/strawberry.obj when there is none, with --entities
+// entities per mesh. Draws --frames frames of --width by --height, prints how long they took and
+// what the last one drew, and writes it to --out as an uncompressed TGA.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "utilities.h"
+#include "platform/platform.h"
+#include "engine/engine.h"
+#include "engine/rendering/renderer.h"
+#include "engine/rendering/scene.h"
+#include "engine/rendering/software/software_renderer.h"
+
+#define MAX_RENDER_OBJ_COUNT 64
+#define MAX_RENDER_SIDE      8192
+
+// ==============================================
+// <Output>
+// ==============================================
+
+
+// 32 bits per pixel, top row first: the header says so with bit 5 of the descriptor, 8 of them are alpha.
+
+static bool
+WriteTGA(const char *Path, software_image Image)
+{
+    bool  Result = false;
+    FILE *File   = fopen(Path, "wb");
+
+    if (File)
+    {
+        uint8_t Header[18] = {0};
+        Header[2]  = 2;
+        Header[12] = (uint8_t)(Image.Width);
+        Header[13] = (uint8_t)(Image.Width >> 8);
+        Header[14] = (uint8_t)(Image.Height);
+        Header[15] = (uint8_t)(Image.Height >> 8);
+        Header[16] = 32;
+        Header[17] = 0x28;
+
+        Result = fwrite(Header, sizeof(Header), 1, File) == 1;
+
+        uint8_t *Row = malloc((size_t)Image.Width * 4);
+
+        for (uint32_t Y = 0; Y < Image.Height && Result && Row; ++Y)
+        {
+            uint8_t *Source = Image.Pixels + (uint64_t)Y * Image.Pitch;
+
+            for (uint32_t X = 0; X < Image.Width; ++X)
+            {
+                Row[X * 4 + 0] = Source[X * 4 + 2];
+                Row[X * 4 + 1] = Source[X * 4 + 1];
+                Row[X * 4 + 2] = Source[X * 4 + 0];
+                Row[X * 4 + 3] = Source[X * 4 + 3];
+            }
+
+            Result = fwrite(Row, (size_t)Image.Width * 4, 1, File) == 1;
+        }
+
+        Result = Result && Row;
+
+        free(Row);
+        fclose(File);
+    }
+
+    return Result;
+}
+
+// ==============================================
+// <Entry Point>
+// ==============================================
+
+
+int
+main(int ArgCount, char **Args)
+{
+    char    *ObjPaths[MAX_RENDER_OBJ_COUNT];
+    uint32_t ObjCount    = 0;
+    char    *Output      = 0;
+    uint32_t Width       = 1280;
+    uint32_t Height      = 720;
+    uint32_t EntityCount = 1;
+    uint32_t FrameCount  = 10;
+    uint32_t WorkerCount = 0;
+    bool     IsValid     = true;
+
+    for (int ArgIdx = 1; ArgIdx < ArgCount; ++ArgIdx)
+    {
+        char     *Value  = ArgIdx + 1 < ArgCount ? Args[ArgIdx + 1] : 0;
+        uint32_t  Number = Value ? (uint32_t)atoi(Value) : 0;
+
+        if      (!Value)                                                                  IsValid     = false;
+        else if (strcmp(Args[ArgIdx], "--obj") == 0 && ObjCount < MAX_RENDER_OBJ_COUNT)   ObjPaths[ObjCount++] = Value;
+        else if (strcmp(Args[ArgIdx], "--out")      == 0)                                 Output      = Value;
+        else if (strcmp(Args[ArgIdx], "--width")    == 0)                                 Width       = Number;
+        else if (strcmp(Args[ArgIdx], "--height")   == 0)                                 Height      = Number;
+        else if (strcmp(Args[ArgIdx], "--entities") == 0)                                 EntityCount = Number;
+        else if (strcmp(Args[ArgIdx], "--frames")   == 0)                                 FrameCount  = Number;
+        else if (strcmp(Args[ArgIdx], "--jobs")     == 0)                                 WorkerCount = Number;
+        else                                                                              IsValid     = false;
+
+        ++ArgIdx;
+    }
+
+    IsValid = IsValid && Width && Height && Width <= MAX_RENDER_SIDE && Height <= MAX_RENDER_SIDE && FrameCount &&
+              EntityCount && EntityCount <= MAX_ENTITY_COUNT;
+
+    if (!IsValid)
+    {
+        fprintf(stderr, "usage: adb-render [--obj <file>]... [--width N] [--height N] [--entities N] [--frames N] [--jobs N] [--out <file.tga>]\n"
+                        "at most %d by %d pixels, %d obj files and %d entities\n", MAX_RENDER_SIDE, MAX_RENDER_SIDE, MAX_RENDER_OBJ_COUNT, MAX_ENTITY_COUNT);
+        return 2;
+    }
+
+    if (!ObjCount)
+    {
+        ObjPaths[ObjCount++] = "data/strawberry.obj";
+    }
+
+    engine_memory Memory   = OSCreateEngineMemory(WorkerCount);
+    renderer     *Renderer = PushStruct(Memory.StateMemory, renderer);
+    memset(Renderer, 0, sizeof(renderer));
+
+    Renderer->Backend        = SoftwareInitialize(Width, Height, Memory.StateMemory);
+    Renderer->Resources      = CreateResourceManager(Memory.StateMemory);
+    Renderer->ReferenceTable = CreateResourceReferenceTable(Memory.StateMemory);
+
+    byte_string *Paths = PushArray(Memory.StateMemory, byte_string, ObjCount);
+
+    for (uint32_t ObjIdx = 0; ObjIdx < ObjCount; ++ObjIdx)
+    {
+        Paths[ObjIdx] = ByteString((uint8_t *)ObjPaths[ObjIdx], strlen(ObjPaths[ObjIdx]));
+    }
+
+    double   TicksToMs   = 1000.0 / (double)OSGetTimerFrequency();
+    uint64_t ImportStart = OSReadTimer();
+
+    engine_scene_params Params = {Paths, ObjCount, EntityCount};
+    LoadEngineScene(Params, Renderer, &Memory);
+
+    double ImportMs = (double)(OSReadTimer() - ImportStart) * TicksToMs;
+    double TotalMs  = 0.0;
+    double BestMs   = 0.0;
+
+    PopArenaTo(Memory.FrameMemory, 0);
+
+    for (uint32_t Frame = 0; Frame < FrameCount; ++Frame)
+    {
+        uint64_t FrameStart = OSReadTimer();
+
+        UpdateEngine((int)Width, (int)Height, Renderer, &Memory);
+
+        double FrameMs = (double)(OSReadTimer() - FrameStart) * TicksToMs;
+
+        PopArenaTo(Memory.FrameMemory, 0);
+
+        TotalMs += FrameMs;
+        BestMs   = Frame == 0 || FrameMs < BestMs ? FrameMs : BestMs;
+    }
+
+    software_renderer    *Software = (software_renderer *)Renderer->Backend;
+    software_frame_stats  Stats    = GetSoftwareFrameStats(Software);
+    software_image        Image    = GetSoftwareImage(Software);
+
+    printf("adb-render: %u by %u, %u obj files, %u entities | import %.2f ms | %u frames, %.3f ms mean, %.3f ms best, %u jobs\n",
+           Width, Height, ObjCount, EntityCount, ImportMs, FrameCount, TotalMs / (double)FrameCount, BestMs, Memory.WorkerCount);
+    printf("last frame: %u draws, %u triangles, %u rasterized, %u binned, %llu pixels\n",
+           Stats.DrawCount, Stats.TriangleCount, Stats.RasterizedCount, Stats.BinnedCount, (unsigned long long)Stats.PixelCount);
+
+    int Result = Stats.DrawCount ? 0 : 1;
+
+    if (!Stats.DrawCount)
+    {
+        fprintf(stderr, "adb-render: nothing was drawn, the scene did not load\n");
+    }
+
+    if (Output && !WriteTGA(Output, Image))
+    {
+        fprintf(stderr, "adb-render: could not write %s\n", Output);
+        Result = 1;
+    }
+
+    return Result;
+}
\ No newline at end of file
@@ -227,10 +227,11 @@ ByteStringCopy(byte_string Input, memory_arena * Arena)
 
     if (IsValidByteString(Input) && Arena)
     {
-        Result.Data = PushArray(Arena, uint8_t, Input.Size);
+        Result.Data = PushArray(Arena, uint8_t, Input.Size + 1);
         Result.Size = Input.Size;
 
         memcpy(Result.Data, Input.Data, Input.Size);
+        Result.Data[Result.Size] = '\0';
     }
 
     return Result;
@@ -256,13 +257,16 @@ ReplaceFileName(byte_string Path, byte_string Name, memory_arena *Arena)
             --Slash;
         }
 
+        // The extra byte keeps the path null-terminated, it is usually handed to fopen.
+
         Result.Size = Slash + Name.Size;
-        Result.Data = PushArray(Arena, uint8_t, Result.Size);
+        Result.Data = PushArray(Arena, uint8_t, Result.Size + 1);
 
         assert(IsValidByteString(Result));
 
         memcpy(Result.Data, Path.Data, Slash);
         memcpy(Result.Data + Slash, Name.Data, Name.Size);
+        Result.Data[Result.Size] = '\0';
     }
 
     return Result;
@@ -301,7 +305,7 @@ ConcatenateStrings(byte_string *Strings, uint32_t Count, byte_string Separator,
         TotalSize += (Count - 1) * Separator.Size;
     }
 
-    byte_string Result   = ByteString(PushArray(Arena, uint8_t, TotalSize), TotalSize);
+    byte_string Result   = ByteString(PushArray(Arena, uint8_t, TotalSize + 1), TotalSize);
     uint64_t    WriteIdx = 0;
 
     for (uint32_t StringIdx = 0; StringIdx < Count; ++StringIdx)
@@ -320,6 +324,8 @@ ConcatenateStrings(byte_string *Strings, uint32_t Count, byte_string Separator,
         }
     }
 
+    Result.Data[WriteIdx] = '\0';
+
     return Result;
 }
 
@@ -337,6 +343,14 @@ HashByteString(byte_string String)
     return Hash;
 }
 
+
+uint64_t
+CombineHash(uint64_t A, uint64_t B)
+{
+    uint64_t Result = A ^ (B + 0x9E3779B97F4A7C15ull + (A << 6) + (A >> 2));
+    return Result;
+}
+
 // ==============================================
 // <Buffer>
 // ==============================================
@@ -431,6 +445,27 @@ ReadFileInBuffer(byte_string Path, memory_arena *Arena)
 }
 
 
+bool
+WriteBufferToFile(byte_string Path, buffer *Buffer)
+{
+    bool Result = false;
+
+    if (IsValidByteString(Path) && IsBufferValid(Buffer))
+    {
+        FILE *File = fopen((const char *)Path.Data, "wb");
+        if (File)
+        {
+            size_t BytesWritten = fwrite(Buffer->Data, 1, Buffer->Size, File);
+            Result = BytesWritten == Buffer->Size;
+
+            fclose(File);
+        }
+    }
+
+    return Result;
+}
+
+
 void
 SkipWhitespaces(buffer *Buffer)
 {
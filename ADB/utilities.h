@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 
 // ==============================================
@@ -58,6 +59,7 @@ void           ReleaseArena       (memory_arena *Arena);
 
 void         * PushArena          (memory_arena *Arena, uint64_t Size, uint64_t Alignment);
 void           PopArenaTo         (memory_arena *Arena, uint64_t Position);
+uint64_t       GetArenaPosition   (memory_arena *Arena);
 void           ClearArena         (memory_arena *Arena);
 
 memory_region  EnterMemoryRegion  (memory_arena *Arena);
@@ -91,6 +93,7 @@ byte_string StripExtensionName  (byte_string Path);
 byte_string ConcatenateStrings  (byte_string *Strings, uint32_t Count, byte_string Separator, memory_arena *Arena);
                                 
 uint64_t    HashByteString      (byte_string String);
+uint64_t    CombineHash         (uint64_t A, uint64_t B);
 
 
 // ==============================================
@@ -109,6 +112,7 @@ bool        IsBufferValid      (buffer *Buffer);
 bool        IsBufferInBounds   (buffer *Buffer);
 
 buffer      ReadFileInBuffer   (byte_string Path, memory_arena *Arena);
+bool        WriteBufferToFile  (byte_string Path, buffer *Buffer);
 uint8_t     GetNextToken       (buffer *Buffer);
 uint8_t     PeekBuffer         (buffer *Buffer);
 void        SkipWhitespaces    (buffer *Buffer);